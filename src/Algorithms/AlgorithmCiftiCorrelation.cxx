@@ -223,6 +223,7 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
             cacheRow(i);
         }
     }
+    vector<int> blockReverse(numRows, -1);
     for (int startrow = 0; startrow < numRows; startrow += numCacheRows)
     {
         int endrow = startrow + numCacheRows;
@@ -239,40 +240,17 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
                 outRows[i - startrow] = CaretArray<float>(numRows);
             }
         }
-        int curRow = 0;//because we can't trust the order threads hit the critical section
-#pragma omp CARET_PARFOR schedule(dynamic)
-        for (int i = 0; i < numRows; ++i)
+        vector<int> blockIndices(endrow - startrow);
+        for (int i = startrow; i < endrow; ++i)
         {
-            float movingRrs;
-            int myrow;
-            const float* movingRow;
-#pragma omp critical
-            {//CiftiFile may explode if we request multiple rows concurrently (needs mutexes), but we should force sequential requests anyway
-                myrow = curRow;//so, manually force it to read sequentially
-                ++curRow;
-                movingRow = getRow(myrow, movingRrs);
-            }
-            for (int j = startrow; j < endrow; ++j)
-            {
-                if (myrow >= startrow && myrow < endrow)//check whether we are in the output memory area
-                {
-                    if (j >= myrow)//if so, only compute one half, and store both places
-                    {
-                        float cacheRrs;
-                        const float* cacheRow = getRow(j, cacheRrs, true);
-                        outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
-                        outRows[myrow - startrow][j] = outRows[j - startrow][myrow];
-                    }
-                } else {
-                    float cacheRrs;
-                    const float* cacheRow = getRow(j, cacheRrs, true);
-                    outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
-                }
-            }
+            blockIndices[i - startrow] = i;
+            blockReverse[i] = i - startrow;
         }
+        computeBlock(blockIndices, blockReverse, outRows, fisherZ);
         for (int i = startrow; i < endrow; ++i)
         {
             myCiftiOut->setRow(outRows[i - startrow], i);
+            blockReverse[i] = -1;
         }
         if (!cacheFullInput)
         {
@@ -409,13 +387,12 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
             cacheRow(i);
         }
     }
-    CaretArray<int> indexReverse(numRows, -1);
+    vector<int> indexReverse(numRows, -1);
     for (int startrow = 0; startrow < numSelected; startrow += numCacheRows)
     {
         int endrow = startrow + numCacheRows;
         if (endrow > numSelected) endrow = numSelected;
         outRows.resize(endrow - startrow);
-        int curRow = 0;//because we can't trust the order threads hit the critical section
         for (int i = startrow; i < endrow; ++i)
         {
             if (!cacheFullInput)
@@ -426,38 +403,14 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
             {
                 outRows[i - startrow] = CaretArray<float>(numRows);
             }
-            indexReverse[ciftiIndexList[i].first] = i;
+            indexReverse[ciftiIndexList[i].first] = i - startrow;
         }
-#pragma omp CARET_PARFOR schedule(dynamic)
-        for (int i = 0; i < numRows; ++i)
+        vector<int> blockIndices(endrow - startrow);
+        for (int i = startrow; i < endrow; ++i)
         {
-            float movingRrs;
-            int myrow;
-            const float* movingRow;
-#pragma omp critical
-            {//CiftiFile may explode if we request multiple rows concurrently (needs mutexes), but we should force sequential requests anyway
-                myrow = curRow;//so, manually force it to read sequentially
-                ++curRow;
-                movingRow = getRow(myrow, movingRrs);
-            }
-            for (int j = startrow; j < endrow; ++j)
-            {
-                if (indexReverse[myrow] != -1)//check if we are on a row that is in the output memory range
-                {
-                    if (indexReverse[myrow] <= j)//if so, only compute one of the elements, then store it both places
-                    {
-                        float cacheRrs;
-                        const float* cacheRow = getRow(ciftiIndexList[j].first, cacheRrs, true);
-                        outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
-                        outRows[indexReverse[myrow] - startrow][ciftiIndexList[j].first] = outRows[j - startrow][myrow];
-                    }
-                } else {
-                    float cacheRrs;
-                    const float* cacheRow = getRow(ciftiIndexList[j].first, cacheRrs, true);
-                    outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
-                }
-            }
+            blockIndices[i - startrow] = ciftiIndexList[i].first;
         }
+        computeBlock(blockIndices, indexReverse, outRows, fisherZ);
         for (int i = startrow; i < endrow; ++i)
         {
             myCiftiOut->setRow(outRows[i - startrow], ciftiIndexList[i].second);
@@ -517,18 +470,119 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
     AlgorithmCiftiCorrelation(myProgObj, myCifti, myCiftiOut, leftRoiPtr, rightRoiPtr, cerebRoiPtr, volRoiPtr, weights, fisherZ, memLimitGB, noDemean, covariance);//HACK: pass through our progress object
 }
 
-float AlgorithmCiftiCorrelation::correlate(const float* row1, const float& rrs1, const float* row2, const float& rrs2, const bool& fisherZ)
+namespace
+{
+    //tile sizes for the blocked correlation, chosen so that a tile of moving rows and a tile of cached rows, restricted to one length block, fit in L2 together
+    const int MOVING_TILE = 16;//also the number of temporary rows per thread
+    const int CACHE_TILE = 64;
+    const int LENGTH_BLOCK = 1024;
+}
+
+void AlgorithmCiftiCorrelation::computeBlock(const vector<int>& blockIndices, const vector<int>& blockReverse, vector<CaretArray<float> >& outRows, const bool& fisherZ)
+{
+    int numRows = m_inputCifti->getNumberOfRows();
+    int numBlock = (int)blockIndices.size();
+    int numTiles = (numRows + MOVING_TILE - 1) / MOVING_TILE;
+    int curRow = 0;//because we can't trust the order threads hit the critical section
+#pragma omp CARET_PAR
+    {
+        vector<const float*> movingRows(MOVING_TILE), cacheRows(CACHE_TILE);
+        vector<float> movingRrs(MOVING_TILE), cacheRrs(CACHE_TILE);
+        vector<double> accum(MOVING_TILE * CACHE_TILE);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int tile = 0; tile < numTiles; ++tile)
+        {
+            int tileStart;
+#pragma omp critical
+            {//we want the requests to go in roughly file order
+                tileStart = curRow;//so, manually force the tiles to be claimed sequentially
+                curRow += MOVING_TILE;
+            }
+            int numMoving = min(MOVING_TILE, numRows - tileStart);
+            bool allInBlock = true;
+            int minMovingPos = numBlock;
+            for (int m = 0; m < numMoving; ++m)
+            {
+                movingRows[m] = getRow(tileStart + m, movingRrs[m], false, m);//CiftiFile row reads are thread-safe, so let the reads overlap with computation
+                int movingPos = blockReverse[tileStart + m];
+                if (movingPos == -1)
+                {
+                    allInBlock = false;
+                } else {
+                    minMovingPos = min(minMovingPos, movingPos);
+                }
+            }
+            for (int cacheStart = 0; cacheStart < numBlock; cacheStart += CACHE_TILE)
+            {
+                int numCache = min(CACHE_TILE, numBlock - cacheStart);
+                if (allInBlock && cacheStart + numCache <= minMovingPos) continue;//entire tile is on the half of the symmetric part that gets stored from the other side
+                for (int c = 0; c < numCache; ++c)
+                {
+                    cacheRows[c] = getRow(blockIndices[cacheStart + c], cacheRrs[c], true);
+                }
+                dotTile(movingRows.data(), numMoving, cacheRows.data(), numCache, accum.data());
+                for (int m = 0; m < numMoving; ++m)
+                {
+                    int movingIndex = tileStart + m;
+                    int movingPos = blockReverse[movingIndex];
+                    const double* accumRow = accum.data() + m * numCache;
+                    for (int c = 0; c < numCache; ++c)
+                    {
+                        int cachePos = cacheStart + c;
+                        if (movingPos != -1)//check whether we are in the output memory area
+                        {
+                            if (movingPos <= cachePos)//if so, only compute one half, and store both places
+                            {
+                                outRows[cachePos][movingIndex] = finishCorrelation(accumRow[c], movingRrs[m], cacheRrs[c], movingIndex == blockIndices[cachePos], fisherZ);
+                                outRows[movingPos][blockIndices[cachePos]] = outRows[cachePos][movingIndex];
+                            }
+                        } else {
+                            outRows[cachePos][movingIndex] = finishCorrelation(accumRow[c], movingRrs[m], cacheRrs[c], false, fisherZ);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void AlgorithmCiftiCorrelation::dotTile(const float* const* movingRows, const int& numMoving, const float* const* cacheRows, const int& numCache, double* accumOut)
+{
+    int length = m_numCols;
+    if (m_weightedMode)
+    {
+        length = (int)m_weightIndexes.size();//because we compacted the data in the row to not include any zero weights
+    }
+    for (int i = 0; i < numMoving * numCache; ++i)
+    {
+        accumOut[i] = 0.0;
+    }
+    for (int blockStart = 0; blockStart < length; blockStart += LENGTH_BLOCK)//block along the row length, so each piece of a row gets reused from cache for the entire other tile
+    {
+        int blockLength = min(LENGTH_BLOCK, length - blockStart);
+        for (int m = 0; m < numMoving; ++m)
+        {
+            const float* movingPiece = movingRows[m] + blockStart;
+            double* accumRow = accumOut + m * numCache;
+            for (int c = 0; c < numCache; ++c)
+            {
+                accumRow[c] += dsdot(movingPiece, cacheRows[c] + blockStart, blockLength);
+            }
+        }
+    }
+}
+
+float AlgorithmCiftiCorrelation::finishCorrelation(const double& accum, const float& rrs1, const float& rrs2, const bool& sameRow, const bool& fisherZ)
 {
     double r;
-    if (row1 == row2 && !m_covariance)
+    if (sameRow && !m_covariance)
     {
         r = 1.0;//short circuit for same row
     } else {
         if (m_weightedMode)
         {
-            int numWeights = (int)m_weightIndexes.size();//because we compacted the data in the row to not include any zero weights
-            double accum = dsdot(row1, row2, numWeights);//these have already had the weighted row means subtracted out, and weights applied
-            if (m_covariance)
+            int numWeights = (int)m_weightIndexes.size();
+            if (m_covariance)//accum was computed from rows that have already had the weighted row means subtracted out, and weights applied
             {
                 if (m_binaryWeights)
                 {
@@ -540,8 +594,7 @@ float AlgorithmCiftiCorrelation::correlate(const float* row1, const float& rrs1,
                 r = accum / (rrs1 * rrs2);//as do these
             }
         } else {
-            double accum = dsdot(row1, row2, m_numCols);//these have already had the row means subtracted out
-            if (m_covariance)
+            if (m_covariance)//these have already had the row means subtracted out
             {
                 r = accum / m_numCols;
             } else {
@@ -605,6 +658,11 @@ void AlgorithmCiftiCorrelation::init(const CiftiFile* input, const vector<float>
     } else {
         m_weightedMode = false;
     }
+#ifdef CARET_OMP
+    m_tempRows.resize(omp_get_max_threads() * MOVING_TILE);//size it now, so that getTempRow doesn't resize from multiple threads
+#else
+    m_tempRows.resize(MOVING_TILE);
+#endif
 }
 
 void AlgorithmCiftiCorrelation::cacheRow(const int& ciftiIndex)
@@ -638,7 +696,7 @@ void AlgorithmCiftiCorrelation::clearCache()
     m_cacheUsed = 0;
 }
 
-const float* AlgorithmCiftiCorrelation::getRow(const int& ciftiIndex, float& rootResidSqr, const bool& mustBeCached)
+const float* AlgorithmCiftiCorrelation::getRow(const int& ciftiIndex, float& rootResidSqr, const bool& mustBeCached, const int& tempSlot)
 {
     float* ret;
     CaretAssertVectorIndex(m_rowInfo, ciftiIndex);
@@ -651,7 +709,7 @@ const float* AlgorithmCiftiCorrelation::getRow(const int& ciftiIndex, float& roo
         {
             throw AlgorithmException("something very bad happened, notify the developers");
         }
-        ret = getTempRow();
+        ret = getTempRow(tempSlot);
         m_inputCifti->getRow(ret, ciftiIndex);
         if (!m_rowInfo[ciftiIndex].m_haveCalculated)
         {
@@ -710,7 +768,7 @@ void AlgorithmCiftiCorrelation::computeRowStats(const float* row, float& mean, f
             {
                 accum += m_weights[i];
             }
-            rootResidSqr = accum;//repurpose this variable to store the weight sum - NOTE: don't take sqrt in case negative sum (whatever that means), so must not divide by both in correlate() in covariance mode
+            rootResidSqr = accum;//repurpose this variable to store the weight sum - NOTE: don't take sqrt in case negative sum (whatever that means), so must not divide by both in finishCorrelation() in covariance mode
         }
     } else {
         if (m_weightedMode)
@@ -769,28 +827,20 @@ void AlgorithmCiftiCorrelation::doSubtract(float* row, const float& mean)
     }
 }
 
-float* AlgorithmCiftiCorrelation::getTempRow()
+float* AlgorithmCiftiCorrelation::getTempRow(const int& slot)
 {
+    CaretAssert(slot >= 0 && slot < MOVING_TILE);
 #ifdef CARET_OMP
-    int oldsize = (int)m_tempRows.size();
-    int threadNum = omp_get_thread_num();
-    if (threadNum >= oldsize)
-    {
-        m_tempRows.resize(threadNum + 1);
-        for (int i = oldsize; i <= threadNum; ++i)
-        {
-            m_tempRows[i] = CaretArray<float>(m_numCols);
-        }
-    }
-    return m_tempRows[threadNum].getArray();
+    int index = omp_get_thread_num() * MOVING_TILE + slot;
 #else
-    if (m_tempRows.size() == 0)
+    int index = slot;
+#endif
+    CaretAssertVectorIndex(m_tempRows, index);//the vector is sized in init(), so that it never gets resized from multiple threads
+    if (m_tempRows[index].size() != m_numCols)//each element is only used by one thread, so allocating it here is fine
     {
-        m_tempRows.resize(1);
-        m_tempRows[0] = CaretArray<float>(m_numCols);
+        m_tempRows[index] = CaretArray<float>(m_numCols);
     }
-    return m_tempRows[0].getArray();
-#endif
+    return m_tempRows[index].getArray();
 }
 
 int AlgorithmCiftiCorrelation::numRowsForMem(const float& memLimitGB, bool& cacheFullInput)
@@ -800,9 +850,9 @@ int AlgorithmCiftiCorrelation::numRowsForMem(const float& memLimitGB, bool& cach
     int64_t targetBytes = (int64_t)(memLimitGB * 1024 * 1024 * 1024);
     if (m_inputCifti->isInMemory()) targetBytes -= numRows * m_numCols * 4;//count in-memory input against the total too
 #ifdef CARET_OMP
-    targetBytes -= inrowBytes * omp_get_max_threads();
+    targetBytes -= inrowBytes * omp_get_max_threads() * MOVING_TILE;
 #else
-    targetBytes -= inrowBytes;//1 row in memory that isn't a reference to cache
+    targetBytes -= inrowBytes * MOVING_TILE;//1 tile of rows in memory that aren't references to cache
 #endif
     targetBytes -= numRows * sizeof(RowInfo);//storage for mean, stdev, and info about caching
     int64_t perRowBytes = inrowBytes + outrowBytes;//cache and memory collation for output rows
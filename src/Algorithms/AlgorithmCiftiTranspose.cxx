@@ -21,6 +21,12 @@
 #include "AlgorithmCiftiTranspose.h"
 #include "AlgorithmException.h"
 #include "CiftiFile.h"
+#include "CiftiTileFile.h"
+
+#include <QDir>
+#include <QTemporaryFile>
+
+#include <algorithm>
 
 using namespace caret;
 using namespace std;
@@ -47,7 +53,10 @@ OperationParameters* AlgorithmCiftiTranspose::getParameters()
     
     ret->setHelpText(
         AString("The input must be a 2-dimensional cifti file.  ") +
-        "The output is a cifti file where every row in the input is a column in the output."
+        "The output is a cifti file where every row in the input is a column in the output.\n\n" +
+        "When -mem-limit is too small to hold the output, the input is first copied into a temporary file of square tiles " +
+        "(in the system temporary directory), and the output is then written from columns of tiles, " +
+        "so the input is read only once regardless of the limit."
     );
     return ret;
 }
@@ -91,6 +100,14 @@ AlgorithmCiftiTranspose::AlgorithmCiftiTranspose(ProgressObject* myProgObj, cons
         if (numCacheRows < 1) numCacheRows = 1;
         if (numCacheRows > colSize) numCacheRows = colSize;
     }
+    if (numCacheRows < colSize)
+    {//output doesn't fit, so rather than reading the whole input once per chunk, tile it out-of-core
+        int64_t tileSize = CiftiTileFile::DEFAULT_TILE_SIZE;
+        int64_t bytesPerTileSize = (rowSize + colSize) * sizeof(float);//a band of input rows, or a band of output rows
+        tileSize = min(tileSize, max(int64_t(1), (int64_t)(memLimitGB * 1024 * 1024 * 1024 / bytesPerTileSize)));
+        tiledTranspose(ciftiIn, ciftiOut, tileSize, myProgress);
+        return;
+    }
     vector<vector<float> > cacheRows(numCacheRows, vector<float>(rowSize));
     vector<float> scratchInRow(colSize);
     for (int i = 0; i < colSize; i += numCacheRows)//loop through cache chunks
@@ -109,7 +126,55 @@ AlgorithmCiftiTranspose::AlgorithmCiftiTranspose(ProgressObject* myProgObj, cons
         {
             ciftiOut->setRow(cacheRows[k - i].data(), k);
         }
+        myProgress.reportProgress(((float)end) / colSize);
+    }
+}
+
+void AlgorithmCiftiTranspose::tiledTranspose(const CiftiFile* ciftiIn, CiftiFile* ciftiOut, const int64_t& tileSize, LevelProgress& myProgress)
+{
+    QTemporaryFile tempFile(QDir::tempPath() + "/wb_transpose_XXXXXX.wbtiles");//removed when this goes out of scope
+    if (!tempFile.open())
+    {
+        throw AlgorithmException("failed to create temporary file in '" + QDir::tempPath() + "'");
+    }
+    QString tileFileName = tempFile.fileName();
+    tempFile.close();//keeps the name reserved, lets CaretBinaryFile open it on all platforms
+    CiftiTileFile::writeFile(*ciftiIn, tileFileName, "", tileSize);//reads tileSize input rows at a time
+    myProgress.reportProgress(0.5f);//the tile file is written with one pass over the input, and read with one more pass
+    const vector<int64_t>& inDims = ciftiIn->getDimensions();
+    int64_t inRowSize = inDims[0], inNumRows = inDims[1];
+    CiftiTileFile tiles;
+    if (!tiles.open(tileFileName, inNumRows, inRowSize, ""))
+    {
+        throw AlgorithmException("failed to read temporary file '" + tileFileName + "'");
+    }
+    vector<float> tile(tileSize * tileSize), outRows(tileSize * inNumRows);
+    for (int64_t tileCol = 0; tileCol < tiles.getNumberOfTileColumns(); ++tileCol)
+    {//a column of tiles is a band of output rows
+        int64_t firstOutRow = tileCol * tileSize;
+        int64_t numOutRows = min(tileSize, inRowSize - firstOutRow);
+        for (int64_t tileRow = 0; tileRow < tiles.getNumberOfTileRows(); ++tileRow)
+        {
+            tiles.getTile(tile.data(), tileRow, tileCol);
+            int64_t firstOutCol = tileRow * tileSize;
+            int64_t numOutCols = min(tileSize, inNumRows - firstOutCol);
+            for (int64_t r = 0; r < numOutRows; ++r)
+            {//tiles are column-major, so each input column in the tile is already a contiguous piece of an output row
+                const float* tileColumn = tile.data() + r * tileSize;
+                float* outRow = outRows.data() + r * inNumRows + firstOutCol;
+                for (int64_t c = 0; c < numOutCols; ++c)
+                {
+                    outRow[c] = tileColumn[c];
+                }
+            }
+        }
+        for (int64_t r = 0; r < numOutRows; ++r)
+        {
+            ciftiOut->setRow(outRows.data() + r * inNumRows, firstOutRow + r);
+        }
+        myProgress.reportProgress(0.5f + 0.5f * (tileCol + 1) / tiles.getNumberOfTileColumns());
     }
+    tiles.close();
 }
 
 float AlgorithmCiftiTranspose::getAlgorithmInternalWeight()
@@ -28,6 +28,7 @@ namespace caret {
     class AlgorithmCiftiTranspose : public AbstractAlgorithm
     {
         AlgorithmCiftiTranspose();
+        static void tiledTranspose(const CiftiFile* ciftiIn, CiftiFile* ciftiOut, const int64_t& tileSize, LevelProgress& myProgress);
     protected:
         static float getSubAlgorithmWeight();
         static float getAlgorithmInternalWeight();
@@ -399,9 +399,9 @@ void AlgorithmMetricDilate::processColumn(float* colScratch, const float* myInpu
                 int closestNode = myGeoHelp->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
                 if (closestNode == -1)//check neighbors, to ensure we dilate by at least one node everywhere
                 {
-                    const vector<int32_t>& nodeList = myTopoHelp->getNodeNeighbors(i);
+                    const TopologyIndexSpan nodeList = myTopoHelp->getNodeNeighbors(i);
                     vector<float> distList;
-                    myGeoHelp->getGeoToTheseNodes(i, nodeList, distList);//ok, its a little silly to do this
+                    myGeoHelp->getGeoToTheseNodes(i, nodeList.data(), (int32_t)nodeList.size(), distList);//ok, its a little silly to do this
                     const int numInRange = (int)nodeList.size();
                     for (int j = 0; j < numInRange; ++j)
                     {
@@ -620,9 +620,9 @@ void AlgorithmMetricDilate::precomputeStencils(vector<pair<int, StencilElem> >&
                 int closestNode = myGeoHelp->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
                 if (closestNode == -1)//check neighbors, to ensure we dilate by at least one node everywhere
                 {
-                    const vector<int32_t>& nodeList = myTopoHelp->getNodeNeighbors(i);
+                    const TopologyIndexSpan nodeList = myTopoHelp->getNodeNeighbors(i);
                     vector<float> distList;
-                    myGeoHelp->getGeoToTheseNodes(i, nodeList, distList);//ok, its a little silly to do this
+                    myGeoHelp->getGeoToTheseNodes(i, nodeList.data(), (int32_t)nodeList.size(), distList);//ok, its a little silly to do this
                     const int numInRange = (int)nodeList.size();
                     for (int j = 0; j < numInRange; ++j)
                     {
@@ -742,9 +742,9 @@ void AlgorithmMetricDilate::precomputeNearest(vector<pair<int, int> >& myNearest
                 int closestNode = myGeoHelp->getClosestNodeInRoi(i, charRoi.data(), distance, closestDist);
                 if (closestNode == -1)//check neighbors, to ensure we dilate by at least one node everywhere
                 {
-                    const vector<int32_t>& nodeList = myTopoHelp->getNodeNeighbors(i);
+                    const TopologyIndexSpan nodeList = myTopoHelp->getNodeNeighbors(i);
                     vector<float> distList;
-                    myGeoHelp->getGeoToTheseNodes(i, nodeList, distList);//ok, its a little silly to do this
+                    myGeoHelp->getGeoToTheseNodes(i, nodeList.data(), (int32_t)nodeList.size(), distList);//ok, its a little silly to do this
                     const int numInRange = (int)nodeList.size();
                     for (int j = 0; j < numInRange; ++j)
                     {
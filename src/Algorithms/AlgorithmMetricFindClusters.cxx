@@ -190,7 +190,7 @@ namespace
                 {
                     int node = newCluster.members[index];//keep list around so we can put it into the output immediately if it is large enough
                     newCluster.area += nodeAreas[node];
-                    const vector<int32_t>& neighbors = myTopoHelp->getNodeNeighbors(node);
+                    const TopologyIndexSpan neighbors = myTopoHelp->getNodeNeighbors(node);
                     int numNeigh = (int)neighbors.size();
                     for (int n = 0; n < numNeigh; ++n)
                     {
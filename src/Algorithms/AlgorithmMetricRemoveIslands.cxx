@@ -115,7 +115,7 @@ AlgorithmMetricRemoveIslands::AlgorithmMetricRemoveIslands(ProgressObject* myPro
                 {
                     int curnode = mystack.back();
                     mystack.pop_back();
-                    const vector<int32_t>& neighbors = myHelp->getNodeNeighbors(curnode);
+                    const TopologyIndexSpan neighbors = myHelp->getNodeNeighbors(curnode);
                     int numNeigh = (int)neighbors.size();
                     for (int j = 0; j < numNeigh; ++j)
                     {
@@ -203,16 +203,21 @@ AlgorithmMetricSmoothing::AlgorithmMetricSmoothing(ProgressObject* myProgObj, co
         myMetricOut->setStructure(mySurf->getStructure());
         for (int32_t col = 0; col < numCols; ++col)
         {
-            myProgress.setTask("Smoothing Column " + AString::number(col));
             myMetricOut->setColumnName(col, myMetric->getColumnName(col) + ", smooth " + AString::number(myKernel));
             *(myMetricOut->getPaletteColorMapping(col)) = *(myMetric->getPaletteColorMapping(col));//copy the palette settings
-            if (myRoi != NULL && matchRoiColumns)
+        }
+        if (myRoi != NULL && matchRoiColumns)
+        {
+            for (int32_t col = 0; col < numCols; ++col)
             {
+                myProgress.setTask("Smoothing Column " + AString::number(col));
                 mySmoothObj->smoothColumn(myMetric, col, myMetricOut, col, myRoi, col, fixZeros);
-            } else {
-                mySmoothObj->smoothColumn(myMetric, col, myMetricOut, col, myRoi, 0, fixZeros);
+                myProgress.reportProgress(precomputeWeightWork + ((float)col + 1) / numCols);
             }
-            myProgress.reportProgress(precomputeWeightWork + ((float)col + 1) / numCols);
+        } else {
+            myProgress.setTask("Smoothing Columns");
+            mySmoothObj->smoothMetric(myMetric, myMetricOut, myRoi, fixZeros);//applies the weights to blocks of columns at once
+            myProgress.reportProgress(precomputeWeightWork + 1.0f);
         }
     } else {
         myMetricOut->setNumberOfNodesAndColumns(numNodes, 1);
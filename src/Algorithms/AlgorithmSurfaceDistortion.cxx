@@ -161,7 +161,7 @@ AlgorithmSurfaceDistortion::AlgorithmSurfaceDistortion(ProgressObject* myProgObj
         CaretPointer<TopologyHelper> myhelp = referenceSurf->getTopologyHelper();
         for (int i = 0; i < numNodes; ++i)
         {
-            const vector<int32_t>& myTiles = myhelp->getNodeTiles(i);
+            const TopologyIndexSpan myTiles = myhelp->getNodeTiles(i);
             int tileCount = (int)myTiles.size();
             double accum = 0.0;
             for (int j = 0; j < tileCount; ++j)
@@ -194,7 +194,7 @@ AlgorithmSurfaceDistortion::AlgorithmSurfaceDistortion(ProgressObject* myProgObj
         {
             Vector3D refCenter = refCoords + i * 3;
             Vector3D distortCenter = distortCoords + i * 3;
-            const vector<int32_t>& neighbors = myhelp->getNodeNeighbors(i);
+            const TopologyIndexSpan neighbors = myhelp->getNodeNeighbors(i);
             int numNeigh = (int)neighbors.size();
             float accum = 0.0f;
             for (int j = 0; j < numNeigh; ++j)
@@ -261,7 +261,7 @@ AlgorithmSurfaceDistortion::AlgorithmSurfaceDistortion(ProgressObject* myProgObj
         CaretPointer<TopologyHelper> myTopoHelp = referenceSurf->getTopologyHelper();
         for (int i = 0; i < numNodes; ++i)
         {
-            const vector<int32_t>& myTiles = myTopoHelp->getNodeTiles(i);
+            const TopologyIndexSpan myTiles = myTopoHelp->getNodeTiles(i);
             double accumJ = 0.0, accumR = 0.0;
             for (int j = 0; j < (int)myTiles.size(); ++j)
             {
@@ -24,7 +24,9 @@
 #include "CaretLogger.h"
 #include "CaretOMP.h"
 #include "NiftiIO.h"
-#include "Vector3D.h"
+#include "VolumeResamplingHelper.h"
+
+#include <vector>
 
 using namespace caret;
 using namespace std;
@@ -121,11 +123,6 @@ AlgorithmVolumeAffineResample::AlgorithmVolumeAffineResample(ProgressObject* myP
     targetToSource[3][2] = 0.0f;
     targetToSource[3][3] = 1.0f;
     targetToSource = targetToSource.inverse();
-    Vector3D xvec, yvec, zvec, offset;
-    xvec[0] = targetToSource[0][0]; xvec[1] = targetToSource[1][0]; xvec[2] = targetToSource[2][0];
-    yvec[0] = targetToSource[0][1]; yvec[1] = targetToSource[1][1]; yvec[2] = targetToSource[2][1];
-    zvec[0] = targetToSource[0][2]; zvec[1] = targetToSource[1][2]; zvec[2] = targetToSource[2][2];
-    offset[0] = targetToSource[0][3]; offset[1] = targetToSource[1][3]; offset[2] = targetToSource[2][3];
     if (inVol->isMappedWithLabelTable())
     {
         if (myMethod != VolumeFile::ENCLOSING_VOXEL)
@@ -141,32 +138,27 @@ AlgorithmVolumeAffineResample::AlgorithmVolumeAffineResample(ProgressObject* myP
     {
         outVol->setMapName(i, inVol->getMapName(i));
     }
-    for (int64_t c = 0; c < numComponents; ++c)
+    VolumeResamplingHelper myHelper(inVol->getVolumeSpace(), outVol->getVolumeSpace(), targetToSource, myMethod);//find the source of each output voxel only once
+    int64_t numFrames = numMaps * numComponents;
+    bool threadFrames = false;
+#ifdef CARET_OMP
+    threadFrames = (numFrames >= omp_get_max_threads());//with enough frames, one frame per thread avoids synchronizing after every frame, and cubic deconvolves frames concurrently
+#endif
+#pragma omp CARET_PAR if (threadFrames)
     {
-        for (int64_t b = 0; b < numMaps; ++b)
+        vector<float> outFrame(outDims[0] * outDims[1] * outDims[2]);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int64_t f = 0; f < numFrames; ++f)
         {
-            if (myMethod == VolumeFile::CUBIC)
-            {
-                inVol->validateSpline(b, c);//because deconvolve is parallel, but won't execute parallel if we are already in a parallel section
-            }
-#pragma omp CARET_PARFOR schedule(dynamic)
-            for (int64_t k = 0; k < outDims[2]; ++k)
+            int64_t b = f % numMaps, c = f / numMaps;
+            bool allNumeric = myHelper.resampleFrame(inVol->getFrame(b, c), outFrame.data());
+#pragma omp critical
             {
-                for (int64_t j = 0; j < outDims[1]; ++j)
+                if (!allNumeric)
                 {
-                    for (int64_t i = 0; i < outDims[0]; ++i)
-                    {
-                        Vector3D outCoord, inCoord;
-                        outVol->indexToSpace(i, j, k, outCoord);
-                        inCoord = xvec * outCoord[0] + yvec * outCoord[1] + zvec * outCoord[2] + offset;
-                        float interpVal = inVol->interpolateValue(inCoord, myMethod, NULL, b, c);
-                        outVol->setValue(interpVal, i, j, k, b, c);
-                    }
+                    CaretLogWarning("ignored non-numeric input value when calculating cubic splines in volume '" + inVol->getFileName() + "', frame #" + AString::number(b + 1));
                 }
-            }
-            if (myMethod == VolumeFile::CUBIC)
-            {
-                inVol->freeSpline(b, c);//release memory we no longer need, if we allocated it
+                outVol->setFrame(outFrame.data(), b, c);//setFrame marks the file modified, which isn't thread safe
             }
         }
     }
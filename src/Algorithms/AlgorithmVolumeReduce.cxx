@@ -25,11 +25,17 @@
 #include "ReductionOperation.h"
 #include "VolumeFile.h"
 
+#include <algorithm>
 #include <vector>
 
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    const int64_t BLOCK_FLOATS = 64 * 1024 * 1024;//256MiB of transposed data at a time, so each frame is fetched once per block rather than once per voxel
+}
+
 AString AlgorithmVolumeReduce::getCommandSwitch()
 {
     return "-volume-reduce";
@@ -94,21 +100,30 @@ AlgorithmVolumeReduce::AlgorithmVolumeReduce(ProgressObject* myProgObj, const Vo
         *(volumeOut->getMapLabelTable(0)) = *(volumeIn->getMapLabelTable(0));
     }
     int64_t frameSize = myDims[0] * myDims[1] * myDims[2];
-    vector<float> scratchArray(myDims[3]), outFrame(frameSize);
+    int64_t blockSize = min(frameSize, max((int64_t)1, BLOCK_FLOATS / myDims[3]));
+    vector<float> blockArray(blockSize * myDims[3]), outFrame(frameSize);
     for (int c = 0; c < myDims[4]; ++c)
     {
-        for (int64_t i = 0; i < frameSize; ++i)
+        for (int64_t blockStart = 0; blockStart < frameSize; blockStart += blockSize)
         {
+            int64_t blockEnd = min(blockStart + blockSize, frameSize);
             for (int b = 0; b < myDims[3]; ++b)
-            {
+            {//frame-major, so volumes with frames read on demand don't reread frames for every voxel
                 const float* tempFrame = volumeIn->getFrame(b, c);
-                scratchArray[b] = tempFrame[i];
+                for (int64_t i = blockStart; i < blockEnd; ++i)
+                {
+                    blockArray[(i - blockStart) * myDims[3] + b] = tempFrame[i];
+                }
             }
-            if (onlyNumeric)
+            for (int64_t i = blockStart; i < blockEnd; ++i)
             {
-                outFrame[i] = ReductionOperation::reduceOnlyNumeric(scratchArray.data(), myDims[3], myReduce);
-            } else {
-                outFrame[i] = ReductionOperation::reduce(scratchArray.data(), myDims[3], myReduce);
+                const float* scratchArray = blockArray.data() + (i - blockStart) * myDims[3];
+                if (onlyNumeric)
+                {
+                    outFrame[i] = ReductionOperation::reduceOnlyNumeric(scratchArray, myDims[3], myReduce);
+                } else {
+                    outFrame[i] = ReductionOperation::reduce(scratchArray, myDims[3], myReduce);
+                }
             }
         }
         volumeOut->setFrame(outFrame.data(), 0, c);
@@ -128,17 +143,25 @@ AlgorithmVolumeReduce::AlgorithmVolumeReduce(ProgressObject* myProgObj, const Vo
         *(volumeOut->getMapLabelTable(0)) = *(volumeIn->getMapLabelTable(0));
     }
     int64_t frameSize = myDims[0] * myDims[1] * myDims[2];
-    vector<float> scratchArray(myDims[3]), outFrame(frameSize);
+    int64_t blockSize = min(frameSize, max((int64_t)1, BLOCK_FLOATS / myDims[3]));
+    vector<float> blockArray(blockSize * myDims[3]), outFrame(frameSize);
     for (int c = 0; c < myDims[4]; ++c)
     {
-        for (int64_t i = 0; i < frameSize; ++i)
+        for (int64_t blockStart = 0; blockStart < frameSize; blockStart += blockSize)
         {
+            int64_t blockEnd = min(blockStart + blockSize, frameSize);
             for (int b = 0; b < myDims[3]; ++b)
             {
                 const float* tempFrame = volumeIn->getFrame(b, c);
-                scratchArray[b] = tempFrame[i];
+                for (int64_t i = blockStart; i < blockEnd; ++i)
+                {
+                    blockArray[(i - blockStart) * myDims[3] + b] = tempFrame[i];
+                }
+            }
+            for (int64_t i = blockStart; i < blockEnd; ++i)
+            {
+                outFrame[i] = ReductionOperation::reduceExcludeDev(blockArray.data() + (i - blockStart) * myDims[3], myDims[3], myReduce, sigmaBelow, sigmaAbove);
             }
-            outFrame[i] = ReductionOperation::reduceExcludeDev(scratchArray.data(), myDims[3], myReduce, sigmaBelow, sigmaAbove);
         }
         volumeOut->setFrame(outFrame.data(), 0, c);
     }
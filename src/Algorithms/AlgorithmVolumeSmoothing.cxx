@@ -161,20 +161,48 @@ AlgorithmVolumeSmoothing::AlgorithmVolumeSmoothing(ProgressObject* myProgObj, co
         {
             vector<int64_t> origDims = inVol->getOriginalDimensions();
             outVol->reinitialize(origDims, volSpace, myDims[4]);
-            vector<int> lists[3];
-            for (int s = 0; s < myDims[3]; ++s)
+            const int64_t frameSize = myDims[0] * myDims[1] * myDims[2], numFrames = myDims[3] * myDims[4];
+            bool threadFrames = false;//with many small frames, give each thread whole frames instead of splitting every frame into slices
+#ifdef CARET_OMP
+            const int64_t FRAME_THREADING_MAX_VOXELS = 1 << 22;//each thread needs 4 frames of scratch, don't multiply that for very large frames
+            threadFrames = (roiVol == NULL && numFrames > 1 && numFrames >= omp_get_max_threads() && frameSize <= FRAME_THREADING_MAX_VOXELS);
+#endif
+            if (threadFrames)
             {
-                outVol->setMapName(s, inVol->getMapName(s) + ", smooth " + AString::number(kernel));
-                for (int c = 0; c < myDims[4]; ++c)
+                for (int s = 0; s < myDims[3]; ++s)
                 {
-                    const float* inFrame = inVol->getFrame(s, c);
-                    if (roiVol == NULL)
+                    outVol->setMapName(s, inVol->getMapName(s) + ", smooth " + AString::number(kernel));
+                }
+#pragma omp CARET_PAR
+                {
+                    CaretArray<float> threadFrame(frameSize), threadFrame2(frameSize), threadWeights(frameSize), threadWeights2(frameSize);
+#pragma omp CARET_FOR schedule(dynamic)
+                    for (int64_t f = 0; f < numFrames; ++f)
                     {
-                        smoothFrame(inFrame, myDims, scratchFrame, scratchFrame2, scratchWeights, scratchWeights2, inVol, iweights, jweights, kweights, irange, jrange, krange, fixZeros);
-                    } else {
-                        smoothFrameROI(inFrame, myDims, scratchFrame, scratchFrame2, scratchFrame3, scratchWeights, scratchWeights2, lists, inVol, roiVol, iweights, jweights, kweights, irange, jrange, krange, fixZeros);
+                        int64_t s = f % myDims[3], c = f / myDims[3];
+                        smoothFrame(inVol->getFrame(s, c), myDims, threadFrame, threadFrame2, threadWeights, threadWeights2, inVol, iweights, jweights, kweights, irange, jrange, krange, fixZeros, false);
+#pragma omp critical
+                        {
+                            outVol->setFrame(threadFrame, s, c);
+                        }
+                    }
+                }
+            } else {
+                vector<int> lists[3];
+                for (int s = 0; s < myDims[3]; ++s)
+                {
+                    outVol->setMapName(s, inVol->getMapName(s) + ", smooth " + AString::number(kernel));
+                    for (int c = 0; c < myDims[4]; ++c)
+                    {
+                        const float* inFrame = inVol->getFrame(s, c);
+                        if (roiVol == NULL)
+                        {
+                            smoothFrame(inFrame, myDims, scratchFrame, scratchFrame2, scratchWeights, scratchWeights2, inVol, iweights, jweights, kweights, irange, jrange, krange, fixZeros);
+                        } else {
+                            smoothFrameROI(inFrame, myDims, scratchFrame, scratchFrame2, scratchFrame3, scratchWeights, scratchWeights2, lists, inVol, roiVol, iweights, jweights, kweights, irange, jrange, krange, fixZeros);
+                        }
+                        outVol->setFrame(scratchFrame, s, c);
                     }
-                    outVol->setFrame(scratchFrame, s, c);
                 }
             }
         } else {
@@ -273,89 +301,107 @@ AlgorithmVolumeSmoothing::AlgorithmVolumeSmoothing(ProgressObject* myProgObj, co
     }
 }
 
-void AlgorithmVolumeSmoothing::smoothFrame(const float* inFrame, vector<int64_t> myDims, CaretArray<float> scratchFrame, CaretArray<float> scratchFrame2, CaretArray<float> scratchWeights, CaretArray<float> scratchWeights2, const VolumeFile* inVol, CaretArray<float> iweights, CaretArray<float> jweights, CaretArray<float> kweights, int irange, int jrange, int krange, const bool& fixZeros)
+void AlgorithmVolumeSmoothing::smoothFrame(const float* inFrame, vector<int64_t> myDims, CaretArray<float> scratchFrame, CaretArray<float> scratchFrame2, CaretArray<float> scratchWeights, CaretArray<float> scratchWeights2, const VolumeFile* inVol, CaretArray<float> iweights, CaretArray<float> jweights, CaretArray<float> kweights, int irange, int jrange, int krange, const bool& fixZeros, const bool& threadWithinFrame)
 {//this function should ONLY get invoked when the volume is orthogonal (axes are perpendicular, not necessarily aligned with x, y, z, and not necessarily equal spacing)
-#pragma omp CARET_PARFOR schedule(dynamic)
+    const int64_t rowSize = myDims[0], sliceSize = myDims[0] * myDims[1];
+    //all three passes accumulate one kernel tap at a time over a whole row (or slice), so the innermost loop is contiguous along i and vectorizes,
+    //instead of looping over the kernel per voxel and stepping along the smoothed axis with a stride of a row or a slice - the order of the additions per voxel is unchanged
+#pragma omp CARET_PARFOR schedule(dynamic) if (threadWithinFrame)
     for (int k = 0; k < myDims[2]; ++k)//smooth along i axis
     {
         for (int j = 0; j < myDims[1]; ++j)
         {
-            for (int i = 0; i < myDims[0]; ++i)
+            const float* inRow = inFrame + k * sliceSize + j * rowSize;
+            float* sumRow = scratchFrame + k * sliceSize + j * rowSize;
+            float* weightRow = scratchWeights + k * sliceSize + j * rowSize;
+            for (int64_t i = 0; i < rowSize; ++i)
             {
-                int imin = i - irange, imax = i + irange + 1;//one-after array size convention
-                if (imin < 0) imin = 0;
-                if (imax > myDims[0]) imax = myDims[0];
-                float sum = 0.0f, weightsum = 0.0f;
-                int64_t baseInd = inVol->getIndex(0, j, k, 0);//extra 0 on a default parameter is to prevent int->pointer vs int->int64 conversion ambiguity
-                int64_t curInd = baseInd + i;
-                for (int ikern = imin; ikern < imax; ++ikern)
+                sumRow[i] = 0.0f;
+                weightRow[i] = 0.0f;
+            }
+            for (int ioffset = -irange; ioffset <= irange; ++ioffset)
+            {
+                const float weight = iweights[ioffset + irange];
+                int64_t istart = 0, iend = rowSize;//one-after array size convention, restricted so that i + ioffset is in the row
+                if (ioffset < 0) istart = -ioffset;
+                if (ioffset > 0) iend = rowSize - ioffset;
+                if (fixZeros)
                 {
-                    int64_t thisIndex = baseInd + ikern;
-                    if ((!fixZeros || inFrame[thisIndex] != 0.0f))
+                    for (int64_t i = istart; i < iend; ++i)
+                    {
+                        const float value = inRow[i + ioffset];
+                        weightRow[i] += (value != 0.0f ? weight : 0.0f);
+                        sumRow[i] += weight * value;//zero values add nothing here anyway
+                    }
+                } else {
+                    for (int64_t i = istart; i < iend; ++i)
                     {
-                        float weight = iweights[ikern - i + irange];
-                        weightsum += weight;
-                        sum += weight * inFrame[thisIndex];
+                        weightRow[i] += weight;
+                        sumRow[i] += weight * inRow[i + ioffset];
                     }
                 }
-                scratchWeights[curInd] = weightsum;
-                scratchFrame[curInd] = sum;//don't divide yet, we will divide later after we gather the weighted sums of the weighted sums of the weight sums (yes, that repetition is right)
-            }
+            }//don't divide yet, we will divide later after we gather the weighted sums of the weighted sums of the weight sums (yes, that repetition is right)
         }
     }
-#pragma omp CARET_PARFOR schedule(dynamic)
+#pragma omp CARET_PARFOR schedule(dynamic) if (threadWithinFrame)
     for (int k = 0; k < myDims[2]; ++k)//now j
     {
-        for (int i = 0; i < myDims[0]; ++i)
+        for (int j = 0; j < myDims[1]; ++j)
         {
-            for (int j = 0; j < myDims[1]; ++j)//step along the dimension being smoothed last for best cache coherence
+            int jmin = j - jrange, jmax = j + jrange + 1;//one-after array size convention
+            if (jmin < 0) jmin = 0;
+            if (jmax > myDims[1]) jmax = myDims[1];
+            float* sumRow = scratchFrame2 + k * sliceSize + j * rowSize;
+            float* weightRow = scratchWeights2 + k * sliceSize + j * rowSize;
+            for (int64_t i = 0; i < rowSize; ++i)
+            {
+                sumRow[i] = 0.0f;
+                weightRow[i] = 0.0f;
+            }
+            for (int jkern = jmin; jkern < jmax; ++jkern)
             {
-                int jmin = j - jrange, jmax = j + jrange + 1;//one-after array size convention
-                if (jmin < 0) jmin = 0;
-                if (jmax > myDims[1]) jmax = myDims[1];
-                float sum = 0.0f, weightsum = 0.0f;
-                int64_t baseInd = inVol->getIndex(i, 0, k);
-                int64_t curInd = baseInd + j * myDims[0];
-                for (int jkern = jmin; jkern < jmax; ++jkern)
+                const float weight = jweights[jkern - j + jrange];
+                const float* frameRow = scratchFrame + k * sliceSize + jkern * rowSize;
+                const float* weightsRow = scratchWeights + k * sliceSize + jkern * rowSize;
+                for (int64_t i = 0; i < rowSize; ++i)
                 {
-                    int64_t thisIndex = baseInd + jkern * myDims[0];
-                    float weight = jweights[jkern - j + jrange];
-                    weightsum += weight * scratchWeights[thisIndex];
-                    sum += weight * scratchFrame[thisIndex];
+                    weightRow[i] += weight * weightsRow[i];
+                    sumRow[i] += weight * frameRow[i];
                 }
-                scratchWeights2[curInd] = weightsum;
-                scratchFrame2[curInd] = sum;//we now have the weighted sum of the weight sums
-            }
+            }//we now have the weighted sum of the weight sums
         }
     }
-//somehow this loop set is helped by collapsing the two outers, while the other two are not helped by it
-//however, we need to upgrade our windows compiler before we can use "collapse"
-#pragma omp CARET_PARFOR schedule(dynamic)
-    for (int j = 0; j < myDims[1]; ++j)//and finally k
+#pragma omp CARET_PARFOR schedule(dynamic) if (threadWithinFrame)
+    for (int k = 0; k < myDims[2]; ++k)//and finally k, scratchFrame and scratchWeights are free again, so accumulate into them
     {
-        for (int i = 0; i < myDims[0]; ++i)
+        int kmin = k - krange, kmax = k + krange + 1;//one-after array size convention
+        if (kmin < 0) kmin = 0;
+        if (kmax > myDims[2]) kmax = myDims[2];
+        float* sumSlice = scratchFrame + k * sliceSize;
+        float* weightSlice = scratchWeights + k * sliceSize;
+        for (int64_t v = 0; v < sliceSize; ++v)
         {
-            for (int k = 0; k < myDims[2]; ++k)//ditto
+            sumSlice[v] = 0.0f;
+            weightSlice[v] = 0.0f;
+        }
+        for (int kkern = kmin; kkern < kmax; ++kkern)
+        {
+            const float weight = kweights[kkern - k + krange];
+            const float* frameSlice = scratchFrame2 + kkern * sliceSize;
+            const float* weightsSlice = scratchWeights2 + kkern * sliceSize;
+            for (int64_t v = 0; v < sliceSize; ++v)
             {
-                int64_t baseInd = inVol->getIndex(i, j, 0);
-                int64_t curInd = baseInd + k * myDims[0] * myDims[1];
-                int kmin = k - krange, kmax = k + krange + 1;//one-after array size convention
-                if (kmin < 0) kmin = 0;
-                if (kmax > myDims[2]) kmax = myDims[2];
-                float sum = 0.0f, weightsum = 0.0f;
-                for (int kkern = kmin; kkern < kmax; ++kkern)
-                {
-                    int64_t thisIndex = baseInd + kkern * myDims[0] * myDims[1];
-                    float weight = kweights[kkern - k + krange];
-                    weightsum += weight * scratchWeights2[thisIndex];
-                    sum += weight * scratchFrame2[thisIndex];
-                }
-                if (weightsum != 0.0f)
-                {
-                    scratchFrame[curInd] = sum / weightsum;//NOW we can divide
-                } else {
-                    scratchFrame[curInd] = 0.0f;
-                }
+                weightSlice[v] += weight * weightsSlice[v];
+                sumSlice[v] += weight * frameSlice[v];
+            }
+        }
+        for (int64_t v = 0; v < sliceSize; ++v)
+        {
+            if (weightSlice[v] != 0.0f)
+            {
+                sumSlice[v] /= weightSlice[v];//NOW we can divide
+            } else {
+                sumSlice[v] = 0.0f;
             }
         }
     }
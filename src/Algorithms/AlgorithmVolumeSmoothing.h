@@ -34,7 +34,7 @@ namespace caret {
         static float getAlgorithmInternalWeight();
         void smoothFrame(const float* inFrame, std::vector<int64_t> myDims, CaretArray<float> scratchFrame, CaretArray<float> scratchFrame2, CaretArray<float> scratchWeights,
                          CaretArray<float> scratchWeights2, const VolumeFile* inVol, CaretArray<float> iweights, CaretArray<float> jweights, CaretArray<float> kweights,
-                         int irange, int jrange, int krange, const bool& fixZeros);
+                         int irange, int jrange, int krange, const bool& fixZeros, const bool& threadWithinFrame = true);
         void smoothFrameROI(const float* inFrame, std::vector<int64_t> myDims, CaretArray<float> scratchFrame, CaretArray<float> scratchFrame2, CaretArray<float> scratchFrame3,
                                               CaretArray<float> scratchWeights, CaretArray<float> scratchWeights2, std::vector<int> lists[3],
                                               const VolumeFile* inVol, const VolumeFile* roiVol, CaretArray<float> iweights, CaretArray<float> jweights, CaretArray<float> kweights,
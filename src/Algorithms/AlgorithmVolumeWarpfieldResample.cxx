@@ -24,9 +24,11 @@
 #include "CaretLogger.h"
 #include "CaretOMP.h"
 #include "NiftiIO.h"
-#include "Vector3D.h"
+#include "VolumeResamplingHelper.h"
 #include "WarpfieldFile.h"
 
+#include <vector>
+
 using namespace caret;
 using namespace std;
 
@@ -127,41 +129,27 @@ AlgorithmVolumeWarpfieldResample::AlgorithmVolumeWarpfieldResample(ProgressObjec
     {
         outVol->setMapName(i, inVol->getMapName(i));
     }
-    for (int64_t c = 0; c < numComponents; ++c)
+    VolumeResamplingHelper myHelper(inVol->getVolumeSpace(), outVol->getVolumeSpace(), warpfield, myMethod);//interpolate the warpfield only once, rather than once per frame
+    int64_t numFrames = numMaps * numComponents;
+    bool threadFrames = false;
+#ifdef CARET_OMP
+    threadFrames = (numFrames >= omp_get_max_threads());
+#endif
+#pragma omp CARET_PAR if (threadFrames)
     {
-        for (int64_t b = 0; b < numMaps; ++b)
+        vector<float> outFrame(outDims[0] * outDims[1] * outDims[2]);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int64_t f = 0; f < numFrames; ++f)
         {
-            if (myMethod == VolumeFile::CUBIC)
-            {
-                inVol->validateSpline(b, c);//because deconvolve is parallel, but won't execute parallel if we are already in a parallel section
-            }
-#pragma omp CARET_PARFOR schedule(dynamic)
-            for (int64_t k = 0; k < outDims[2]; ++k)
+            int64_t b = f % numMaps, c = f / numMaps;
+            bool allNumeric = myHelper.resampleFrame(inVol->getFrame(b, c), outFrame.data());
+#pragma omp critical
             {
-                for (int64_t j = 0; j < outDims[1]; ++j)
+                if (!allNumeric)
                 {
-                    for (int64_t i = 0; i < outDims[0]; ++i)
-                    {
-                        Vector3D outCoord, inCoord, displacement;
-                        outVol->indexToSpace(i, j, k, outCoord);
-                        bool validDisplacement = false;
-                        displacement[0] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, &validDisplacement, 0);
-                        if (validDisplacement)
-                        {
-                            displacement[1] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, NULL, 1);
-                            displacement[2] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, NULL, 2);
-                            inCoord = outCoord + displacement;
-                            float interpVal = inVol->interpolateValue(inCoord, myMethod, NULL, b, c);
-                            outVol->setValue(interpVal, i, j, k, b, c);
-                        } else {
-                            outVol->setValue(VolumeFile::INVALID_INTERP_VALUE, i, j, k, b, c);
-                        }
-                    }
+                    CaretLogWarning("ignored non-numeric input value when calculating cubic splines in volume '" + inVol->getFileName() + "', frame #" + AString::number(b + 1));
                 }
-            }
-            if (myMethod == VolumeFile::CUBIC)
-            {
-                inVol->freeSpline(b, c);//release memory we no longer need, if we allocated it
+                outVol->setFrame(outFrame.data(), b, c);
             }
         }
     }
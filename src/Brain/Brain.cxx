@@ -35,6 +35,7 @@
 #include "BrainordinateRegionOfInterest.h"
 #include "BrainStructure.h"
 #include "BrowserTabContent.h"
+#include "CaretDataFileConcurrentReader.h"
 #include "CaretDataFileHelper.h"
 #include "CaretLogger.h"
 #include "CaretPreferences.h"
@@ -5448,6 +5449,70 @@ Brain::readDataFile(const DataFileTypeEnum::Enum dataFileType,
     return caretDataFileRead;
 }
 
+/**
+ * Add a data file that was read by the concurrent reader.  This is
+ * the same as readDataFile() except that the file has already been read.
+ *
+ * @param concurrentReader
+ *    Reader that read the file.
+ * @param concurrentReaderFileIndex
+ *    Index of the file in the reader.
+ * @param dataFileType
+ *    Type of data file.
+ * @param structure
+ *    Struture of file (used if not invalid)
+ * @param dataFileName
+ *    Name of data file.
+ * @throws DataFileException
+ *    If there was an error reading the file or the file is
+ *    not compatible with files already loaded.
+ * @return
+ *    Pointer to file that was added, if no errors.
+ */
+CaretDataFile*
+Brain::addDataFileReadConcurrently(CaretDataFileConcurrentReader& concurrentReader,
+                                   const int32_t concurrentReaderFileIndex,
+                                   const DataFileTypeEnum::Enum dataFileType,
+                                   const StructureEnum::Enum structure,
+                                   const AString& dataFileName)
+{
+    CaretDataFile* caretDataFile = concurrentReader.takeFile(concurrentReaderFileIndex);
+    CaretAssert(caretDataFile);
+    
+    try {
+        /*
+         * Validation uses the loaded surfaces so it is performed
+         * now and not when the file is read.
+         */
+        const CiftiMappableDataFile* ciftiMapFile = dynamic_cast<const CiftiMappableDataFile*>(caretDataFile);
+        if (ciftiMapFile != NULL) {
+            validateCiftiMappableDataFile(ciftiMapFile);
+        }
+        
+        addReadOrReloadDataFile(FILE_MODE_ADD,
+                                caretDataFile,
+                                dataFileType,
+                                structure,
+                                dataFileName,
+                                false);
+    }
+    catch (const DataFileException& dfe) {
+        /*
+         * Delete the file unless it was added to the brain
+         */
+        std::vector<CaretDataFile*> allDataFiles;
+        getAllDataFiles(allDataFiles);
+        if (std::find(allDataFiles.begin(),
+                      allDataFiles.end(),
+                      caretDataFile) == allDataFiles.end()) {
+            delete caretDataFile;
+        }
+        throw dfe;
+    }
+    
+    return caretDataFile;
+}
+
 /**
  * Processing performed after adding or removing a data file.
  */
@@ -5501,7 +5566,36 @@ Brain::loadFilesSelectedInSpecFile(EventSpecFileReadDataFiles* readSpecFileDataF
     FileInformation fileInfo(sf->getFileName());
     setCurrentDirectory(fileInfo.getPathName());
     
-    const int32_t numberOfFilesToRead = sf->getNumberOfFilesSelectedForLoading();
+    /*
+     * Files whose reading does not depend upon other files are read
+     * concurrently on worker threads.  They are still added to the
+     * brain, below, in the order they are listed in the spec file.
+     */
+    const int32_t numFileGroups = sf->getNumberOfDataFileTypeGroups();
+    CaretDataFileConcurrentReader concurrentReader;
+    std::map<const SpecFileDataFile*, int32_t> specFileEntryToConcurrentReaderIndex;
+    for (int32_t ig = 0; ig < numFileGroups; ig++) {
+        const SpecFileDataFileTypeGroup* group = sf->getDataFileTypeGroupByIndex(ig);
+        const int32_t numFiles = group->getNumberOfFiles();
+        for (int32_t iFile = 0; iFile < numFiles; iFile++) {
+            const SpecFileDataFile* dataFileInfo = group->getFileInformation(iFile);
+            if (dataFileInfo->isLoadingSelected()) {
+                const int32_t readerIndex = concurrentReader.addFile(group->getDataFileType(),
+                                                                     convertFilePathNameToAbsolutePathName(dataFileInfo->getFileName()));
+                if (readerIndex >= 0) {
+                    specFileEntryToConcurrentReaderIndex.insert(std::make_pair(dataFileInfo,
+                                                                               readerIndex));
+                }
+            }
+        }
+    }
+    
+    /*
+     * Progress counts files read concurrently and then all files
+     * as they are added to the brain.
+     */
+    const int32_t numberOfFilesToRead = (sf->getNumberOfFilesSelectedForLoading()
+                                         + concurrentReader.getNumberOfFiles());
     int32_t fileReadCounter = 0;
     
     EventProgressUpdate progressUpdate(0,
@@ -5510,11 +5604,29 @@ Brain::loadFilesSelectedInSpecFile(EventSpecFileReadDataFiles* readSpecFileDataF
                                        "Starting to read selected files");
     EventManager::get()->sendEvent(progressUpdate.getPointer());
 
+    while (concurrentReader.hasFilesToRead()) {
+        progressUpdate.setProgress(concurrentReader.getNumberOfFilesRead(),
+                                   ("Reading "
+                                    + concurrentReader.getNextFileNameToRead()));
+        EventManager::get()->sendEvent(progressUpdate.getPointer());
+        
+        /*
+         * If user cancelled, reset brain and get out!
+         * Files read concurrently are deleted by the reader.
+         */
+        if (progressUpdate.isCancelled()) {
+            resetBrain();
+            return;
+        }
+        
+        concurrentReader.readNextFiles();
+    }
+    fileReadCounter = concurrentReader.getNumberOfFiles();
+    
     /*
      * Note: Need to read palette first since some of the individual file
      * reading routines update palette coloring when file is read
      */
-    const int32_t numFileGroups = sf->getNumberOfDataFileTypeGroups();
     for (int32_t ig = -1; ig < numFileGroups; ig++) {
         const SpecFileDataFileTypeGroup* group = ((ig == -1)
                                                ? sf->getDataFileTypeGroupByType(DataFileTypeEnum::PALETTE)
@@ -5550,10 +5662,20 @@ Brain::loadFilesSelectedInSpecFile(EventSpecFileReadDataFiles* readSpecFileDataF
                 }
                 
                 try {
-                    readDataFile(dataFileType,
-                                 structure,
-                                 filename,
-                                 false);
+                    std::map<const SpecFileDataFile*, int32_t>::iterator readerIter = specFileEntryToConcurrentReaderIndex.find(dataFileInfo);
+                    if (readerIter != specFileEntryToConcurrentReaderIndex.end()) {
+                        addDataFileReadConcurrently(concurrentReader,
+                                                    readerIter->second,
+                                                    dataFileType,
+                                                    structure,
+                                                    filename);
+                    }
+                    else {
+                        readDataFile(dataFileType,
+                                     structure,
+                                     filename,
+                                     false);
+                    }
                 }
                 catch (const DataFileException& e) {
                     if (errorMessage.isEmpty() == false) {
@@ -5784,9 +5906,50 @@ Brain::loadSpecFileFromScene(const SceneAttributes* sceneAttributes,
     
     
     /*
-     * Load new files and add existing files that were previously loaded.
+     * New files whose reading does not depend upon other files are read
+     * concurrently on worker threads.  Files named relative to a scene
+     * file on the network are read from the network so they are
+     * read one at a time below.
      */
     const int32_t numFileGroups = specFileToLoad->getNumberOfDataFileTypeGroups();
+    CaretDataFileConcurrentReader concurrentReader;
+    std::map<const SpecFileDataFile*, int32_t> specFileEntryToConcurrentReaderIndex;
+    if ( ! sceneFileOnNetwork) {
+        for (int32_t ig = 0; ig < numFileGroups; ig++) {
+            const SpecFileDataFileTypeGroup* group = specFileToLoad->getDataFileTypeGroupByIndex(ig);
+            const int32_t numFiles = group->getNumberOfFiles();
+            for (int32_t iFile = 0; iFile < numFiles; iFile++) {
+                const SpecFileDataFile* fileInfo = group->getFileInformation(iFile);
+                if (fileInfo->isLoadingSelected()) {
+                    if (specFilesEntryToNonModifiedFile.find(fileInfo) == specFilesEntryToNonModifiedFile.end()) {
+                        const int32_t readerIndex = concurrentReader.addFile(group->getDataFileType(),
+                                                                             convertFilePathNameToAbsolutePathName(fileInfo->getFileName()));
+                        if (readerIndex >= 0) {
+                            specFileEntryToConcurrentReaderIndex.insert(std::make_pair(fileInfo,
+                                                                                       readerIndex));
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    while (concurrentReader.hasFilesToRead()) {
+        progressEvent.setProgressMessage("Loading "
+                                         + concurrentReader.getNextFileNameToRead());
+        EventManager::get()->sendEvent(progressEvent.getPointer());
+        if (progressEvent.isCancelled()) {
+            resetBrain(keepSceneFiles,
+                       keepSpecFile);
+            return;
+        }
+        
+        concurrentReader.readNextFiles();
+    }
+    
+    /*
+     * Load new files and add existing files that were previously loaded.
+     */
     for (int32_t ig = 0; ig < numFileGroups; ig++) {
         const SpecFileDataFileTypeGroup* group = specFileToLoad->getDataFileTypeGroupByIndex(ig);
         const DataFileTypeEnum::Enum dataFileType = group->getDataFileType();
@@ -5842,10 +6005,20 @@ Brain::loadSpecFileFromScene(const SceneAttributes* sceneAttributes,
                                 }
                             }
                         }
-                        readDataFile(dataFileType,
-                                     structure,
-                                     filename,
-                                     false);
+                        std::map<const SpecFileDataFile*, int32_t>::iterator readerIter = specFileEntryToConcurrentReaderIndex.find(fileInfo);
+                        if (readerIter != specFileEntryToConcurrentReaderIndex.end()) {
+                            addDataFileReadConcurrently(concurrentReader,
+                                                        readerIter->second,
+                                                        dataFileType,
+                                                        structure,
+                                                        filename);
+                        }
+                        else {
+                            readDataFile(dataFileType,
+                                         structure,
+                                         filename,
+                                         false);
+                        }
                     }
                 }
                 catch (const DataFileException& e) {
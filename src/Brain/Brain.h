@@ -47,6 +47,7 @@ namespace caret {
     class FociFile;
     class BrainStructure;
     class CaretDataFile;
+    class CaretDataFileConcurrentReader;
     class CaretMappableDataFile;
     class CaretPreferences;
     class ChartingDataManager;
@@ -496,6 +497,12 @@ namespace caret {
                           const AString& dataFileName,
                           const bool markDataFileAsModified);
         
+        CaretDataFile* addDataFileReadConcurrently(CaretDataFileConcurrentReader& concurrentReader,
+                                                   const int32_t concurrentReaderFileIndex,
+                                                   const DataFileTypeEnum::Enum dataFileType,
+                                                   const StructureEnum::Enum structure,
+                                                   const AString& dataFileName);
+        
         void createModelChartTwo();
         
         /**
@@ -24,6 +24,7 @@
 #undef __BRAIN_OPEN_G_L_CHART_TWO_DRAWING_FIXED_PIPELINE_DECLARE__
 
 #include <algorithm>
+#include <cmath>
 
 #include "AnnotationCoordinate.h"
 #include "AnnotationColorBar.h"
@@ -49,12 +50,14 @@
 #include "ChartableTwoFileMatrixChart.h"
 #include "ChartableTwoFileLineSeriesChart.h"
 #include "CiftiMappableConnectivityMatrixDataFile.h"
+#include "CiftiMatrixPyramid.h"
 #include "DeveloperFlagsEnum.h"
 #include "FastStatistics.h"
 #include "GraphicsEngineDataOpenGL.h"
 #include "GraphicsPrimitiveV3f.h"
 #include "GraphicsPrimitiveV3fC4f.h"
 #include "GraphicsPrimitiveV3fC4ub.h"
+#include "GraphicsPrimitiveV3fT3f.h"
 #include "GraphicsShape.h"
 #include "IdentificationWithColor.h"
 #include "MathFunctions.h"
@@ -1242,6 +1245,14 @@ BrainOpenGLChartTwoDrawingFixedPipeline::drawMatrixChartContent(const ChartableT
                                                                 const float /*zooming*/,
                                                                 std::vector<MatrixRowColumnHighight*>& rowColumnHighlightingOut)
 {
+    if (matrixChart->isMatrixChartingWithPyramid()) {
+        drawMatrixChartContentPyramid(matrixChart,
+                                      chartViewingType,
+                                      cellWidth,
+                                      cellHeight);
+        return;
+    }
+    
     GraphicsPrimitiveV3fC4f* matrixPrimitive = matrixChart->getMatrixChartingGraphicsPrimitive(chartViewingType,
                                                                                                CiftiMappableDataFile::MatrixGridMode::FILLED);
     if (matrixPrimitive == NULL) {
@@ -1415,6 +1426,187 @@ BrainOpenGLChartTwoDrawingFixedPipeline::drawMatrixChartContent(const ChartableT
     glPopMatrix();
 }
 
+/*
+ * Draw a matrix chart content using tiles from the matrix pyramid.
+ * Only tiles that are visible are drawn and the pyramid level is
+ * chosen so that a block of cells is not much smaller than a pixel.
+ * Grid lines and row/column highlighting are not drawn since
+ * cells are usually smaller than a pixel.
+ *
+ * @param matrixChart
+ *     Matrix chart that is drawn.
+ * @param chartViewingType
+ *     Type of chart viewing.
+ * @param cellWidth
+ *     Width of cell.
+ * @param cellHeight
+ *     Height of cell.
+ */
+void
+BrainOpenGLChartTwoDrawingFixedPipeline::drawMatrixChartContentPyramid(const ChartableTwoFileMatrixChart* matrixChart,
+                                                                       const ChartTwoMatrixTriangularViewingModeEnum::Enum chartViewingType,
+                                                                       const float cellWidth,
+                                                                       const float cellHeight)
+{
+    const CiftiMatrixPyramid* pyramid = matrixChart->getMatrixPyramid();
+    if (pyramid == NULL) {
+        return;
+    }
+    const int64_t numberOfRows    = pyramid->getNumberOfRows();
+    const int64_t numberOfColumns = pyramid->getNumberOfColumns();
+    
+    glPushMatrix();
+    glScalef(cellWidth, cellHeight, 1.0);
+    
+    /*
+     * Cells are 1.0 x 1.0 in model coordinates with the first row at the top
+     */
+    GLdouble modelViewMatrix[16];
+    GLdouble projectionMatrix[16];
+    GLint viewport[4];
+    glGetDoublev(GL_MODELVIEW_MATRIX, modelViewMatrix);
+    glGetDoublev(GL_PROJECTION_MATRIX, projectionMatrix);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    
+    if (m_identificationModeFlag) {
+        /*
+         * No need to draw, row and column are from the mouse position
+         */
+        GLdouble modelXYZ[3];
+        if (gluUnProject(m_fixedPipelineDrawing->mouseX,
+                         m_fixedPipelineDrawing->mouseY,
+                         0.0,
+                         modelViewMatrix,
+                         projectionMatrix,
+                         viewport,
+                         &modelXYZ[0],
+                         &modelXYZ[1],
+                         &modelXYZ[2]) == GL_TRUE) {
+            const int64_t columnIndex = static_cast<int64_t>(std::floor(modelXYZ[0]));
+            const int64_t rowIndex    = numberOfRows - 1 - static_cast<int64_t>(std::floor(modelXYZ[1]));
+            if ((rowIndex >= 0)
+                && (rowIndex < numberOfRows)
+                && (columnIndex >= 0)
+                && (columnIndex < numberOfColumns)) {
+                bool cellDrawnFlag = true;
+                if (numberOfRows == numberOfColumns) {
+                    switch (chartViewingType) {
+                        case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_FULL:
+                            break;
+                        case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_FULL_NO_DIAGONAL:
+                            cellDrawnFlag = (rowIndex != columnIndex);
+                            break;
+                        case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_LOWER_NO_DIAGONAL:
+                            cellDrawnFlag = (rowIndex > columnIndex);
+                            break;
+                        case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_UPPER_NO_DIAGONAL:
+                            cellDrawnFlag = (rowIndex < columnIndex);
+                            break;
+                    }
+                }
+                
+                GLdouble windowXYZ[3];
+                if (cellDrawnFlag
+                    && (gluProject(columnIndex + 0.5,
+                                   numberOfRows - rowIndex - 0.5,
+                                   0.0,
+                                   modelViewMatrix,
+                                   projectionMatrix,
+                                   viewport,
+                                   &windowXYZ[0],
+                                   &windowXYZ[1],
+                                   &windowXYZ[2]) == GL_TRUE)) {
+                    if (m_selectionItemMatrix->isOtherScreenDepthCloserToViewer(windowXYZ[2])) {
+                        m_selectionItemMatrix->setMatrixChart(const_cast<ChartableTwoFileMatrixChart*>(matrixChart),
+                                                              rowIndex,
+                                                              columnIndex);
+                    }
+                }
+            }
+        }
+        
+        glPopMatrix();
+        return;
+    }
+    
+    /*
+     * Region of the matrix that is in the viewport
+     */
+    GLdouble minCornerXYZ[3];
+    GLdouble maxCornerXYZ[3];
+    if ((gluUnProject(viewport[0],
+                      viewport[1],
+                      0.0,
+                      modelViewMatrix,
+                      projectionMatrix,
+                      viewport,
+                      &minCornerXYZ[0],
+                      &minCornerXYZ[1],
+                      &minCornerXYZ[2]) != GL_TRUE)
+        || (gluUnProject(viewport[0] + viewport[2],
+                         viewport[1] + viewport[3],
+                         0.0,
+                         modelViewMatrix,
+                         projectionMatrix,
+                         viewport,
+                         &maxCornerXYZ[0],
+                         &maxCornerXYZ[1],
+                         &maxCornerXYZ[2]) != GL_TRUE)
+        || (viewport[2] <= 0)
+        || (viewport[3] <= 0)) {
+        glPopMatrix();
+        return;
+    }
+    const double minX = std::min(minCornerXYZ[0], maxCornerXYZ[0]);
+    const double maxX = std::max(minCornerXYZ[0], maxCornerXYZ[0]);
+    const double minY = std::min(minCornerXYZ[1], maxCornerXYZ[1]);
+    const double maxY = std::max(minCornerXYZ[1], maxCornerXYZ[1]);
+    
+    const double firstVisibleColumn = std::max(minX, 0.0);
+    const double lastVisibleColumn  = std::min(maxX, static_cast<double>(numberOfColumns));
+    const double firstVisibleRow    = std::max(numberOfRows - maxY, 0.0);
+    const double lastVisibleRow     = std::min(numberOfRows - minY, static_cast<double>(numberOfRows));
+    if ((firstVisibleColumn >= lastVisibleColumn)
+        || (firstVisibleRow >= lastVisibleRow)) {
+        glPopMatrix();
+        return;
+    }
+    
+    const float cellsPerPixel = static_cast<float>(std::max((maxX - minX) / viewport[2],
+                                                            (maxY - minY) / viewport[3]));
+    const int32_t level = pyramid->getLevelForCellsPerPixel(cellsPerPixel);
+    const double tileCellSize = static_cast<double>(CiftiMatrixPyramid::TILE_SIZE << level);
+    const int64_t firstTileColumn = static_cast<int64_t>(firstVisibleColumn / tileCellSize);
+    const int64_t lastTileColumn  = std::min(static_cast<int64_t>(lastVisibleColumn / tileCellSize),
+                                             pyramid->getNumberOfTileColumns(level) - 1);
+    const int64_t firstTileRow    = static_cast<int64_t>(firstVisibleRow / tileCellSize);
+    const int64_t lastTileRow     = std::min(static_cast<int64_t>(lastVisibleRow / tileCellSize),
+                                             pyramid->getNumberOfTileRows(level) - 1);
+    
+    /*
+     * Enable alpha blending so cells that are not drawn from higher layers
+     * allow cells from lower layers to be seen.
+     */
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+    std::vector<GraphicsPrimitiveV3fT3f*> tilePrimitives;
+    for (int64_t tileRow = firstTileRow; tileRow <= lastTileRow; tileRow++) {
+        matrixChart->getMatrixPyramidTileGraphicsPrimitives(chartViewingType,
+                                                            level,
+                                                            tileRow,
+                                                            firstTileColumn,
+                                                            lastTileColumn,
+                                                            tilePrimitives);
+        for (auto tilePrimitive : tilePrimitives) {
+            drawPrimitivePrivate(tilePrimitive);
+        }
+    }
+    
+    glDisable(GL_BLEND);
+    glPopMatrix();
+}
+
 /**
  * Save the state of OpenGL.
  * Copied from Qt's qgl.cpp, qt_save_gl_state().
@@ -235,6 +235,11 @@ namespace caret {
                                     const float zooming,
                                     std::vector<MatrixRowColumnHighight*>& rowColumnHighlightingOut);
         
+        void drawMatrixChartContentPyramid(const ChartableTwoFileMatrixChart* matrixChart,
+                                           const ChartTwoMatrixTriangularViewingModeEnum::Enum chartViewingType,
+                                           const float cellWidth,
+                                           const float cellHeight);
+        
         void drawHistogramOrLineSeriesChart(const ChartTwoDataTypeEnum::Enum chartDataType);
         
         void drawChartGraphicsBoxAndSetViewport(const float vpX,
@@ -61,6 +61,7 @@
 #include "CaretLogger.h"
 #include "CaretMappableDataFile.h"
 #include "CaretPreferences.h"
+#include "CaretTriangleLocator.h"
 #include "ChartableMatrixInterface.h"
 #include "ChartableMatrixSeriesInterface.h"
 #include "ChartModelDataSeries.h"
@@ -102,6 +103,7 @@
 #include "GraphicsEngineDataOpenGL.h"
 #include "GraphicsPrimitiveV3fC4ub.h"
 #include "GraphicsPrimitiveV3f.h"
+#include "GraphicsPrimitiveV3fN3fC4f.h"
 #include "GraphicsShape.h"
 #include "GroupAndNameHierarchyModel.h"
 #include "IdentifiedItemNode.h"
@@ -2020,51 +2022,68 @@ BrainOpenGLFixedPipeline::drawSurfaceTriangles(Surface* surface,
             break;
     }
     
+    /*
+     * Identification first tries a ray cast through the surface's
+     * bounding volume hierarchy, which avoids drawing the triangles
+     * in identification colors and reading back the frame buffer.
+     */
+    bool isRayCast = false;
+    int32_t triangleIndex = -1;
+    float depth = -1.0;
     if (isSelect) {
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        int32_t nearestNodeIndex = -1;
+        isRayCast = getSurfaceItemUnderMouseWithRayCast(surface,
+                                                        triangleIndex,
+                                                        nearestNodeIndex,
+                                                        depth);
+        if ( ! isRayCast) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
     }
     
-    uint8_t rgba[4];
-    
-    glBegin(GL_TRIANGLES);
-    for (int32_t i = 0; i < numTriangles; i++) {
-        const int32_t i3 = i * 3;
-        const int32_t n1 = triangles[i3];
-        const int32_t n2 = triangles[i3+1];
-        const int32_t n3 = triangles[i3+2];
+    if ( ! isRayCast) {
+        uint8_t rgba[4];
         
-        if (isSelect) {
-            this->colorIdentification->addItem(rgba, SelectionItemDataTypeEnum::SURFACE_TRIANGLE, i);
-            glColor3ubv(rgba);
-            glNormal3fv(&normals[n1*3]);
-            glVertex3fv(&coordinates[n1*3]);
-            glNormal3fv(&normals[n2*3]);
-            glVertex3fv(&coordinates[n2*3]);
-            glNormal3fv(&normals[n3*3]);
-            glVertex3fv(&coordinates[n3*3]);
-        }
-        else {
-            glColor4fv(&nodeColoringRGBA[n1*4]);
-            glNormal3fv(&normals[n1*3]);
-            glVertex3fv(&coordinates[n1*3]);
-            glColor4fv(&nodeColoringRGBA[n2*4]);
-            glNormal3fv(&normals[n2*3]);
-            glVertex3fv(&coordinates[n2*3]);
-            glColor4fv(&nodeColoringRGBA[n3*4]);
-            glNormal3fv(&normals[n3*3]);
-            glVertex3fv(&coordinates[n3*3]);
+        glBegin(GL_TRIANGLES);
+        for (int32_t i = 0; i < numTriangles; i++) {
+            const int32_t i3 = i * 3;
+            const int32_t n1 = triangles[i3];
+            const int32_t n2 = triangles[i3+1];
+            const int32_t n3 = triangles[i3+2];
+        
+            if (isSelect) {
+                this->colorIdentification->addItem(rgba, SelectionItemDataTypeEnum::SURFACE_TRIANGLE, i);
+                glColor3ubv(rgba);
+                glNormal3fv(&normals[n1*3]);
+                glVertex3fv(&coordinates[n1*3]);
+                glNormal3fv(&normals[n2*3]);
+                glVertex3fv(&coordinates[n2*3]);
+                glNormal3fv(&normals[n3*3]);
+                glVertex3fv(&coordinates[n3*3]);
+            }
+            else {
+                glColor4fv(&nodeColoringRGBA[n1*4]);
+                glNormal3fv(&normals[n1*3]);
+                glVertex3fv(&coordinates[n1*3]);
+                glColor4fv(&nodeColoringRGBA[n2*4]);
+                glNormal3fv(&normals[n2*3]);
+                glVertex3fv(&coordinates[n2*3]);
+                glColor4fv(&nodeColoringRGBA[n3*4]);
+                glNormal3fv(&normals[n3*3]);
+                glVertex3fv(&coordinates[n3*3]);
+            }
         }
+        glEnd();
     }
-    glEnd();
     
     if (isSelect) {
-        int32_t triangleIndex = -1;
-        float depth = -1.0;
-        this->getIndexFromColorSelection(SelectionItemDataTypeEnum::SURFACE_TRIANGLE, 
-                                         this->mouseX, 
-                                         this->mouseY,
-                                         triangleIndex,
-                                         depth);
+        if ( ! isRayCast) {
+            this->getIndexFromColorSelection(SelectionItemDataTypeEnum::SURFACE_TRIANGLE, 
+                                             this->mouseX, 
+                                             this->mouseY,
+                                             triangleIndex,
+                                             depth);
+        }
         
         
         if (triangleIndex >= 0) {
@@ -2352,7 +2371,6 @@ BrainOpenGLFixedPipeline::drawSurfaceNodes(Surface* surface,
         case MODE_IDENTIFICATION:
             if (nodeID->isEnabledForSelection()) {
                 isSelect = true;
-                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);            
             }
             else {
                 return;
@@ -2362,42 +2380,62 @@ BrainOpenGLFixedPipeline::drawSurfaceNodes(Surface* surface,
             break;
     }
     
-    uint8_t rgba[4];
-
-    float pointSize = dps->getNodeSize();
+    /*
+     * Identification first tries a ray cast, the vertex of the
+     * triangle under the mouse that is nearest the mouse is selected.
+     */
+    bool isRayCast = false;
+    int32_t nodeIndex = -1;
+    float depth = -1.0;
     if (isSelect) {
-        if (pointSize < 2.0) {
-            pointSize = 2.0;
+        int32_t triangleIndex = -1;
+        isRayCast = getSurfaceItemUnderMouseWithRayCast(surface,
+                                                        triangleIndex,
+                                                        nodeIndex,
+                                                        depth);
+        if ( ! isRayCast) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         }
     }
-    setPointSize(pointSize);
     
-    glBegin(GL_POINTS);
-    for (int32_t i = 0; i < numNodes; i++) {
-        const int32_t i3 = i * 3;
+    if ( ! isRayCast) {
+        uint8_t rgba[4];
         
+        float pointSize = dps->getNodeSize();
         if (isSelect) {
-            this->colorIdentification->addItem(rgba, SelectionItemDataTypeEnum::SURFACE_NODE, i);
-            glColor3ubv(rgba);
-            glNormal3fv(&normals[i3]);
-            glVertex3fv(&coordinates[i3]);
+            if (pointSize < 2.0) {
+                pointSize = 2.0;
+            }
         }
-        else {
-            glColor4fv(&nodeColoringRGBA[i*4]);
-            glNormal3fv(&normals[i3]);
-            glVertex3fv(&coordinates[i3]);
+        setPointSize(pointSize);
+    
+        glBegin(GL_POINTS);
+        for (int32_t i = 0; i < numNodes; i++) {
+            const int32_t i3 = i * 3;
+        
+            if (isSelect) {
+                this->colorIdentification->addItem(rgba, SelectionItemDataTypeEnum::SURFACE_NODE, i);
+                glColor3ubv(rgba);
+                glNormal3fv(&normals[i3]);
+                glVertex3fv(&coordinates[i3]);
+            }
+            else {
+                glColor4fv(&nodeColoringRGBA[i*4]);
+                glNormal3fv(&normals[i3]);
+                glVertex3fv(&coordinates[i3]);
+            }
         }
+        glEnd();
     }
-    glEnd();
     
     if (isSelect) {
-        int nodeIndex = -1;
-        float depth = -1.0;
-        this->getIndexFromColorSelection(SelectionItemDataTypeEnum::SURFACE_NODE, 
-                                         this->mouseX, 
-                                         this->mouseY,
-                                         nodeIndex,
-                                         depth);
+        if ( ! isRayCast) {
+            this->getIndexFromColorSelection(SelectionItemDataTypeEnum::SURFACE_NODE, 
+                                             this->mouseX, 
+                                             this->mouseY,
+                                             nodeIndex,
+                                             depth);
+        }
         if (nodeIndex >= 0) {
             if (nodeID->isOtherScreenDepthCloserToViewer(depth)) {
                 nodeID->setBrain(surface->getBrainStructure()->getBrain());
@@ -2417,6 +2455,12 @@ BrainOpenGLFixedPipeline::drawSurfaceNodes(Surface* surface,
 
 /**
  * Draw a surface triangles with vertex arrays.
+ *
+ * When there is coloring, the surface's graphics primitive is drawn.  Its
+ * coordinates, normal vectors, and triangles stay in OpenGL buffers and
+ * only the coloring is reloaded, when it changes.  Without coloring (the
+ * background fill when drawing links), client-side arrays are used.
+ *
  * @param surface
  *    Surface that is drawn.
  * @param nodeColoringRGBA
@@ -2426,6 +2470,14 @@ void
 BrainOpenGLFixedPipeline::drawSurfaceTrianglesWithVertexArrays(const Surface* surface,
                                                                const float* nodeColoringRGBA)
 {
+    if (nodeColoringRGBA != NULL) {
+        GraphicsPrimitiveV3fN3fC4f* trianglesPrimitive = surface->getTrianglesGraphicsPrimitive(nodeColoringRGBA);
+        if (trianglesPrimitive != NULL) {
+            GraphicsEngineDataOpenGL::draw(trianglesPrimitive);
+            return;
+        }
+    }
+    
     glEnableClientState(GL_VERTEX_ARRAY);
     if (nodeColoringRGBA != NULL) {
         glEnableClientState(GL_COLOR_ARRAY);
@@ -5836,6 +5888,160 @@ BrainOpenGLFixedPipeline::getIndexFromColorSelection(SelectionItemDataTypeEnum::
     glPopClientAttrib();
 }
 
+/**
+ * Find the surface triangle and vertex under the mouse by casting a ray
+ * through the mouse position with the current viewing transformations.
+ * The ray is tested against the surface's bounding volume hierarchy,
+ * so nothing is drawn and the frame buffer is not read.
+ *
+ * @param surface
+ *    Surface that is tested.
+ * @param triangleIndexOut
+ *    Output with index of the triangle under the mouse, -1 if none.
+ * @param nearestNodeIndexOut
+ *    Output with the triangle's vertex nearest the mouse, -1 if none.
+ * @param depthOut
+ *    Output with the screen depth of the point under the mouse.
+ * @return
+ *    True if the ray cast was performed, even when nothing is under the
+ *    mouse.  False if color identification must be used instead, such
+ *    as when clipping planes are enabled, since the closest triangle
+ *    on the ray may be clipped.
+ */
+bool
+BrainOpenGLFixedPipeline::getSurfaceItemUnderMouseWithRayCast(const Surface* surface,
+                                                              int32_t& triangleIndexOut,
+                                                              int32_t& nearestNodeIndexOut,
+                                                              float& depthOut)
+{
+    triangleIndexOut = -1;
+    nearestNodeIndexOut = -1;
+    depthOut = -1.0;
+    
+    for (int32_t i = 0; i < 6; i++) {
+        if (glIsEnabled(GL_CLIP_PLANE0 + i)) {
+            return false;
+        }
+    }
+    
+    GLdouble modelviewMatrix[16];
+    glGetDoublev(GL_MODELVIEW_MATRIX, modelviewMatrix);
+    
+    GLdouble projectionMatrix[16];
+    glGetDoublev(GL_PROJECTION_MATRIX, projectionMatrix);
+    
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    
+    if ((this->mouseX < viewport[0])
+        || (this->mouseX >= (viewport[0] + viewport[2]))
+        || (this->mouseY < viewport[1])
+        || (this->mouseY >= (viewport[1] + viewport[3]))) {
+        return true;
+    }
+    
+    /*
+     * Ray from the near clipping plane to the far clipping plane
+     */
+    double nearXYZ[3];
+    double farXYZ[3];
+    if ( ! (gluUnProject(this->mouseX,
+                         this->mouseY,
+                         0.0,
+                         modelviewMatrix,
+                         projectionMatrix,
+                         viewport,
+                         &nearXYZ[0],
+                         &nearXYZ[1],
+                         &nearXYZ[2])
+            && gluUnProject(this->mouseX,
+                            this->mouseY,
+                            1.0,
+                            modelviewMatrix,
+                            projectionMatrix,
+                            viewport,
+                            &farXYZ[0],
+                            &farXYZ[1],
+                            &farXYZ[2]))) {
+        return false;
+    }
+    
+    const float rayOrigin[3] = {
+        (float)nearXYZ[0],
+        (float)nearXYZ[1],
+        (float)nearXYZ[2]
+    };
+    const float rayDirection[3] = {
+        (float)(farXYZ[0] - nearXYZ[0]),
+        (float)(farXYZ[1] - nearXYZ[1]),
+        (float)(farXYZ[2] - nearXYZ[2])
+    };
+    
+    CaretPointer<const CaretTriangleLocator> triangleLocator = surface->getTriangleLocator();
+    float rayDistance = 0.0;
+    const int64_t triangleIndex = triangleLocator->closestRayHit(rayOrigin,
+                                                                 rayDirection,
+                                                                 &rayDistance);
+    if ((triangleIndex < 0)
+        || (rayDistance > 1.0)) {
+        /*
+         * Nothing hit or hit is beyond the far clipping plane
+         */
+        return true;
+    }
+    
+    const double hitXYZ[3] = {
+        rayOrigin[0] + rayDirection[0] * rayDistance,
+        rayOrigin[1] + rayDirection[1] * rayDistance,
+        rayOrigin[2] + rayDirection[2] * rayDistance
+    };
+    double hitWindowXYZ[3];
+    if ( ! gluProject(hitXYZ[0],
+                      hitXYZ[1],
+                      hitXYZ[2],
+                      modelviewMatrix,
+                      projectionMatrix,
+                      viewport,
+                      &hitWindowXYZ[0],
+                      &hitWindowXYZ[1],
+                      &hitWindowXYZ[2])) {
+        return false;
+    }
+    
+    /*
+     * Vertex of the triangle that is nearest the mouse on the screen
+     */
+    const int32_t* triangleNodes = surface->getTriangle(triangleIndex);
+    double nearestDistance = std::numeric_limits<double>::max();
+    for (int32_t i = 0; i < 3; i++) {
+        const float* xyz = surface->getCoordinate(triangleNodes[i]);
+        double windowXYZ[3];
+        if (gluProject(xyz[0],
+                       xyz[1],
+                       xyz[2],
+                       modelviewMatrix,
+                       projectionMatrix,
+                       viewport,
+                       &windowXYZ[0],
+                       &windowXYZ[1],
+                       &windowXYZ[2])) {
+            const double dist = MathFunctions::distanceSquared2D(windowXYZ[0],
+                                                                 windowXYZ[1],
+                                                                 this->mouseX,
+                                                                 this->mouseY);
+            if (dist < nearestDistance) {
+                nearestDistance = dist;
+                nearestNodeIndexOut = triangleNodes[i];
+            }
+        }
+    }
+    
+    triangleIndexOut = static_cast<int32_t>(triangleIndex);
+    depthOut = static_cast<float>(hitWindowXYZ[2]);
+    
+    return true;
+}
+
 /**
  * Analyze color information to extract identification data.
  * @param dataType
@@ -350,6 +350,11 @@ namespace caret {
                                            int32_t& indexOut,
                                            float& depthOut);
         
+        bool getSurfaceItemUnderMouseWithRayCast(const Surface* surface,
+                                                 int32_t& triangleIndexOut,
+                                                 int32_t& nearestNodeIndexOut,
+                                                 float& depthOut);
+        
         void getIndexFromColorSelection(const SelectionItemDataTypeEnum::Enum dataType,
                                         const int32_t x,
                                         const int32_t y,
@@ -44,12 +44,15 @@
 #include "DisplayPropertiesFoci.h"
 #include "DisplayPropertiesLabels.h"
 #include "ElapsedTimer.h"
+#include "EventGraphicsOpenGLCreateTextureName.h"
+#include "EventManager.h"
 #include "FociFile.h"
 #include "Focus.h"
 #include "GapsAndMargins.h"
 #include "GiftiLabel.h"
 #include "GiftiLabelTable.h"
 #include "GraphicsEngineDataOpenGL.h"
+#include "GraphicsOpenGLTextureName.h"
 #include "GraphicsPrimitiveV3fC4f.h"
 #include "GraphicsUtilitiesOpenGL.h"
 #include "GroupAndNameHierarchyModel.h"
@@ -3743,6 +3746,26 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceVoxels(const float sliceNormal
         }
     }
     
+    /*
+     * Except when identifying voxels, the slice is drawn as one quad
+     * textured with the slice's coloring.
+     */
+    if (s_sliceTextureDrawingEnabled
+        && ( ! m_identificationModeFlag)) {
+        if (drawOrthogonalSliceVoxelsTexture(sliceNormalVector,
+                                             coordinate,
+                                             rowStep,
+                                             columnStep,
+                                             numberOfColumns,
+                                             numberOfRows,
+                                             sliceRGBA,
+                                             volumeInterface,
+                                             mapIndex,
+                                             sliceOpacity)) {
+            return;
+        }
+    }
+    
     /*
      * There are two ways to draw the voxels.
      *
@@ -3818,6 +3841,261 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceVoxels(const float sliceNormal
     
 }
 
+/**
+ * Enable/disable drawing volume slices as textured quads.  When disabled,
+ * quads are drawn for each voxel.
+ *
+ * @param enabled
+ *     New status.
+ */
+void
+BrainOpenGLVolumeSliceDrawing::setSliceTextureDrawingEnabled(const bool enabled)
+{
+    s_sliceTextureDrawingEnabled = enabled;
+}
+
+/**
+ * @return Are volume slices drawn as textured quads?
+ */
+bool
+BrainOpenGLVolumeSliceDrawing::isSliceTextureDrawingEnabled()
+{
+    return s_sliceTextureDrawingEnabled;
+}
+
+/**
+ * Draw the voxels in an orthogonal slice as one quad with a texture
+ * containing the coloring of the voxels.  The cost of redrawing the
+ * slice does not depend upon the number of voxels when the slice's
+ * coloring has not changed.
+ *
+ * @param sliceNormalVector
+ *    Normal vector of the slice plane.
+ * @param coordinate
+ *    Coordinate of first voxel in the slice (bottom left as begin viewed)
+ * @param rowStep
+ *    Three-dimensional step to next row.
+ * @param columnStep
+ *    Three-dimensional step to next column.
+ * @param numberOfColumns
+ *    Number of columns in the slice.
+ * @param numberOfRows
+ *    Number of rows in the slice.
+ * @param sliceRGBA
+ *    RGBA coloring for voxels in the slice.
+ * @param volumeInterface
+ *    Volume being drawn.
+ * @param mapIndex
+ *    Map index of the volume being drawn.
+ * @param sliceOpacity
+ *    Opacity from the overlay.
+ * @return
+ *    True if the slice was drawn, false if the slice is too large
+ *    for a texture or a texture could not be created.
+ */
+bool
+BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceVoxelsTexture(const float sliceNormalVector[3],
+                                                                const float coordinate[3],
+                                                                const float rowStep[3],
+                                                                const float columnStep[3],
+                                                                const int64_t numberOfColumns,
+                                                                const int64_t numberOfRows,
+                                                                const std::vector<uint8_t>& sliceRGBA,
+                                                                const VolumeMappableInterface* volumeInterface,
+                                                                const int32_t mapIndex,
+                                                                const uint8_t sliceOpacity)
+{
+    if ((numberOfColumns <= 0)
+        || (numberOfRows <= 0)) {
+        return true;
+    }
+    
+    GLint maximumTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE,
+                  &maximumTextureSize);
+    if ((numberOfColumns > maximumTextureSize)
+        || (numberOfRows > maximumTextureSize)) {
+        return false;
+    }
+    
+    /*
+     * Texel order is the same as the slice's voxels (column
+     * changes fastest).  Voxels that are displayed use the
+     * overlay's opacity, others are transparent.
+     */
+    const int64_t numberOfVoxels = numberOfColumns * numberOfRows;
+    CaretAssert(static_cast<int64_t>(sliceRGBA.size()) >= (numberOfVoxels * 4));
+    m_sliceTextureRGBA.assign(numberOfVoxels * 4, 0);
+    for (int64_t i = 0; i < numberOfVoxels; i++) {
+        const int64_t i4 = i * 4;
+        if (sliceRGBA[i4 + 3] > 0) {
+            m_sliceTextureRGBA[i4]     = sliceRGBA[i4];
+            m_sliceTextureRGBA[i4 + 1] = sliceRGBA[i4 + 1];
+            m_sliceTextureRGBA[i4 + 2] = sliceRGBA[i4 + 2];
+            m_sliceTextureRGBA[i4 + 3] = sliceOpacity;
+        }
+    }
+    
+    const SliceTextureKey key(m_fixedPipelineDrawing->getContextSharingGroupPointer(),
+                              volumeInterface,
+                              mapIndex,
+                              m_tabIndex,
+                              numberOfColumns,
+                              numberOfRows,
+                              {{ coordinate[0], coordinate[1], coordinate[2],
+                                  sliceNormalVector[0], sliceNormalVector[1], sliceNormalVector[2] }});
+    const GLuint textureName = getSliceTexture(key,
+                                               numberOfColumns,
+                                               numberOfRows);
+    if (textureName == 0) {
+        return false;
+    }
+    
+    /*
+     * Corners of the slice
+     */
+    const float bottomLeft[3] = {
+        coordinate[0],
+        coordinate[1],
+        coordinate[2]
+    };
+    const float bottomRight[3] = {
+        bottomLeft[0] + (numberOfColumns * columnStep[0]),
+        bottomLeft[1] + (numberOfColumns * columnStep[1]),
+        bottomLeft[2] + (numberOfColumns * columnStep[2])
+    };
+    const float topLeft[3] = {
+        bottomLeft[0] + (numberOfRows * rowStep[0]),
+        bottomLeft[1] + (numberOfRows * rowStep[1]),
+        bottomLeft[2] + (numberOfRows * rowStep[2])
+    };
+    const float topRight[3] = {
+        bottomRight[0] + (numberOfRows * rowStep[0]),
+        bottomRight[1] + (numberOfRows * rowStep[1]),
+        bottomRight[2] + (numberOfRows * rowStep[2])
+    };
+    
+    glPushAttrib(GL_ENABLE_BIT
+                 | GL_TEXTURE_BIT
+                 | GL_COLOR_BUFFER_BIT);
+    
+    /*
+     * Transparent texels must not change the depth buffer so
+     * that lower layers are still drawn where voxels are not displayed.
+     */
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.0);
+    
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, textureName);
+    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    
+    glBegin(GL_QUADS);
+    glNormal3fv(sliceNormalVector);
+    glTexCoord2f(0.0, 0.0);
+    glVertex3fv(bottomLeft);
+    glTexCoord2f(1.0, 0.0);
+    glVertex3fv(bottomRight);
+    glTexCoord2f(1.0, 1.0);
+    glVertex3fv(topRight);
+    glTexCoord2f(0.0, 1.0);
+    glVertex3fv(topLeft);
+    glEnd();
+    
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPopAttrib();
+    
+    return true;
+}
+
+/**
+ * Get the texture for a slice containing the texels in m_sliceTextureRGBA.
+ * The slice's texture is found with its key and is only loaded again when
+ * the slice's coloring has changed.  Coloring depends upon palettes, label
+ * selection in the tab, thresholding with other volumes, etc., so the
+ * texels of the slice's texture are compared, which costs the same as
+ * copying the slice's coloring once.  When a new texture is needed and
+ * there are too many textures, the least recently used texture is deleted.
+ *
+ * @param key
+ *    Identifies the slice.
+ * @param numberOfColumns
+ *    Width of the texture.
+ * @param numberOfRows
+ *    Height of the texture.
+ * @return
+ *    OpenGL name of the texture or zero if a texture could not be created.
+ */
+GLuint
+BrainOpenGLVolumeSliceDrawing::getSliceTexture(const SliceTextureKey& key,
+                                               const int64_t numberOfColumns,
+                                               const int64_t numberOfRows)
+{
+    SliceTexture* sliceTexture = NULL;
+    auto iter = s_sliceTextures.find(key);
+    if (iter != s_sliceTextures.end()) {
+        sliceTexture = iter->second;
+        sliceTexture->m_lastUsed = ++s_sliceTextureUseCounter;
+        if (sliceTexture->m_textureRGBA == m_sliceTextureRGBA) {
+            return sliceTexture->m_textureName->getTextureName();
+        }
+    }
+    else {
+        if (static_cast<int32_t>(s_sliceTextures.size()) >= MAXIMUM_NUMBER_OF_SLICE_TEXTURES) {
+            auto oldestIter = s_sliceTextures.begin();
+            for (auto stIter = s_sliceTextures.begin(); stIter != s_sliceTextures.end(); stIter++) {
+                if (stIter->second->m_lastUsed < oldestIter->second->m_lastUsed) {
+                    oldestIter = stIter;
+                }
+            }
+            delete oldestIter->second->m_textureName;
+            delete oldestIter->second;
+            s_sliceTextures.erase(oldestIter);
+        }
+        
+        EventGraphicsOpenGLCreateTextureName createEvent;
+        EventManager::get()->sendEvent(createEvent.getPointer());
+        if (createEvent.getOpenGLTextureName() == NULL) {
+            return 0;
+        }
+        sliceTexture = new SliceTexture();
+        sliceTexture->m_textureName = createEvent.getOpenGLTextureName();
+        sliceTexture->m_lastUsed    = ++s_sliceTextureUseCounter;
+        s_sliceTextures.insert(std::make_pair(key, sliceTexture));
+    }
+    CaretAssert(sliceTexture);
+    
+    sliceTexture->m_textureRGBA = m_sliceTextureRGBA;
+    
+    const GLuint textureName = sliceTexture->m_textureName->getTextureName();
+    
+    glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    
+    /*
+     * Nearest filtering so that voxels are drawn as solid squares
+     */
+    glBindTexture(GL_TEXTURE_2D, textureName);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D,     // MUST BE GL_TEXTURE_2D
+                 0,                 // level of detail 0=base, n is nth mipmap reduction
+                 GL_RGBA,           // number of components
+                 numberOfColumns,   // width of image
+                 numberOfRows,      // height of image
+                 0,                 // border
+                 GL_RGBA,           // format of the pixel data
+                 GL_UNSIGNED_BYTE,  // data type of pixel data
+                 &sliceTexture->m_textureRGBA[0]);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    
+    glPopClientAttrib();
+    
+    return textureName;
+}
+
 /**
  * Draw the voxels in an orthogonal slice with single quads.
  *
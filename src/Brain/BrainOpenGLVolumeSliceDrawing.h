@@ -21,6 +21,10 @@
  */
 /*LICENSE_END*/
 
+#include <array>
+#include <map>
+#include <tuple>
+
 #include "BrainOpenGLFixedPipeline.h"
 #include "CaretObject.h"
 #include "DisplayGroupEnum.h"
@@ -36,6 +40,7 @@ namespace caret {
     class Brain;
     class BrowserTabContent;
     class CiftiMappableDataFile;
+    class GraphicsOpenGLTextureName;
     class Matrix4x4;
     class ModelVolume;
     class ModelWholeBrain;
@@ -57,6 +62,10 @@ namespace caret {
                   const VolumeSliceProjectionTypeEnum::Enum sliceProjectionType,
                   const int32_t viewport[4]);
         
+        static void setSliceTextureDrawingEnabled(const bool enabled);
+        
+        static bool isSliceTextureDrawingEnabled();
+        
         // ADD_NEW_METHODS_HERE
         
     private:
@@ -179,6 +188,30 @@ namespace caret {
             std::vector<int64_t> m_sliceOffsets;
         };
         
+        /**
+         * A slice's coloring loaded into an OpenGL texture.  Textures are kept
+         * between redraws so that a slice whose coloring has not changed
+         * (panning, zooming, montage, other windows) is not loaded again.
+         * The least recently used texture is deleted when there are too many.
+         */
+        class SliceTexture {
+        public:
+            SliceTexture() { }
+            
+            /** RGBA of the texture's texels, compared with the slice's current texels to find a change in coloring */
+            std::vector<uint8_t> m_textureRGBA;
+            
+            GraphicsOpenGLTextureName* m_textureName = NULL;
+            
+            int64_t m_lastUsed = 0;
+        };
+        
+        /**
+         * Key is OpenGL context, volume, map, tab, number of columns and rows, and the
+         * coordinate of the first voxel and the normal vector, which identify the slice
+         */
+        typedef std::tuple<void*, const VolumeMappableInterface*, int32_t, int32_t, int64_t, int64_t, std::array<float, 6>> SliceTextureKey;
+        
         BrainOpenGLVolumeSliceDrawing(const BrainOpenGLVolumeSliceDrawing&);
         
         BrainOpenGLVolumeSliceDrawing& operator=(const BrainOpenGLVolumeSliceDrawing&);
@@ -306,6 +339,21 @@ namespace caret {
                                                   const int32_t mapIndex,
                                                   const uint8_t sliceOpacity);
         
+        bool drawOrthogonalSliceVoxelsTexture(const float sliceNormalVector[3],
+                                              const float coordinate[3],
+                                              const float rowStep[3],
+                                              const float columnStep[3],
+                                              const int64_t numberOfColumns,
+                                              const int64_t numberOfRows,
+                                              const std::vector<uint8_t>& sliceRGBA,
+                                              const VolumeMappableInterface* volumeInterface,
+                                              const int32_t mapIndex,
+                                              const uint8_t sliceOpacity);
+        
+        GLuint getSliceTexture(const SliceTextureKey& key,
+                               const int64_t numberOfColumns,
+                               const int64_t numberOfRows);
+        
         void drawOrthogonalSliceVoxelsQuadIndicesAndStrips(const float sliceNormalVector[3],
                                                            const float coordinate[3],
                                                            const float rowStep[3],
@@ -374,12 +422,23 @@ namespace caret {
         
         double m_orthographicBounds[6];
         
+        /** Texels of the slice being drawn with a texture, kept to avoid allocating for each slice */
+        std::vector<uint8_t> m_sliceTextureRGBA;
+        
         std::vector<int32_t> m_identificationIndices;
         
         bool m_identificationModeFlag;
         
         static const int32_t IDENTIFICATION_INDICES_PER_VOXEL;
         
+        static const int32_t MAXIMUM_NUMBER_OF_SLICE_TEXTURES;
+        
+        static std::map<SliceTextureKey, SliceTexture*> s_sliceTextures;
+        
+        static int64_t s_sliceTextureUseCounter;
+        
+        static bool s_sliceTextureDrawingEnabled;
+        
         friend class BrainOpenGLVolumeObliqueSliceDrawing;
         
         // ADD_NEW_MEMBERS_HERE
@@ -387,6 +446,10 @@ namespace caret {
     
 #ifdef __BRAIN_OPEN_GL_VOLUME_SLICE_DRAWING_DECLARE__
     const int32_t BrainOpenGLVolumeSliceDrawing::IDENTIFICATION_INDICES_PER_VOXEL = 8;
+    const int32_t BrainOpenGLVolumeSliceDrawing::MAXIMUM_NUMBER_OF_SLICE_TEXTURES = 128;
+    std::map<BrainOpenGLVolumeSliceDrawing::SliceTextureKey, BrainOpenGLVolumeSliceDrawing::SliceTexture*> BrainOpenGLVolumeSliceDrawing::s_sliceTextures;
+    int64_t BrainOpenGLVolumeSliceDrawing::s_sliceTextureUseCounter = 0;
+    bool BrainOpenGLVolumeSliceDrawing::s_sliceTextureDrawingEnabled = true;
 #endif // __BRAIN_OPEN_GL_VOLUME_SLICE_DRAWING_DECLARE__
     
 } // namespace
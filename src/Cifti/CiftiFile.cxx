@@ -24,28 +24,51 @@
 #include "CaretAssert.h"
 #include "CaretHttpManager.h"
 #include "CaretLogger.h"
+#include "CaretMutex.h"
+#include "CiftiTileFile.h"
 #include "DataFileException.h"
 #include "FileInformation.h"
 #include "MultiDimArray.h"
 #include "MultiDimIterator.h"
 #include "NiftiIO.h"
 
+#include <algorithm>
+
 using namespace std;
 using namespace caret;
 
 //private implementation classes
 namespace
 {
+    const int64_t COLUMN_TILE_WIDTH = 64;//columns per tile, a tile is filled with one small read per row
+    const int64_t COLUMN_TILE_MEMORY = 256 * 1024 * 1024;//bytes of column tiles to keep per file, at least one tile is always kept
+    const int SYMMETRY_ROWS = 8;//full rows to read when checking whether a matrix is symmetric
+    const int SYMMETRY_SAMPLES_PER_ROW = 16;//nonzero values per row to compare against their transposed element
+    const int SYMMETRY_MIN_NONZERO = 32;//sparse matrices can match on zeros alone, so require this many nonzero pairs before treating a matrix as symmetric
+    
     class CiftiOnDiskImpl : public CiftiFile::WriteImplInterface
     {
+        struct ColumnTile
+        {
+            int64_t m_start, m_width, m_lastUsed;
+            vector<float> m_data;//row-major, m_width values per row
+        };
         mutable NiftiIO m_nifti;//because file objects aren't stateless (current position), so reading "changes" them
         CiftiXML m_xml;//because we need to parse it to set up the dimensions anyway
+        mutable CaretMutex m_columnMutex;//protects the tiles and the symmetry state
+        mutable vector<ColumnTile> m_columnTiles;
+        mutable int64_t m_columnTileCounter;
+        mutable int m_symmetricState;//-1 for not checked yet
+        CiftiTileFile m_tiles;//only opened when a valid sidecar exists
+        void invalidateColumnCache();
     public:
-        CiftiOnDiskImpl(const QString& filename);//read-only
+        CiftiOnDiskImpl(const QString& filename);//read-only, memory mapped when possible
         CiftiOnDiskImpl(const QString& filename, const CiftiXML& xml, const CiftiVersion& version, const bool& swapEndian,
                         const int16_t& datatype, const bool& rescale, const double& minval, const double& maxval);//make new empty file with read/write
         void getRow(float* dataOut, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead) const;
         void getColumn(float* dataOut, const int64_t& index) const;
+        void getRows(float* dataOut, const int64_t& firstRow, const int64_t& numRows, const int64_t& rowLength) const;
+        bool isSymmetric() const;
         const CiftiXML& getCiftiXML() const { return m_xml; }
         QString getFilename() const { return m_nifti.getFilename(); }
         bool isSwapped() const { return m_nifti.getHeader().isSwapped(); }
@@ -110,6 +133,7 @@ CiftiFile::WriteImplInterface::~WriteImplInterface()
 CiftiFile::CiftiFile(const QString& fileName)
 {
     m_endianPref = NATIVE;
+    m_symmetricColumnReading = false;
     setWritingDataTypeNoScaling();//default argument is float32
     openFile(fileName);
 }
@@ -254,9 +278,20 @@ void CiftiFile::getColumn(float* dataOut, const int64_t& index) const
     if (m_dims.empty()) throw DataFileException("getColumn called on uninitialized CiftiFile");
     if (m_dims.size() != 2) throw DataFileException("getColumn called on non-2D CiftiFile");
     if (m_readingImpl == NULL) return;//NOT an error because we are pretending to have a matrix already, while we are waiting for setRow to actually start writing the file
+    if (m_symmetricColumnReading && m_readingImpl->isSymmetric())
+    {
+        getRow(dataOut, index, false);//one sequential read instead of one per row
+        return;
+    }
     m_readingImpl->getColumn(dataOut, index);
 }
 
+bool CiftiFile::isSymmetric() const
+{
+    if (m_dims.size() != 2 || m_readingImpl == NULL) return false;
+    return m_readingImpl->isSymmetric();
+}
+
 void CiftiFile::setCiftiXML(const CiftiXML& xml, const bool useOldMetadata)
 {
     if (xml.getNumberOfDimensions() == 0) throw DataFileException("setCiftiXML called with 0-dimensional CiftiXML");
@@ -336,6 +371,25 @@ void CiftiFile::getRow(float* dataOut, const int64_t& index) const
     getRow(dataOut, index, false);//once CiftiInterface is gone, we can collapse this into a default value
 }
 
+void CiftiFile::getRows(float* dataOut, const int64_t& firstRow, const int64_t& numRows) const
+{
+    if (m_dims.empty()) throw DataFileException("getRows called on uninitialized CiftiFile");
+    if (m_dims.size() != 2) throw DataFileException("getRows called on non-2D CiftiFile");
+    if (firstRow < 0 || numRows < 0 || firstRow + numRows > m_dims[1]) throw DataFileException("getRows called with invalid row range");
+    if (m_readingImpl == NULL) return;//NOT an error because we are pretending to have a matrix already, while we are waiting for setRow to actually start writing the file
+    m_readingImpl->getRows(dataOut, firstRow, numRows, m_dims[0]);
+}
+
+void CiftiFile::ReadImplInterface::getRows(float* dataOut, const int64_t& firstRow, const int64_t& numRows, const int64_t& rowLength) const
+{
+    vector<int64_t> tempvec(1);
+    for (int64_t i = 0; i < numRows; ++i)
+    {
+        tempvec[0] = firstRow + i;
+        getRow(dataOut + i * rowLength, tempvec, false);
+    }
+}
+
 int64_t CiftiFile::getNumberOfRows() const
 {
     if (m_dims.empty()) throw DataFileException("getNumberOfRows called on uninitialized CiftiFile");
@@ -460,7 +514,9 @@ void CiftiMemoryImpl::setColumn(const float* dataIn, const int64_t& index)
 
 CiftiOnDiskImpl::CiftiOnDiskImpl(const QString& filename)
 {//opens existing file for reading
-    m_nifti.openRead(filename);//read-only, so we don't need write permission to read a cifti file
+    m_columnTileCounter = 0;
+    m_symmetricState = -1;
+    m_nifti.openRead(filename, true);//read-only, so we don't need write permission to read a cifti file, and we can memory map it (if uncompressed) to avoid seek/read calls and locking
     if (m_nifti.getNumComponents() != 1) throw DataFileException("complex or rgb datatype found in file '" + filename + "', these are not supported in cifti");
     const NiftiHeader& myHeader = m_nifti.getHeader();
     int numExts = (int)myHeader.m_extensions.size(), whichExt = -1;
@@ -514,6 +570,11 @@ CiftiOnDiskImpl::CiftiOnDiskImpl(const QString& filename)
             }
         }
     }
+    if (m_xml.getNumberOfDimensions() == 2)
+    {//a tiled sidecar made by -cifti-tile-sidecar makes getColumn read one small piece per tile row
+        m_tiles.open(CiftiTileFile::getSidecarFileName(filename), m_xml.getDimensionLength(CiftiXML::ALONG_COLUMN),
+                     m_xml.getDimensionLength(CiftiXML::ALONG_ROW), filename);
+    }
 }
 
 namespace
@@ -613,6 +674,8 @@ namespace
 CiftiOnDiskImpl::CiftiOnDiskImpl(const QString& filename, const CiftiXML& xml, const CiftiVersion& version, const bool& swapEndian,
                                  const int16_t& datatype, const bool& rescale, const double& minval, const double& maxval)
 {//starts writing new file
+    m_columnTileCounter = 0;
+    m_symmetricState = -1;
     warnForBadExtension(filename, xml);
     NiftiHeader outHeader;
     if (rescale)
@@ -669,23 +732,158 @@ void CiftiOnDiskImpl::getRow(float* dataOut, const vector<int64_t>& indexSelect,
     m_nifti.readData(dataOut, 5, indexSelect, tolerateShortRead);//5 means 4 reserved (space and time) plus the first cifti dimension
 }
 
+void CiftiOnDiskImpl::getRows(float* dataOut, const int64_t& firstRow, const int64_t& numRows, const int64_t&) const
+{
+    if (numRows < 1) return;
+    vector<int64_t> indexSelect(1, firstRow);
+    m_nifti.readDataRange(dataOut, 5, indexSelect, numRows);//one contiguous read, instead of one per row
+}
+
 void CiftiOnDiskImpl::getColumn(float* dataOut, const int64_t& index) const
 {
     CaretAssert(m_xml.getNumberOfDimensions() == 2);//otherwise this shouldn't be called
     CaretAssert(index >= 0 && index < m_xml.getDimensionLength(CiftiXML::ALONG_ROW));
-    CaretLogFine("getColumn called on CiftiOnDiskImpl, this will be slow");//generate logging messages at a low priority
-    vector<int64_t> indexSelect(2);
-    indexSelect[0] = index;
+    if (m_tiles.isOpen())
+    {
+        m_tiles.getColumn(dataOut, index);
+        return;
+    }
+    int64_t rowLength = m_xml.getDimensionLength(CiftiXML::ALONG_ROW);
     int64_t colLength = m_xml.getDimensionLength(CiftiXML::ALONG_COLUMN);
-    for (int64_t i = 0; i < colLength; ++i)//assume if they really want getColumn on disk, they don't want their pagecache obliterated, so read it 1 element at a time
+    int64_t tileStart = (index / COLUMN_TILE_WIDTH) * COLUMN_TILE_WIDTH;
+    CaretMutexLocker locked(&m_columnMutex);
+    int whichTile = -1;
+    for (int i = 0; i < (int)m_columnTiles.size(); ++i)
     {
-        indexSelect[1] = i;
-        m_nifti.readData(dataOut + i, 4, indexSelect);//4 means just the 4 reserved dimensions, so 1 element of the matrix
+        if (m_columnTiles[i].m_start == tileStart)
+        {
+            whichTile = i;
+            break;
+        }
     }
+    if (whichTile == -1)
+    {//assume if they really want getColumn on disk, they don't want their pagecache obliterated, so read only a narrow band of each row
+        //a band of COLUMN_TILE_WIDTH elements costs the same pages as 1 element, and then neighboring columns don't need to touch the file
+        CaretLogFine("reading column tile from CiftiOnDiskImpl, this will be slow");//generate logging messages at a low priority
+        ColumnTile newTile;
+        newTile.m_start = tileStart;
+        newTile.m_width = min(COLUMN_TILE_WIDTH, rowLength - tileStart);
+        newTile.m_data.resize(colLength * newTile.m_width);
+        vector<int64_t> indexSelect(2);
+        indexSelect[0] = tileStart;
+        for (int64_t i = 0; i < colLength; ++i)
+        {
+            indexSelect[1] = i;
+            m_nifti.readDataRange(newTile.m_data.data() + i * newTile.m_width, 4, indexSelect, newTile.m_width);//4 means just the 4 reserved dimensions, so a range of elements within one row
+        }
+        int64_t maxTiles = max(int64_t(1), COLUMN_TILE_MEMORY / (colLength * COLUMN_TILE_WIDTH * (int64_t)sizeof(float)));
+        if ((int64_t)m_columnTiles.size() < maxTiles)
+        {
+            m_columnTiles.push_back(ColumnTile());
+            whichTile = (int)m_columnTiles.size() - 1;
+        } else {
+            whichTile = 0;//replace the least recently used tile
+            for (int i = 1; i < (int)m_columnTiles.size(); ++i)
+            {
+                if (m_columnTiles[i].m_lastUsed < m_columnTiles[whichTile].m_lastUsed) whichTile = i;
+            }
+        }
+        m_columnTiles[whichTile].m_start = newTile.m_start;
+        m_columnTiles[whichTile].m_width = newTile.m_width;
+        m_columnTiles[whichTile].m_data.swap(newTile.m_data);
+    }
+    ColumnTile& myTile = m_columnTiles[whichTile];
+    myTile.m_lastUsed = ++m_columnTileCounter;
+    const float* tileData = myTile.m_data.data() + (index - tileStart);
+    for (int64_t i = 0; i < colLength; ++i)
+    {
+        dataOut[i] = tileData[i * myTile.m_width];
+    }
+}
+
+bool CiftiOnDiskImpl::isSymmetric() const
+{
+    CaretMutexLocker locked(&m_columnMutex);
+    if (m_symmetricState == -1)
+    {
+        m_symmetricState = 0;
+        const CiftiMappingType* rowMap = m_xml.getMap(CiftiXML::ALONG_ROW), *colMap = m_xml.getMap(CiftiXML::ALONG_COLUMN);
+        if (m_xml.getNumberOfDimensions() == 2 && rowMap != NULL && colMap != NULL && *rowMap == *colMap)
+        {//identical mappings are necessary, but not sufficient (for instance, a dconn of gradients), so also check some values
+            int64_t length = m_xml.getDimensionLength(CiftiXML::ALONG_ROW);
+            int numRows = (int)min((int64_t)SYMMETRY_ROWS, length);
+            uint32_t state = 1;//fixed seed so that the answer doesn't change between runs
+            vector<int64_t> rowIndices(numRows);
+            vector<vector<float> > rows(numRows, vector<float>(length));
+            vector<int64_t> indexSelect(1);
+            for (int i = 0; i < numRows; ++i)
+            {
+                state = state * 1664525u + 1013904223u;
+                rowIndices[i] = state % length;
+                indexSelect[0] = rowIndices[i];
+                m_nifti.readData(rows[i].data(), 5, indexSelect);
+            }
+            bool matches = true;
+            int nonzeroPairs = 0;
+            for (int i = 0; matches && i < numRows; ++i)
+            {
+                for (int j = i + 1; j < numRows; ++j)
+                {//pairs where both rows are in memory, zeros included
+                    float upper = rows[i][rowIndices[j]], lower = rows[j][rowIndices[i]];
+                    if (upper != lower && !(upper != upper && lower != lower))//NaN matches NaN
+                    {
+                        matches = false;
+                        break;
+                    }
+                    if (upper != 0.0f) ++nonzeroPairs;
+                }
+            }
+            indexSelect.resize(2);
+            for (int i = 0; matches && i < numRows; ++i)
+            {//nonzero values, spread across the row, against single elements of the transposed position
+                vector<int64_t> nonzeroCols;
+                for (int64_t j = 0; j < length; ++j)
+                {
+                    if (rows[i][j] != 0.0f && rows[i][j] == rows[i][j] && j != rowIndices[i]) nonzeroCols.push_back(j);
+                }
+                int64_t numNonzero = (int64_t)nonzeroCols.size();
+                int64_t numToCheck = min((int64_t)SYMMETRY_SAMPLES_PER_ROW, numNonzero);
+                for (int64_t k = 0; k < numToCheck; ++k)
+                {
+                    int64_t col = nonzeroCols[k * numNonzero / numToCheck];
+                    float transposed;
+                    indexSelect[0] = rowIndices[i];//element in row col, column rowIndices[i]
+                    indexSelect[1] = col;
+                    m_nifti.readData(&transposed, 4, indexSelect);
+                    if (transposed != rows[i][col])
+                    {
+                        matches = false;
+                        break;
+                    }
+                    ++nonzeroPairs;
+                }
+            }
+            if (nonzeroPairs < SYMMETRY_MIN_NONZERO)
+            {//not enough evidence, so use the column tiles, which are correct either way
+                CaretLogFine("too few nonzero values to establish symmetry, reading columns from tiles");
+                matches = false;
+            }
+            if (matches) m_symmetricState = 1;
+        }
+    }
+    return m_symmetricState == 1;
+}
+
+void CiftiOnDiskImpl::invalidateColumnCache()
+{
+    CaretMutexLocker locked(&m_columnMutex);
+    m_columnTiles.clear();
+    m_symmetricState = -1;
 }
 
 void CiftiOnDiskImpl::setRow(const float* dataIn, const vector<int64_t>& indexSelect)
 {
+    invalidateColumnCache();
     m_nifti.writeData(dataIn, 5, indexSelect);
 }
 
@@ -694,6 +892,7 @@ void CiftiOnDiskImpl::setColumn(const float* dataIn, const int64_t& index)
     CaretAssert(m_xml.getNumberOfDimensions() == 2);//otherwise this shouldn't be called
     CaretAssert(index >= 0 && index < m_xml.getDimensionLength(CiftiXML::ALONG_ROW));
     CaretLogFine("setColumn called on CiftiOnDiskImpl, this will be slow");//generate logging messages at a low priority
+    invalidateColumnCache();
     vector<int64_t> indexSelect(2);
     indexSelect[0] = index;
     int64_t colLength = m_xml.getDimensionLength(CiftiXML::ALONG_COLUMN);
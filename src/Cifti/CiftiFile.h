@@ -49,6 +49,7 @@ namespace caret
         CiftiFile()
         {
             m_endianPref = NATIVE;
+            m_symmetricColumnReading = false;
             setWritingDataTypeNoScaling();//default argument is float32
         }
         explicit CiftiFile(const QString &fileName);//calls openFile
@@ -69,6 +70,8 @@ namespace caret
             return MultiDimIterator<int64_t>(std::vector<int64_t>(m_dims.begin() + 1, m_dims.end()));
         }
         void getColumn(float* dataOut, const int64_t& index) const;//for 2D only, will be slow if on disk!
+        bool isSymmetric() const;//2D with identical mappings, and a deterministic sample of rows matches the transposed elements, including enough nonzero values - checked on first call
+        void setSymmetricColumnReading(const bool& allowed) { m_symmetricColumnReading = allowed; }//let getColumn return the matching row when isSymmetric(), for display use
         
         void setCiftiXML(const CiftiXML& xml, const bool useOldMetadata = true);
         void setCiftiXML(const CiftiXMLOld &xml, const bool useOldMetadata = true);//set xml from old implementation
@@ -81,6 +84,7 @@ namespace caret
         
         void getRow(float* dataOut, const int64_t& index, const bool& tolerateShortRead) const;//backwards compatibility for old CiftiFile/CiftiInterface
         void getRow(float* dataOut, const int64_t& index) const;
+        void getRows(float* dataOut, const int64_t& firstRow, const int64_t& numRows) const;//for 2D only, consecutive rows, one read when on disk
         int64_t getNumberOfRows() const;
         int64_t getNumberOfColumns() const;
         
@@ -91,7 +95,9 @@ namespace caret
         public:
             virtual void getRow(float* dataOut, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead) const = 0;
             virtual void getColumn(float* dataOut, const int64_t& index) const = 0;
+            virtual void getRows(float* dataOut, const int64_t& firstRow, const int64_t& numRows, const int64_t& rowLength) const;//default calls getRow for each row
             virtual bool isInMemory() const { return false; }
+            virtual bool isSymmetric() const { return false; }
             virtual ~ReadImplInterface();
         };
         //assume if you can write to it, you can also read from it
@@ -111,7 +117,7 @@ namespace caret
         //CiftiXML m_xml;//uncomment when we drop CiftiInterface
         CiftiVersion m_onDiskVersion;
         ENDIAN m_endianPref;
-        bool m_doWriteScaling;
+        bool m_doWriteScaling, m_symmetricColumnReading;
         int16_t m_writingDataType;
         double m_minScalingVal, m_maxScalingVal;
         
@@ -0,0 +1,353 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiMatrixPyramid.h"
+
+#include "CaretAssert.h"
+#include "CaretBinaryFile.h"
+#include "CaretLogger.h"
+#include "CaretOMP.h"
+#include "CiftiFile.h"
+#include "DataFileException.h"
+#include "MathFunctions.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace caret;
+using namespace std;
+
+const int64_t CiftiMatrixPyramid::TILE_SIZE = 256;
+const int64_t CiftiMatrixPyramid::DEFAULT_MAX_STORED_CELLS = 2048 * 2048;//about 64MB for all stored levels
+
+namespace
+{
+    const char PYRAMID_MAGIC[8] = { 'w', 'b', 'p', 'y', 'r', 'a', 'm', '\0' };
+    const int64_t PYRAMID_VERSION = 1;
+    const int64_t PYRAMID_HEADER_SIZE = 64;//magic, 7 int64 values
+
+    void combineValue(const float& minIn, const float& maxIn, const double& sumIn, const int64_t& countIn,
+                      float& minOut, float& maxOut, double& sumOut, int64_t& countOut)
+    {
+        if (countIn == 0) return;
+        if (countOut == 0)
+        {
+            minOut = minIn;
+            maxOut = maxIn;
+        } else {
+            if (minIn < minOut) minOut = minIn;
+            if (maxIn > maxOut) maxOut = maxIn;
+        }
+        sumOut += sumIn;
+        countOut += countIn;
+    }
+}
+
+QString CiftiMatrixPyramid::getSidecarFileName(const QString& ciftiFileName)
+{
+    return ciftiFileName + ".wbpyramid";
+}
+
+CiftiMatrixPyramid::CiftiMatrixPyramid()
+{
+    m_input = NULL;
+    m_numRows = 0;
+    m_numCols = 0;
+    m_firstStoredLevel = 0;
+    m_numLevels = 0;
+}
+
+void CiftiMatrixPyramid::setup(const CiftiFile* input, const int64_t& numRows, const int64_t& numCols)
+{
+    m_input = input;
+    m_numRows = numRows;
+    m_numCols = numCols;
+    m_storedLevels.clear();
+    m_numLevels = 1;
+    while (getLevelRows(m_numLevels - 1) > TILE_SIZE || getLevelColumns(m_numLevels - 1) > TILE_SIZE)
+    {
+        ++m_numLevels;
+    }
+}
+
+bool CiftiMatrixPyramid::build(const CiftiFile* input, const int64_t& maxStoredCells, BuildObserver* observer)
+{
+    CaretAssert(input != NULL);
+    const vector<int64_t>& dims = input->getDimensions();
+    if (dims.size() != 2) throw DataFileException("matrix pyramids can only be made from 2D cifti");
+    if (dims[0] < 1 || dims[1] < 1) throw DataFileException("matrix pyramids can't be made from an empty matrix");
+    setup(input, dims[1], dims[0]);
+    m_firstStoredLevel = 0;
+    while (m_firstStoredLevel < m_numLevels - 1 && getLevelRows(m_firstStoredLevel) * getLevelColumns(m_firstStoredLevel) > maxStoredCells)
+    {
+        ++m_firstStoredLevel;
+    }
+    m_storedLevels.resize(m_numLevels - m_firstStoredLevel);
+    const float NaN = numeric_limits<float>::quiet_NaN();
+    const int64_t blockSize = (int64_t)1 << m_firstStoredLevel;
+    int64_t levelRows = getLevelRows(m_firstStoredLevel), levelCols = getLevelColumns(m_firstStoredLevel);
+    for (int i = 0; i < 3; ++i)
+    {
+        m_storedLevels[0].m_values[i].resize(levelRows * levelCols);
+    }
+    vector<int64_t> counts(levelRows * levelCols);//numeric values in each block, to weight the means for coarser levels
+    vector<float> band(blockSize * m_numCols);
+    for (int64_t blockRow = 0; blockRow < levelRows; ++blockRow)
+    {
+        const int64_t firstRow = blockRow * blockSize, bandRows = min(blockSize, m_numRows - firstRow);
+        input->getRows(band.data(), firstRow, bandRows);//one read per band when on disk
+        StoredLevel& base = m_storedLevels[0];
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t blockCol = 0; blockCol < levelCols; ++blockCol)
+        {
+            const int64_t firstCol = blockCol * blockSize, blockCols = min(blockSize, m_numCols - firstCol);
+            float minVal = NaN, maxVal = NaN;
+            double sum = 0.0;
+            int64_t count = 0;
+            for (int64_t r = 0; r < bandRows; ++r)
+            {
+                const float* rowData = band.data() + r * m_numCols + firstCol;
+                for (int64_t c = 0; c < blockCols; ++c)
+                {
+                    const float value = rowData[c];
+                    if (!MathFunctions::isNumeric(value)) continue;
+                    combineValue(value, value, value, 1, minVal, maxVal, sum, count);
+                }
+            }
+            const int64_t index = blockRow * levelCols + blockCol;
+            base.m_values[MINIMUM][index] = minVal;
+            base.m_values[MAXIMUM][index] = maxVal;
+            base.m_values[MEAN][index] = (count > 0 ? (float)(sum / count) : NaN);
+            counts[index] = count;
+        }
+        if (observer != NULL && !observer->bandFinished(blockRow + 1, levelRows))
+        {
+            m_numLevels = 0;
+            m_storedLevels.clear();
+            return false;
+        }
+    }
+    for (int i = 1; i < (int)m_storedLevels.size(); ++i)
+    {//each coarser level combines 2 by 2 blocks of the previous one
+        const StoredLevel& finer = m_storedLevels[i - 1];
+        StoredLevel& coarser = m_storedLevels[i];
+        const int64_t finerRows = levelRows, finerCols = levelCols;
+        levelRows = getLevelRows(m_firstStoredLevel + i);
+        levelCols = getLevelColumns(m_firstStoredLevel + i);
+        for (int j = 0; j < 3; ++j)
+        {
+            coarser.m_values[j].resize(levelRows * levelCols);
+        }
+        vector<int64_t> coarserCounts(levelRows * levelCols);
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t row = 0; row < levelRows; ++row)
+        {
+            for (int64_t col = 0; col < levelCols; ++col)
+            {
+                float minVal = NaN, maxVal = NaN;
+                double sum = 0.0;
+                int64_t count = 0;
+                for (int64_t finerRow = row * 2; finerRow < min(row * 2 + 2, finerRows); ++finerRow)
+                {
+                    for (int64_t finerCol = col * 2; finerCol < min(col * 2 + 2, finerCols); ++finerCol)
+                    {
+                        const int64_t finerIndex = finerRow * finerCols + finerCol;
+                        combineValue(finer.m_values[MINIMUM][finerIndex], finer.m_values[MAXIMUM][finerIndex],
+                                     (double)finer.m_values[MEAN][finerIndex] * counts[finerIndex], counts[finerIndex],
+                                     minVal, maxVal, sum, count);
+                    }
+                }
+                const int64_t index = row * levelCols + col;
+                coarser.m_values[MINIMUM][index] = minVal;
+                coarser.m_values[MAXIMUM][index] = maxVal;
+                coarser.m_values[MEAN][index] = (count > 0 ? (float)(sum / count) : NaN);
+                coarserCounts[index] = count;
+            }
+        }
+        counts.swap(coarserCounts);
+    }
+    return true;
+}
+
+bool CiftiMatrixPyramid::readFile(const QString& pyramidFileName, const CiftiFile* input, const QString& sourceFileName)
+{
+    CaretAssert(input != NULL);
+    m_numLevels = 0;
+    m_storedLevels.clear();
+    if (!QFile::exists(pyramidFileName)) return false;
+    const vector<int64_t>& dims = input->getDimensions();
+    if (dims.size() != 2) return false;
+    try
+    {
+        CaretBinaryFile inFile(pyramidFileName);
+        char magic[8];
+        int64_t header[(PYRAMID_HEADER_SIZE - 8) / sizeof(int64_t)];
+        inFile.read(magic, 8);
+        inFile.read(header, sizeof(header));
+        bool ok = memcmp(magic, PYRAMID_MAGIC, 8) == 0 && header[0] == PYRAMID_VERSION &&
+                  header[3] == dims[1] && header[4] == dims[0];
+        if (ok && !sourceFileName.isEmpty())
+        {
+            QFileInfo sourceInfo(sourceFileName);
+            ok = header[1] == sourceInfo.size() && header[2] == sourceInfo.lastModified().toMSecsSinceEpoch();
+        }
+        if (ok)
+        {
+            setup(input, dims[1], dims[0]);
+            ok = header[5] >= 0 && header[5] < m_numLevels && header[6] == m_numLevels;
+        }
+        if (ok)
+        {
+            m_firstStoredLevel = (int)header[5];
+            int64_t expectedSize = PYRAMID_HEADER_SIZE;
+            for (int level = m_firstStoredLevel; level < m_numLevels; ++level)
+            {
+                expectedSize += 3 * getLevelRows(level) * getLevelColumns(level) * (int64_t)sizeof(float);
+            }
+            ok = inFile.size() == expectedSize;//also catches an interrupted write
+        }
+        if (ok)
+        {
+            m_storedLevels.resize(m_numLevels - m_firstStoredLevel);
+            for (int i = 0; i < (int)m_storedLevels.size(); ++i)
+            {
+                const int64_t numValues = getLevelRows(m_firstStoredLevel + i) * getLevelColumns(m_firstStoredLevel + i);
+                for (int j = 0; j < 3; ++j)
+                {
+                    m_storedLevels[i].m_values[j].resize(numValues);
+                    inFile.read(m_storedLevels[i].m_values[j].data(), numValues * sizeof(float));
+                }
+            }
+            CaretLogFine("using matrix pyramid file '" + pyramidFileName + "'");
+            return true;
+        }
+        CaretLogFine("ignoring stale or invalid matrix pyramid file '" + pyramidFileName + "'");
+    } catch (DataFileException& e) {
+        CaretLogFine("unable to read matrix pyramid file '" + pyramidFileName + "': " + e.whatString());
+    }
+    m_numLevels = 0;
+    m_storedLevels.clear();
+    return false;
+}
+
+void CiftiMatrixPyramid::writeFile(const QString& pyramidFileName, const QString& sourceFileName) const
+{
+    CaretAssert(isValid());
+    int64_t header[(PYRAMID_HEADER_SIZE - 8) / sizeof(int64_t)] = { 0 };
+    header[0] = PYRAMID_VERSION;
+    if (!sourceFileName.isEmpty())
+    {
+        QFileInfo sourceInfo(sourceFileName);
+        header[1] = sourceInfo.size();
+        header[2] = sourceInfo.lastModified().toMSecsSinceEpoch();
+    }
+    header[3] = m_numRows;
+    header[4] = m_numCols;
+    header[5] = m_firstStoredLevel;
+    header[6] = m_numLevels;
+    CaretBinaryFile outFile(pyramidFileName, CaretBinaryFile::WRITE_TRUNCATE);
+    outFile.write(PYRAMID_MAGIC, 8);
+    outFile.write(header, sizeof(header));
+    for (int i = 0; i < (int)m_storedLevels.size(); ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            outFile.write(m_storedLevels[i].m_values[j].data(), m_storedLevels[i].m_values[j].size() * sizeof(float));
+        }
+    }
+    outFile.close();
+}
+
+int64_t CiftiMatrixPyramid::getLevelRows(const int& level) const
+{
+    const int64_t blockSize = (int64_t)1 << level;
+    return (m_numRows + blockSize - 1) / blockSize;
+}
+
+int64_t CiftiMatrixPyramid::getLevelColumns(const int& level) const
+{
+    const int64_t blockSize = (int64_t)1 << level;
+    return (m_numCols + blockSize - 1) / blockSize;
+}
+
+int64_t CiftiMatrixPyramid::getNumberOfTileRows(const int& level) const
+{
+    return (getLevelRows(level) + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+int64_t CiftiMatrixPyramid::getNumberOfTileColumns(const int& level) const
+{
+    return (getLevelColumns(level) + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+int CiftiMatrixPyramid::getLevelForCellsPerPixel(const float& cellsPerPixel) const
+{
+    CaretAssert(isValid());
+    if (!(cellsPerPixel > 1.0f)) return 0;//also NaN
+    int level = (int)ceil(log(cellsPerPixel) / log(2.0f));
+    if (level < m_firstStoredLevel) level = m_firstStoredLevel;//in between, blocks of the first stored level cover several pixels
+    if (level >= m_numLevels) level = m_numLevels - 1;
+    return level;
+}
+
+const float* CiftiMatrixPyramid::getStoredLevelData(const int& level, const SummaryType& type) const
+{
+    if (level < m_firstStoredLevel || level >= m_numLevels) return NULL;
+    return m_storedLevels[level - m_firstStoredLevel].m_values[type].data();
+}
+
+void CiftiMatrixPyramid::getTiles(float* dataOut, const int& level, const SummaryType& type, const int64_t& tileRow, const int64_t& firstTileColumn, const int64_t& numTileColumns) const
+{
+    CaretAssert(isValid());
+    CaretAssert(level == 0 || (level >= m_firstStoredLevel && level < m_numLevels));
+    const int64_t tileValues = TILE_SIZE * TILE_SIZE;
+    fill(dataOut, dataOut + numTileColumns * tileValues, numeric_limits<float>::quiet_NaN());
+    const int64_t levelRows = getLevelRows(level), levelCols = getLevelColumns(level);
+    const int64_t firstRow = tileRow * TILE_SIZE, numRows = min(TILE_SIZE, levelRows - firstRow);
+    if (numRows <= 0) return;
+    const float* source = getStoredLevelData(level, type);
+    vector<float> band;
+    if (source == NULL)
+    {//level 0 isn't stored, every summary is the value itself
+        CaretAssert(level == 0 && m_input != NULL);
+        band.resize(numRows * m_numCols);
+        m_input->getRows(band.data(), firstRow, numRows);
+        source = band.data();
+    } else {
+        source += firstRow * levelCols;
+    }
+    for (int64_t tile = 0; tile < numTileColumns; ++tile)
+    {
+        const int64_t firstCol = (firstTileColumn + tile) * TILE_SIZE, numCols = min(TILE_SIZE, levelCols - firstCol);
+        if (numCols <= 0) break;
+        float* tileData = dataOut + tile * tileValues;
+        for (int64_t r = 0; r < numRows; ++r)
+        {
+            const float* rowData = source + r * levelCols + firstCol;
+            copy(rowData, rowData + numCols, tileData + r * TILE_SIZE);
+        }
+    }
+}
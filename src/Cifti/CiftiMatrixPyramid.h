@@ -0,0 +1,102 @@
+#ifndef __CIFTI_MATRIX_PYRAMID_H__
+#define __CIFTI_MATRIX_PYRAMID_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <QString>
+
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+
+    class CiftiFile;
+
+    ///minimum, maximum, and mean of a 2D cifti matrix over square blocks, for drawing matrices that are far too large to draw cell by cell
+    ///level L summarizes blocks of 2^L by 2^L cells, levels from getFirstStoredLevel() up are kept in memory, level 0 is read from the cifti file when requested
+    ///values are handed out in square tiles of TILE_SIZE blocks, so a viewer only needs the tiles that are visible at the level that matches its zoom
+    ///NOTE: the sidecar file is a machine-local cache like CiftiTileFile, native byte order and float32, and it records the size and modification time of the cifti file it was made from
+    class CiftiMatrixPyramid
+    {
+    public:
+        enum SummaryType
+        {
+            MINIMUM = 0,
+            MAXIMUM = 1,
+            MEAN = 2
+        };
+    private:
+        struct StoredLevel
+        {
+            std::vector<float> m_values[3];//indexed by SummaryType, row-major
+        };
+        const CiftiFile* m_input;//not owned, only used for level 0 tiles when level 0 isn't stored
+        int64_t m_numRows, m_numCols;
+        int m_firstStoredLevel, m_numLevels;
+        std::vector<StoredLevel> m_storedLevels;//level m_firstStoredLevel + i
+        void setup(const CiftiFile* input, const int64_t& numRows, const int64_t& numCols);
+        CiftiMatrixPyramid(const CiftiMatrixPyramid&);
+        CiftiMatrixPyramid& operator=(const CiftiMatrixPyramid&);
+    public:
+        ///lets the caller of build() report progress and stop the build, bandFinished() is called on the thread that called build()
+        class BuildObserver
+        {
+        public:
+            virtual ~BuildObserver() { }
+            ///return false to stop building
+            virtual bool bandFinished(const int64_t& bandsDone, const int64_t& numBands) = 0;
+        };
+        
+        static const int64_t TILE_SIZE;
+        static const int64_t DEFAULT_MAX_STORED_CELLS;
+
+        static QString getSidecarFileName(const QString& ciftiFileName);//cifti file name plus ".wbpyramid"
+
+        CiftiMatrixPyramid();
+        ///reads the input once, in bands of rows, the finest stored level is the first with no more than maxStoredCells blocks
+        ///returns false if the observer stopped it, which leaves the pyramid invalid
+        bool build(const CiftiFile* input, const int64_t& maxStoredCells = DEFAULT_MAX_STORED_CELLS, BuildObserver* observer = NULL);
+        ///false for a missing, stale, or mismatched file, input is still needed for level 0 tiles
+        bool readFile(const QString& pyramidFileName, const CiftiFile* input, const QString& sourceFileName);
+        ///sourceFileName is what readFile() will check against
+        void writeFile(const QString& pyramidFileName, const QString& sourceFileName) const;
+
+        bool isValid() const { return m_numLevels > 0; }
+        int64_t getNumberOfRows() const { return m_numRows; }
+        int64_t getNumberOfColumns() const { return m_numCols; }
+        int getNumberOfLevels() const { return m_numLevels; }//the last level is a single tile
+        int getFirstStoredLevel() const { return m_firstStoredLevel; }
+        int64_t getLevelRows(const int& level) const;
+        int64_t getLevelColumns(const int& level) const;
+        int64_t getNumberOfTileRows(const int& level) const;
+        int64_t getNumberOfTileColumns(const int& level) const;
+        ///the level to draw when a pixel covers cellsPerPixel cells, levels between 0 and the first stored level are skipped in favor of the first stored level
+        int getLevelForCellsPerPixel(const float& cellsPerPixel) const;
+        ///summary values of a stored level, row-major, NULL if the level isn't stored
+        const float* getStoredLevelData(const int& level, const SummaryType& type) const;
+        ///numTileColumns adjacent tiles from one row of tiles, TILE_SIZE * TILE_SIZE values each, row-major inside, padding and blocks with no numeric values are NaN
+        ///level 0 is one read of a band of rows from the cifti file, and all summary types are the cell values
+        void getTiles(float* dataOut, const int& level, const SummaryType& type, const int64_t& tileRow, const int64_t& firstTileColumn, const int64_t& numTileColumns) const;
+    };
+
+}
+
+#endif //__CIFTI_MATRIX_PYRAMID_H__
@@ -0,0 +1,178 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CiftiTileFile.h"
+
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "CiftiFile.h"
+#include "DataFileException.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+const int64_t CiftiTileFile::DEFAULT_TILE_SIZE = 256;
+
+namespace
+{
+    const char TILE_MAGIC[8] = { 'w', 'b', 't', 'i', 'l', 'e', 's', '\0' };
+    const int64_t TILE_VERSION = 1;
+    const int64_t TILE_HEADER_SIZE = 64;//magic, 6 int64 values, padding
+}
+
+QString CiftiTileFile::getSidecarFileName(const QString& ciftiFileName)
+{
+    return ciftiFileName + ".wbtiles";
+}
+
+void CiftiTileFile::writeFile(const CiftiFile& input, const QString& tileFileName, const QString& sourceFileName, const int64_t& tileSize)
+{
+    const vector<int64_t>& dims = input.getDimensions();
+    if (dims.size() != 2) throw DataFileException("tiled cifti files can only be made from 2D cifti");
+    if (tileSize < 1) throw DataFileException("tile size must be positive");
+    const int64_t numCols = dims[0], numRows = dims[1];
+    int64_t header[(TILE_HEADER_SIZE - 8) / sizeof(int64_t)] = { 0 };
+    header[0] = TILE_VERSION;
+    if (!sourceFileName.isEmpty())
+    {
+        QFileInfo sourceInfo(sourceFileName);
+        header[1] = sourceInfo.size();
+        header[2] = sourceInfo.lastModified().toMSecsSinceEpoch();
+    }
+    header[3] = numRows;
+    header[4] = numCols;
+    header[5] = tileSize;
+    CaretBinaryFile outFile(tileFileName, CaretBinaryFile::WRITE_TRUNCATE);
+    outFile.write(TILE_MAGIC, 8);
+    outFile.write(header, sizeof(header));
+    vector<float> band(tileSize * numCols), tile(tileSize * tileSize);
+    for (int64_t firstRow = 0; firstRow < numRows; firstRow += tileSize)
+    {
+        int64_t bandRows = min(tileSize, numRows - firstRow);
+        input.getRows(band.data(), firstRow, bandRows);//one sequential read per band
+        for (int64_t firstCol = 0; firstCol < numCols; firstCol += tileSize)
+        {
+            int64_t tileCols = min(tileSize, numCols - firstCol);
+            if (bandRows < tileSize || tileCols < tileSize) tile.assign(tile.size(), 0.0f);//padding
+            for (int64_t c = 0; c < tileCols; ++c)
+            {
+                float* tileColumn = tile.data() + c * tileSize;
+                const float* bandColumn = band.data() + firstCol + c;
+                for (int64_t r = 0; r < bandRows; ++r)
+                {
+                    tileColumn[r] = bandColumn[r * numCols];
+                }
+            }
+            outFile.write(tile.data(), tile.size() * sizeof(float));
+        }
+    }
+    outFile.close();
+}
+
+CiftiTileFile::CiftiTileFile()
+{
+    m_numRows = 0;
+    m_numCols = 0;
+    m_tileSize = 0;
+    m_numTileRows = 0;
+    m_numTileCols = 0;
+}
+
+bool CiftiTileFile::open(const QString& tileFileName, const int64_t& numRows, const int64_t& numCols, const QString& sourceFileName)
+{
+    close();
+    if (!QFile::exists(tileFileName)) return false;
+    try
+    {
+        m_file.open(tileFileName);
+        char magic[8];
+        int64_t header[(TILE_HEADER_SIZE - 8) / sizeof(int64_t)];
+        m_file.read(magic, 8);
+        m_file.read(header, sizeof(header));
+        bool ok = memcmp(magic, TILE_MAGIC, 8) == 0 && header[0] == TILE_VERSION &&
+                  header[3] == numRows && header[4] == numCols && header[5] > 0;
+        if (ok && !sourceFileName.isEmpty())
+        {
+            QFileInfo sourceInfo(sourceFileName);
+            ok = header[1] == sourceInfo.size() && header[2] == sourceInfo.lastModified().toMSecsSinceEpoch();
+        }
+        if (ok)
+        {
+            int64_t tileSize = header[5];
+            int64_t numTileRows = (numRows + tileSize - 1) / tileSize, numTileCols = (numCols + tileSize - 1) / tileSize;
+            ok = m_file.size() == TILE_HEADER_SIZE + numTileRows * numTileCols * tileSize * tileSize * (int64_t)sizeof(float);//also catches an interrupted write
+            if (ok)
+            {
+                m_numRows = numRows;
+                m_numCols = numCols;
+                m_tileSize = tileSize;
+                m_numTileRows = numTileRows;
+                m_numTileCols = numTileCols;
+                CaretLogFine("using tiled cifti file '" + tileFileName + "'");
+                return true;
+            }
+        }
+        CaretLogFine("ignoring stale or invalid tiled cifti file '" + tileFileName + "'");
+    } catch (DataFileException& e) {
+        CaretLogFine("unable to read tiled cifti file '" + tileFileName + "': " + e.whatString());
+    }
+    close();
+    return false;
+}
+
+void CiftiTileFile::close()
+{
+    m_file.close();
+    m_numRows = 0;
+    m_numCols = 0;
+    m_tileSize = 0;
+    m_numTileRows = 0;
+    m_numTileCols = 0;
+}
+
+void CiftiTileFile::getColumn(float* dataOut, const int64_t& index) const
+{
+    CaretAssert(isOpen());
+    CaretAssert(index >= 0 && index < m_numCols);
+    const int64_t tileBytes = m_tileSize * m_tileSize * sizeof(float);
+    const int64_t tileCol = index / m_tileSize, colInTile = index % m_tileSize;
+    for (int64_t tileRow = 0; tileRow < m_numTileRows; ++tileRow)
+    {
+        int64_t position = TILE_HEADER_SIZE + (tileRow * m_numTileCols + tileCol) * tileBytes + colInTile * m_tileSize * sizeof(float);
+        int64_t numValues = min(m_tileSize, m_numRows - tileRow * m_tileSize);//don't read the padding
+        m_file.readAt(dataOut + tileRow * m_tileSize, position, numValues * sizeof(float));
+    }
+}
+
+void CiftiTileFile::getTile(float* dataOut, const int64_t& tileRow, const int64_t& tileColumn) const
+{
+    CaretAssert(isOpen());
+    CaretAssert(tileRow >= 0 && tileRow < m_numTileRows && tileColumn >= 0 && tileColumn < m_numTileCols);
+    const int64_t tileBytes = m_tileSize * m_tileSize * sizeof(float);
+    m_file.readAt(dataOut, TILE_HEADER_SIZE + (tileRow * m_numTileCols + tileColumn) * tileBytes, tileBytes);
+}
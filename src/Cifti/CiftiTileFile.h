@@ -0,0 +1,63 @@
+#ifndef __CIFTI_TILE_FILE_H__
+#define __CIFTI_TILE_FILE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretBinaryFile.h"
+
+#include <QString>
+
+#include <stdint.h>
+
+namespace caret {
+    
+    class CiftiFile;
+    
+    ///tiled copy of a 2D cifti matrix, so that a column can be read without touching every row of the original file
+    ///tiles are square, in tile-row-major order, and column-major inside (edge tiles are padded), so a column is one read of tileSize values per tile row
+    ///NOTE: this is a machine-local cache, so native byte order and float32 are used, and it records the size and modification time of the cifti file it was made from
+    class CiftiTileFile
+    {
+        mutable CaretBinaryFile m_file;//readAt is safe from multiple threads, but isn't const
+        int64_t m_numRows, m_numCols, m_tileSize, m_numTileRows, m_numTileCols;
+        CiftiTileFile(const CiftiTileFile&);
+        CiftiTileFile& operator=(const CiftiTileFile&);
+    public:
+        static const int64_t DEFAULT_TILE_SIZE;
+        
+        static QString getSidecarFileName(const QString& ciftiFileName);//cifti file name plus ".wbtiles"
+        ///reads tileSize rows of the input at a time, sourceFileName is what open() will check against, empty for a temporary file
+        static void writeFile(const CiftiFile& input, const QString& tileFileName, const QString& sourceFileName, const int64_t& tileSize = DEFAULT_TILE_SIZE);
+        
+        CiftiTileFile();
+        bool open(const QString& tileFileName, const int64_t& numRows, const int64_t& numCols, const QString& sourceFileName);//false for a missing, stale, or mismatched file
+        void close();
+        bool isOpen() const { return m_tileSize > 0; }
+        int64_t getTileSize() const { return m_tileSize; }
+        int64_t getNumberOfTileRows() const { return m_numTileRows; }
+        int64_t getNumberOfTileColumns() const { return m_numTileCols; }
+        void getColumn(float* dataOut, const int64_t& index) const;
+        void getTile(float* dataOut, const int64_t& tileRow, const int64_t& tileColumn) const;//tileSize * tileSize values, column-major
+    };
+    
+}
+
+#endif //__CIFTI_TILE_FILE_H__
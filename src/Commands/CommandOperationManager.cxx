@@ -158,6 +158,7 @@
 #include "OperationCiftiLabelExportTable.h"
 #include "OperationCiftiLabelImport.h"
 #include "OperationCiftiMath.h"
+#include "OperationCiftiMatrixPyramid.h"
 #include "OperationCiftiMerge.h"
 #include "OperationCiftiPalette.h"
 #include "OperationCiftiResampleDconnMemory.h"
@@ -165,6 +166,7 @@
 #include "OperationCiftiROIAverage.h"
 #include "OperationCiftiSeparateAll.h"
 #include "OperationCiftiStats.h"
+#include "OperationCiftiTileSidecar.h"
 #include "OperationCiftiWeightedStats.h"
 #include "OperationConvertAffine.h"
 #include "OperationConvertFiberOrientations.h"
@@ -189,6 +191,7 @@
 #include "OperationMetricMerge.h"
 #include "OperationMetricPalette.h"
 #include "OperationMetricStats.h"
+#include "OperationMetricTFCEMax.h"
 #include "OperationMetricVertexSum.h"
 #include "OperationMetricWeightedStats.h"
 #include "OperationNiftiInformation.h"
@@ -223,6 +226,7 @@
 #include "OperationVolumeReorient.h"
 #include "OperationVolumeSetSpace.h"
 #include "OperationVolumeStats.h"
+#include "OperationVolumeTFCEMax.h"
 #include "OperationVolumeWeightedStats.h"
 #include "OperationWbsparseMergeDense.h"
 #include "OperationZipSceneFile.h"
@@ -244,7 +248,10 @@
 
 #include "CaretLogger.h"
 #include "dot_wrapper.h"
+#include "GzipIndexedReader.h"
+#include "MetricSmoothingObject.h"
 #include "StructureEnum.h"
+#include "VolumeFile.h"
 
 #include <iostream>
 #include <map>
@@ -417,11 +424,13 @@ CommandOperationManager::CommandOperationManager()
     this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiLabelExportTable()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiLabelImport()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiMath()));
+    this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiMatrixPyramid()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiMerge()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiPalette()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiResampleDconnMemory()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiROIAverage()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiStats()));
+    this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiTileSidecar()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationCiftiWeightedStats()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationConvertAffine()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationConvertFiberOrientations()));
@@ -446,6 +455,7 @@ CommandOperationManager::CommandOperationManager()
     this->commandOperations.push_back(new CommandParser(new AutoOperationMetricMerge()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationMetricPalette()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationMetricStats()));
+    this->commandOperations.push_back(new CommandParser(new AutoOperationMetricTFCEMax()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationMetricWeightedStats()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationNiftiInformation()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationProbtrackXDotConvert()));
@@ -480,6 +490,7 @@ CommandOperationManager::CommandOperationManager()
     this->commandOperations.push_back(new CommandParser(new AutoOperationVolumeReorient()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationVolumeSetSpace()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationVolumeStats()));
+    this->commandOperations.push_back(new CommandParser(new AutoOperationVolumeTFCEMax()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationVolumeWeightedStats()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationWbsparseMergeDense()));
     this->commandOperations.push_back(new CommandParser(new AutoOperationZipSceneFile()));
@@ -579,6 +590,21 @@ CommandOperationManager::runCommand(ProgramParameters& parameters)
             CaretLogWarning("SIMD type '" + DotSIMDEnum::toName(impl) + "' not supported (could be cpu, compiler, or build options), using '" + DotSIMDEnum::toName(retval) + "'");
         }
     }
+    if (getGlobalOption(parameters, "-gzip-index-cache", 0, globalOptionArgs))
+    {
+        GzipIndexedReader::setIndexCaching(true);
+    }
+    if (getGlobalOption(parameters, "-smoothing-weight-cache", 1, globalOptionArgs))
+    {
+        MetricSmoothingObject::setWeightCacheDirectory(globalOptionArgs[0]);
+    }
+    if (getGlobalOption(parameters, "-volume-frames-on-demand", 1, globalOptionArgs))
+    {
+        bool valid = false;
+        int64_t megabytes = globalOptionArgs[0].toLongLong(&valid);
+        if (!valid || megabytes < 0) throw CommandException("invalid memory amount for -volume-frames-on-demand: '" + globalOptionArgs[0] + "'");
+        VolumeFile::setFramesOnDemand(true, megabytes * 1024 * 1024);
+    }
     int16_t ciftiDType = NIFTI_TYPE_FLOAT32;
     bool ciftiScale = false;
     double ciftiMin = -1.0, ciftiMax = -1.0;
@@ -710,6 +736,17 @@ AString CommandOperationManager::doCompletion(ProgramParameters& parameters, con
         }
         return ret;
     }
+    parseGlobalOption(parameters, "-gzip-index-cache", 0, globalOptionArgs, true);//no arguments, doesn't need completion testing
+    OptionInfo smoothCacheInfo = parseGlobalOption(parameters, "-smoothing-weight-cache", 1, globalOptionArgs, true);
+    if (smoothCacheInfo.specified && !smoothCacheInfo.complete)
+    {
+        return "fileglob *";
+    }
+    OptionInfo framesOnDemandInfo = parseGlobalOption(parameters, "-volume-frames-on-demand", 1, globalOptionArgs, true);
+    if (framesOnDemandInfo.specified && !framesOnDemandInfo.complete)
+    {//can't tab complete a literal number
+        return "";
+    }
     OptionInfo ciftiDTypeInfo = parseGlobalOption(parameters, "-cifti-output-datatype", 1, globalOptionArgs, true);
     if (ciftiDTypeInfo.specified && !ciftiDTypeInfo.complete)
     {
@@ -720,7 +757,7 @@ AString CommandOperationManager::doCompletion(ProgramParameters& parameters, con
     {//can't tab complete a literal number
         return "";
     }
-    ret = "wordlist -disable-provenance\\ -logging\\ -simd\\ -cifti-output-datatype\\ -cifti-output-range";//we could prevent suggesting an already-provided global option, but that would be a bit surprising
+    ret = "wordlist -disable-provenance\\ -logging\\ -simd\\ -cifti-output-datatype\\ -cifti-output-range\\ -gzip-index-cache\\ -smoothing-weight-cache\\ -volume-frames-on-demand";//we could prevent suggesting an already-provided global option, but that would be a bit surprising
     const uint64_t numberOfCommands = this->commandOperations.size();
     const uint64_t numberOfDeprecated = this->deprecatedOperations.size();
     if (!parameters.hasNext())
@@ -1104,6 +1141,25 @@ void CommandOperationManager::printGlobalOptions()
         cout << "         " << DotSIMDEnum::toName(*iter) << endl;
     }
     cout << endl;
+    //guide for wrap, assuming 80 columns:                                                  |
+    cout << "   -gzip-index-cache                 save the seek index of .gz input files as" << endl;
+    cout << "                                        <file>.wbgzidx, and use it when the" << endl;
+    cout << "                                        same file is read again" << endl;
+    cout << endl;
+    //guide for wrap, assuming 80 columns:                                                  |
+    cout << "   -smoothing-weight-cache <directory>" << endl;
+    cout << "                                     save surface smoothing weights in" << endl;
+    cout << "                                        <directory>, and use them instead of" << endl;
+    cout << "                                        recomputing when the same surface," << endl;
+    cout << "                                        kernel, method, and roi are used again" << endl;
+    cout << endl;
+    //guide for wrap, assuming 80 columns:                                                  |
+    cout << "   -volume-frames-on-demand <megabytes>" << endl;
+    cout << "                                     read frames of multi-frame input volumes" << endl;
+    cout << "                                        only when they are used, keeping at most" << endl;
+    cout << "                                        <megabytes> of frames in memory for each" << endl;
+    cout << "                                        volume" << endl;
+    cout << endl;
 }
 
 void CommandOperationManager::printCiftiHelp()
@@ -298,3 +298,139 @@ uint64_t Base64::decode(const unsigned char *input,
 
   return optr - output;
 }
+
+//----------------------------------------------------------------------------
+// Same as Base64DecodeTable except that padding ('=') is invalid and
+// whitespace is 0xFE so that both leave the fast path of decodeText().
+static const unsigned char Base64DecodeTextTable[256] =
+{
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFE,0xFE,0xFF,0xFF,0xFE,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFE,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0x3E,0xFF,0xFF,0xFF,0x3F,
+  0x34,0x35,0x36,0x37,0x38,0x39,0x3A,0x3B,
+  0x3C,0x3D,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0x00,0x01,0x02,0x03,0x04,0x05,0x06,
+  0x07,0x08,0x09,0x0A,0x0B,0x0C,0x0D,0x0E,
+  0x0F,0x10,0x11,0x12,0x13,0x14,0x15,0x16,
+  0x17,0x18,0x19,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0x1A,0x1B,0x1C,0x1D,0x1E,0x1F,0x20,
+  0x21,0x22,0x23,0x24,0x25,0x26,0x27,0x28,
+  0x29,0x2A,0x2B,0x2C,0x2D,0x2E,0x2F,0x30,
+  0x31,0x32,0x33,0xFF,0xFF,0xFF,0xFF,0xFF,
+  //-------------------------------------
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,
+  0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF
+};
+
+//----------------------------------------------------------------------------
+uint64_t Base64::decodeText(const char* input,
+                            const uint64_t inputLength,
+                            unsigned char* output,
+                            const uint64_t outputLength)
+{
+  const unsigned char* in = reinterpret_cast<const unsigned char*>(input);
+  uint64_t inPos = 0;
+  uint64_t outPos = 0;
+  uint32_t quad = 0;
+  int32_t quadCount = 0;
+
+  while (inPos < inputLength)
+    {
+    // Fast path, two complete groups (8 characters to 6 bytes) per pass
+    // with a single test for anything that is not a base64 digit.
+    if (quadCount == 0)
+      {
+      while ((inPos + 8 <= inputLength) && (outPos + 6 <= outputLength))
+        {
+        const unsigned char* p = in + inPos;
+        const uint32_t a0 = Base64DecodeTextTable[p[0]];
+        const uint32_t a1 = Base64DecodeTextTable[p[1]];
+        const uint32_t a2 = Base64DecodeTextTable[p[2]];
+        const uint32_t a3 = Base64DecodeTextTable[p[3]];
+        const uint32_t b0 = Base64DecodeTextTable[p[4]];
+        const uint32_t b1 = Base64DecodeTextTable[p[5]];
+        const uint32_t b2 = Base64DecodeTextTable[p[6]];
+        const uint32_t b3 = Base64DecodeTextTable[p[7]];
+        if ((a0 | a1 | a2 | a3 | b0 | b1 | b2 | b3) & 0x80)
+          {
+          break;
+          }
+        const uint32_t va = (a0 << 18) | (a1 << 12) | (a2 << 6) | a3;
+        const uint32_t vb = (b0 << 18) | (b1 << 12) | (b2 << 6) | b3;
+        unsigned char* o = output + outPos;
+        o[0] = static_cast<unsigned char>(va >> 16);
+        o[1] = static_cast<unsigned char>(va >> 8);
+        o[2] = static_cast<unsigned char>(va);
+        o[3] = static_cast<unsigned char>(vb >> 16);
+        o[4] = static_cast<unsigned char>(vb >> 8);
+        o[5] = static_cast<unsigned char>(vb);
+        inPos  += 8;
+        outPos += 6;
+        }
+      if (inPos >= inputLength)
+        {
+        break;
+        }
+      }
+
+    // One character at a time near whitespace and at the end of the data
+    const unsigned char d = Base64DecodeTextTable[in[inPos]];
+    inPos++;
+    if (d == 0xFE)
+      {
+      continue;
+      }
+    if (d == 0xFF)
+      {
+      // Padding, a terminating null, or an invalid character ends the data
+      break;
+      }
+    quad = (quad << 6) | d;
+    quadCount++;
+    if (quadCount == 4)
+      {
+      if (outPos + 3 > outputLength)
+        {
+        quadCount = 0;
+        break;
+        }
+      output[outPos]     = static_cast<unsigned char>(quad >> 16);
+      output[outPos + 1] = static_cast<unsigned char>(quad >> 8);
+      output[outPos + 2] = static_cast<unsigned char>(quad);
+      outPos += 3;
+      quad = 0;
+      quadCount = 0;
+      }
+    }
+
+  // A final incomplete group of 2 or 3 characters holds 1 or 2 bytes
+  if (quadCount >= 2)
+    {
+    quad <<= (6 * (4 - quadCount));
+    const int32_t numBytes = quadCount - 1;
+    for (int32_t i = 0; (i < numBytes) && (outPos < outputLength); i++)
+      {
+      output[outPos] = static_cast<unsigned char>(quad >> (16 - (8 * i)));
+      outPos++;
+      }
+    }
+
+  return outPos;
+}
@@ -89,6 +89,19 @@ public:
                               unsigned char *output,
                               uint64_t max_input_length = 0);
     
+  // Description:
+  // Decode 'inputLength' characters of base64 text, that may contain
+  // whitespace, into the output buffer, writing at most 'outputLength'
+  // bytes.  Decoding stops at padding or at any other character that
+  // is not base64.  Return the number of bytes decoded.  Unlike decode(),
+  // the input does not need to be null terminated and complete groups
+  // of characters are decoded without testing each character.
+  // ((inputLength / 4) * 3 + 3) bytes of output hold any input.
+  static uint64_t decodeText(const char* input,
+                             const uint64_t inputLength,
+                             unsigned char* output,
+                             const uint64_t outputLength);
+    
 private:
     // Description:  
     // Decode 4 bytes into 3 bytes.
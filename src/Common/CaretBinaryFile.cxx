@@ -29,11 +29,20 @@
 #include "CaretBinaryFile.h"
 #include "CaretLogger.h"
 #include "DataFileException.h"
+#include "GzipIndexedReader.h"
+#include "GzipParallelWriter.h"
 
 #include <QFile>
+#include <QThread>
 #include "zlib.h"
 
 #include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef CARET_OS_WINDOWS
+#include <unistd.h>
+#endif
 
 using namespace caret;
 using namespace std;
@@ -42,28 +51,62 @@ using namespace std;
 namespace caret
 {
 #ifdef ZLIB_VERSION
+    //inflates the next chunk of a compressed file while the caller is busy with the previous one
+    class ZReadAheadThread : public QThread
+    {
+        GzipIndexedReader* m_reader;
+    public:
+        vector<char> m_buffer;
+        int64_t m_start, m_count, m_numRead;
+        bool m_valid, m_error;
+        AString m_errorMessage;
+        ZReadAheadThread(GzipIndexedReader* reader) { m_reader = reader; m_start = -1; m_count = 0; m_numRead = 0; m_valid = false; m_error = false; }
+        void run()
+        {
+            try
+            {
+                if ((int64_t)m_buffer.size() < m_count) m_buffer.resize(m_count);
+                m_reader->seek(m_start);
+                m_numRead = m_reader->read(m_buffer.data(), m_count);
+            } catch (CaretException& e) {
+                m_error = true;
+                m_errorMessage = e.whatString();
+            } catch (exception& e) {
+                m_error = true;
+                m_errorMessage = e.what();
+            }
+        }
+    };
+    
     class ZFileImpl : public CaretBinaryFile::ImplInterface
     {
-        gzFile m_zfile;
-        const static int64_t CHUNK_SIZE;
+        GzipIndexedReader m_reader;//reading uses an index of access points, so seeking backwards doesn't restart from the beginning
+        GzipParallelWriter m_writer;//writing compresses blocks on multiple threads
+        ZReadAheadThread m_readAhead;//m_reader must not be used while this is running
+        int64_t m_pos, m_lastReadEnd;
+        const static int64_t READ_AHEAD_MIN, READ_AHEAD_MAX;
+        void finishReadAhead();
     public:
-        ZFileImpl() { m_zfile = NULL; }
+        ZFileImpl() : m_readAhead(&m_reader) { m_pos = 0; m_lastReadEnd = -1; }
         void open(const QString& filename, const CaretBinaryFile::OpenMode& opmode);
         void close();
         void seek(const int64_t& position);
         int64_t pos();
-        int64_t size() { return -1; }
+        int64_t size() { finishReadAhead(); return m_reader.size(); }//-1 unless the reader has found the end, or loaded a cached index
         void read(void* dataOut, const int64_t& count, int64_t* numRead);
         void write(const void* dataIn, const int64_t& count);
         ~ZFileImpl();
     };
     
-    const int64_t ZFileImpl::CHUNK_SIZE = 1<<26;//64MiB, large enough for good performance, small enough for zlib, must convert to uint32
+    const int64_t ZFileImpl::READ_AHEAD_MIN = 1<<16;//don't bother with a thread for header reads and such
+    const int64_t ZFileImpl::READ_AHEAD_MAX = 1<<26;//64MiB
 #endif //ZLIB_VERSION
 
     class QFileImpl : public CaretBinaryFile::ImplInterface
     {
+    protected:
         QFile m_file;
+    private:
         const static int64_t CHUNK_SIZE;
     public:
         void open(const QString& filename, const CaretBinaryFile::OpenMode& opmode);
@@ -72,16 +115,41 @@ namespace caret
         int64_t pos();
         int64_t size() { return m_file.size(); }
         void read(void* dataOut, const int64_t& count, int64_t* numRead);
+        void readAt(void* dataOut, const int64_t& position, const int64_t& count, int64_t* numRead);
         void write(const void* dataIn, const int64_t& count);
     };
     
     const int64_t QFileImpl::CHUNK_SIZE = 1<<30;//1GiB, QT4 apparently chokes at more than 2GiB via buffer.read using int32
+    
+    //read-only, maps the whole file if possible, otherwise behaves exactly like QFileImpl (32-bit address space, filesystems that don't support mapping)
+    class QFileMappedImpl : public QFileImpl
+    {
+        const char* m_mapped;
+        int64_t m_size, m_pos;
+    public:
+        QFileMappedImpl() { m_mapped = NULL; m_size = 0; m_pos = 0; }
+        void open(const QString& filename, const CaretBinaryFile::OpenMode& opmode);
+        void close();
+        void seek(const int64_t& position);
+        int64_t pos();
+        int64_t size() { return m_size; }
+        void read(void* dataOut, const int64_t& count, int64_t* numRead);
+        void readAt(void* dataOut, const int64_t& position, const int64_t& count, int64_t* numRead);
+        const char* getMappedData() { return m_mapped; }
+    };
 }
 
 CaretBinaryFile::ImplInterface::~ImplInterface()
 {
 }
 
+void CaretBinaryFile::ImplInterface::readAt(void* dataOut, const int64_t& position, const int64_t& count, int64_t* numRead)
+{
+    CaretMutexLocker locked(&m_positionMutex);
+    seek(position);
+    read(dataOut, count, numRead);
+}
+
 CaretBinaryFile::CaretBinaryFile(const QString& filename, const OpenMode& fileMode)
 {
     open(filename, fileMode);
@@ -115,20 +183,34 @@ void CaretBinaryFile::open(const QString& filename, const OpenMode& opmode)
 {
     close();
     if (opmode == NONE) throw DataFileException("can't open file with NONE mode");
+    if ((opmode & MEMORY_MAP) && opmode != READ_MEMORY_MAP) throw DataFileException("memory mapping is only supported for read-only access");
+    OpenMode implMode = opmode;
     if (filename.endsWith(".gz"))
     {
 #ifdef ZLIB_VERSION
         m_impl.grabNew(new ZFileImpl());
+        implMode = READ;//can't map compressed data, so just read it normally - READ_MEMORY_MAP is the only mode containing MEMORY_MAP
 #else //ZLIB_VERSION
         throw DataFileException("can't open .gz file '" + filename + "', compiled without zlib support");
 #endif //ZLIB_VERSION
     } else {
-        m_impl.grabNew(new QFileImpl());
+        if (opmode & MEMORY_MAP)
+        {
+            m_impl.grabNew(new QFileMappedImpl());
+        } else {
+            m_impl.grabNew(new QFileImpl());
+        }
     }
-    m_impl->open(filename, opmode);
+    m_impl->open(filename, implMode);
     m_curMode = opmode;
 }
 
+const char* CaretBinaryFile::getMappedData()
+{
+    if (m_curMode == NONE) return NULL;
+    return m_impl->getMappedData();
+}
+
 void CaretBinaryFile::read(void* dataOut, const int64_t& count, int64_t* numRead)
 {
     CaretAssert(count >= 0);//not sure about allowing 0
@@ -136,6 +218,14 @@ void CaretBinaryFile::read(void* dataOut, const int64_t& count, int64_t* numRead
     m_impl->read(dataOut, count, numRead);
 }
 
+void CaretBinaryFile::readAt(void* dataOut, const int64_t& position, const int64_t& count, int64_t* numRead)
+{
+    CaretAssert(position >= 0);
+    CaretAssert(count >= 0);
+    if (m_curMode == NONE) throw DataFileException("file is not open, can't read");
+    m_impl->readAt(dataOut, position, count, numRead);
+}
+
 void CaretBinaryFile::seek(const int64_t& position)
 {
     CaretAssert(position >= 0);
@@ -167,62 +257,73 @@ void ZFileImpl::open(const QString& filename, const CaretBinaryFile::OpenMode& o
 {
     close();//don't need to, but just because
     m_fileName = filename;
-    const char* mode = NULL;
-    switch (opmode)//we only support a limited number of combinations, and the string modes are quirky
+    m_pos = 0;
+    m_lastReadEnd = -1;
+    switch (opmode)//we only support a limited number of combinations
     {
         case CaretBinaryFile::READ:
-            mode = "rb";
+            m_reader.open(filename);
             break;
         case CaretBinaryFile::WRITE_TRUNCATE:
-            mode = "wb";//you have to do "w+b" in order to ask it to not truncate, which zlib doesn't support anyway
+            m_writer.open(filename);
             break;
         default:
             throw DataFileException("compressed file only supports READ and WRITE_TRUNCATE modes");
     }
-#if !defined(CARET_OS_MACOSX) && ZLIB_VERNUM > 0x1232
-    m_zfile = gzopen64(filename.toLocal8Bit().constData(), mode);
-#else
-    m_zfile = gzopen(filename.toLocal8Bit().constData(), mode);
-#endif
-    if (m_zfile == NULL)
-    {
-        if (!QFile::exists(filename))
-        {
-            if (!(opmode & CaretBinaryFile::TRUNCATE))
-            {
-                throw DataFileException("failed to open compressed file '" + filename + "', file does not exist, or folder permissions prevent seeing it");
-            } else {//use same logic as QFile impl for now
-                throw DataFileException("failed to open compressed file '" + filename + "', unable to create file");
-            }
-        }//TODO: check gzerror and errno for more informative error messages
-        throw DataFileException("failed to open compressed file '" + filename + "'");
-    }
 }
 
 void ZFileImpl::close()
 {
-    if (m_zfile == NULL) return;//happens when closed and then destroyed, error opening
-    if (gzclose(m_zfile) != 0) throw DataFileException("error closing compressed file '" + m_fileName + "'");
-    m_zfile = NULL;
+    finishReadAhead();
+    m_readAhead.m_buffer = vector<char>();
+    m_reader.close();
+    m_writer.close();
+}
+
+void ZFileImpl::finishReadAhead()
+{
+    m_readAhead.wait();//returns immediately if it isn't running
 }
 
 void ZFileImpl::read(void* dataOut, const int64_t& count, int64_t* numRead)
 {
-    if (m_zfile == NULL) throw DataFileException("read called on unopened ZFileImpl");//shouldn't happen
+    if (!m_reader.isOpen()) throw DataFileException("read called on unopened ZFileImpl");//shouldn't happen
+    finishReadAhead();
     int64_t totalRead = 0;
-    int readret = 0;//to preserve the info of the read that broke early
-    while (totalRead < count)
+    bool gotEnd = false;
+    if (m_readAhead.m_valid && m_readAhead.m_start == m_pos)
     {
-        int64_t iterSize = min(count - totalRead, CHUNK_SIZE);
-        readret = gzread(m_zfile, ((char*)dataOut) + totalRead, iterSize);
-        if (readret < 1) break;//0 or -1 indicate eof or error
-        totalRead += readret;
+        if (m_readAhead.m_error)
+        {
+            m_readAhead.m_valid = false;
+            throw DataFileException(m_readAhead.m_errorMessage);
+        }
+        totalRead = min(count, m_readAhead.m_numRead);
+        memcpy(dataOut, m_readAhead.m_buffer.data(), totalRead);
+        gotEnd = (m_readAhead.m_numRead < m_readAhead.m_count);
+    }
+    m_readAhead.m_valid = false;
+    if (totalRead < count && !gotEnd)
+    {
+        m_reader.seek(m_pos + totalRead);
+        totalRead += m_reader.read(((char*)dataOut) + totalRead, count - totalRead);//throws on decompression errors
+    }
+    bool sequential = (m_pos == m_lastReadEnd);
+    m_pos += totalRead;
+    m_lastReadEnd = m_pos;
+    if (sequential && totalRead == count && count >= READ_AHEAD_MIN)
+    {//only start reading ahead after two back to back reads, so random access (like cifti rows) doesn't pay for data it won't use
+        m_readAhead.m_start = m_pos;
+        m_readAhead.m_count = min(count, READ_AHEAD_MAX);
+        m_readAhead.m_numRead = 0;
+        m_readAhead.m_error = false;
+        m_readAhead.m_valid = true;
+        m_readAhead.start();
     }
     if (numRead == NULL)
     {
         if (totalRead != count)
         {
-            if (readret < 0) throw DataFileException("error while reading compressed file '" + m_fileName + "'");
             throw DataFileException("premature end of file in compressed file '" + m_fileName + "'");
         }
     } else {
@@ -232,38 +333,31 @@ void ZFileImpl::read(void* dataOut, const int64_t& count, int64_t* numRead)
 
 void ZFileImpl::seek(const int64_t& position)
 {
-    if (m_zfile == NULL) throw DataFileException("seek called on unopened ZFileImpl");//shouldn't happen
-    if (pos() == position) return;//slight hack, since gzseek is slow or nonfunctional for some cases, so don't try it unless necessary
-#if !defined(CARET_OS_MACOSX) && ZLIB_VERNUM > 0x1232
-    int64_t ret = gzseek64(m_zfile, position, SEEK_SET);
-#else
-    int64_t ret = gzseek(m_zfile, position, SEEK_SET);
-#endif
-    if (ret != position) throw DataFileException("seek failed in compressed file '" + m_fileName + "'");
+    if (!m_reader.isOpen() && !m_writer.isOpen()) throw DataFileException("seek called on unopened ZFileImpl");//shouldn't happen
+    if (m_writer.isOpen())
+    {//like gzseek, only allow seeking forward when writing, and fill with zeros
+        if (position < m_writer.pos()) throw DataFileException("cannot seek backwards while writing compressed file '" + m_fileName + "'");
+        vector<char> zeros(min(position - m_writer.pos(), (int64_t)1<<20), 0);
+        while (m_writer.pos() < position)
+        {
+            m_writer.write(zeros.data(), min(position - m_writer.pos(), (int64_t)zeros.size()));
+        }
+        return;
+    }
+    m_pos = position;//lazy, the decompressor is repositioned on the next read
 }
 
 int64_t ZFileImpl::pos()
 {
-    if (m_zfile == NULL) throw DataFileException("pos called on unopened ZFileImpl");//shouldn't happen
-#if !defined(CARET_OS_MACOSX) && ZLIB_VERNUM > 0x1232
-    return gztell64(m_zfile);
-#else
-    return gztell(m_zfile);
-#endif
+    if (m_writer.isOpen()) return m_writer.pos();
+    if (!m_reader.isOpen()) throw DataFileException("pos called on unopened ZFileImpl");//shouldn't happen
+    return m_pos;
 }
 
 void ZFileImpl::write(const void* dataIn, const int64_t& count)
 {
-    if (m_zfile == NULL) throw DataFileException("read called on unopened ZFileImpl");//shouldn't happen
-    int64_t totalWritten = 0;
-    while (totalWritten < count)
-    {
-        int64_t iterSize = min(count - totalWritten, CHUNK_SIZE);
-        int writeret = gzwrite(m_zfile, ((const char*)dataIn) + totalWritten, iterSize);
-        if (writeret < 1) break;//0 or -1 indicate eof or error
-        totalWritten += writeret;
-    }
-    if (totalWritten != count) throw DataFileException("failed to write to compressed file '" + m_fileName + "'");
+    if (!m_writer.isOpen()) throw DataFileException("write called on unopened ZFileImpl");//shouldn't happen
+    m_writer.write(dataIn, count);
 }
 
 ZFileImpl::~ZFileImpl()
@@ -344,6 +438,38 @@ void QFileImpl::read(void* dataOut, const int64_t& count, int64_t* numRead)
     }
 }
 
+void QFileImpl::readAt(void* dataOut, const int64_t& position, const int64_t& count, int64_t* numRead)
+{
+#ifndef CARET_OS_WINDOWS
+    if (m_file.openMode() == QIODevice::ReadOnly)//QFile buffers writes, so only bypass it when there can't be anything buffered
+    {
+        int fd = m_file.handle();
+        int64_t total = 0;
+        int64_t readret = -1;
+        while (total < count)
+        {
+            int64_t maxToRead = min(count - total, CHUNK_SIZE);
+            readret = pread(fd, ((char*)dataOut) + total, maxToRead, position + total);//doesn't use or change the file position, so no locking needed
+            if (readret < 0 && errno == EINTR) continue;
+            if (readret < 1) break;//0 or -1 means error or eof
+            total += readret;
+        }
+        if (numRead == NULL)
+        {
+            if (total != count)
+            {
+                if (readret < 0) throw DataFileException("error while reading file '" + m_fileName + "'");
+                throw DataFileException("premature end of file in '" + m_fileName + "'");
+            }
+        } else {
+            *numRead = total;
+        }
+        return;
+    }
+#endif
+    ImplInterface::readAt(dataOut, position, count, numRead);
+}
+
 void QFileImpl::seek(const int64_t& position)
 {
     if (!m_file.seek(position)) throw DataFileException("seek failed in file '" + m_fileName + "'");
@@ -374,3 +500,83 @@ void QFileImpl::write(const void* dataIn, const int64_t& count)
                          + " bytes.");
     if (total != count) throw DataFileException(msg);
 }
+
+void QFileMappedImpl::open(const QString& filename, const CaretBinaryFile::OpenMode& opmode)
+{
+    close();
+    QFileImpl::open(filename, CaretBinaryFile::READ);//use the same error checking and messages
+    m_size = m_file.size();
+    m_pos = 0;
+    if (m_size > 0)
+    {
+        m_mapped = (const char*)m_file.map(0, m_size);
+    }
+    if (m_mapped == NULL)
+    {
+        CaretLogFine("unable to memory map file '" + filename + "', falling back to normal reads");
+    }
+}
+
+void QFileMappedImpl::close()
+{
+    if (m_mapped != NULL)
+    {
+        m_file.unmap((uchar*)m_mapped);
+        m_mapped = NULL;
+    }
+    m_size = 0;
+    m_pos = 0;
+    QFileImpl::close();
+}
+
+void QFileMappedImpl::seek(const int64_t& position)
+{
+    if (m_mapped == NULL)
+    {
+        QFileImpl::seek(position);
+        return;
+    }
+    if (position > m_size) throw DataFileException("seek failed in file '" + m_fileName + "'");//QFile allows seeking past the end for writing, but this is read-only
+    m_pos = position;
+}
+
+int64_t QFileMappedImpl::pos()
+{
+    if (m_mapped == NULL) return QFileImpl::pos();
+    return m_pos;
+}
+
+void QFileMappedImpl::read(void* dataOut, const int64_t& count, int64_t* numRead)
+{
+    if (m_mapped == NULL)
+    {
+        QFileImpl::read(dataOut, count, numRead);
+        return;
+    }
+    int64_t total = min(count, m_size - m_pos);
+    memcpy(dataOut, m_mapped + m_pos, total);
+    m_pos += total;
+    if (numRead == NULL)
+    {
+        if (total != count) throw DataFileException("premature end of file in '" + m_fileName + "'");
+    } else {
+        *numRead = total;
+    }
+}
+
+void QFileMappedImpl::readAt(void* dataOut, const int64_t& position, const int64_t& count, int64_t* numRead)
+{
+    if (m_mapped == NULL)
+    {
+        QFileImpl::readAt(dataOut, position, count, numRead);
+        return;
+    }
+    int64_t total = max(min(count, m_size - position), int64_t(0));
+    memcpy(dataOut, m_mapped + position, total);
+    if (numRead == NULL)
+    {
+        if (total != count) throw DataFileException("premature end of file in '" + m_fileName + "'");
+    } else {
+        *numRead = total;
+    }
+}
@@ -21,6 +21,7 @@
  */
 /*LICENSE_END*/
 
+#include "CaretMutex.h"
 #include "CaretPointer.h"
 
 #include <QString>
@@ -41,7 +42,9 @@ namespace caret {
             READ_WRITE = 3,//for convenience
             TRUNCATE = 4,
             WRITE_TRUNCATE = 6,//ditto
-            READ_WRITE_TRUNCATE = 7//ditto
+            READ_WRITE_TRUNCATE = 7,//ditto
+            MEMORY_MAP = 8,//only valid with READ alone, ignored for compressed files
+            READ_MEMORY_MAP = 9//ditto
         };
         CaretBinaryFile() { }
         ///constructor that opens file
@@ -54,12 +57,15 @@ namespace caret {
         void seek(const int64_t& position);
         int64_t pos();
         void read(void* dataOut, const int64_t& count, int64_t* numRead = NULL);//throw if numRead is NULL and (error or end of file reached early)
+        void readAt(void* dataOut, const int64_t& position, const int64_t& count, int64_t* numRead = NULL);//positional read, safe to call from multiple threads at once (but not concurrently with seek/read/write), pos() is undefined afterwards
         void write(const void* dataIn, const int64_t& count);//failure to complete write is always an exception
         int64_t size();//may return -1 if size cannot be determined efficiently
+        const char* getMappedData();//returns NULL if the file is not memory mapped, otherwise the start of the entire file contents, valid until close
         class ImplInterface
         {
         protected:
             QString m_fileName;//filename is tracked here so error messages can be implementation-specific
+            CaretMutex m_positionMutex;//for the default readAt, which has to use seek and read
         public:
             virtual void open(const QString& filename, const OpenMode& opmode) = 0;
             virtual void close() = 0;
@@ -68,7 +74,9 @@ namespace caret {
             virtual int64_t pos() = 0;
             virtual int64_t size() = 0;
             virtual void read(void* dataOut, const int64_t& count, int64_t* numRead) = 0;
+            virtual void readAt(void* dataOut, const int64_t& position, const int64_t& count, int64_t* numRead);//default is seek and read under a mutex
             virtual void write(const void* dataIn, const int64_t& count) = 0;
+            virtual const char* getMappedData() { return NULL; }
             virtual ~ImplInterface();
         };
     private:
@@ -22,7 +22,9 @@
 #include "CaretException.h"
 #include "CaretLogger.h"
 #include "CaretMathExpression.h"
+#include "CaretOMP.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace caret;
@@ -39,6 +41,8 @@ CaretMathExpression::CaretMathExpression(const AString& expression)
         throw CaretException("extra characters on end of expression input: '" + m_input.mid(m_position) + "'");
     }
     CaretLogFiner("parsed '" + expression + "' as '" + toString() + "'");
+    m_numRegisters = 0;
+    compile(m_root, 0);
 }
 
 double CaretMathExpression::evaluate(const vector<float>& variableValues) const
@@ -47,6 +51,339 @@ double CaretMathExpression::evaluate(const vector<float>& variableValues) const
     return m_root->eval(variableValues);
 }
 
+const int64_t CaretMathExpression::BATCH_SIZE = 512;//enough to amortize the instruction dispatch, small enough that the registers stay in cache
+
+void CaretMathExpression::evaluateMany(float* dataOut, const vector<const float*>& variableData, const int64_t& count, const vector<int64_t>& variableStrides) const
+{
+    CaretAssert(variableData.size() == m_varNames.size());
+    CaretAssert(variableStrides.empty() || variableStrides.size() == m_varNames.size());
+    if (count <= 0) return;
+    vector<int64_t> strides = variableStrides;
+    if (strides.empty()) strides.resize(variableData.size(), 1);
+    int64_t numBatches = (count - 1) / BATCH_SIZE + 1;
+#pragma omp CARET_PAR if (numBatches > 8)
+    {
+        vector<double> registers(m_numRegisters * BATCH_SIZE);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int64_t batch = 0; batch < numBatches; ++batch)
+        {
+            int64_t start = batch * BATCH_SIZE;
+            int64_t thisCount = min(BATCH_SIZE, count - start);
+            runProgram(registers.data(), variableData, strides, start, thisCount);
+            for (int64_t i = 0; i < thisCount; ++i)
+            {
+                dataOut[start + i] = (float)registers[i];//result is always in register 0
+            }
+        }
+    }
+}
+
+void CaretMathExpression::compile(const MathNode* node, const int& outReg)
+{//arguments of a node go into consecutive registers starting at outReg, like a stack
+    m_numRegisters = max(m_numRegisters, outReg + 1);
+    switch (node->m_type)
+    {
+        case MathNode::OR:
+        case MathNode::AND:
+        case MathNode::EQUAL:
+        case MathNode::GREATERLESS:
+        case MathNode::ADDSUB:
+        case MathNode::MULTDIV:
+        {
+            int end = (int)node->m_arguments.size();
+            CaretAssert(end > 1);
+            compile(node->m_arguments[0], outReg);
+            for (int i = 1; i < end; ++i)
+            {//left to right, each one combining the previous result with the next argument
+                compile(node->m_arguments[i], outReg + 1);
+                Instruction::OpCode op = Instruction::OR;
+                switch (node->m_type)
+                {
+                    case MathNode::OR:
+                        op = Instruction::OR;
+                        break;
+                    case MathNode::AND:
+                        op = Instruction::AND;
+                        break;
+                    case MathNode::EQUAL:
+                        op = (node->m_invert[i] ? Instruction::NOT_EQUAL : Instruction::EQUAL);
+                        break;
+                    case MathNode::GREATERLESS:
+                        if (node->m_inclusive[i])
+                        {
+                            op = (node->m_invert[i] ? Instruction::LESS_EQUAL : Instruction::GREATER_EQUAL);
+                        } else {
+                            op = (node->m_invert[i] ? Instruction::LESS : Instruction::GREATER);
+                        }
+                        break;
+                    case MathNode::ADDSUB:
+                        op = (node->m_invert[i] ? Instruction::SUBTRACT : Instruction::ADD);
+                        break;
+                    case MathNode::MULTDIV:
+                        op = (node->m_invert[i] ? Instruction::DIVIDE : Instruction::MULTIPLY);
+                        break;
+                    default:
+                        CaretAssert(0);
+                }
+                m_program.push_back(Instruction(op, outReg));
+            }
+            break;
+        }
+        case MathNode::NOT:
+            CaretAssert(node->m_arguments.size() == 1);
+            compile(node->m_arguments[0], outReg);
+            m_program.push_back(Instruction(Instruction::NOT, outReg));
+            break;
+        case MathNode::NEGATE:
+            CaretAssert(node->m_arguments.size() == 1);
+            compile(node->m_arguments[0], outReg);
+            m_program.push_back(Instruction(Instruction::NEGATE, outReg));
+            break;
+        case MathNode::POW:
+            CaretAssert(node->m_arguments.size() == 2);
+            compile(node->m_arguments[0], outReg);
+            compile(node->m_arguments[1], outReg + 1);
+            m_program.push_back(Instruction(Instruction::POW, outReg));
+            break;
+        case MathNode::FUNC:
+        {
+            int end = (int)node->m_arguments.size();
+            for (int i = 0; i < end; ++i)
+            {
+                compile(node->m_arguments[i], outReg + i);
+            }
+            Instruction temp(Instruction::FUNC, outReg);
+            temp.m_function = node->m_function;
+            m_program.push_back(temp);
+            break;
+        }
+        case MathNode::VAR:
+        {
+            Instruction temp(Instruction::LOAD_VAR, outReg);
+            temp.m_varIndex = node->m_varIndex;
+            m_program.push_back(temp);
+            break;
+        }
+        case MathNode::CONST:
+        {
+            Instruction temp(Instruction::LOAD_CONST, outReg);
+            temp.m_constVal = node->m_constVal;
+            m_program.push_back(temp);
+            break;
+        }
+        case MathNode::INVALID:
+            CaretAssertMessage(0, "parsing left INVALID MathNode");
+            throw CaretException("parsing problem in CaretMathExpression");
+    }
+}
+
+void CaretMathExpression::runProgram(double* registers, const vector<const float*>& variableData, const vector<int64_t>& variableStrides,
+                                     const int64_t& start, const int64_t& count) const
+{//each case must do exactly what MathNode::eval does, so that the results are identical
+    int numInstructions = (int)m_program.size();
+    for (int instr = 0; instr < numInstructions; ++instr)
+    {
+        const Instruction& myInstr = m_program[instr];
+        double* a = registers + myInstr.m_out * BATCH_SIZE;//output, and first operand
+        const double* b = a + BATCH_SIZE;//second operand, if any
+        const double* c = b + BATCH_SIZE;//third operand, if any
+        switch (myInstr.m_op)
+        {
+            case Instruction::LOAD_VAR:
+            {
+                CaretAssertVectorIndex(variableData, myInstr.m_varIndex);
+                const float* varData = variableData[myInstr.m_varIndex];
+                int64_t stride = variableStrides[myInstr.m_varIndex];
+                if (stride == 1)
+                {
+                    const float* varStart = varData + start;
+                    for (int64_t i = 0; i < count; ++i) a[i] = varStart[i];
+                } else {
+                    for (int64_t i = 0; i < count; ++i) a[i] = varData[(start + i) * stride];
+                }
+                break;
+            }
+            case Instruction::LOAD_CONST:
+            {
+                double value = myInstr.m_constVal;
+                for (int64_t i = 0; i < count; ++i) a[i] = value;
+                break;
+            }
+            case Instruction::OR:
+                for (int64_t i = 0; i < count; ++i) a[i] = ((a[i] > 0.0 || b[i] > 0.0) ? 1.0 : 0.0);//evaluates both sides, but there are no side effects, so it doesn't change the result
+                break;
+            case Instruction::AND:
+                for (int64_t i = 0; i < count; ++i) a[i] = ((a[i] > 0.0 && b[i] > 0.0) ? 1.0 : 0.0);
+                break;
+            case Instruction::EQUAL:
+            case Instruction::NOT_EQUAL:
+            {
+                double ifEqual = (myInstr.m_op == Instruction::EQUAL ? 1.0 : 0.0);
+                for (int64_t i = 0; i < count; ++i)
+                {
+                    float adjust = min(abs(a[i]), abs(b[i])) / 1000000;
+                    bool equal = (a[i] >= b[i] - adjust) && (a[i] <= b[i] + adjust);
+                    a[i] = (equal ? ifEqual : 1.0 - ifEqual);
+                }
+                break;
+            }
+            case Instruction::GREATER:
+                for (int64_t i = 0; i < count; ++i) a[i] = (a[i] > b[i] ? 1.0 : 0.0);
+                break;
+            case Instruction::LESS:
+                for (int64_t i = 0; i < count; ++i) a[i] = (a[i] < b[i] ? 1.0 : 0.0);
+                break;
+            case Instruction::GREATER_EQUAL:
+                for (int64_t i = 0; i < count; ++i)
+                {
+                    float adjust = min(abs(a[i]), abs(b[i])) / 1000000;
+                    a[i] = (a[i] >= b[i] - adjust ? 1.0 : 0.0);
+                }
+                break;
+            case Instruction::LESS_EQUAL:
+                for (int64_t i = 0; i < count; ++i)
+                {
+                    float adjust = min(abs(a[i]), abs(b[i])) / 1000000;
+                    a[i] = (a[i] <= b[i] + adjust ? 1.0 : 0.0);
+                }
+                break;
+            case Instruction::ADD:
+                for (int64_t i = 0; i < count; ++i) a[i] += b[i];
+                break;
+            case Instruction::SUBTRACT:
+                for (int64_t i = 0; i < count; ++i) a[i] -= b[i];
+                break;
+            case Instruction::MULTIPLY:
+                for (int64_t i = 0; i < count; ++i) a[i] *= b[i];
+                break;
+            case Instruction::DIVIDE:
+                for (int64_t i = 0; i < count; ++i) a[i] /= b[i];
+                break;
+            case Instruction::NOT:
+                for (int64_t i = 0; i < count; ++i) a[i] = (a[i] > 0.0 ? 0.0 : 1.0);
+                break;
+            case Instruction::NEGATE:
+                for (int64_t i = 0; i < count; ++i) a[i] = -a[i];
+                break;
+            case Instruction::POW:
+                for (int64_t i = 0; i < count; ++i) a[i] = pow(a[i], b[i]);
+                break;
+            case Instruction::FUNC:
+                switch (myInstr.m_function)
+                {
+                    case MathFunctionEnum::SIN:
+                        for (int64_t i = 0; i < count; ++i) a[i] = sin(a[i]);
+                        break;
+                    case MathFunctionEnum::COS:
+                        for (int64_t i = 0; i < count; ++i) a[i] = cos(a[i]);
+                        break;
+                    case MathFunctionEnum::TAN:
+                        for (int64_t i = 0; i < count; ++i) a[i] = tan(a[i]);
+                        break;
+                    case MathFunctionEnum::ASIN:
+                        for (int64_t i = 0; i < count; ++i) a[i] = asin(a[i]);
+                        break;
+                    case MathFunctionEnum::ACOS:
+                        for (int64_t i = 0; i < count; ++i) a[i] = acos(a[i]);
+                        break;
+                    case MathFunctionEnum::ATAN:
+                        for (int64_t i = 0; i < count; ++i) a[i] = atan(a[i]);
+                        break;
+                    case MathFunctionEnum::SINH:
+                        for (int64_t i = 0; i < count; ++i) a[i] = sinh(a[i]);
+                        break;
+                    case MathFunctionEnum::COSH:
+                        for (int64_t i = 0; i < count; ++i) a[i] = cosh(a[i]);
+                        break;
+                    case MathFunctionEnum::TANH:
+                        for (int64_t i = 0; i < count; ++i) a[i] = tanh(a[i]);
+                        break;
+                    case MathFunctionEnum::ASINH:
+                        for (int64_t i = 0; i < count; ++i)
+                        {
+                            double arg = a[i];
+                            if (arg > 0)
+                            {
+                                a[i] = log(arg + sqrt(arg * arg + 1));
+                            } else {
+                                a[i] = -log(-arg + sqrt(arg * arg + 1));
+                            }
+                        }
+                        break;
+                    case MathFunctionEnum::ACOSH:
+                        for (int64_t i = 0; i < count; ++i) a[i] = log(a[i] + sqrt(a[i] * a[i] - 1));
+                        break;
+                    case MathFunctionEnum::ATANH:
+                        for (int64_t i = 0; i < count; ++i) a[i] = 0.5 * log((1 + a[i]) / (1 - a[i]));
+                        break;
+                    case MathFunctionEnum::LN:
+                        for (int64_t i = 0; i < count; ++i) a[i] = log(a[i]);
+                        break;
+                    case MathFunctionEnum::EXP:
+                        for (int64_t i = 0; i < count; ++i) a[i] = exp(a[i]);
+                        break;
+                    case MathFunctionEnum::LOG:
+                        for (int64_t i = 0; i < count; ++i) a[i] = log10(a[i]);
+                        break;
+                    case MathFunctionEnum::SQRT:
+                        for (int64_t i = 0; i < count; ++i) a[i] = sqrt(a[i]);
+                        break;
+                    case MathFunctionEnum::ABS:
+                        for (int64_t i = 0; i < count; ++i) a[i] = abs(a[i]);
+                        break;
+                    case MathFunctionEnum::FLOOR:
+                        for (int64_t i = 0; i < count; ++i) a[i] = floor(a[i]);
+                        break;
+                    case MathFunctionEnum::ROUND:
+                        for (int64_t i = 0; i < count; ++i)
+                        {
+                            if (a[i] > 0.0)
+                            {
+                                a[i] = floor(a[i] + 0.5);
+                            } else {
+                                a[i] = ceil(a[i] - 0.5);
+                            }
+                        }
+                        break;
+                    case MathFunctionEnum::CEIL:
+                        for (int64_t i = 0; i < count; ++i) a[i] = ceil(a[i]);
+                        break;
+                    case MathFunctionEnum::ATAN2:
+                        for (int64_t i = 0; i < count; ++i) a[i] = atan2(a[i], b[i]);
+                        break;
+                    case MathFunctionEnum::MIN:
+                        for (int64_t i = 0; i < count; ++i) if (a[i] > b[i]) a[i] = b[i];
+                        break;
+                    case MathFunctionEnum::MAX:
+                        for (int64_t i = 0; i < count; ++i) if (a[i] < b[i]) a[i] = b[i];
+                        break;
+                    case MathFunctionEnum::MOD:
+                        for (int64_t i = 0; i < count; ++i)
+                        {
+                            if (b[i] == 0.0)
+                            {
+                                a[i] = 0.0;
+                            } else {
+                                a[i] = a[i] - b[i] * floor(a[i] / b[i]);
+                            }
+                        }
+                        break;
+                    case MathFunctionEnum::CLAMP:
+                        for (int64_t i = 0; i < count; ++i)
+                        {
+                            if (a[i] < b[i]) a[i] = b[i];
+                            if (a[i] > c[i]) a[i] = c[i];
+                        }
+                        break;
+                    case MathFunctionEnum::INVALID:
+                        CaretAssertMessage(0, "Instruction is type FUNC but INVALID function");
+                        throw CaretException("parsing problem in CaretMathExpression");
+                }
+                break;
+        }
+    }
+}
+
 vector<AString> CaretMathExpression::getVarNames() const
 {
     vector<AString> ret(m_varNames.size());
@@ -26,6 +26,7 @@
 #include "MathFunctionEnum.h"
 
 #include <map>
+#include <stdint.h>
 #include <vector>
 
 namespace caret {
@@ -63,6 +64,41 @@ class CaretMathExpression
         double eval(const std::vector<float>& values) const;
         AString toString(const std::vector<AString>& varNames) const;
     };
+    struct Instruction
+    {//bytecode for evaluating many elements at once, operands are registers starting at m_out, which also receives the result
+        enum OpCode
+        {
+            LOAD_VAR,
+            LOAD_CONST,
+            OR,
+            AND,
+            EQUAL,
+            NOT_EQUAL,
+            GREATER,
+            LESS,
+            GREATER_EQUAL,
+            LESS_EQUAL,
+            ADD,
+            SUBTRACT,
+            MULTIPLY,
+            DIVIDE,
+            NOT,
+            NEGATE,
+            POW,
+            FUNC
+        };
+        OpCode m_op;
+        MathFunctionEnum::Enum m_function;
+        int m_out;
+        int m_varIndex;
+        double m_constVal;
+        Instruction(const OpCode& op, const int& out) { m_op = op; m_out = out; m_function = MathFunctionEnum::INVALID; m_varIndex = -1; m_constVal = 0.0; }
+    };
+    std::vector<Instruction> m_program;
+    int m_numRegisters;
+    void compile(const MathNode* node, const int& outReg);
+    void runProgram(double* registers, const std::vector<const float*>& variableData, const std::vector<int64_t>& variableStrides,
+                    const int64_t& start, const int64_t& count) const;//registers must be m_numRegisters * BATCH_SIZE
     std::map<AString, int> m_varNames;
     AString m_input;
     int m_position, m_end;
@@ -86,6 +122,11 @@ public:
     static bool getNamedConstant(const AString& name, double& valueOut);
     CaretMathExpression(const AString& expression);
     double evaluate(const std::vector<float>& variableValues) const;
+    ///evaluate count elements into dataOut, variable i of element j is variableData[i][j * variableStrides[i]], empty variableStrides means all 1, use stride 0 for a constant
+    ///uses compiled bytecode that runs each operation over a batch of elements, results are identical to evaluate(), splits the work across threads when count is large
+    void evaluateMany(float* dataOut, const std::vector<const float*>& variableData, const int64_t& count,
+                      const std::vector<int64_t>& variableStrides = std::vector<int64_t>()) const;
+    static const int64_t BATCH_SIZE;
     std::vector<AString> getVarNames() const;
     AString toString() const;//the expression, with a lot of parentheses added
 };
@@ -0,0 +1,237 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretTriangleLocator.h"
+
+#include "CaretAssert.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    struct CentroidCompare
+    {
+        const float* m_centroids;
+        int32_t m_axis;
+        CentroidCompare(const float* centroids, const int32_t axis) : m_centroids(centroids), m_axis(axis) { }
+        bool operator()(const int32_t& lhs, const int32_t& rhs) const
+        {
+            return m_centroids[lhs * 3 + m_axis] < m_centroids[rhs * 3 + m_axis];
+        }
+    };
+}
+
+CaretTriangleLocator::CaretTriangleLocator(const float* coordsIn, const int64_t numCoords, const int32_t* trianglesIn, const int64_t numTriangles)
+{
+    m_coords.assign(coordsIn, coordsIn + numCoords * 3);
+    vector<int32_t> validTriangles;
+    validTriangles.reserve(numTriangles * 3);
+    m_triangleIndex.reserve(numTriangles);
+    for (int64_t i = 0; i < numTriangles; ++i)
+    {
+        const int32_t* thisTri = trianglesIn + i * 3;
+        if (thisTri[0] < 0 || thisTri[1] < 0 || thisTri[2] < 0 || thisTri[0] >= numCoords || thisTri[1] >= numCoords || thisTri[2] >= numCoords) continue;//can't hit a triangle that isn't there
+        validTriangles.insert(validTriangles.end(), thisTri, thisTri + 3);
+        m_triangleIndex.push_back(i);
+    }
+    const int32_t numValid = (int32_t)m_triangleIndex.size();
+    if (numValid == 0) return;
+    vector<float> centroids(numValid * 3);
+    vector<int32_t> order(numValid);
+    for (int32_t i = 0; i < numValid; ++i)
+    {
+        order[i] = i;
+        for (int axis = 0; axis < 3; ++axis)
+        {//we only compare centroids, so skip dividing by 3
+            centroids[i * 3 + axis] = m_coords[validTriangles[i * 3] * 3 + axis] + m_coords[validTriangles[i * 3 + 1] * 3 + axis] + m_coords[validTriangles[i * 3 + 2] * 3 + axis];
+        }
+    }
+    m_nodes.reserve(2 * (numValid / NUM_TRIANGLES_SPLIT + 1));
+    buildNode(order, centroids, validTriangles, 0, numValid);
+    m_triangles.resize(numValid * 3);//put the triangles in tree order, so leaves are contiguous
+    vector<int64_t> origIndex(numValid);
+    for (int32_t i = 0; i < numValid; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            m_triangles[i * 3 + j] = validTriangles[order[i] * 3 + j];
+        }
+        origIndex[i] = m_triangleIndex[order[i]];
+    }
+    m_triangleIndex.swap(origIndex);
+}
+
+int32_t CaretTriangleLocator::buildNode(vector<int32_t>& order, const vector<float>& centroids, const vector<int32_t>& triangles, const int32_t start, const int32_t end)
+{
+    CaretAssert(end > start);
+    const int32_t myIndex = (int32_t)m_nodes.size();
+    m_nodes.push_back(Node());//don't keep a reference, the recursion reallocates
+    float nodeMin[3], nodeMax[3], centMin[3], centMax[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        nodeMin[axis] = centMin[axis] = numeric_limits<float>::max();
+        nodeMax[axis] = centMax[axis] = -numeric_limits<float>::max();
+    }
+    for (int32_t i = start; i < end; ++i)
+    {
+        const int32_t thisTri = order[i];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float centroid = centroids[thisTri * 3 + axis];
+            if (centroid < centMin[axis]) centMin[axis] = centroid;
+            if (centroid > centMax[axis]) centMax[axis] = centroid;
+            for (int j = 0; j < 3; ++j)
+            {
+                const float coord = m_coords[triangles[thisTri * 3 + j] * 3 + axis];
+                if (coord < nodeMin[axis]) nodeMin[axis] = coord;
+                if (coord > nodeMax[axis]) nodeMax[axis] = coord;
+            }
+        }
+    }
+    int32_t splitAxis = 0;
+    for (int axis = 1; axis < 3; ++axis)
+    {
+        if (centMax[axis] - centMin[axis] > centMax[splitAxis] - centMin[splitAxis]) splitAxis = axis;
+    }
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        m_nodes[myIndex].m_min[axis] = nodeMin[axis];
+        m_nodes[myIndex].m_max[axis] = nodeMax[axis];
+    }
+    const int32_t count = end - start;
+    if (count <= NUM_TRIANGLES_SPLIT || centMax[splitAxis] <= centMin[splitAxis])//identical centroids can't be split
+    {
+        m_nodes[myIndex].m_start = start;
+        m_nodes[myIndex].m_count = count;
+        m_nodes[myIndex].m_axis = splitAxis;
+        return myIndex;
+    }
+    const int32_t mid = start + count / 2;//median split keeps the depth logarithmic
+    nth_element(order.begin() + start, order.begin() + mid, order.begin() + end, CentroidCompare(centroids.data(), splitAxis));
+    buildNode(order, centroids, triangles, start, mid);//first child immediately follows
+    const int32_t secondChild = buildNode(order, centroids, triangles, mid, end);
+    m_nodes[myIndex].m_start = secondChild;
+    m_nodes[myIndex].m_count = 0;
+    m_nodes[myIndex].m_axis = splitAxis;
+    return myIndex;
+}
+
+bool CaretTriangleLocator::rayHitsNode(const Node& node, const float origin[3], const float invDirection[3], const float maxDistance) const
+{
+    float tmin = 0.0f, tmax = maxDistance;
+    for (int axis = 0; axis < 3; ++axis)
+    {//NaN from a zero direction component on a slab boundary fails both comparisons, so that axis just doesn't restrict the range
+        float t1 = (node.m_min[axis] - origin[axis]) * invDirection[axis];
+        float t2 = (node.m_max[axis] - origin[axis]) * invDirection[axis];
+        if (t1 > t2) swap(t1, t2);
+        if (t1 > tmin) tmin = t1;
+        if (t2 < tmax) tmax = t2;
+        if (tmin > tmax) return false;
+    }
+    return true;
+}
+
+bool CaretTriangleLocator::rayHitsTriangle(const int32_t which, const float origin[3], const float direction[3], float& distanceOut, float& uOut, float& vOut) const
+{//Moller-Trumbore, in double because the edges of small triangles far from the origin lose precision
+    const float* vert0 = m_coords.data() + m_triangles[which * 3] * 3;
+    const float* vert1 = m_coords.data() + m_triangles[which * 3 + 1] * 3;
+    const float* vert2 = m_coords.data() + m_triangles[which * 3 + 2] * 3;
+    double edge1[3], edge2[3], svec[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        edge1[i] = (double)vert1[i] - vert0[i];
+        edge2[i] = (double)vert2[i] - vert0[i];
+        svec[i] = (double)origin[i] - vert0[i];
+    }
+    double pvec[3] = { direction[1] * edge2[2] - direction[2] * edge2[1],
+                       direction[2] * edge2[0] - direction[0] * edge2[2],
+                       direction[0] * edge2[1] - direction[1] * edge2[0] };
+    double det = edge1[0] * pvec[0] + edge1[1] * pvec[1] + edge1[2] * pvec[2];
+    if (det == 0.0) return false;//parallel or degenerate, either facing is accepted otherwise
+    double invDet = 1.0 / det;
+    double u = (svec[0] * pvec[0] + svec[1] * pvec[1] + svec[2] * pvec[2]) * invDet;
+    if (u < 0.0 || u > 1.0) return false;
+    double qvec[3] = { svec[1] * edge1[2] - svec[2] * edge1[1],
+                       svec[2] * edge1[0] - svec[0] * edge1[2],
+                       svec[0] * edge1[1] - svec[1] * edge1[0] };
+    double v = (direction[0] * qvec[0] + direction[1] * qvec[1] + direction[2] * qvec[2]) * invDet;
+    if (v < 0.0 || u + v > 1.0) return false;
+    double t = (edge2[0] * qvec[0] + edge2[1] * qvec[1] + edge2[2] * qvec[2]) * invDet;
+    if (t < 0.0) return false;
+    distanceOut = (float)t;
+    uOut = (float)u;
+    vOut = (float)v;
+    return true;
+}
+
+int64_t CaretTriangleLocator::closestRayHit(const float origin[3], const float direction[3], float* distanceOut, float baryWeightsOut[3]) const
+{
+    if (m_nodes.empty()) return -1;
+    float invDirection[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        invDirection[axis] = 1.0f / direction[axis];//infinity for zero components is what the slab test wants
+    }
+    int32_t bestTriangle = -1;
+    float bestDistance = numeric_limits<float>::infinity(), bestU = 0.0f, bestV = 0.0f;
+    vector<int32_t> nodeStack;
+    nodeStack.reserve(64);
+    nodeStack.push_back(0);
+    while (!nodeStack.empty())
+    {
+        const int32_t thisIndex = nodeStack.back();
+        nodeStack.pop_back();
+        const Node& thisNode = m_nodes[thisIndex];
+        if (!rayHitsNode(thisNode, origin, invDirection, bestDistance)) continue;//also prunes nodes entirely behind the closest hit so far
+        if (thisNode.m_count > 0)
+        {
+            const int32_t end = thisNode.m_start + thisNode.m_count;
+            for (int32_t i = thisNode.m_start; i < end; ++i)
+            {
+                float distance, u, v;
+                if (rayHitsTriangle(i, origin, direction, distance, u, v) && distance < bestDistance)
+                {
+                    bestTriangle = i;
+                    bestDistance = distance;
+                    bestU = u;
+                    bestV = v;
+                }
+            }
+        } else {
+            int32_t nearChild = thisIndex + 1, farChild = thisNode.m_start;
+            if (direction[thisNode.m_axis] < 0.0f) swap(nearChild, farChild);
+            nodeStack.push_back(farChild);
+            nodeStack.push_back(nearChild);//visit the near side first, so the far side is usually pruned
+        }
+    }
+    if (bestTriangle < 0) return -1;
+    if (distanceOut != NULL) *distanceOut = bestDistance;
+    if (baryWeightsOut != NULL)
+    {
+        baryWeightsOut[0] = 1.0f - bestU - bestV;
+        baryWeightsOut[1] = bestU;
+        baryWeightsOut[2] = bestV;
+    }
+    return m_triangleIndex[bestTriangle];
+}
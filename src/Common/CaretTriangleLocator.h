@@ -0,0 +1,61 @@
+#ifndef __CARET_TRIANGLE_LOCATOR_H__
+#define __CARET_TRIANGLE_LOCATOR_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+//NOTE: this is a bounding volume hierarchy over the triangles of a surface, for finding the first triangle a ray hits (for instance, the triangle under the mouse),
+//      it copies the coordinates and triangles, so it must be rebuilt when either changes
+//
+//NOTE: queries don't modify anything, so multiple threads can use the same instance concurrently
+
+#include "stdint.h"
+#include <cstddef>
+#include <vector>
+
+namespace caret {
+
+    class CaretTriangleLocator
+    {
+        struct Node
+        {
+            float m_min[3], m_max[3];
+            int32_t m_start, m_count;//leaf: range of m_triangles (in triangles), interior: m_start is the index of the second child (the first child follows the node), m_count is 0
+            int32_t m_axis;//interior: axis the children were split on
+        };
+        std::vector<Node> m_nodes;
+        std::vector<float> m_coords;
+        std::vector<int32_t> m_triangles;//3 vertices per triangle, in tree order, triangles with invalid vertices are left out
+        std::vector<int64_t> m_triangleIndex;//original index of each triangle in m_triangles
+        static const int NUM_TRIANGLES_SPLIT = 4;
+        int32_t buildNode(std::vector<int32_t>& order, const std::vector<float>& centroids, const std::vector<int32_t>& triangles, const int32_t start, const int32_t end);
+        bool rayHitsNode(const Node& node, const float origin[3], const float invDirection[3], const float maxDistance) const;
+        bool rayHitsTriangle(const int32_t which, const float origin[3], const float direction[3], float& distanceOut, float& uOut, float& vOut) const;
+        CaretTriangleLocator();
+    public:
+        ///make a triangle locator from surface coordinates and triangles (3 vertex indices each)
+        CaretTriangleLocator(const float* coordsIn, const int64_t numCoords, const int32_t* trianglesIn, const int64_t numTriangles);
+        ///find the closest triangle hit by a ray in either direction of facing, returns -1 if none - distance is in multiples of the direction vector, baryWeightsOut is per vertex of the triangle
+        int64_t closestRayHit(const float origin[3], const float direction[3], float* distanceOut = NULL, float baryWeightsOut[3] = NULL) const;
+    };
+
+}
+
+#endif //__CARET_TRIANGLE_LOCATOR_H__
@@ -0,0 +1,433 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+//try to force large file support, same as CaretBinaryFile
+#ifndef CARET_OS_MACOSX
+#define _LARGEFILE64_SOURCE
+#define _LFS64_LARGEFILE 1
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "GzipIndexedReader.h"
+
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "DataFileException.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace caret;
+using namespace std;
+
+const int64_t GzipIndexedReader::INDEX_SPAN = 1<<23;//8MiB of uncompressed data between access points, so 32KiB of window per 8MiB, and on average 4MiB to decompress per seek
+const int64_t GzipIndexedReader::WINDOW_SIZE = 1<<15;//maximum deflate distance
+bool GzipIndexedReader::s_indexCaching = false;
+
+namespace
+{
+    const int64_t INPUT_BUFFER_SIZE = 1<<18;
+    const int64_t SKIP_BUFFER_SIZE = 1<<18;
+    const int64_t INFLATE_CHUNK = 1<<26;//must fit in uInt
+    const char INDEX_MAGIC[8] = { 'W', 'B', 'G', 'Z', 'I', 'D', 'X', '1' };
+
+    template<typename T>
+    bool writeVal(FILE* file, const T& val)
+    {
+        return fwrite(&val, sizeof(T), 1, file) == 1;
+    }
+
+    template<typename T>
+    bool readVal(FILE* file, T& val)
+    {
+        return fread(&val, sizeof(T), 1, file) == 1;
+    }
+}
+
+GzipIndexedReader::GzipIndexedReader()
+{
+    m_file = NULL;
+    m_strmInit = false;
+    m_rawMode = false;
+    m_betweenMembers = false;
+    m_atEnd = false;
+    m_indexModified = false;
+    m_trailerSkip = 0;
+    m_windowFill = 0;
+    m_windowNext = 0;
+    m_fileReadPos = 0;
+    m_outPos = 0;
+    m_curPos = 0;
+    m_totalSize = -1;
+}
+
+GzipIndexedReader::~GzipIndexedReader()
+{
+    try//throwing from a destructor is a bad idea
+    {
+        close();
+    } catch (CaretException& e) {
+        CaretLogSevere(e.whatString());
+    } catch (exception& e) {
+        CaretLogSevere(e.what());
+    } catch (...) {
+        CaretLogSevere("caught unknown exception type while closing a compressed file");
+    }
+}
+
+void GzipIndexedReader::open(const QString& filename)
+{
+    close();
+    m_fileName = filename;
+    m_file = fopen(filename.toLocal8Bit().constData(), "rb");
+    if (m_file == NULL)
+    {
+        if (!QFileInfo(filename).exists())
+        {
+            throw DataFileException("failed to open compressed file '" + filename + "', file does not exist, or folder permissions prevent seeing it");
+        }
+        throw DataFileException("failed to open compressed file '" + filename + "'");
+    }
+    memset(&m_strm, 0, sizeof(m_strm));
+    if (inflateInit2(&m_strm, 47) != Z_OK)//32 + 15: automatic gzip or zlib header detection, max window
+    {
+        fclose(m_file);
+        m_file = NULL;
+        throw DataFileException("failed to initialize decompression for file '" + filename + "'");
+    }
+    m_strmInit = true;
+    m_inBuf.resize(INPUT_BUFFER_SIZE);
+    m_window.resize(WINDOW_SIZE);
+    AccessPoint start;
+    start.m_outPos = 0;
+    start.m_inPos = 0;
+    start.m_bits = 0;
+    m_index.push_back(start);
+    loadIndex();
+    restartAt(m_index[0]);
+    m_curPos = 0;
+}
+
+void GzipIndexedReader::close()
+{
+    if (m_file == NULL) return;
+    if (s_indexCaching && m_indexModified && m_totalSize >= 0)
+    {
+        saveIndex();
+    }
+    if (m_strmInit)
+    {
+        inflateEnd(&m_strm);
+        m_strmInit = false;
+    }
+    fclose(m_file);
+    m_file = NULL;
+    m_index.clear();
+    m_inBuf.clear();
+    m_window.clear();
+    m_skipBuf.clear();
+    m_totalSize = -1;
+    m_indexModified = false;
+    m_atEnd = false;
+    m_betweenMembers = false;
+    m_outPos = 0;
+    m_curPos = 0;
+}
+
+void GzipIndexedReader::fileSeek(const int64_t& position)
+{
+#ifdef CARET_OS_WINDOWS
+    int ret = _fseeki64(m_file, position, SEEK_SET);
+#else
+    int ret = fseeko(m_file, position, SEEK_SET);
+#endif
+    if (ret != 0) throw DataFileException("seek failed in compressed file '" + m_fileName + "'");
+    m_fileReadPos = position;
+}
+
+bool GzipIndexedReader::ensureInput()
+{
+    if (m_strm.avail_in > 0) return true;
+    size_t numRead = fread(m_inBuf.data(), 1, m_inBuf.size(), m_file);
+    if (numRead == 0)
+    {
+        if (ferror(m_file)) throw DataFileException("error while reading compressed file '" + m_fileName + "'");
+        return false;
+    }
+    m_fileReadPos += numRead;
+    m_strm.next_in = m_inBuf.data();
+    m_strm.avail_in = (uInt)numRead;
+    return true;
+}
+
+void GzipIndexedReader::addToWindow(const unsigned char* data, const int64_t& count)
+{
+    if (count >= WINDOW_SIZE)
+    {
+        memcpy(m_window.data(), data + count - WINDOW_SIZE, WINDOW_SIZE);
+        m_windowNext = 0;
+        m_windowFill = WINDOW_SIZE;
+        return;
+    }
+    int64_t firstPart = min(count, WINDOW_SIZE - m_windowNext);
+    memcpy(m_window.data() + m_windowNext, data, firstPart);
+    memcpy(m_window.data(), data + firstPart, count - firstPart);
+    m_windowNext = (m_windowNext + count) % WINDOW_SIZE;
+    m_windowFill = min(m_windowFill + count, WINDOW_SIZE);
+}
+
+void GzipIndexedReader::maybeAddAccessPoint()
+{
+    CaretAssert(!m_index.empty());
+    if (m_outPos - m_index.back().m_outPos < INDEX_SPAN) return;//also prevents adding points when redoing an already indexed section
+    m_index.push_back(AccessPoint());
+    AccessPoint& newPoint = m_index.back();
+    newPoint.m_outPos = m_outPos;
+    newPoint.m_inPos = m_fileReadPos - m_strm.avail_in;
+    newPoint.m_bits = m_strm.data_type & 7;
+    newPoint.m_window.resize(m_windowFill);//linearize the circular buffer
+    int64_t start = (m_windowNext - m_windowFill + WINDOW_SIZE) % WINDOW_SIZE;
+    int64_t firstPart = min(m_windowFill, WINDOW_SIZE - start);
+    memcpy(newPoint.m_window.data(), m_window.data() + start, firstPart);
+    memcpy(newPoint.m_window.data() + firstPart, m_window.data(), m_windowFill - firstPart);
+    m_indexModified = true;
+}
+
+void GzipIndexedReader::restartAt(const AccessPoint& point)
+{
+    m_strm.avail_in = 0;
+    m_strm.next_in = Z_NULL;
+    if (point.m_outPos == 0)
+    {//start of file, has the gzip header
+        if (inflateReset2(&m_strm, 47) != Z_OK) throw DataFileException("failed to reset decompression for file '" + m_fileName + "'");
+        m_rawMode = false;
+        fileSeek(0);
+    } else {
+        if (inflateReset2(&m_strm, -15) != Z_OK) throw DataFileException("failed to reset decompression for file '" + m_fileName + "'");//raw deflate, we are in the middle of the stream
+        m_rawMode = true;
+        if (point.m_bits != 0)
+        {
+            fileSeek(point.m_inPos - 1);
+            int partial = fgetc(m_file);
+            if (partial == EOF) throw DataFileException("error while reading compressed file '" + m_fileName + "'");
+            m_fileReadPos += 1;
+            inflatePrime(&m_strm, point.m_bits, partial >> (8 - point.m_bits));
+        } else {
+            fileSeek(point.m_inPos);
+        }
+        if (inflateSetDictionary(&m_strm, point.m_window.data(), (uInt)point.m_window.size()) != Z_OK)
+        {
+            throw DataFileException("failed to restore decompression state for file '" + m_fileName + "'");
+        }
+    }
+    m_windowFill = 0;
+    m_windowNext = 0;
+    addToWindow(point.m_window.data(), (int64_t)point.m_window.size());
+    m_outPos = point.m_outPos;
+    m_betweenMembers = false;
+    m_atEnd = false;
+    m_trailerSkip = 0;
+}
+
+int64_t GzipIndexedReader::inflateInto(unsigned char* out, const int64_t& count)
+{
+    int64_t produced = 0;
+    while (produced < count && !m_atEnd)
+    {
+        if (m_betweenMembers)
+        {//gzip allows concatenated members, and some tools append zero padding, which gzread ignores
+            while (m_trailerSkip > 0)//raw mode doesn't know about the gzip trailer
+            {
+                if (!ensureInput()) break;//zlib format has a shorter trailer, and we don't care if the crc is missing
+                int skip = (int)min((int64_t)m_trailerSkip, (int64_t)m_strm.avail_in);
+                m_strm.next_in += skip;
+                m_strm.avail_in -= skip;
+                m_trailerSkip -= skip;
+            }
+            if (!ensureInput() || m_strm.next_in[0] != 0x1f)
+            {
+                m_atEnd = true;
+                if (m_totalSize < 0)
+                {
+                    m_totalSize = m_outPos;
+                    m_indexModified = true;
+                }
+                break;
+            }
+            if (inflateReset2(&m_strm, 47) != Z_OK) throw DataFileException("failed to reset decompression for file '" + m_fileName + "'");
+            m_rawMode = false;
+            m_betweenMembers = false;
+        }
+        if (!ensureInput()) throw DataFileException("premature end of file in compressed file '" + m_fileName + "'");
+        uInt toProduce = (uInt)min(count - produced, INFLATE_CHUNK);
+        m_strm.next_out = out + produced;
+        m_strm.avail_out = toProduce;
+        int ret = inflate(&m_strm, Z_BLOCK);//stop at block boundaries, so we can record access points
+        switch (ret)
+        {
+            case Z_OK:
+            case Z_STREAM_END:
+            case Z_BUF_ERROR://no progress possible, more input will be read next iteration
+                break;
+            case Z_MEM_ERROR:
+                throw DataFileException("out of memory while decompressing file '" + m_fileName + "'");
+            default://Z_NEED_DICT, Z_DATA_ERROR, Z_STREAM_ERROR
+                throw DataFileException("error decompressing file '" + m_fileName + "', file may be corrupt");
+        }
+        int64_t numOut = toProduce - m_strm.avail_out;
+        addToWindow(out + produced, numOut);
+        produced += numOut;
+        m_outPos += numOut;
+        if (ret == Z_STREAM_END)
+        {
+            m_betweenMembers = true;
+            m_trailerSkip = (m_rawMode ? 8 : 0);//crc32 and length
+            continue;
+        }
+        if ((m_strm.data_type & 128) && !(m_strm.data_type & 64))//just after the end of a block that isn't the last
+        {
+            maybeAddAccessPoint();
+        }
+    }
+    return produced;
+}
+
+void GzipIndexedReader::reposition()
+{
+    if (m_curPos == m_outPos) return;
+    int64_t low = 0, high = (int64_t)m_index.size();//find the last access point at or before the requested position
+    while (high - low > 1)
+    {
+        int64_t mid = (low + high) / 2;
+        if (m_index[mid].m_outPos <= m_curPos)
+        {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    if (m_curPos < m_outPos || m_index[low].m_outPos > m_outPos)//restoring an access point is cheaper than decompressing up to it
+    {
+        restartAt(m_index[low]);
+    }
+    if (m_skipBuf.empty()) m_skipBuf.resize(SKIP_BUFFER_SIZE);
+    while (m_outPos < m_curPos && !m_atEnd)
+    {
+        inflateInto(m_skipBuf.data(), min(m_curPos - m_outPos, SKIP_BUFFER_SIZE));
+    }
+}
+
+void GzipIndexedReader::seek(const int64_t& position)
+{
+    if (m_file == NULL) throw DataFileException("seek called on unopened GzipIndexedReader");
+    if (position < 0) throw DataFileException("seek to negative position in compressed file '" + m_fileName + "'");
+    m_curPos = position;//defer the work until a read, so multiple seeks in a row are cheap
+}
+
+int64_t GzipIndexedReader::read(void* dataOut, const int64_t& count)
+{
+    if (m_file == NULL) throw DataFileException("read called on unopened GzipIndexedReader");
+    reposition();
+    if (m_outPos != m_curPos) return 0;//seeked past the end
+    int64_t ret = inflateInto((unsigned char*)dataOut, count);
+    m_curPos = m_outPos;
+    return ret;
+}
+
+QString GzipIndexedReader::getIndexFileName() const
+{
+    return m_fileName + ".wbgzidx";
+}
+
+void GzipIndexedReader::loadIndex()
+{//NOTE: index files are a machine-local cache, so native byte order and type sizes are used, and anything unexpected just means ignore it
+    if (!s_indexCaching) return;
+    QString indexName = getIndexFileName();
+    QFileInfo indexInfo(indexName), dataInfo(m_fileName);
+    if (!indexInfo.exists()) return;
+    FILE* indexFile = fopen(indexName.toLocal8Bit().constData(), "rb");
+    if (indexFile == NULL) return;
+    char magic[8];
+    int64_t dataSize, dataModified, span, totalSize, numPoints;
+    bool ok = fread(magic, 1, 8, indexFile) == 8 && memcmp(magic, INDEX_MAGIC, 8) == 0 &&
+              readVal(indexFile, dataSize) && readVal(indexFile, dataModified) && readVal(indexFile, span) &&
+              readVal(indexFile, totalSize) && readVal(indexFile, numPoints);
+    ok = ok && dataSize == dataInfo.size() && dataModified == dataInfo.lastModified().toMSecsSinceEpoch() && numPoints > 0 && totalSize >= 0;
+    vector<AccessPoint> newIndex;
+    for (int64_t i = 0; ok && i < numPoints; ++i)
+    {
+        AccessPoint point;
+        int64_t windowSize;
+        int32_t bits;
+        ok = readVal(indexFile, point.m_outPos) && readVal(indexFile, point.m_inPos) && readVal(indexFile, bits) && readVal(indexFile, windowSize);
+        ok = ok && bits >= 0 && bits < 8 && windowSize >= 0 && windowSize <= WINDOW_SIZE && (i == 0) == (point.m_outPos == 0);
+        if (!ok) break;
+        point.m_bits = bits;
+        point.m_window.resize(windowSize);
+        ok = (windowSize == 0 || fread(point.m_window.data(), 1, windowSize, indexFile) == (size_t)windowSize);
+        if (i > 0 && point.m_outPos <= newIndex.back().m_outPos) ok = false;
+        newIndex.push_back(point);
+    }
+    fclose(indexFile);
+    if (ok)
+    {
+        m_index = newIndex;
+        m_totalSize = totalSize;
+        m_indexModified = false;
+        CaretLogFine("loaded gzip index '" + indexName + "' with " + QString::number(numPoints) + " access points");
+    } else {
+        CaretLogFine("ignoring stale or invalid gzip index '" + indexName + "'");
+    }
+}
+
+void GzipIndexedReader::saveIndex()
+{
+    QString indexName = getIndexFileName();
+    QFileInfo dataInfo(m_fileName);
+    FILE* indexFile = fopen(indexName.toLocal8Bit().constData(), "wb");
+    if (indexFile == NULL)
+    {
+        CaretLogFine("unable to write gzip index '" + indexName + "'");//it is just a cache, so this is not a problem
+        return;
+    }
+    int64_t dataSize = dataInfo.size(), dataModified = dataInfo.lastModified().toMSecsSinceEpoch(), span = INDEX_SPAN, numPoints = (int64_t)m_index.size();
+    bool ok = fwrite(INDEX_MAGIC, 1, 8, indexFile) == 8 &&
+              writeVal(indexFile, dataSize) && writeVal(indexFile, dataModified) && writeVal(indexFile, span) &&
+              writeVal(indexFile, m_totalSize) && writeVal(indexFile, numPoints);
+    for (int64_t i = 0; ok && i < numPoints; ++i)
+    {
+        const AccessPoint& point = m_index[i];
+        int64_t windowSize = (int64_t)point.m_window.size();
+        int32_t bits = point.m_bits;
+        ok = writeVal(indexFile, point.m_outPos) && writeVal(indexFile, point.m_inPos) && writeVal(indexFile, bits) && writeVal(indexFile, windowSize);
+        ok = ok && (windowSize == 0 || fwrite(point.m_window.data(), 1, windowSize, indexFile) == (size_t)windowSize);
+    }
+    if (fclose(indexFile) != 0) ok = false;
+    if (!ok)
+    {
+        CaretLogFine("failed to write gzip index '" + indexName + "'");
+        remove(indexName.toLocal8Bit().constData());//don't leave a truncated index around
+    } else {
+        m_indexModified = false;
+    }
+}
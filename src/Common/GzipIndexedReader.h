@@ -0,0 +1,95 @@
+#ifndef __GZIP_INDEXED_READER_H__
+#define __GZIP_INDEXED_READER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <QString>
+
+#include "zlib.h"
+
+#include <cstdio>
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+
+    ///read-only random access into gzip files, using the method from zran.c in the zlib examples
+    ///while decompressing, it saves the decompressor state (position and previous 32KiB of output) every INDEX_SPAN bytes at deflate block boundaries,
+    ///so a backwards or far seek only needs to decompress from the nearest saved point, instead of from the start of the file like gzseek
+    class GzipIndexedReader
+    {
+        struct AccessPoint
+        {
+            int64_t m_outPos;//uncompressed position
+            int64_t m_inPos;//compressed position of the first byte that isn't entirely consumed
+            int m_bits;//number of bits from the byte before m_inPos that are still needed, 0 if byte aligned
+            std::vector<unsigned char> m_window;//previous (up to) 32KiB of uncompressed data, empty for the start of the file
+        };
+        FILE* m_file;
+        QString m_fileName;
+        z_stream m_strm;
+        bool m_strmInit, m_rawMode, m_betweenMembers, m_atEnd, m_indexModified;
+        int m_trailerSkip;
+        std::vector<unsigned char> m_inBuf, m_window, m_skipBuf;
+        int64_t m_windowFill, m_windowNext;//circular buffer of the most recent output
+        int64_t m_fileReadPos;//compressed position just past what has been put into m_inBuf
+        int64_t m_outPos;//uncompressed position of the decompressor
+        int64_t m_curPos;//position the caller wants, seek is lazy
+        int64_t m_totalSize;//-1 until the end of the data has been found
+        std::vector<AccessPoint> m_index;//always contains the start of the file, sorted by position
+
+        static bool s_indexCaching;
+
+        bool ensureInput();
+        int64_t inflateInto(unsigned char* out, const int64_t& count);//returns less than count only at end of data
+        void addToWindow(const unsigned char* data, const int64_t& count);
+        void maybeAddAccessPoint();
+        void restartAt(const AccessPoint& point);
+        void reposition();
+        void fileSeek(const int64_t& position);
+        QString getIndexFileName() const;
+        void loadIndex();
+        void saveIndex();
+        GzipIndexedReader(const GzipIndexedReader&);
+        GzipIndexedReader& operator=(const GzipIndexedReader&);
+    public:
+        static const int64_t INDEX_SPAN;
+        static const int64_t WINDOW_SIZE;
+
+        GzipIndexedReader();
+        ~GzipIndexedReader();
+        void open(const QString& filename);
+        void close();//writes the index sidecar file if caching is enabled and the index is complete and new
+        bool isOpen() const { return m_file != NULL; }
+        void seek(const int64_t& position);//seeking past the end is not an error until something is read
+        int64_t pos() const { return m_curPos; }
+        int64_t read(void* dataOut, const int64_t& count);//returns number of bytes read, less than count only at end of data, throws on error
+        int64_t size() const { return m_totalSize; }//-1 if the end hasn't been reached (or the index wasn't loaded from cache)
+        int64_t getNumAccessPoints() const { return (int64_t)m_index.size(); }
+
+        ///whether to save the index as a sidecar file (filename + ".wbgzidx") after reaching the end of a file, and use it when opening the file again
+        static void setIndexCaching(const bool& enabled) { s_indexCaching = enabled; }
+        static bool getIndexCaching() { return s_indexCaching; }
+    };
+
+}
+
+#endif //__GZIP_INDEXED_READER_H__
@@ -0,0 +1,219 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+//try to force large file support, same as CaretBinaryFile
+#ifndef CARET_OS_MACOSX
+#define _LARGEFILE64_SOURCE
+#define _LFS64_LARGEFILE 1
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "GzipParallelWriter.h"
+
+#include "CaretLogger.h"
+#include "CaretOMP.h"
+#include "DataFileException.h"
+
+#include "zlib.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace caret;
+using namespace std;
+
+const int64_t GzipParallelWriter::BLOCK_SIZE = 1<<18;//256KiB, about the same compression ratio as a single stream when using the previous block as dictionary
+
+namespace
+{
+    const int64_t WINDOW_SIZE = 1<<15;//maximum deflate distance, and maximum dictionary size
+    const int BLOCKS_PER_THREAD = 4;//so that threads that get easily compressible blocks don't sit idle much
+
+    //deflate one block as part of a raw deflate stream, ending either with a sync flush (byte aligned, not final) or the final block
+    bool deflateBlock(const unsigned char* dict, const int64_t& dictSize, const unsigned char* data, const int64_t& size,
+                      const int& level, const bool& final, vector<unsigned char>& out)
+    {
+        z_stream strm;
+        memset(&strm, 0, sizeof(strm));
+        if (deflateInit2(&strm, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) return false;
+        bool ok = true;
+        if (dictSize > 0 && deflateSetDictionary(&strm, dict, dictSize) != Z_OK) ok = false;
+        out.resize(deflateBound(&strm, size) + 16);//sync flush marker and final empty block aren't counted by deflateBound
+        strm.next_in = (Bytef*)data;
+        strm.avail_in = size;
+        int64_t used = 0;
+        const int flush = (final ? Z_FINISH : Z_SYNC_FLUSH);
+        while (ok)
+        {
+            if (used == (int64_t)out.size()) out.resize(out.size() * 2);
+            strm.next_out = out.data() + used;
+            strm.avail_out = out.size() - used;
+            int ret = deflate(&strm, flush);
+            used = out.size() - strm.avail_out;
+            if (ret == Z_STREAM_END) break;
+            if (ret != Z_OK && ret != Z_BUF_ERROR) ok = false;
+            if (!final && strm.avail_in == 0 && strm.avail_out != 0) break;//sync flush is complete when there is output space left over
+        }
+        out.resize(used);
+        deflateEnd(&strm);
+        return ok;
+    }
+}
+
+GzipParallelWriter::GzipParallelWriter()
+{
+    m_file = NULL;
+    m_level = Z_DEFAULT_COMPRESSION;
+    m_dictSize = 0;
+    m_batchSize = BLOCK_SIZE;
+    m_crc = 0;
+    m_totalIn = 0;
+}
+
+GzipParallelWriter::~GzipParallelWriter()
+{
+    try//throwing from a destructor is a bad idea
+    {
+        close();
+    } catch (CaretException& e) {
+        CaretLogSevere(e.whatString());
+    } catch (exception& e) {
+        CaretLogSevere(e.what());
+    } catch (...) {
+        CaretLogSevere("caught unknown exception type while closing a compressed file");
+    }
+}
+
+void GzipParallelWriter::open(const QString& filename, const int& level)
+{
+    close();
+    m_fileName = filename;
+    m_level = level;
+    m_file = fopen(filename.toLocal8Bit().constData(), "wb");
+    if (m_file == NULL)
+    {
+        throw DataFileException("failed to open compressed file '" + filename + "', unable to create file");
+    }
+    int numThreads = 1;
+#ifdef CARET_OMP
+    numThreads = omp_get_max_threads();
+#endif
+    m_batchSize = BLOCK_SIZE * BLOCKS_PER_THREAD * numThreads;
+    m_pending.clear();
+    m_pending.reserve(m_batchSize + WINDOW_SIZE);
+    m_dictSize = 0;
+    m_crc = crc32(0L, Z_NULL, 0);
+    m_totalIn = 0;
+    const unsigned char header[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 255 };//deflate, no flags, no mtime, unknown OS
+    writeOut(header, 10);
+}
+
+void GzipParallelWriter::write(const void* dataIn, const int64_t& count)
+{
+    if (m_file == NULL) throw DataFileException("write called on unopened GzipParallelWriter");//shouldn't happen
+    const unsigned char* data = (const unsigned char*)dataIn;
+    int64_t done = 0;
+    while (done < count)
+    {//copy only up to the batch size at a time, so a huge write doesn't mean a huge buffer
+        int64_t pendingNew = (int64_t)m_pending.size() - m_dictSize;
+        int64_t toCopy = min(count - done, m_batchSize - pendingNew);
+        m_pending.insert(m_pending.end(), data + done, data + done + toCopy);
+        done += toCopy;
+        if ((int64_t)m_pending.size() - m_dictSize >= m_batchSize) compressPending(false);
+    }
+}
+
+void GzipParallelWriter::compressPending(const bool& final)
+{
+    const int64_t pendingNew = (int64_t)m_pending.size() - m_dictSize;
+    int64_t numBlocks = pendingNew / BLOCK_SIZE;//only compress full blocks, except at the end
+    if (final && (numBlocks * BLOCK_SIZE < pendingNew || numBlocks == 0)) ++numBlocks;//always compress at least one block at the end, to finish the deflate stream
+    if (numBlocks == 0) return;
+    if ((int64_t)m_outBlocks.size() < numBlocks)
+    {
+        m_outBlocks.resize(numBlocks);
+        m_blockCrcs.resize(numBlocks);
+    }
+    const unsigned char* pendingData = m_pending.data();
+    const int64_t pendingSize = (int64_t)m_pending.size();
+    int failed = 0;
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int64_t i = 0; i < numBlocks; ++i)
+    {
+        int64_t start = m_dictSize + i * BLOCK_SIZE;
+        int64_t size = min(BLOCK_SIZE, pendingSize - start);
+        int64_t dictStart = max((int64_t)0, start - WINDOW_SIZE);
+        bool lastBlock = final && (i == numBlocks - 1);
+        if (!deflateBlock(pendingData + dictStart, start - dictStart, pendingData + start, size, m_level, lastBlock, m_outBlocks[i]))
+        {
+#pragma omp atomic
+            ++failed;
+        }
+        m_blockCrcs[i] = crc32(crc32(0L, Z_NULL, 0), pendingData + start, size);
+    }
+    if (failed != 0) throw DataFileException("error while compressing data for file '" + m_fileName + "'");
+    for (int64_t i = 0; i < numBlocks; ++i)
+    {
+        int64_t size = min(BLOCK_SIZE, pendingSize - (m_dictSize + i * BLOCK_SIZE));
+        writeOut(m_outBlocks[i].data(), m_outBlocks[i].size());
+        m_crc = crc32_combine(m_crc, m_blockCrcs[i], size);
+        m_totalIn += size;
+    }
+    const int64_t consumedEnd = min(pendingSize, m_dictSize + numBlocks * BLOCK_SIZE);
+    const int64_t keepFrom = max((int64_t)0, consumedEnd - WINDOW_SIZE);//keep the last 32KiB of compressed input as dictionary for the next block
+    m_pending.erase(m_pending.begin(), m_pending.begin() + keepFrom);
+    m_dictSize = consumedEnd - keepFrom;
+}
+
+void GzipParallelWriter::writeOut(const void* data, const int64_t& count)
+{
+    if (count == 0) return;
+    if (fwrite(data, 1, count, m_file) != (size_t)count)
+    {
+        throw DataFileException("failed to write to compressed file '" + m_fileName + "'");
+    }
+}
+
+void GzipParallelWriter::close()
+{
+    if (m_file == NULL) return;//happens when closed and then destroyed, error opening
+    try
+    {
+        compressPending(true);
+        unsigned char trailer[8];
+        for (int i = 0; i < 4; ++i)
+        {//gzip trailer is little endian, crc then length mod 2^32
+            trailer[i] = (unsigned char)(m_crc >> (8 * i));
+            trailer[i + 4] = (unsigned char)(((uint64_t)m_totalIn) >> (8 * i));
+        }
+        writeOut(trailer, 8);
+    } catch (...) {
+        fclose(m_file);
+        m_file = NULL;
+        throw;
+    }
+    int ret = fclose(m_file);
+    m_file = NULL;
+    m_pending.clear();
+    m_dictSize = 0;
+    m_outBlocks.clear();
+    m_blockCrcs.clear();
+    if (ret != 0) throw DataFileException("error closing compressed file '" + m_fileName + "'");
+}
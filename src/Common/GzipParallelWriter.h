@@ -0,0 +1,66 @@
+#ifndef __GZIP_PARALLEL_WRITER_H__
+#define __GZIP_PARALLEL_WRITER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <QString>
+
+#include <cstdio>
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+
+    ///writes standard gzip files using multiple threads, in the way pigz does
+    ///input is split into BLOCK_SIZE blocks that are deflated independently, each using the previous 32KiB of input as its dictionary,
+    ///and ending on a byte boundary via a sync flush, so the compressed blocks can simply be concatenated into one deflate stream
+    class GzipParallelWriter
+    {
+        FILE* m_file;
+        QString m_fileName;
+        int m_level;
+        std::vector<unsigned char> m_pending;//input that hasn't been compressed yet, preceded by up to 32KiB of dictionary
+        int64_t m_dictSize;//amount of m_pending that is dictionary from previously compressed input
+        int64_t m_batchSize;//compress when this much new input is pending
+        uint32_t m_crc;
+        int64_t m_totalIn;
+        std::vector<std::vector<unsigned char> > m_outBlocks;
+        std::vector<uint32_t> m_blockCrcs;
+
+        void compressPending(const bool& final);
+        void writeOut(const void* data, const int64_t& count);
+        GzipParallelWriter(const GzipParallelWriter&);
+        GzipParallelWriter& operator=(const GzipParallelWriter&);
+    public:
+        static const int64_t BLOCK_SIZE;
+
+        GzipParallelWriter();
+        ~GzipParallelWriter();
+        void open(const QString& filename, const int& level = -1);//-1 is Z_DEFAULT_COMPRESSION
+        void close();//compresses the remaining data and writes the gzip trailer
+        bool isOpen() const { return m_file != NULL; }
+        void write(const void* dataIn, const int64_t& count);
+        int64_t pos() const { return m_totalIn + ((int64_t)m_pending.size() - m_dictSize); }//uncompressed bytes written so far, including those not yet compressed
+    };
+
+}
+
+#endif //__GZIP_PARALLEL_WRITER_H__
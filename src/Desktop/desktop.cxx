@@ -42,6 +42,7 @@
 #include "ApplicationInformation.h"
 #include "BrainBrowserWindow.h"
 #include "BrainOpenGL.h"
+#include "BrainOpenGLVolumeSliceDrawing.h"
 #include "BrainOpenGLWidget.h"
 #include "CaretAssert.h"
 #include "CaretCommandLine.h"
@@ -58,6 +59,8 @@
 #include "SessionManager.h"
 #include "SplashScreen.h"
 #include "SystemUtilities.h"
+#include "VolumeFile.h"
+#include "VolumeFileVoxelColorizer.h"
 #include "WuQMessageBox.h"
 #include "WuQtUtilities.h"
 
@@ -739,6 +742,10 @@ void printHelp(const AString& progName)
     << "    -no-splash" << endl
     << "        disable all splash screens" << endl
     << endl
+    << "    -no-volume-slice-textures" << endl
+    << "        draw each voxel of volume slices as a separate" << endl
+    << "        polygon instead of drawing slices with textures" << endl
+    << endl
     << "    -scene-load <scene-file-name> <scene-name-or-number>" << endl
     << "        load the specified scene file and display the scene " << endl
     << "        in the file that matches by name or number.  Name" << endl
@@ -765,6 +772,16 @@ void printHelp(const AString& progName)
     << "    -spec-load-all" << endl
     << "        load all files in the given spec file, don't show spec file dialog" << endl
     << endl
+    << "    -volume-coloring-memory <megabytes>" << endl
+    << "        memory shared by the voxel coloring of all volume files," << endl
+    << "        coloring of the least recently viewed maps is discarded" << endl
+    << "        when more is needed (default 512)" << endl
+    << endl
+    << "    -volume-frames-on-demand <megabytes>" << endl
+    << "        read frames of multi-frame volume files only when they" << endl
+    << "        are displayed or used, keeping at most <megabytes> of" << endl
+    << "        frames in memory for each volume file" << endl
+    << endl
     << "    -window-size  <X Y>" << endl
     << "        Set the size of the browser window" << endl
     << endl
@@ -814,6 +831,8 @@ void parseCommandLine(const AString& progName, ProgramParameters* myParams, Prog
                     }
                 } else if (thisParam == "-no-splash") {
                     myState.showSplash = false;
+                } else if (thisParam == "-no-volume-slice-textures") {
+                    BrainOpenGLVolumeSliceDrawing::setSliceTextureDrawingEnabled(false);
                 } else if (thisParam == "-scene-load") {
                     if (myParams->hasNext()) {
                         myState.sceneFileName = myParams->nextString("Scene File Name");
@@ -885,6 +904,36 @@ void parseCommandLine(const AString& progName, ProgramParameters* myParams, Prog
                         cerr << "Missing Y position for window" << endl;
                         hasFatalError = true;
                     }
+                } else if (thisParam == "-volume-coloring-memory") {
+                    if (myParams->hasNext()) {
+                        const int64_t megabytes = myParams->nextLong("Volume coloring memory");
+                        if (megabytes < 0) {
+                            cerr << "Memory for \"-volume-coloring-memory\" must not be negative" << endl;
+                            hasFatalError = true;
+                        }
+                        else {
+                            VolumeFileVoxelColorizer::setCacheMemoryBudget(megabytes * 1024 * 1024);
+                        }
+                    }
+                    else {
+                        cerr << "Missing memory amount for \"-volume-coloring-memory\" option" << endl;
+                        hasFatalError = true;
+                    }
+                } else if (thisParam == "-volume-frames-on-demand") {
+                    if (myParams->hasNext()) {
+                        const int64_t megabytes = myParams->nextLong("Volume frame memory");
+                        if (megabytes < 0) {
+                            cerr << "Memory for \"-volume-frames-on-demand\" must not be negative" << endl;
+                            hasFatalError = true;
+                        }
+                        else {
+                            VolumeFile::setFramesOnDemand(true, megabytes * 1024 * 1024);
+                        }
+                    }
+                    else {
+                        cerr << "Missing memory amount for \"-volume-frames-on-demand\" option" << endl;
+                        hasFatalError = true;
+                    }
                 } else if (thisParam.startsWith("-psn")) {
                     /*
                      * 21 April 2014 (Did not have this problem before this date)
@@ -0,0 +1,338 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#define __CARET_DATA_FILE_CONCURRENT_READER_DECLARE__
+#include "CaretDataFileConcurrentReader.h"
+#undef __CARET_DATA_FILE_CONCURRENT_READER_DECLARE__
+
+#include <algorithm>
+#include <new>
+
+#include "CaretAssert.h"
+#include "CaretDataFile.h"
+#include "CaretDataFileHelper.h"
+#include "CaretOMP.h"
+#include "DataFileException.h"
+#include "FileInformation.h"
+
+using namespace caret;
+
+
+
+/**
+ * \class caret::CaretDataFileConcurrentReader
+ * \brief Reads independent data files on worker threads.
+ * \ingroup Files
+ */
+
+/**
+ * Constructor.
+ */
+CaretDataFileConcurrentReader::CaretDataFileConcurrentReader()
+: m_numberOfFilesRead(0)
+{
+}
+
+/**
+ * Destructor.  Deletes any files that were not taken.
+ */
+CaretDataFileConcurrentReader::~CaretDataFileConcurrentReader()
+{
+    for (std::vector<FileToRead>::iterator iter = m_files.begin();
+         iter != m_files.end();
+         iter++) {
+        if ( ! iter->m_takenFlag) {
+            delete iter->m_caretDataFile;
+        }
+        iter->m_caretDataFile = NULL;
+    }
+}
+
+/**
+ * Is the given type of file read by this reader?  Only types whose
+ * reading does not send events or use the palettes are read on
+ * worker threads.  Types not listed here, particularly palette,
+ * scene, annotation, and the connectivity matrix files, are
+ * read on the main thread.  Surfaces are also read on the main
+ * thread since the brain needs a Surface, which is not a file
+ * type that can be created here.
+ *
+ * @param dataFileType
+ *    Type of data file.
+ * @return
+ *    True if the type of file may be read on a worker thread.
+ */
+bool
+CaretDataFileConcurrentReader::isDataFileTypeReadConcurrently(const DataFileTypeEnum::Enum dataFileType)
+{
+    bool concurrentFlag = false;
+
+    switch (dataFileType) {
+        case DataFileTypeEnum::ANNOTATION:
+            break;
+        case DataFileTypeEnum::ANNOTATION_TEXT_SUBSTITUTION:
+            break;
+        case DataFileTypeEnum::BORDER:
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_DENSE:
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_DENSE_DYNAMIC:
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_DENSE_LABEL:
+            concurrentFlag = true;
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_DENSE_PARCEL:
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_DENSE_SCALAR:
+            concurrentFlag = true;
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_DENSE_TIME_SERIES:
+            concurrentFlag = true;
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_FIBER_ORIENTATIONS_TEMPORARY:
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_FIBER_TRAJECTORY_TEMPORARY:
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_PARCEL:
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_PARCEL_DENSE:
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_PARCEL_LABEL:
+            concurrentFlag = true;
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_PARCEL_SCALAR:
+            concurrentFlag = true;
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_PARCEL_SERIES:
+            concurrentFlag = true;
+            break;
+        case DataFileTypeEnum::CONNECTIVITY_SCALAR_DATA_SERIES:
+            break;
+        case DataFileTypeEnum::FOCI:
+            break;
+        case DataFileTypeEnum::IMAGE:
+            break;
+        case DataFileTypeEnum::LABEL:
+            concurrentFlag = true;
+            break;
+        case DataFileTypeEnum::METRIC:
+            concurrentFlag = true;
+            break;
+        case DataFileTypeEnum::PALETTE:
+            break;
+        case DataFileTypeEnum::RGBA:
+            concurrentFlag = true;
+            break;
+        case DataFileTypeEnum::SCENE:
+            break;
+        case DataFileTypeEnum::SPECIFICATION:
+            break;
+        case DataFileTypeEnum::SURFACE:
+            break;
+        case DataFileTypeEnum::UNKNOWN:
+            break;
+        case DataFileTypeEnum::VOLUME:
+            concurrentFlag = true;
+            break;
+    }
+
+    return concurrentFlag;
+}
+
+/**
+ * Add a file for reading.  The file object is created now, on the
+ * calling thread.
+ *
+ * @param dataFileType
+ *    Type of data file.
+ * @param filename
+ *    Absolute name of the file.
+ * @return
+ *    Index of the file for takeFile() or negative if the file
+ *    cannot be read by this reader (type not supported or file
+ *    is on the network).
+ */
+int32_t
+CaretDataFileConcurrentReader::addFile(const DataFileTypeEnum::Enum dataFileType,
+                                       const AString& filename)
+{
+    if ( ! isDataFileTypeReadConcurrently(dataFileType)) {
+        return -1;
+    }
+    if (DataFile::isFileOnNetwork(filename)) {
+        return -1;
+    }
+
+    FileToRead fileToRead(dataFileType,
+                          filename);
+    fileToRead.m_caretDataFile = CaretDataFileHelper::createCaretDataFileForFileType(dataFileType);
+    if (fileToRead.m_caretDataFile == NULL) {
+        return -1;
+    }
+
+    m_files.push_back(fileToRead);
+
+    return static_cast<int32_t>(m_files.size() - 1);
+}
+
+/**
+ * @return Number of files added to this reader.
+ */
+int32_t
+CaretDataFileConcurrentReader::getNumberOfFiles() const
+{
+    return m_files.size();
+}
+
+/**
+ * @return Number of files that have been read (successfully or not).
+ */
+int32_t
+CaretDataFileConcurrentReader::getNumberOfFilesRead() const
+{
+    return m_numberOfFilesRead;
+}
+
+/**
+ * @return True if there are files that have not been read.
+ */
+bool
+CaretDataFileConcurrentReader::hasFilesToRead() const
+{
+    return (m_numberOfFilesRead < getNumberOfFiles());
+}
+
+/**
+ * @return Name, without path, of the next file to be read, for progress
+ * reporting.  Empty if all files have been read.
+ */
+AString
+CaretDataFileConcurrentReader::getNextFileNameToRead() const
+{
+    if (hasFilesToRead()) {
+        FileInformation fileInfo(m_files[m_numberOfFilesRead].m_filename);
+        return fileInfo.getFileName();
+    }
+
+    return "";
+}
+
+/**
+ * Read the next batch of files, one file per thread.  Returns after
+ * all files in the batch have been read.
+ */
+void
+CaretDataFileConcurrentReader::readNextFiles()
+{
+    int32_t batchSize = 1;
+#ifdef CARET_OMP
+    batchSize = omp_get_max_threads();
+#endif // CARET_OMP
+    if (batchSize < 1) {
+        batchSize = 1;
+    }
+
+    const int32_t firstIndex = m_numberOfFilesRead;
+    const int32_t lastIndex  = std::min(firstIndex + batchSize,
+                                        getNumberOfFiles());
+
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int32_t i = firstIndex; i < lastIndex; i++) {
+        readFile(m_files[i]);
+    }
+
+    m_numberOfFilesRead = lastIndex;
+}
+
+/**
+ * Read a file.  Runs on a worker thread so any error is saved and
+ * reported by takeFile() on the calling thread.
+ *
+ * @param fileToRead
+ *    The file that is read.
+ */
+void
+CaretDataFileConcurrentReader::readFile(FileToRead& fileToRead)
+{
+    CaretAssert(fileToRead.m_caretDataFile);
+
+    try {
+        /*
+         * Same message as when the brain reads a file that does not exist
+         */
+        FileInformation fileInfo(fileToRead.m_filename);
+        if ( ! fileInfo.exists()) {
+            throw DataFileException(fileToRead.m_filename,
+                                    "File not found:");
+        }
+
+        try {
+            fileToRead.m_caretDataFile->readFile(fileToRead.m_filename);
+        }
+        catch (const std::bad_alloc&) {
+            throw DataFileException(fileToRead.m_filename,
+                                    CaretDataFileHelper::createBadAllocExceptionMessage(fileToRead.m_filename));
+        }
+    }
+    catch (const DataFileException& dfe) {
+        fileToRead.m_errorMessage = dfe.whatString();
+    }
+    catch (const CaretException& e) {
+        fileToRead.m_errorMessage = e.whatString();
+    }
+    catch (const std::exception& e) {
+        fileToRead.m_errorMessage = (fileToRead.m_filename
+                                     + ": "
+                                     + AString(e.what()));
+    }
+
+    fileToRead.m_readFlag = true;
+}
+
+/**
+ * Take a file that has been read.  The caller is responsible for
+ * the file once it is taken.
+ *
+ * @param fileIndex
+ *    Index returned by addFile().
+ * @return
+ *    The file that was read.
+ * @throws DataFileException
+ *    If there was an error reading the file (the file is deleted).
+ */
+CaretDataFile*
+CaretDataFileConcurrentReader::takeFile(const int32_t fileIndex)
+{
+    CaretAssertVectorIndex(m_files, fileIndex);
+    FileToRead& fileToRead = m_files[fileIndex];
+    CaretAssert(fileToRead.m_readFlag);
+    CaretAssert( ! fileToRead.m_takenFlag);
+
+    CaretDataFile* caretDataFile = fileToRead.m_caretDataFile;
+    fileToRead.m_caretDataFile = NULL;
+    fileToRead.m_takenFlag = true;
+
+    if ( ! fileToRead.m_errorMessage.isEmpty()) {
+        delete caretDataFile;
+        throw DataFileException(fileToRead.m_errorMessage);
+    }
+
+    return caretDataFile;
+}
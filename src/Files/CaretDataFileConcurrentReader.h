@@ -0,0 +1,110 @@
+#ifndef __CARET_DATA_FILE_CONCURRENT_READER_H__
+#define __CARET_DATA_FILE_CONCURRENT_READER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <vector>
+
+#include "AString.h"
+#include "DataFileTypeEnum.h"
+
+namespace caret {
+
+    class CaretDataFile;
+
+    /**
+     * Reads independent data files on worker threads.
+     *
+     * The file objects are created on the calling thread (file constructors
+     * register event listeners and the event manager is not thread safe),
+     * only CaretDataFile::readFile() runs on the workers.  Files are read
+     * in batches so that the caller may report progress and check for
+     * cancellation between batches.  A file that is never taken from
+     * the reader is deleted when the reader is deleted.
+     */
+    class CaretDataFileConcurrentReader {
+
+    public:
+        CaretDataFileConcurrentReader();
+
+        ~CaretDataFileConcurrentReader();
+
+        static bool isDataFileTypeReadConcurrently(const DataFileTypeEnum::Enum dataFileType);
+
+        int32_t addFile(const DataFileTypeEnum::Enum dataFileType,
+                        const AString& filename);
+
+        int32_t getNumberOfFiles() const;
+
+        int32_t getNumberOfFilesRead() const;
+
+        bool hasFilesToRead() const;
+
+        AString getNextFileNameToRead() const;
+
+        void readNextFiles();
+
+        CaretDataFile* takeFile(const int32_t fileIndex);
+
+    private:
+        CaretDataFileConcurrentReader(const CaretDataFileConcurrentReader&);
+
+        CaretDataFileConcurrentReader& operator=(const CaretDataFileConcurrentReader&);
+
+        class FileToRead {
+        public:
+            FileToRead(const DataFileTypeEnum::Enum dataFileType,
+                       const AString& filename)
+            : m_dataFileType(dataFileType),
+            m_filename(filename),
+            m_caretDataFile(NULL),
+            m_readFlag(false),
+            m_takenFlag(false) { }
+
+            DataFileTypeEnum::Enum m_dataFileType;
+
+            AString m_filename;
+
+            CaretDataFile* m_caretDataFile;
+
+            AString m_errorMessage;
+
+            bool m_readFlag;
+
+            bool m_takenFlag;
+        };
+
+        static void readFile(FileToRead& fileToRead);
+
+        std::vector<FileToRead> m_files;
+
+        int32_t m_numberOfFilesRead;
+
+        // ADD_NEW_MEMBERS_HERE
+
+    };
+
+#ifdef __CARET_DATA_FILE_CONCURRENT_READER_DECLARE__
+    // <PLACE DECLARATIONS OF STATIC MEMBERS HERE>
+#endif // __CARET_DATA_FILE_CONCURRENT_READER_DECLARE__
+
+} // namespace
+#endif  //__CARET_DATA_FILE_CONCURRENT_READER_H__
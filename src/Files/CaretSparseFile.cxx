@@ -32,6 +32,34 @@ using namespace caret;
 using namespace std;
 
 const char magic[] = "\0\0\0\0cst\0";
+const char magicVersion2[] = "\0\0\0\0cst\2";
+
+namespace
+{
+    void appendVarint(vector<unsigned char>& bytes, uint64_t value)
+    {//7 bits per byte, low bits first, high bit set on all but the last byte
+        while (value >= 128)
+        {
+            bytes.push_back((unsigned char)(value | 128));
+            value >>= 7;
+        }
+        bytes.push_back((unsigned char)value);
+    }
+    
+    uint64_t readVarint(const unsigned char*& data, const unsigned char* end)
+    {
+        uint64_t ret = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (data >= end) throw DataFileException("row data is truncated in wbsparse file");
+            unsigned char thisByte = *data;
+            ++data;
+            ret |= ((uint64_t)(thisByte & 127)) << shift;
+            if (thisByte < 128) return ret;
+        }
+        throw DataFileException("invalid varint found in wbsparse file");
+    }
+}
 
 CaretSparseFile::CaretSparseFile(const AString& fileName)
 {
@@ -45,13 +73,23 @@ void CaretSparseFile::readFile(const AString& filename)
     {
         throw DataFileException("wbsparse files cannot be read while compressed");
     }
-    m_file.open(filename);
+    m_file.open(filename, CaretBinaryFile::READ_MEMORY_MAP);//version 2 rows are decoded directly from the mapping
     FileInformation fileInfo(filename);//useful later for file size, but create it now to reduce the amount of time between file open and size check
     char buf[8];
     m_file.read(buf, 8);
+    bool isVersion1 = true, isVersion2 = true;
     for (int i = 0; i < 8; ++i)
     {
-        if (buf[i] != magic[i]) throw DataFileException("file has the wrong magic string");
+        if (buf[i] != magic[i]) isVersion1 = false;
+        if (buf[i] != magicVersion2[i]) isVersion2 = false;
+    }
+    if (isVersion1)
+    {
+        m_version = 1;
+    } else if (isVersion2) {
+        m_version = 2;
+    } else {
+        throw DataFileException("file has the wrong magic string");
     }
     m_file.read(m_dims, 2 * sizeof(int64_t));
     if (ByteOrderEnum::isSystemBigEndian())
@@ -60,20 +98,37 @@ void CaretSparseFile::readFile(const AString& filename)
     }
     if (m_dims[0] < 1 || m_dims[1] < 1) throw DataFileException("both dimensions must be positive");
     m_indexArray.resize(m_dims[1] + 1);
-    vector<int64_t> lengthArray(m_dims[1]);
-    m_file.read(lengthArray.data(), m_dims[1] * sizeof(int64_t));
-    if (ByteOrderEnum::isSystemBigEndian())
+    int64_t xml_offset = -1;
+    if (m_version == 1)
     {
-        ByteSwapping::swapBytes(lengthArray.data(), m_dims[1]);
-    }
-    m_indexArray[0] = 0;
-    for (int64_t i = 0; i < m_dims[1]; ++i)
-    {
-        if (lengthArray[i] > m_dims[0] || lengthArray[i] < 0) throw DataFileException("impossible value found in length array");
-        m_indexArray[i + 1] = m_indexArray[i] + lengthArray[i];
+        vector<int64_t> lengthArray(m_dims[1]);
+        m_file.read(lengthArray.data(), m_dims[1] * sizeof(int64_t));
+        if (ByteOrderEnum::isSystemBigEndian())
+        {
+            ByteSwapping::swapBytes(lengthArray.data(), m_dims[1]);
+        }
+        m_indexArray[0] = 0;
+        for (int64_t i = 0; i < m_dims[1]; ++i)
+        {
+            if (lengthArray[i] > m_dims[0] || lengthArray[i] < 0) throw DataFileException("impossible value found in length array");
+            m_indexArray[i + 1] = m_indexArray[i] + lengthArray[i];
+        }
+        m_valuesOffset = 8 + 2 * sizeof(int64_t) + m_dims[1] * sizeof(int64_t);
+        xml_offset = m_valuesOffset + m_indexArray[m_dims[1]] * 2 * sizeof(int64_t);
+    } else {
+        m_file.read(m_indexArray.data(), (m_dims[1] + 1) * sizeof(uint64_t));
+        if (ByteOrderEnum::isSystemBigEndian())
+        {
+            ByteSwapping::swapBytes(m_indexArray.data(), m_dims[1] + 1);
+        }
+        if (m_indexArray[0] != 0) throw DataFileException("impossible value found in row offset array");
+        for (int64_t i = 0; i < m_dims[1]; ++i)
+        {
+            if (m_indexArray[i + 1] < m_indexArray[i] || m_indexArray[i + 1] > (uint64_t)fileInfo.size()) throw DataFileException("impossible value found in row offset array");
+        }
+        m_valuesOffset = 8 + 2 * sizeof(int64_t) + (m_dims[1] + 1) * sizeof(uint64_t);
+        xml_offset = m_valuesOffset + m_indexArray[m_dims[1]];
     }
-    m_valuesOffset = 8 + 2 * sizeof(int64_t) + m_dims[1] * sizeof(int64_t);
-    int64_t xml_offset = m_valuesOffset + m_indexArray[m_dims[1]] * 2 * sizeof(int64_t);
     if (xml_offset >= fileInfo.size()) throw DataFileException("file is truncated");
     int64_t xml_length = fileInfo.size() - xml_offset;
     if (xml_length < 1) throw DataFileException("file is truncated");
@@ -100,9 +155,56 @@ CaretSparseFile::~CaretSparseFile()
 {
 }
 
+const unsigned char* CaretSparseFile::getRowBytes(const int64_t& index, const unsigned char*& endOut)
+{
+    CaretAssert(m_version == 2);
+    CaretAssert(index >= 0 && index < m_dims[1]);
+    const uint64_t start = m_indexArray[index], end = m_indexArray[index + 1];
+    const char* mapped = m_file.getMappedData();
+    if (mapped != NULL)
+    {
+        endOut = (const unsigned char*)(mapped + m_valuesOffset + end);
+        return (const unsigned char*)(mapped + m_valuesOffset + start);
+    }
+    m_scratchBytes.resize(end - start);
+    if (end > start) m_file.readAt(m_scratchBytes.data(), m_valuesOffset + start, end - start);
+    endOut = m_scratchBytes.data() + (end - start);
+    return m_scratchBytes.data();
+}
+
 void CaretSparseFile::getRow(const int64_t& index, int64_t* rowOut)
 {
     CaretAssert(index >= 0 && index < m_dims[1]);
+    if (m_version == 2)
+    {
+        const unsigned char* end = NULL;
+        const unsigned char* data = getRowBytes(index, end);
+        int64_t curIndex = 0;
+        if (data != end)//empty rows have no bytes at all
+        {
+            uint64_t numNonzero = readVarint(data, end);
+            if (numNonzero > (uint64_t)m_dims[0]) throw DataFileException("impossible nonzero count found in file");
+            for (uint64_t i = 0; i < numNonzero; ++i)
+            {
+                uint64_t gap = readVarint(data, end);
+                if (gap >= (uint64_t)(m_dims[0] - curIndex)) throw DataFileException("impossible index value found in file");
+                int64_t nonzeroIndex = curIndex + (int64_t)gap;
+                while (curIndex < nonzeroIndex)
+                {
+                    rowOut[curIndex] = 0;
+                    ++curIndex;
+                }
+                rowOut[nonzeroIndex] = (int64_t)readVarint(data, end);
+                curIndex = nonzeroIndex + 1;
+            }
+        }
+        while (curIndex < m_dims[0])
+        {
+            rowOut[curIndex] = 0;
+            ++curIndex;
+        }
+        return;
+    }
     int64_t start = m_indexArray[index], end = m_indexArray[index + 1];
     int64_t numToRead = (end - start) * 2;
     m_scratchArray.resize(numToRead);
@@ -135,6 +237,26 @@ void CaretSparseFile::getRow(const int64_t& index, int64_t* rowOut)
 void CaretSparseFile::getRowSparse(const int64_t& index, vector<int64_t>& indicesOut, vector<int64_t>& valuesOut)
 {
     CaretAssert(index >= 0 && index < m_dims[1]);
+    if (m_version == 2)
+    {
+        const unsigned char* end = NULL;
+        const unsigned char* data = getRowBytes(index, end);
+        uint64_t numNonzero = 0;
+        if (data != end) numNonzero = readVarint(data, end);
+        if (numNonzero > (uint64_t)m_dims[0]) throw DataFileException("impossible nonzero count found in file");
+        indicesOut.resize(numNonzero);
+        valuesOut.resize(numNonzero);
+        int64_t curIndex = 0;
+        for (uint64_t i = 0; i < numNonzero; ++i)
+        {
+            uint64_t gap = readVarint(data, end);
+            if (gap >= (uint64_t)(m_dims[0] - curIndex)) throw DataFileException("impossible index value found in file");
+            indicesOut[i] = curIndex + (int64_t)gap;
+            valuesOut[i] = (int64_t)readVarint(data, end);
+            curIndex = indicesOut[i] + 1;
+        }
+        return;
+    }
     int64_t start = m_indexArray[index], end = m_indexArray[index + 1];
     int64_t numToRead = (end - start) * 2, numNonzero = end - start;
     m_scratchArray.resize(numToRead);
@@ -206,12 +328,14 @@ void FiberFractions::zero()
     distance = 0.0f;
 }
 
-CaretSparseFileWriter::CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml)
+CaretSparseFileWriter::CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml, const int& version)
 {
     if (!fileName.endsWith(".trajTEMP.wbsparse"))
     {//for now (and maybe forever), this format is single-purpose
         CaretLogWarning("sparse trajectory file '" + fileName + "' should be saved ending in .trajTEMP.wbsparse");
     }
+    if (version != 1 && version != 2) throw DataFileException("unsupported wbsparse version: " + AString::number(version));
+    m_version = version;
     m_finished = false;
     int64_t dimensions[2] = { xml.getDimensionLength(CiftiXML::ALONG_ROW), xml.getDimensionLength(CiftiXML::ALONG_COLUMN) };
     if (dimensions[0] < 1 || dimensions[1] < 1) throw DataFileException("both dimensions must be positive");
@@ -223,27 +347,81 @@ CaretSparseFileWriter::CaretSparseFileWriter(const AString& fileName, const Cift
         throw DataFileException("wbsparse files cannot be written compressed");
     }//because after we finish writing the data, we have to come back and write the lengths array
     m_file.open(fileName, CaretBinaryFile::WRITE_TRUNCATE);
-    m_file.write(magic, 8);
+    if (m_version == 1)
+    {
+        m_file.write(magic, 8);
+    } else {
+        m_file.write(magicVersion2, 8);
+    }
     int64_t tempdims[2] = { m_dims[0], m_dims[1] };
     if (ByteOrderEnum::isSystemBigEndian())
     {
         ByteSwapping::swapBytes(tempdims, 2);
     }
     m_file.write(tempdims, 2 * sizeof(int64_t));
-    m_lengthArray.resize(m_dims[1], 0);//initialize the memory so that valgrind won't complain
-    m_file.write(m_lengthArray.data(), m_dims[1] * sizeof(uint64_t));//write it to get the file to the correct length
+    if (m_version == 1)
+    {
+        m_lengthArray.resize(m_dims[1], 0);//initialize the memory so that valgrind won't complain
+    } else {
+        m_lengthArray.resize(m_dims[1] + 1, 0);
+    }
+    m_file.write(m_lengthArray.data(), m_lengthArray.size() * sizeof(uint64_t));//write it to get the file to the correct length
     m_nextRowIndex = 0;
-    m_valuesOffset = 8 + 2 * sizeof(int64_t) + m_dims[1] * sizeof(int64_t);
+    m_valuesOffset = 8 + 2 * sizeof(int64_t) + m_lengthArray.size() * sizeof(uint64_t);
+}
+
+void CaretSparseFileWriter::skipToRow(const int64_t& index)
+{
+    while (m_nextRowIndex < index)
+    {
+        if (m_version == 1)
+        {
+            m_lengthArray[m_nextRowIndex] = 0;
+        } else {
+            m_lengthArray[m_nextRowIndex + 1] = m_lengthArray[m_nextRowIndex];//empty rows have no bytes
+        }
+        ++m_nextRowIndex;
+    }
+}
+
+void CaretSparseFileWriter::writeRowBytes(const int64_t& index)
+{
+    CaretAssert(m_version == 2);
+    m_lengthArray[index + 1] = m_lengthArray[index] + m_scratchBytes.size();
+    m_file.write(m_scratchBytes.data(), m_scratchBytes.size());
+    m_nextRowIndex = index + 1;
+    if (m_nextRowIndex == m_dims[1]) finish();
 }
 
 void CaretSparseFileWriter::writeRow(const int64_t& index, const int64_t* row)
 {
     CaretAssert(index < m_dims[1]);
     CaretAssert(index >= m_nextRowIndex);
-    while (m_nextRowIndex < index)
+    skipToRow(index);
+    if (m_version == 2)
     {
-        m_lengthArray[m_nextRowIndex] = 0;
-        ++m_nextRowIndex;
+        int64_t count = 0;
+        for (int64_t i = 0; i < m_dims[0]; ++i)
+        {
+            if (row[i] != 0) ++count;
+        }
+        m_scratchBytes.clear();
+        if (count > 0)
+        {
+            appendVarint(m_scratchBytes, count);
+            int64_t nextIndex = 0;
+            for (int64_t i = 0; i < m_dims[0]; ++i)
+            {
+                if (row[i] != 0)
+                {
+                    appendVarint(m_scratchBytes, i - nextIndex);
+                    appendVarint(m_scratchBytes, (uint64_t)row[i]);
+                    nextIndex = i + 1;
+                }
+            }
+        }
+        writeRowBytes(index);
+        return;
     }
     m_scratchArray.clear();
     int64_t count = 0;
@@ -271,10 +449,25 @@ void CaretSparseFileWriter::writeRowSparse(const int64_t& index, const vector<in
     CaretAssert(index < m_dims[1]);
     CaretAssert(index >= m_nextRowIndex);
     CaretAssert(indices.size() == values.size());
-    while (m_nextRowIndex < index)
+    skipToRow(index);
+    if (m_version == 2)
     {
-        m_lengthArray[m_nextRowIndex] = 0;
-        ++m_nextRowIndex;
+        size_t numNonzero = indices.size();//assume no zeros
+        m_scratchBytes.clear();
+        if (numNonzero > 0)
+        {
+            appendVarint(m_scratchBytes, numNonzero);
+            int64_t nextIndex = 0;
+            for (size_t i = 0; i < numNonzero; ++i)
+            {
+                if (indices[i] < nextIndex || indices[i] >= m_dims[0]) throw DataFileException("indices must be sorted when writing sparse rows");
+                appendVarint(m_scratchBytes, indices[i] - nextIndex);
+                appendVarint(m_scratchBytes, (uint64_t)values[i]);
+                nextIndex = indices[i] + 1;
+            }
+        }
+        writeRowBytes(index);
+        return;
     }
     m_scratchArray.clear();
     size_t numNonzero = indices.size();//assume no zeros
@@ -326,11 +519,7 @@ void CaretSparseFileWriter::finish()
 {
     if (m_finished) return;
     m_finished = true;
-    while (m_nextRowIndex < m_dims[1])
-    {
-        m_lengthArray[m_nextRowIndex] = 0;
-        ++m_nextRowIndex;
-    }
+    skipToRow(m_dims[1]);
     QByteArray myXMLBytes = m_xml.writeXMLToQByteArray();
     m_file.write(myXMLBytes.constData(), myXMLBytes.size());
     m_file.seek(8 + 2 * sizeof(int64_t));
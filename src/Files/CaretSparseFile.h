@@ -40,19 +40,24 @@ namespace caret {
         void zero();
     };
     
+    ///version 1 stores each nonzero as raw int64 index and value pairs, with a length array per row
+    ///version 2 stores a byte offset array per row, and each row as varint count, then varint pairs of (index - previous index - 1) and value, so it can be decoded straight from the memory mapped file
     class CaretSparseFile /* : public DataFile */
     {
         static void decodeFibers(const uint64_t& coded, FiberFractions& decoded);//takes a uint because right shift on signed is implementation dependent
         CaretBinaryFile m_file;
+        int m_version;
         int64_t m_dims[2], m_valuesOffset;
-        std::vector<uint64_t> m_indexArray, m_scratchRow;
+        std::vector<uint64_t> m_indexArray, m_scratchRow;//for version 2, m_indexArray is byte offsets of rows from m_valuesOffset
         std::vector<int64_t> m_scratchArray, m_scratchSparseRow;
+        std::vector<unsigned char> m_scratchBytes;//version 2 rows when the file couldn't be mapped
         CaretSparseFile(const CaretSparseFile& rhs);
         CiftiXML m_xml;
+        const unsigned char* getRowBytes(const int64_t& index, const unsigned char*& endOut);
     public:
         const int64_t* getDimensions() { return m_dims; }
 
-        CaretSparseFile() {};
+        CaretSparseFile() { m_version = 1; }
         
         virtual void readFile(const AString& filename);
         
@@ -79,14 +84,19 @@ namespace caret {
         static void encodeFibers(const FiberFractions& orig, uint64_t& coded);
         static uint32_t myclamp(const int& x);
         CaretBinaryFile m_file;
+        int m_version;
         int64_t m_dims[2], m_valuesOffset, m_nextRowIndex;
         bool m_finished;
-        std::vector<uint64_t> m_lengthArray, m_scratchRow;
+        std::vector<uint64_t> m_lengthArray, m_scratchRow;//for version 2, m_lengthArray is the row byte offsets, with one extra element
         std::vector<int64_t> m_scratchArray, m_scratchSparseRow;
+        std::vector<unsigned char> m_scratchBytes;
         CaretSparseFileWriter(const CaretSparseFileWriter& rhs);
         CiftiXML m_xml;
+        void skipToRow(const int64_t& index);
+        void writeRowBytes(const int64_t& index);
     public:
-        CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml);
+        ///version 1 files can be read by older versions of workbench, version 2 files are much smaller, but need a newer reader
+        CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml, const int& version = 1);
         
         ~CaretSparseFileWriter();
         
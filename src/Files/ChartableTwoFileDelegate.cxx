@@ -89,6 +89,8 @@ ChartableTwoFileDelegate::updateAfterFileChanged()
     switch (m_caretMappableDataFile->getDataFileType()) {
         case DataFileTypeEnum::CONNECTIVITY_DENSE:
             histogramType = ChartTwoHistogramContentTypeEnum::HISTOGRAM_CONTENT_TYPE_MAP_DATA;
+            /* drawn from matrix pyramid, no row/column selection */
+            matrixType = ChartTwoMatrixContentTypeEnum::MATRIX_CONTENT_BRAINORDINATE_MAPPABLE;
             break;
         case DataFileTypeEnum::CONNECTIVITY_DENSE_DYNAMIC:
             histogramType = ChartTwoHistogramContentTypeEnum::HISTOGRAM_CONTENT_TYPE_MAP_DATA;
@@ -105,6 +107,8 @@ ChartableTwoFileDelegate::updateAfterFileChanged()
         case DataFileTypeEnum::CONNECTIVITY_DENSE_TIME_SERIES:
             histogramType = ChartTwoHistogramContentTypeEnum::HISTOGRAM_CONTENT_TYPE_MAP_DATA;
             lineSeriesType = ChartTwoLineSeriesContentTypeEnum::LINE_SERIES_CONTENT_BRAINORDINATE_DATA;
+            /* drawn from matrix pyramid, no row/column selection */
+            matrixType = ChartTwoMatrixContentTypeEnum::MATRIX_CONTENT_BRAINORDINATE_MAPPABLE;
             break;
         case DataFileTypeEnum::CONNECTIVITY_PARCEL:
             histogramType = ChartTwoHistogramContentTypeEnum::HISTOGRAM_CONTENT_TYPE_MAP_DATA;
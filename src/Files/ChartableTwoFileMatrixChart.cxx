@@ -94,6 +94,7 @@ m_validRowColumnSelectionDimensions(validRowColumnSelectionDimensions)
             case DataFileTypeEnum::BORDER:
                 break;
             case DataFileTypeEnum::CONNECTIVITY_DENSE:
+                m_matrixDataFileType = MatrixDataFileType::DENSE;
                 break;
             case DataFileTypeEnum::CONNECTIVITY_DENSE_DYNAMIC:
                 break;
@@ -104,6 +105,7 @@ m_validRowColumnSelectionDimensions(validRowColumnSelectionDimensions)
             case DataFileTypeEnum::CONNECTIVITY_DENSE_SCALAR:
                 break;
             case DataFileTypeEnum::CONNECTIVITY_DENSE_TIME_SERIES:
+                m_matrixDataFileType = MatrixDataFileType::DENSE;
                 break;
             case DataFileTypeEnum::CONNECTIVITY_FIBER_ORIENTATIONS_TEMPORARY:
                 break;
@@ -159,6 +161,12 @@ m_validRowColumnSelectionDimensions(validRowColumnSelectionDimensions)
                 CaretAssert(0);
                 return;
                 break;
+            case MatrixDataFileType::DENSE:
+                /*
+                 * Too many rows and columns for selection,
+                 * names of rows and columns are their numbers
+                 */
+                break;
             case MatrixDataFileType::PARCEL:
                 m_parcelFile = dynamic_cast<CiftiConnectivityMatrixParcelFile*>(ciftiMapFile);
                 CaretAssert(m_parcelFile);
@@ -285,6 +293,15 @@ m_validRowColumnSelectionDimensions(validRowColumnSelectionDimensions)
         if (matrixFile != NULL) {
             m_matrixTriangularViewingModeSupportedFlag = matrixFile->hasSymetricRowColumnNames();
         }
+        else if (m_matrixDataFileType == MatrixDataFileType::DENSE) {
+            const CiftiMappableDataFile* ciftiMapFile = getCiftiMappableDataFile();
+            CaretAssert(ciftiMapFile);
+            const CiftiXML ciftiXML = ciftiMapFile->getCiftiXML();
+            if (m_numberOfRows == m_numberOfColumns) {
+                m_matrixTriangularViewingModeSupportedFlag = (*ciftiXML.getMap(CiftiXML::ALONG_ROW)
+                                                              == *ciftiXML.getMap(CiftiXML::ALONG_COLUMN));
+            }
+        }
     }
     else {
         m_matrixContentType = ChartTwoMatrixContentTypeEnum::MATRIX_CONTENT_UNSUPPORTED;
@@ -353,6 +370,71 @@ ChartableTwoFileMatrixChart::isMatrixTriangularViewingModeSupported() const
 }
 
 
+/**
+ * @return True if the matrix is drawn from tiles of the matrix pyramid
+ * instead of a primitive containing every cell.
+ */
+bool
+ChartableTwoFileMatrixChart::isMatrixChartingWithPyramid() const
+{
+    if (m_matrixContentType == ChartTwoMatrixContentTypeEnum::MATRIX_CONTENT_UNSUPPORTED) {
+        return false;
+    }
+    
+    const CiftiMappableDataFile* ciftiMapFile = getCiftiMappableDataFile();
+    CaretAssert(ciftiMapFile);
+    
+    return ciftiMapFile->isMatrixChartingWithPyramid();
+}
+
+/**
+ * @return The matrix pyramid for drawing the matrix (NULL if not available).
+ */
+const CiftiMatrixPyramid*
+ChartableTwoFileMatrixChart::getMatrixPyramid() const
+{
+    const CiftiMappableDataFile* ciftiMapFile = getCiftiMappableDataFile();
+    CaretAssert(ciftiMapFile);
+    
+    return ciftiMapFile->getMatrixPyramid();
+}
+
+/**
+ * Get graphics primitives for adjacent tiles in a row of tiles of the
+ * matrix pyramid.
+ *
+ * @param matrixViewMode
+ *     The matrix visualization mode (upper/lower).
+ * @param level
+ *     Level in the matrix pyramid.
+ * @param tileRow
+ *     Row of tiles.
+ * @param firstTileColumn
+ *     First tile column.
+ * @param lastTileColumn
+ *     Last tile column, inclusive.
+ * @param primitivesOut
+ *     Output containing primitive for each tile (NULL if not valid).
+ */
+void
+ChartableTwoFileMatrixChart::getMatrixPyramidTileGraphicsPrimitives(const ChartTwoMatrixTriangularViewingModeEnum::Enum matrixViewMode,
+                                                                    const int32_t level,
+                                                                    const int64_t tileRow,
+                                                                    const int64_t firstTileColumn,
+                                                                    const int64_t lastTileColumn,
+                                                                    std::vector<GraphicsPrimitiveV3fT3f*>& primitivesOut) const
+{
+    const CiftiMappableDataFile* ciftiMapFile = getCiftiMappableDataFile();
+    CaretAssert(ciftiMapFile);
+    
+    ciftiMapFile->getMatrixPyramidTileGraphicsPrimitives(matrixViewMode,
+                                                         level,
+                                                         tileRow,
+                                                         firstTileColumn,
+                                                         lastTileColumn,
+                                                         primitivesOut);
+}
+
 /**
  * Get the matrix dimensions.
  *
@@ -449,6 +531,8 @@ ChartableTwoFileMatrixChart::getSelectedRowColumnDimension() const
         case MatrixDataFileType::INVALID:
             CaretAssert(0);
             break;
+        case MatrixDataFileType::DENSE:
+            break;
         case MatrixDataFileType::PARCEL:
             CaretAssert(m_parcelFile);
             switch (m_parcelFile->getMatrixLoadingDimension()) {
@@ -493,6 +577,8 @@ ChartableTwoFileMatrixChart::setSelectedRowColumnDimension(const ChartTwoMatrixL
         case MatrixDataFileType::INVALID:
             CaretAssert(0);
             break;
+        case MatrixDataFileType::DENSE:
+            break;
         case MatrixDataFileType::PARCEL:
         {
             CaretAssert(m_parcelFile);
@@ -562,6 +648,8 @@ ChartableTwoFileMatrixChart::getSelectedRowColumnIndices(const int32_t tabIndex,
         case MatrixDataFileType::INVALID:
             CaretAssert(0);
             break;
+        case MatrixDataFileType::DENSE:
+            break;
         case MatrixDataFileType::PARCEL:
         {
             CaretAssert(m_parcelFile);
@@ -649,6 +737,8 @@ ChartableTwoFileMatrixChart::setSelectedRowColumnIndex(const int32_t tabIndex,
         case MatrixDataFileType::INVALID:
             CaretAssert(0);
             break;
+        case MatrixDataFileType::DENSE:
+            break;
         case MatrixDataFileType::PARCEL:
         {
             CaretAssert(m_parcelFile);
@@ -31,11 +31,13 @@
 namespace caret {
 
     class CiftiConnectivityMatrixParcelFile;
+    class CiftiMatrixPyramid;
     class CiftiParcelLabelFile;
     class CiftiParcelScalarFile;
     class CiftiParcelSeriesFile;
     class CiftiScalarDataSeriesFile;
     class GraphicsPrimitiveV3fC4f;
+    class GraphicsPrimitiveV3fT3f;
     
     class ChartableTwoFileMatrixChart : public ChartableTwoFileBaseChart {
         
@@ -66,6 +68,17 @@ namespace caret {
         
         bool isMatrixTriangularViewingModeSupported() const;
 
+        bool isMatrixChartingWithPyramid() const;
+        
+        const CiftiMatrixPyramid* getMatrixPyramid() const;
+        
+        void getMatrixPyramidTileGraphicsPrimitives(const ChartTwoMatrixTriangularViewingModeEnum::Enum matrixViewMode,
+                                                    const int32_t level,
+                                                    const int64_t tileRow,
+                                                    const int64_t firstTileColumn,
+                                                    const int64_t lastTileColumn,
+                                                    std::vector<GraphicsPrimitiveV3fT3f*>& primitivesOut) const;
+        
         // ADD_NEW_METHODS_HERE
         
         ChartTwoMatrixLoadingDimensionEnum::Enum getSelectedRowColumnDimension() const;
@@ -99,6 +112,7 @@ namespace caret {
     protected:
         enum class MatrixDataFileType {
             INVALID,
+            DENSE,
             PARCEL,
             PARCEL_LABEL,
             PARCEL_SCALAR,
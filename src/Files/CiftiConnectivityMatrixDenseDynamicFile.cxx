@@ -19,14 +19,18 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
+#include <QThread>
+
 #define __CIFTI_CONNECTIVITY_MATRIX_DENSE_DYNAMIC_FILE_DECLARE__
 #include "CiftiConnectivityMatrixDenseDynamicFile.h"
 #undef __CIFTI_CONNECTIVITY_MATRIX_DENSE_DYNAMIC_FILE_DECLARE__
 
 #include "CaretAssert.h"
+#include "CaretException.h"
 #include "CaretLogger.h"
 #include "CaretOMP.h"
 #include "CiftiBrainordinateDataSeriesFile.h"
@@ -46,8 +50,35 @@ using namespace caret;
  * Internally, the file format is the same as a data series file.  When
  * a row is requested, the row is correlated with all other rows
  * producing the connectivity from that row to all other rows.
+ *
+ * Rows are read from the parent's CIFTI file in blocks.  The mean and
+ * sum-squared of each row are computed the first time its block is read,
+ * so the first row requested does not wait for the whole data series to
+ * be loaded.  When the parent's data is on disk, blocks are kept in a cache
+ * that is shared by all dense dynamic files and limited to a memory budget,
+ * with the least recently used blocks of other files evicted to make room.
+ * After reading, a background thread computes the remaining statistics and
+ * fills the cache while there is room in the budget.
  */
 
+namespace {
+    /**
+     * Runs the background statistics and cache filling of a dense dynamic file
+     */
+    class DenseDynamicCacheThread : public QThread
+    {
+    public:
+        DenseDynamicCacheThread(CiftiConnectivityMatrixDenseDynamicFile* denseDynamicFile) {
+            m_denseDynamicFile = denseDynamicFile;
+        }
+        void run() {
+            m_denseDynamicFile->fillCacheInBackground();
+        }
+        
+        CiftiConnectivityMatrixDenseDynamicFile* m_denseDynamicFile;
+    };
+}
+
 /**
  * Constructor.
  *
@@ -60,11 +91,17 @@ m_parentDataSeriesFile(parentDataSeriesFile),
 m_parentDataSeriesCiftiFile(NULL),
 m_numberOfBrainordinates(-1),
 m_numberOfTimePoints(-1),
+m_useBlockCacheFlag(false),
+m_stopBackgroundFlag(false),
 m_validDataFlag(false),
-m_enabledAsLayer(true),
-m_cacheDataFlag(false)
+m_enabledAsLayer(true)
 {
     CaretAssert(m_parentDataSeriesFile);
+    
+    {
+        CaretMutexLocker locked(&s_cacheMutex);
+        s_allFiles.insert(this);
+    }
 
     m_sceneAssistant.grabNew(new SceneClassAssistant());
     m_sceneAssistant->add("m_enabledAsLayer",
@@ -76,6 +113,36 @@ m_cacheDataFlag(false)
  */
 CiftiConnectivityMatrixDenseDynamicFile::~CiftiConnectivityMatrixDenseDynamicFile()
 {
+    stopBackgroundCaching();
+    releaseCache();
+    
+    CaretMutexLocker locked(&s_cacheMutex);
+    s_allFiles.erase(this);
+}
+
+/**
+ * Set the memory budget for cached row data, shared by all dense dynamic files.
+ * If the cache is over the new budget, least recently used blocks are released.
+ *
+ * @param bytes
+ *     Maximum number of bytes of row data to cache, zero disables caching.
+ */
+void
+CiftiConnectivityMatrixDenseDynamicFile::setCacheMemoryBudget(const int64_t& bytes)
+{
+    CaretMutexLocker locked(&s_cacheMutex);
+    s_cacheMemoryBudget = std::max(bytes, (int64_t)0);
+    makeRoomInCache(0, NULL, true);
+}
+
+/**
+ * @return The memory budget for cached row data, shared by all dense dynamic files.
+ */
+int64_t
+CiftiConnectivityMatrixDenseDynamicFile::getCacheMemoryBudget()
+{
+    CaretMutexLocker locked(&s_cacheMutex);
+    return s_cacheMemoryBudget;
 }
 
 /**
@@ -148,6 +215,9 @@ CiftiConnectivityMatrixDenseDynamicFile::updateAfterReading(const CiftiFile* cif
 {
     m_validDataFlag = false;
     
+    stopBackgroundCaching();
+    releaseCache();
+    
     m_parentDataSeriesCiftiFile = const_cast<CiftiFile*>(ciftiFile);
     
     AString path, nameNoExt, ext;
@@ -171,26 +241,20 @@ CiftiConnectivityMatrixDenseDynamicFile::updateAfterReading(const CiftiFile* cif
         && (m_numberOfTimePoints > 0)) {
         m_rowData.resize(m_numberOfBrainordinates);
         
-        if (m_cacheDataFlag) {
-            /*
-             * Read all of the data.  Time-series type files are not
-             * too large and by caching the data, it eliminates
-             * numerous calls to read the data when correlation
-             * is performed.
-             *
-             * READ DATA FROM PARENT FILE
-             */
-            for (int32_t i = 0; i < m_numberOfBrainordinates; i++) {
-                CaretAssertVectorIndex(m_rowData, i);
-                m_rowData[i].m_data.resize(m_numberOfTimePoints);
-                m_parentDataSeriesCiftiFile->getRow(&m_rowData[i].m_data[0],
-                                                    i);
-            }
+        /*
+         * Statistics and data are read lazily, by block, when they are
+         * first needed or by the background thread, whichever is first
+         */
+        const int32_t numberOfBlocks = (m_numberOfBrainordinates + ROW_BLOCK_SIZE - 1) / ROW_BLOCK_SIZE;
+        {
+            CaretMutexLocker locked(&s_cacheMutex);
+            m_rowBlocks.resize(numberOfBlocks);
         }
-        
-        preComputeRowMeanAndSumSquared();
+        m_useBlockCacheFlag = ( ! m_parentDataSeriesCiftiFile->isInMemory());
         
         m_validDataFlag = true;
+        
+        startBackgroundCaching();
     }
 }
 
@@ -228,6 +292,26 @@ CiftiConnectivityMatrixDenseDynamicFile::getDataForRow(float* dataOut,
                                         index);
 }
 
+/**
+ * Load data for consecutive rows.
+ *
+ * @param dataOut
+ *     Output with data, must have space for numberOfRows rows.
+ * @param firstIndex
+ *     Index of the first row.
+ * @param numberOfRows
+ *     Number of rows.
+ */
+void
+CiftiConnectivityMatrixDenseDynamicFile::getDataForRows(float* dataOut,
+                                                        const int64_t& firstIndex,
+                                                        const int64_t& numberOfRows) const
+{
+    m_parentDataSeriesCiftiFile->getRows(dataOut,
+                                         firstIndex,
+                                         numberOfRows);
+}
+
 /**
  * Load PROCESSED data for the given column.
  *
@@ -268,25 +352,25 @@ CiftiConnectivityMatrixDenseDynamicFile::getProcessedDataForRow(float* dataOut,
         return;
     }
     
+    /*
+     * Read the selected row directly from the file so that it does not
+     * wait for the statistics of its block
+     */
     std::vector<float> rowData(m_numberOfTimePoints);
     m_parentDataSeriesCiftiFile->getRow(&rowData[0], index);
-    const float mean = m_rowData[index].m_mean;
-    const float ssxx = m_rowData[index].m_sqrt_ssxx;
+    float mean = 0.0;
+    float ssxx = 0.0;
+    computeDataMeanAndSumSquared(&rowData[0],
+                                 m_numberOfTimePoints,
+                                 mean,
+                                 ssxx);
     
-    /*
-     * TSC: hyperthreading means some cores end up "faster" than others, so "static" scheduling is generally not as fast
-     * there is almost no overhead to dynamic scheduling
-     */
-#pragma omp CARET_PARFOR schedule(dynamic)
-    for (int32_t iRow = 0; iRow < m_numberOfBrainordinates; iRow++) {
-        float coefficient = 1.0;
-        
-        if (iRow != index) {
-            coefficient = correlation(rowData, mean, ssxx, iRow, m_numberOfTimePoints);
-        }
-        
-        dataOut[iRow] = coefficient;
-    }
+    correlateWithAllRows(&rowData[0],
+                         mean,
+                         ssxx,
+                         dataOut);
+    
+    dataOut[index] = 1.0;
 }
 
 /**
@@ -325,97 +409,282 @@ CiftiConnectivityMatrixDenseDynamicFile::processRowAverageData(std::vector<float
     
     std::vector<float> processedRowAverageData(m_numberOfBrainordinates);
     
-    /*
-     * TSC: hyperthreading means some cores end up "faster" than others, so "static" scheduling is generally not as fast
-     * there is almost no overhead to dynamic scheduling
-     */
-#pragma omp CARET_PARFOR schedule(dynamic)
-    for (int32_t iRow = 0; iRow < m_numberOfBrainordinates; iRow++) {
-        const float coefficient = correlation(rowAverageDataInOut,
-                                              mean,
-                                              sumSquared,
-                                              iRow,
-                                              dataLength);
-        CaretAssertVectorIndex(processedRowAverageData, iRow);
-        processedRowAverageData[iRow] = coefficient;
-    }
+    correlateWithAllRows(&rowAverageDataInOut[0],
+                         mean,
+                         sumSquared,
+                         &processedRowAverageData[0]);
     
     rowAverageDataInOut = processedRowAverageData;
 }
 
 
 /**
- * Compute the mean and sum-squared for each row so that they
- * are only calculated once.
+ * Correlate data with every row, a block of rows at a time.
+ *
+ * @param data
+ *     Data for correlation, must contain number of time points values.
+ * @param mean
+ *     Mean of data
+ * @param sumSquared
+ *     Sum squared of data.
+ * @param dataOut
+ *     Output with correlation to each row, must contain number of brainordinates values.
  */
 void
-CiftiConnectivityMatrixDenseDynamicFile::preComputeRowMeanAndSumSquared()
+CiftiConnectivityMatrixDenseDynamicFile::correlateWithAllRows(const float* data,
+                                                              const float mean,
+                                                              const float sumSquared,
+                                                              float* dataOut) const
 {
-    CaretAssert(m_numberOfBrainordinates > 0);
-    CaretAssert(m_numberOfTimePoints > 0);
-
+    const int32_t numberOfBlocks = static_cast<int32_t>(m_rowBlocks.size());
+    
     /*
      * TSC: hyperthreading means some cores end up "faster" than others, so "static" scheduling is generally not as fast
      * there is almost no overhead to dynamic scheduling
      */
 #pragma omp CARET_PARFOR schedule(dynamic)
-    for (int32_t iRow = 0; iRow < m_numberOfBrainordinates; iRow++) {
+    for (int32_t iBlock = 0; iBlock < numberOfBlocks; iBlock++) {
+        const CaretArray<float> blockData = getRowBlock(iBlock, false);
+        const int32_t firstRow = iBlock * ROW_BLOCK_SIZE;
+        const int32_t numberOfRows = getNumberOfRowsInBlock(iBlock);
+        for (int32_t i = 0; i < numberOfRows; i++) {
+            const int32_t iRow = firstRow + i;
+            CaretAssertVectorIndex(m_rowData, iRow);
+            dataOut[iRow] = correlation(data,
+                                        mean,
+                                        sumSquared,
+                                        blockData.getArray() + (int64_t)i * m_numberOfTimePoints,
+                                        m_rowData[iRow].m_mean,
+                                        m_rowData[iRow].m_sqrt_ssxx,
+                                        m_numberOfTimePoints);
+        }
+    }
+}
 
-        CaretAssertVectorIndex(m_rowData, iRow);
-        
-        if (m_cacheDataFlag) {
-            CaretAssertVectorIndex(m_rowData[iRow].m_data, (m_numberOfTimePoints - 1));
-            computeDataMeanAndSumSquared(&m_rowData[iRow].m_data[0],
-                                         m_numberOfTimePoints,
-                                         m_rowData[iRow].m_mean,
-                                         m_rowData[iRow].m_sqrt_ssxx);
+/**
+ * @return Number of rows in the given block (the last block may be short).
+ *
+ * @param blockIndex
+ *     Index of the block.
+ */
+int32_t
+CiftiConnectivityMatrixDenseDynamicFile::getNumberOfRowsInBlock(const int32_t blockIndex) const
+{
+    return std::min(ROW_BLOCK_SIZE,
+                    m_numberOfBrainordinates - blockIndex * ROW_BLOCK_SIZE);
+}
+
+/**
+ * Get the data for a block of rows, from the cache if it is there, otherwise
+ * from the parent's CIFTI file.  Statistics for the rows in the block are
+ * valid after this returns.
+ *
+ * @param blockIndex
+ *     Index of the block.
+ * @param backgroundFlag
+ *     True when called by the background thread: it does not evict other
+ *     blocks, and does not read blocks that would neither be cached nor
+ *     provide new statistics.
+ * @return
+ *     Data for the rows in the block, one row after another.  Invalid (NULL)
+ *     only when backgroundFlag is true and there was nothing to do.
+ */
+CaretArray<float>
+CiftiConnectivityMatrixDenseDynamicFile::getRowBlock(const int32_t blockIndex,
+                                                     const bool backgroundFlag) const
+{
+    CaretAssertVectorIndex(m_rowBlocks, blockIndex);
+    const int32_t firstRow = blockIndex * ROW_BLOCK_SIZE;
+    const int32_t numberOfRows = getNumberOfRowsInBlock(blockIndex);
+    const int64_t blockBytes = (int64_t)numberOfRows * m_numberOfTimePoints * sizeof(float);
+    
+    {
+        CaretMutexLocker locked(&s_cacheMutex);
+        RowBlock& block = m_rowBlocks[blockIndex];
+        if (block.m_data != NULL) {
+            if ( ! backgroundFlag) {
+                block.m_lastUsed = ++s_cacheUseCounter;
+            }
+            return block.m_data;
         }
-        else {
-            std::vector<float> data(m_numberOfTimePoints);
-#pragma omp critical
-            {//TSC: this can do disk access, which is not currently thread-safe
-                m_parentDataSeriesCiftiFile->getRow(&data[0], iRow);
+        if (backgroundFlag
+            && block.m_statsValid) {
+            if (( ! m_useBlockCacheFlag)
+                || (s_cacheMemoryUsed + blockBytes > s_cacheMemoryBudget)) {
+                return CaretArray<float>();
             }
-            computeDataMeanAndSumSquared(&data[0],
-                                         m_numberOfTimePoints,
-                                         m_rowData[iRow].m_mean,
-                                         m_rowData[iRow].m_sqrt_ssxx);
         }
-        
-//        double sum = 0.0;
-//        double sumSquared = 0.0;
-//        if (m_cacheDataFlag) {
-//            for (int32_t iPoint = 0; iPoint < m_numberOfTimePoints; iPoint++) {
-//                CaretAssertVectorIndex(m_rowData[iRow].m_data, iPoint);
-//                const float d = m_rowData[iRow].m_data[iPoint];
-//                sum        += d;
-//                sumSquared += (d * d);
-//            }
-//        }
-//        else {
-//            std::vector<float> data(m_numberOfTimePoints);
-//            m_parentDataSeriesCiftiFile->getRow(&data[0], iRow);
-//            for (int32_t iPoint = 0; iPoint < m_numberOfTimePoints; iPoint++) {
-//                CaretAssertVectorIndex(data, iPoint);
-//                const float d = data[iPoint];
-//                sum        += d;
-//                sumSquared += (d * d);
-//            }
-//        }
-//        
-//        const float mean       = (sum / numPointsFloat);
-//        const float ssxx = (sumSquared - (numPointsFloat * mean * mean));
-//        CaretAssert(ssxx >= 0.0);
-//        
-//        const float meanDiff = std::fabs(mean - m_rowData[iRow].m_mean);
-//        const float ssDiff   = std::fabs(std::sqrt(ssxx) - m_rowData[iRow].m_sqrt_ssxx);
-//        if ((meanDiff > 0.0001) || (ssDiff > 0.0001)) {
-//            std::cout << "Mean/SS diff" << std::endl;
-//        }
-//        
-//        m_rowData[iRow].m_mean = mean;
-//        m_rowData[iRow].m_sqrt_ssxx = std::sqrt(ssxx);
     }
+    
+    /*
+     * NiftiIO row reads are safe to do from multiple threads
+     */
+    CaretArray<float> blockData((int64_t)numberOfRows * m_numberOfTimePoints);
+    std::vector<RowData> blockStats(numberOfRows);
+    for (int32_t i = 0; i < numberOfRows; i++) {
+        float* rowData = blockData.getArray() + (int64_t)i * m_numberOfTimePoints;
+        m_parentDataSeriesCiftiFile->getRow(rowData, firstRow + i);
+        computeDataMeanAndSumSquared(rowData,
+                                     m_numberOfTimePoints,
+                                     blockStats[i].m_mean,
+                                     blockStats[i].m_sqrt_ssxx);
+    }
+    
+    CaretMutexLocker locked(&s_cacheMutex);
+    RowBlock& block = m_rowBlocks[blockIndex];
+    if ( ! block.m_statsValid) {
+        for (int32_t i = 0; i < numberOfRows; i++) {
+            CaretAssertVectorIndex(m_rowData, firstRow + i);
+            m_rowData[firstRow + i] = blockStats[i];
+        }
+        block.m_statsValid = true;
+    }
+    if (m_useBlockCacheFlag
+        && (block.m_data == NULL)) {
+        if (makeRoomInCache(blockBytes, this, ( ! backgroundFlag))) {
+            block.m_data = blockData;
+            block.m_lastUsed = (backgroundFlag ? 0 : ++s_cacheUseCounter);
+            s_cacheMemoryUsed += blockBytes;
+        }
+    }
+    
+    return blockData;
+}
+
+/**
+ * Release cached blocks until there is room for the given number of bytes.
+ * Caller must hold s_cacheMutex.
+ *
+ * @param bytesNeeded
+ *     Number of bytes to add to the cache.
+ * @param requester
+ *     File that will add to the cache, its own blocks are not evicted
+ *     since a correlation streams through all of its blocks and would
+ *     otherwise evict the blocks it needs next.  NULL allows eviction
+ *     from any file.
+ * @param allowEviction
+ *     If false, only check whether the bytes fit in the budget.
+ * @return
+ *     True if the bytes now fit in the budget.
+ */
+bool
+CiftiConnectivityMatrixDenseDynamicFile::makeRoomInCache(const int64_t& bytesNeeded,
+                                                         const CiftiConnectivityMatrixDenseDynamicFile* requester,
+                                                         const bool allowEviction)
+{
+    if (bytesNeeded > s_cacheMemoryBudget) {
+        return false;
+    }
+    while (s_cacheMemoryUsed + bytesNeeded > s_cacheMemoryBudget) {
+        if ( ! allowEviction) {
+            return false;
+        }
+        CiftiConnectivityMatrixDenseDynamicFile* oldestFile = NULL;
+        int32_t oldestBlock = -1;
+        for (std::set<CiftiConnectivityMatrixDenseDynamicFile*>::iterator iter = s_allFiles.begin();
+             iter != s_allFiles.end();
+             iter++) {
+            CiftiConnectivityMatrixDenseDynamicFile* file = *iter;
+            if (file == requester) {
+                continue;
+            }
+            const int32_t numberOfBlocks = static_cast<int32_t>(file->m_rowBlocks.size());
+            for (int32_t i = 0; i < numberOfBlocks; i++) {
+                const RowBlock& block = file->m_rowBlocks[i];
+                if (block.m_data != NULL) {
+                    if ((oldestFile == NULL)
+                        || (block.m_lastUsed < oldestFile->m_rowBlocks[oldestBlock].m_lastUsed)) {
+                        oldestFile = file;
+                        oldestBlock = i;
+                    }
+                }
+            }
+        }
+        if (oldestFile == NULL) {
+            return false;
+        }
+        RowBlock& block = oldestFile->m_rowBlocks[oldestBlock];
+        s_cacheMemoryUsed -= block.m_data.size() * sizeof(float);
+        block.m_data = CaretArray<float>();//readers that still hold the block keep it alive until they are done
+    }
+    return true;
+}
+
+/**
+ * Compute statistics for blocks that have not been read and cache blocks
+ * while there is room.  Called by the background thread.
+ */
+void
+CiftiConnectivityMatrixDenseDynamicFile::fillCacheInBackground()
+{
+    const int32_t numberOfBlocks = static_cast<int32_t>(m_rowBlocks.size());
+    for (int32_t i = 0; i < numberOfBlocks; i++) {
+        {
+            CaretMutexLocker locked(&s_cacheMutex);
+            if (m_stopBackgroundFlag) {
+                return;
+            }
+        }
+        try {
+            getRowBlock(i, true);
+        }
+        catch (const CaretException& e) {
+            CaretLogWarning("Background reading of "
+                            + getFileNameNoPath()
+                            + " stopped: "
+                            + e.whatString());
+            return;
+        }
+    }
+}
+
+/**
+ * Start the background thread that computes statistics and fills the cache.
+ */
+void
+CiftiConnectivityMatrixDenseDynamicFile::startBackgroundCaching()
+{
+    CaretAssert(m_backgroundThread == NULL);
+    {
+        CaretMutexLocker locked(&s_cacheMutex);
+        m_stopBackgroundFlag = false;
+    }
+    m_backgroundThread.grabNew(new DenseDynamicCacheThread(this));
+    m_backgroundThread->start(QThread::LowPriority);
+}
+
+/**
+ * Stop the background thread and wait for it to finish.
+ */
+void
+CiftiConnectivityMatrixDenseDynamicFile::stopBackgroundCaching()
+{
+    if (m_backgroundThread == NULL) {
+        return;
+    }
+    {
+        CaretMutexLocker locked(&s_cacheMutex);
+        m_stopBackgroundFlag = true;
+    }
+    m_backgroundThread->wait();
+    m_backgroundThread.grabNew(NULL);
+}
+
+/**
+ * Release all blocks of this file and their statistics.
+ */
+void
+CiftiConnectivityMatrixDenseDynamicFile::releaseCache()
+{
+    CaretMutexLocker locked(&s_cacheMutex);
+    for (std::vector<RowBlock>::iterator iter = m_rowBlocks.begin();
+         iter != m_rowBlocks.end();
+         iter++) {
+        if (iter->m_data != NULL) {
+            s_cacheMemoryUsed -= iter->m_data.size() * sizeof(float);
+        }
+    }
+    m_rowBlocks.clear();
 }
 
 /**
@@ -468,99 +737,39 @@ CiftiConnectivityMatrixDenseDynamicFile::computeDataMeanAndSumSquared(const floa
  *     Mean of data
  * @param sumSquared
  *     Sum squared of data.
- * @param otherRowIndex
- *     Index of another row
+ * @param otherData
+ *     Data of another row
+ * @param otherMean
+ *     Mean of the other row
+ * @param otherSumSquared
+ *     Sum squared of the other row
  * @param numberOfPoints
  *     Number of points int the two arrays
  * @return
  *     The correlation coefficient computed on the two arrays.
  */
 float
-CiftiConnectivityMatrixDenseDynamicFile::correlation(const std::vector<float>& data,
+CiftiConnectivityMatrixDenseDynamicFile::correlation(const float* data,
                                                      const float mean,
                                                      const float sumSquared,
-                                                     const int32_t otherRowIndex,
+                                                     const float* otherData,
+                                                     const float otherMean,
+                                                     const float otherSumSquared,
                                                      const int32_t numberOfPoints) const
 {
     const double numFloat = numberOfPoints;
-    double xySum = 0.0;
-    
-    CaretAssertVectorIndex(m_rowData, otherRowIndex);
-    const RowData& otherData = m_rowData[otherRowIndex];
-    
-    if (m_cacheDataFlag) {
-        xySum = dsdot(&data[0], &otherData.m_data[0], numberOfPoints);
-    }
-    else {
-        std::vector<float> otherDataVector(m_numberOfTimePoints);
-        m_parentDataSeriesCiftiFile->getRow(&otherDataVector[0], otherRowIndex);
-        xySum = dsdot(&data[0], &otherDataVector[0], numberOfPoints);
-    }
+    const double xySum = dsdot(data, otherData, numberOfPoints);
     
-    const double ssxy = xySum - (numFloat * mean * otherData.m_mean);
+    const double ssxy = xySum - (numFloat * mean * otherMean);
     
     float correlationCoefficient = 0.0;
     if ((sumSquared > 0.0)
-        && (otherData.m_sqrt_ssxx > 0.0)) {
-        correlationCoefficient = (ssxy / (sumSquared * otherData.m_sqrt_ssxx));
+        && (otherSumSquared > 0.0)) {
+        correlationCoefficient = (ssxy / (sumSquared * otherSumSquared));
     }
     return correlationCoefficient;
 }
 
-/**
- * Correlation from https://en.wikipedia.org/wiki/Pearson_product-moment_correlation_coefficient
- *
- * @param rowIndex
- *     Index of a row
- * @param otherRowIndex
- *     Index of another row
- * @param numberOfPoints
- *     Number of points int the two arrays
- * @return
- *     The correlation coefficient computed on the two arrays.
- */
-float
-CiftiConnectivityMatrixDenseDynamicFile::correlation(const int32_t rowIndex,
-                                                     const int32_t otherRowIndex,
-                                                     const int32_t numberOfPoints) const
-{
-    const double numFloat = numberOfPoints;
-    double xySum = 0.0;
-    
-    CaretAssertVectorIndex(m_rowData, rowIndex);
-    CaretAssertVectorIndex(m_rowData, otherRowIndex);
-    const RowData& data = m_rowData[rowIndex];
-    const RowData& otherData = m_rowData[otherRowIndex];
-    
-    if (m_cacheDataFlag) {
-        for (int i = 0; i < numberOfPoints; i++) {
-            CaretAssertVectorIndex(data.m_data, i);
-            CaretAssertVectorIndex(otherData.m_data, i);
-            xySum += data.m_data[i] * otherData.m_data[i];
-        }
-    }
-    else {
-        std::vector<float> dataVector(m_numberOfTimePoints);
-        std::vector<float> otherDataVector(m_numberOfTimePoints);
-        m_parentDataSeriesCiftiFile->getRow(&dataVector[0], rowIndex);
-        m_parentDataSeriesCiftiFile->getRow(&otherDataVector[0], otherRowIndex);
-        
-        for (int i = 0; i < numberOfPoints; i++) {
-            CaretAssertVectorIndex(dataVector, i);
-            CaretAssertVectorIndex(otherDataVector, i);
-            xySum += dataVector[i] * otherDataVector[i];
-        }
-    }
-    
-    const double ssxy = xySum - (numFloat * data.m_mean * otherData.m_mean);
-    
-    float correlationCoefficient = 0.0;
-    if ((data.m_sqrt_ssxx > 0.0)
-        && (otherData.m_sqrt_ssxx > 0.0)) {
-        correlationCoefficient = (ssxy / (data.m_sqrt_ssxx * otherData.m_sqrt_ssxx));
-    }
-    return correlationCoefficient;
-}
 /**
  * Save subclass data to the scene.
  *
@@ -21,9 +21,14 @@
  */
 /*LICENSE_END*/
 
+#include <set>
+
+#include "CaretMutex.h"
 #include "CaretPointer.h"
 #include "CiftiMappableConnectivityMatrixDataFile.h"
 
+class QThread;
+
 namespace caret {
     class CiftiBrainordinateDataSeriesFile;
     class SceneClassAssistant;
@@ -49,6 +54,12 @@ namespace caret {
         
         const CiftiBrainordinateDataSeriesFile* getParentBrainordinateDataSeriesFile() const;
         
+        static void setCacheMemoryBudget(const int64_t& bytes);
+        
+        static int64_t getCacheMemoryBudget();
+        
+        void fillCacheInBackground();
+        
     private:
         CiftiConnectivityMatrixDenseDynamicFile(const CiftiConnectivityMatrixDenseDynamicFile&);
 
@@ -58,6 +69,8 @@ namespace caret {
         virtual void getDataForColumn(float* dataOut, const int64_t& index) const;
         
         virtual void getDataForRow(float* dataOut, const int64_t& index) const;
+        
+        virtual void getDataForRows(float* dataOut, const int64_t& firstIndex, const int64_t& numberOfRows) const;
                 
         virtual void getProcessedDataForColumn(float* dataOut, const int64_t& index) const;
         
@@ -78,22 +91,51 @@ namespace caret {
             
             ~RowData() { }
             
-            std::vector<float> m_data;
             float m_mean;
             float m_sqrt_ssxx;
         };
         
-        float correlation(const int32_t rowIndex,
-                          const int32_t otherRowIndex,
-                          const int32_t numberOfPoints) const;
+        /**
+         * A block of consecutive rows.  Statistics for the rows are
+         * computed the first time the block is read, the data is kept
+         * only while the shared cache has room for it.
+         */
+        class RowBlock {
+        public:
+            RowBlock() : m_lastUsed(0), m_statsValid(false) { }
+            
+            CaretArray<float> m_data;
+            int64_t m_lastUsed;
+            bool m_statsValid;
+        };
         
-        float correlation(const std::vector<float>& data,
+        float correlation(const float* data,
                           const float mean,
                           const float sumSquared,
-                          const int32_t otherRowIndex,
+                          const float* otherData,
+                          const float otherMean,
+                          const float otherSumSquared,
                           const int32_t numberOfPoints) const;
         
-        void preComputeRowMeanAndSumSquared();
+        void correlateWithAllRows(const float* data,
+                                  const float mean,
+                                  const float sumSquared,
+                                  float* dataOut) const;
+        
+        CaretArray<float> getRowBlock(const int32_t blockIndex,
+                                      const bool backgroundFlag) const;
+        
+        int32_t getNumberOfRowsInBlock(const int32_t blockIndex) const;
+        
+        void startBackgroundCaching();
+        
+        void stopBackgroundCaching();
+        
+        void releaseCache();
+        
+        static bool makeRoomInCache(const int64_t& bytesNeeded,
+                                    const CiftiConnectivityMatrixDenseDynamicFile* requester,
+                                    const bool allowEviction);
         
         void computeDataMeanAndSumSquared(const float* data,
                                           const int32_t dataLength,
@@ -108,22 +150,48 @@ namespace caret {
         
         int32_t m_numberOfTimePoints;
         
-        std::vector<RowData> m_rowData;
+        mutable std::vector<RowData> m_rowData;
+        
+        mutable std::vector<RowBlock> m_rowBlocks;
+        
+        /** cache blocks only when the parent data is on disk, in-memory data is already fast to get */
+        bool m_useBlockCacheFlag;
+        
+        /** protected by s_cacheMutex */
+        bool m_stopBackgroundFlag;
+        
+        CaretPointer<QThread> m_backgroundThread;
         
         bool m_validDataFlag;
         
         bool m_enabledAsLayer;
         
-        const bool m_cacheDataFlag;
-        
         CaretPointer<SceneClassAssistant> m_sceneAssistant;
         
+        static const int32_t ROW_BLOCK_SIZE;
+        
+        /** protects the caches, statistics flags, and memory totals of all dense dynamic files */
+        static CaretMutex s_cacheMutex;
+        
+        static std::set<CiftiConnectivityMatrixDenseDynamicFile*> s_allFiles;
+        
+        static int64_t s_cacheMemoryBudget;
+        
+        static int64_t s_cacheMemoryUsed;
+        
+        static int64_t s_cacheUseCounter;
+        
         // ADD_NEW_MEMBERS_HERE
 
     };
     
 #ifdef __CIFTI_CONNECTIVITY_MATRIX_DENSE_DYNAMIC_FILE_DECLARE__
-    // <PLACE DECLARATIONS OF STATIC MEMBERS HERE>
+    const int32_t CiftiConnectivityMatrixDenseDynamicFile::ROW_BLOCK_SIZE = 512;
+    CaretMutex CiftiConnectivityMatrixDenseDynamicFile::s_cacheMutex;
+    std::set<CiftiConnectivityMatrixDenseDynamicFile*> CiftiConnectivityMatrixDenseDynamicFile::s_allFiles;
+    int64_t CiftiConnectivityMatrixDenseDynamicFile::s_cacheMemoryBudget = ((int64_t)2) * 1024 * 1024 * 1024;//2GiB shared by all open files
+    int64_t CiftiConnectivityMatrixDenseDynamicFile::s_cacheMemoryUsed = 0;
+    int64_t CiftiConnectivityMatrixDenseDynamicFile::s_cacheUseCounter = 0;
 #endif // __CIFTI_CONNECTIVITY_MATRIX_DENSE_DYNAMIC_FILE_DECLARE__
 
 } // namespace
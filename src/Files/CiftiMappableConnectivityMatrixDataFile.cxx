@@ -26,6 +26,7 @@
 #include "CaretAssert.h"
 #include "CiftiFile.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "ChartableMatrixParcelInterface.h"
 #include "ConnectivityDataLoaded.h"
 #include "DataFileException.h"
@@ -35,8 +36,16 @@
 #include "SceneClass.h"
 #include "SceneClassAssistant.h"
 
+#include <algorithm>
+
 using namespace caret;
 
+/**
+ * Maximum number of values read with one request when averaging
+ * consecutive rows, per thread.
+ */
+static const int64_t MAXIMUM_ELEMENTS_PER_READ = 1024 * 1024;
+
 
     
 /**
@@ -336,6 +345,12 @@ CiftiMappableConnectivityMatrixDataFile::getRowColumnIndicesForNodesWhenLoading(
 /**
  * Get the average for or column for the given row/column indices.
  *
+ * The indices are sorted and consecutive rows are read with one request
+ * (getDataForRows), and the reads are spread over threads that each sum
+ * into their own buffer, so averaging a large ROI takes about as long as
+ * one sequential pass over the selected rows.  Progress is reported from
+ * the calling thread, and if the user cancels, both outputs are empty.
+ *
  * @param rowIndices
  *     Indices of the row.
  * @param columnIndices
@@ -344,6 +359,8 @@ CiftiMappableConnectivityMatrixDataFile::getRowColumnIndicesForNodesWhenLoading(
  *     Average values for rows.
  * @param columnAverageOut
  *     Average value for columns.
+ * @throw
+ *    DataFileException if there is an error reading the data.
  */
 void
 CiftiMappableConnectivityMatrixDataFile::getRowColumnAverageForIndices(const std::vector<int64_t>& rowIndices,
@@ -369,42 +386,184 @@ CiftiMappableConnectivityMatrixDataFile::getRowColumnAverageForIndices(const std
     }
     
     const int64_t numIndices = static_cast<int64_t>(indices.size());
-    if (numIndices > 0) {
-        std::vector<double> sum(dataLength, 0.0);
-        std::vector<float>  data(dataLength);
-        
-        for (std::vector<int64_t>::const_iterator iter = indices.begin();
-             iter != indices.end();
-             iter++) {
-            if (doRowsFlag) {
-                getDataForRow(&data[0], *iter);
+    if ((numIndices <= 0)
+        || (dataLength <= 0)) {
+        return;
+    }
+    
+    /*
+     * Sort the indices and count duplicates (a duplicate index is
+     * still counted more than once in the average).
+     */
+    std::sort(indices.begin(),
+              indices.end());
+    std::vector<int64_t> uniqueIndices;
+    std::vector<int64_t> indexCounts;
+    for (int64_t i = 0; i < numIndices; i++) {
+        if (( ! uniqueIndices.empty())
+            && (uniqueIndices.back() == indices[i])) {
+            indexCounts.back()++;
+        }
+        else {
+            uniqueIndices.push_back(indices[i]);
+            indexCounts.push_back(1);
+        }
+    }
+    
+    /*
+     * Group consecutive rows into runs that are read with one request.
+     * Columns are not contiguous in the file, so each is its own run.
+     */
+    const int64_t maximumRunLength = (doRowsFlag
+                                      ? std::max(static_cast<int64_t>(1),
+                                                 MAXIMUM_ELEMENTS_PER_READ / dataLength)
+                                      : 1);
+    std::vector<int64_t> runStarts;
+    std::vector<int64_t> runLengths;
+    const int64_t numUnique = static_cast<int64_t>(uniqueIndices.size());
+    for (int64_t i = 0; i < numUnique; i++) {
+        if (( ! runStarts.empty())
+            && (runLengths.back() < maximumRunLength)
+            && (uniqueIndices[runStarts.back() + runLengths.back() - 1] + 1 == uniqueIndices[i])) {
+            runLengths.back()++;
+        }
+        else {
+            runStarts.push_back(i);
+            runLengths.push_back(1);
+        }
+    }
+    const int64_t numRuns = static_cast<int64_t>(runStarts.size());
+    
+    EventProgressUpdate progressEvent(0,
+                                      numRuns,
+                                      0,
+                                      ("Averaging data for "
+                                       + QString::number(numIndices)
+                                       + " brainordinates in file ")
+                                      + getFileNameNoPath());
+    EventManager::get()->sendEvent(progressEvent.getPointer());
+    
+    /*
+     * Requests to a remote server are not made from multiple threads
+     */
+    const bool parallelFlag = ((numRuns > 1)
+                               && ( ! DataFile::isFileOnNetwork(getFileName())));
+    std::vector<double> sum(dataLength, 0.0);
+    int64_t numberOfRunsDone = 0;
+    /*
+     * Flags are written by one thread and read by others, so they
+     * are only accessed atomically
+     */
+    bool cancelledFlag = false;
+    bool errorFlag = false;
+    AString errorMessage;
+#pragma omp CARET_PAR if (parallelFlag)
+    {
+        std::vector<double> threadSum(dataLength, 0.0);
+        std::vector<float> data(maximumRunLength * dataLength);
+        double* threadSumPointer = &threadSum[0];
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int64_t iRun = 0; iRun < numRuns; iRun++) {
+            bool stopFlag = false;
+            bool stopForErrorFlag = false;
+#pragma omp atomic read
+            stopFlag = cancelledFlag;
+#pragma omp atomic read
+            stopForErrorFlag = errorFlag;
+            if (stopFlag
+                || stopForErrorFlag) {
+                continue;
+            }
+            
+            const int64_t firstUnique = runStarts[iRun];
+            const int64_t runLength   = runLengths[iRun];
+            try {
+                if (doRowsFlag) {
+                    getDataForRows(&data[0],
+                                   uniqueIndices[firstUnique],
+                                   runLength);
+                }
+                else {
+                    getDataForColumn(&data[0],
+                                     uniqueIndices[firstUnique]);
+                }
+            }
+            catch (const CaretException& e) {
+#pragma omp critical
+                {
+                    errorMessage = e.whatString();
+#pragma omp atomic write
+                    errorFlag = true;
+                }
+                continue;
             }
-            else {
-                getDataForColumn(&data[0], *iter);
+            
+            for (int64_t iRow = 0; iRow < runLength; iRow++) {
+                const float* rowData = &data[iRow * dataLength];
+                const double count = indexCounts[firstUnique + iRow];
+                if (count == 1.0) {
+                    for (int64_t i = 0; i < dataLength; i++) {
+                        threadSumPointer[i] += rowData[i];
+                    }
+                }
+                else {
+                    for (int64_t i = 0; i < dataLength; i++) {
+                        threadSumPointer[i] += rowData[i] * count;
+                    }
+                }
             }
             
-            for (int64_t i = 0; i < dataLength; i++) {
-                CaretAssertVectorIndex(sum, i);
-                CaretAssertVectorIndex(data, i);
-                sum[i] += data[i];
+#pragma omp atomic
+            numberOfRunsDone++;
+            
+            /*
+             * Events go to the GUI, so only the calling thread sends them
+             */
+#ifdef CARET_OMP
+            if (omp_get_thread_num() == 0)
+#endif
+            {
+                int64_t runsDoneForProgress = 0;
+#pragma omp atomic read
+                runsDoneForProgress = numberOfRunsDone;
+                progressEvent.setProgress(static_cast<int32_t>(runsDoneForProgress),
+                                          "");
+                EventManager::get()->sendEvent(progressEvent.getPointer());
+                if (progressEvent.isCancelled()) {
+#pragma omp atomic write
+                    cancelledFlag = true;
+                }
             }
         }
-
-        CaretAssert(dataLength > 0);
-        std::vector<float> average(dataLength);
-        const float floatNumIndices = numIndices; //dataLength;
-        for (int64_t i = 0; i < dataLength; i++) {
-            CaretAssertVectorIndex(average, i);
-            CaretAssertVectorIndex(sum, i);
-            average[i] = sum[i] / floatNumIndices;
+        
+#pragma omp critical
+        {
+            for (int64_t i = 0; i < dataLength; i++) {
+                sum[i] += threadSum[i];
+            }
         }
+    }
+    
+    if ( ! errorMessage.isEmpty()) {
+        throw DataFileException(errorMessage);
+    }
+    if (cancelledFlag) {
+        return;
+    }
 
-        if (doRowsFlag) {
-            rowAverageOut = average;
-        }
-        else {
-            columnAverageOut = average;
-        }
+    std::vector<float> average(dataLength);
+    const float floatNumIndices = numIndices; //dataLength;
+    for (int64_t i = 0; i < dataLength; i++) {
+        CaretAssertVectorIndex(average, i);
+        CaretAssertVectorIndex(sum, i);
+        average[i] = sum[i] / floatNumIndices;
+    }
+    
+    if (doRowsFlag) {
+        rowAverageOut = average;
+    }
+    else {
+        columnAverageOut = average;
     }
 }
 
@@ -594,6 +753,26 @@ CiftiMappableConnectivityMatrixDataFile::getDataForRow(float* dataOut, const int
                         index);
 }
 
+/**
+ * Load data for consecutive rows, with one read when the file is on disk.
+ *
+ * @param dataOut
+ *     Output with data, must have space for numberOfRows rows.
+ * @param firstIndex
+ *     Index of the first row.
+ * @param numberOfRows
+ *     Number of rows.
+ */
+void
+CiftiMappableConnectivityMatrixDataFile::getDataForRows(float* dataOut,
+                                                        const int64_t& firstIndex,
+                                                        const int64_t& numberOfRows) const
+{
+    m_ciftiFile->getRows(dataOut,
+                         firstIndex,
+                         numberOfRows);
+}
+
 /**
  * Load PROCESSED data for the given column.
  *
@@ -18,8 +18,11 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
 #include <set>
 
+#include <QFile>
+
 #define __CIFTI_MAPPABLE_DATA_FILE_DECLARE__
 #include "CiftiMappableDataFile.h"
 #undef __CIFTI_MAPPABLE_DATA_FILE_DECLARE__
@@ -35,6 +38,7 @@
 #include "CiftiConnectivityMatrixParcelFile.h"
 #include "CiftiFiberTrajectoryFile.h"
 #include "CiftiFile.h"
+#include "CiftiMatrixPyramid.h"
 #include "CiftiMappableConnectivityMatrixDataFile.h"
 #include "CaretMappableDataFileAndMapSelectionModel.h"
 #include "CiftiParcelLabelFile.h"
@@ -45,8 +49,10 @@
 #include "CaretTemporaryFile.h"
 #include "CiftiXML.h"
 #include "DataFileContentInformation.h"
+#include "DataFileException.h"
 #include "EventManager.h"
 #include "EventCaretPreferencesGet.h"
+#include "EventProgressUpdate.h"
 #include "EventSurfaceColoringInvalidate.h"
 #include "FastStatistics.h"
 #include "FileInformation.h"
@@ -54,6 +60,7 @@
 #include "GiftiLabelTable.h"
 #include "GiftiMetaData.h"
 #include "GraphicsPrimitiveV3fC4f.h"
+#include "GraphicsPrimitiveV3fT3f.h"
 #include "GroupAndNameHierarchyModel.h"
 #include "Histogram.h"
 #include "MapFileDataSelector.h"
@@ -459,6 +466,12 @@ CiftiMappableDataFile::clearPrivate()
     
     m_ciftiFile.grabNew(NULL);
     
+    m_matrixPyramidTiles.clear();
+    m_matrixPyramidFastStatistics.reset();
+    m_matrixPyramid.reset();
+    m_matrixPyramidCachedFlag = false;
+    m_matrixPyramidBuildRequestedFlag = false;
+    
     resetDataLoadingMembers();
     
     m_containsSurfaceData = false;
@@ -682,6 +695,12 @@ CiftiMappableDataFile::readFile(const AString& ciftiMapFileName)
                     break;
                 case FILE_MAP_DATA_TYPE_MATRIX:
                     m_ciftiFile->openFile(ciftiMapFileName);
+                    /*
+                     * Columns of a symmetric matrix (most dense connectomes)
+                     * are loaded from the matching row, which is one read
+                     * instead of one read per row.
+                     */
+                    m_ciftiFile->setSymmetricColumnReading(true);
                     break;
                 case FILE_MAP_DATA_TYPE_MULTI_MAP:
                     m_ciftiFile->openFile(ciftiMapFileName);
@@ -1436,6 +1455,7 @@ CiftiMappableDataFile::invalidateColoringInAllMaps()
      */
     m_matrixGraphicsPrimitive.reset();
     m_matrixGraphicsOutlinePrimitive.reset();
+    m_matrixPyramidTiles.clear();
     invalidateHistogramChartColoring();
 }
 
@@ -1722,6 +1742,426 @@ CiftiMappableDataFile::getMatrixChartingGraphicsPrimitive(const ChartTwoMatrixTr
 }
 
 
+/**
+ * @return True if the matrix chart of this file is drawn from the
+ * matrix pyramid (tiles of min/max/mean summaries) instead of one
+ * primitive containing every cell.  Dense matrices are always drawn
+ * from the pyramid, other matrices only when they are very large.
+ */
+bool
+CiftiMappableDataFile::isMatrixChartingWithPyramid() const
+{
+    if (m_ciftiFile == NULL) {
+        return false;
+    }
+    
+    switch (getDataFileType()) {
+        case DataFileTypeEnum::CONNECTIVITY_DENSE:
+        case DataFileTypeEnum::CONNECTIVITY_DENSE_TIME_SERIES:
+            return true;
+        default:
+            break;
+    }
+    
+    const int64_t numberOfCells = m_ciftiFile->getNumberOfRows() * m_ciftiFile->getNumberOfColumns();
+    return (numberOfCells > s_matrixPyramidMinimumNumberOfCells);
+}
+
+/**
+ * Get the matrix pyramid for drawing a matrix chart of this file.
+ * This is called while drawing, so it never reads the matrix.  On first
+ * use, the pyramid is read from its sidecar file when the sidecar is
+ * valid for this file.  For a file on the network, the sidecar must
+ * have been made with -cifti-matrix-pyramid and placed next to the file.
+ * For a local file without a valid sidecar, a request to build the
+ * pyramid is made, see isMatrixPyramidBuildRequested().
+ *
+ * @return
+ *     The matrix pyramid or NULL if it is not available.
+ */
+const CiftiMatrixPyramid*
+CiftiMappableDataFile::getMatrixPyramid() const
+{
+    if (m_matrixPyramidCachedFlag) {
+        return m_matrixPyramid.get();
+    }
+    m_matrixPyramidCachedFlag = true;
+    
+    if (m_ciftiFile == NULL) {
+        return NULL;
+    }
+    if (m_ciftiFile->getDimensions().size() != 2) {
+        return NULL;
+    }
+    
+    const AString ciftiFileName = getFileName();
+    const AString pyramidFileName = CiftiMatrixPyramid::getSidecarFileName(ciftiFileName);
+    
+    std::unique_ptr<CiftiMatrixPyramid> pyramid(new CiftiMatrixPyramid());
+    if (DataFile::isFileOnNetwork(ciftiFileName)) {
+        /*
+         * Building would read the entire matrix over the network.
+         * The size and time of the remote file are not available,
+         * so the sidecar is only checked against the matrix dimensions.
+         */
+        bool validFlag = false;
+        try {
+            CaretTemporaryFile tempFile;
+            tempFile.readFile(pyramidFileName);
+            validFlag = pyramid->readFile(tempFile.getFileName(),
+                                          m_ciftiFile,
+                                          "");
+        }
+        catch (const DataFileException& dfe) {
+            CaretLogFine("Unable to read matrix summary "
+                         + pyramidFileName
+                         + ": "
+                         + dfe.whatString());
+        }
+        if ( ! validFlag) {
+            CaretLogWarning("The matrix of "
+                            + getFileNameNoPath()
+                            + " cannot be charted because it is on the network and there is no valid matrix summary "
+                            + pyramidFileName
+                            + ".  Create it with wb_command -cifti-matrix-pyramid and place it next to the file.");
+            return NULL;
+        }
+    }
+    else {
+        if ( ! pyramid->readFile(pyramidFileName,
+                                 m_ciftiFile,
+                                 ciftiFileName)) {
+            m_matrixPyramidBuildRequestedFlag = true;
+            return NULL;
+        }
+    }
+    
+    setMatrixPyramid(pyramid.release());
+    
+    return m_matrixPyramid.get();
+}
+
+/**
+ * @return True if drawing needed the matrix pyramid of this file and it
+ * has not been built.  Drawing never builds the pyramid since it reads
+ * the entire matrix.  The user-interface should call buildMatrixPyramid()
+ * outside of drawing and then update the graphics.
+ */
+bool
+CiftiMappableDataFile::isMatrixPyramidBuildRequested() const
+{
+    return m_matrixPyramidBuildRequestedFlag;
+}
+
+/**
+ * Build the matrix pyramid by reading the matrix once, a band of rows at
+ * a time, and attempt to save it to the sidecar file.  Progress is sent
+ * with EventProgressUpdate and the build stops if the user cancels.
+ * A cancelled build is not requested again until the file is read again.
+ *
+ * @return
+ *     True if the pyramid was built, else false.
+ */
+bool
+CiftiMappableDataFile::buildMatrixPyramid()
+{
+    if ( ! m_matrixPyramidBuildRequestedFlag) {
+        return (m_matrixPyramid != NULL);
+    }
+    m_matrixPyramidBuildRequestedFlag = false;
+    CaretAssert(m_ciftiFile);
+    
+    /*
+     * Sends progress and checks for cancellation after each band of rows
+     */
+    class PyramidBuildProgress : public CiftiMatrixPyramid::BuildObserver {
+    public:
+        PyramidBuildProgress(const AString& fileNameNoPath)
+        : m_progressEvent(0,
+                          1000,
+                          0,
+                          ("Computing matrix summary for "
+                           + fileNameNoPath)) {
+            EventManager::get()->sendEvent(m_progressEvent.getPointer());
+        }
+        
+        bool bandFinished(const int64_t& bandsDone,
+                          const int64_t& numBands) {
+            /*
+             * Progress values are int, so report in thousandths
+             */
+            m_progressEvent.setProgress(static_cast<int32_t>((bandsDone * 1000) / numBands),
+                                        "");
+            EventManager::get()->sendEvent(m_progressEvent.getPointer());
+            return ( ! m_progressEvent.isCancelled());
+        }
+        
+        EventProgressUpdate m_progressEvent;
+    };
+    
+    const AString ciftiFileName = getFileName();
+    const AString pyramidFileName = CiftiMatrixPyramid::getSidecarFileName(ciftiFileName);
+    
+    std::unique_ptr<CiftiMatrixPyramid> pyramid(new CiftiMatrixPyramid());
+    try {
+        PyramidBuildProgress progress(getFileNameNoPath());
+        if ( ! pyramid->build(m_ciftiFile,
+                              CiftiMatrixPyramid::DEFAULT_MAX_STORED_CELLS,
+                              &progress)) {
+            CaretLogInfo("Computing matrix summary for "
+                         + getFileNameNoPath()
+                         + " was cancelled.  Create it with wb_command -cifti-matrix-pyramid to chart the matrix.");
+            return false;
+        }
+    }
+    catch (const DataFileException& dfe) {
+        CaretLogWarning("Unable to compute matrix summary for "
+                        + getFileNameNoPath()
+                        + ": "
+                        + dfe.whatString());
+        return false;
+    }
+    
+    try {
+        pyramid->writeFile(pyramidFileName,
+                           ciftiFileName);
+    }
+    catch (const DataFileException& dfe) {
+        /*
+         * Directory may not be writable, pyramid is
+         * still usable but will be computed again
+         * the next time the file is read.
+         */
+        QFile::remove(pyramidFileName);
+        CaretLogFine("Unable to save matrix summary: "
+                     + dfe.whatString());
+    }
+    
+    setMatrixPyramid(pyramid.release());
+    
+    return true;
+}
+
+/**
+ * Replace the matrix pyramid and update the statistics used
+ * for coloring its tiles.
+ *
+ * @param pyramid
+ *     The new pyramid, this file takes ownership of it.
+ */
+void
+CiftiMappableDataFile::setMatrixPyramid(CiftiMatrixPyramid* pyramid) const
+{
+    CaretAssert(pyramid);
+    
+    /*
+     * Palette coloring uses the means of the finest level
+     * kept in memory, so statistics are from that level
+     */
+    const int32_t firstStoredLevel = pyramid->getFirstStoredLevel();
+    const float* meanData = pyramid->getStoredLevelData(firstStoredLevel,
+                                                        CiftiMatrixPyramid::MEAN);
+    CaretAssert(meanData);
+    m_matrixPyramidFastStatistics.reset(new FastStatistics(meanData,
+                                                           (pyramid->getLevelRows(firstStoredLevel)
+                                                            * pyramid->getLevelColumns(firstStoredLevel))));
+    m_matrixPyramidTiles.clear();
+    m_matrixPyramid.reset(pyramid);
+}
+
+/**
+ * Get graphics primitives for adjacent tiles in a row of tiles of the
+ * matrix pyramid.  Each primitive is a textured rectangle in the
+ * coordinates used by the matrix chart (cell is 1.0 x 1.0 with the
+ * first row at the top).  Tiles are colored on first use and kept
+ * until coloring changes or until they are the least recently used
+ * when there are too many tiles.  Primitives are owned by this file
+ * and are only valid until the next call to this method.
+ *
+ * @param matrixViewMode
+ *     The matrix visualization mode (upper/lower).
+ * @param level
+ *     Level in the matrix pyramid.
+ * @param tileRow
+ *     Row of tiles.
+ * @param firstTileColumn
+ *     First tile column.
+ * @param lastTileColumn
+ *     Last tile column, inclusive.
+ * @param primitivesOut
+ *     Output containing primitive for each tile (NULL if not valid).
+ */
+void
+CiftiMappableDataFile::getMatrixPyramidTileGraphicsPrimitives(const ChartTwoMatrixTriangularViewingModeEnum::Enum matrixViewMode,
+                                                              const int32_t level,
+                                                              const int64_t tileRow,
+                                                              const int64_t firstTileColumn,
+                                                              const int64_t lastTileColumn,
+                                                              std::vector<GraphicsPrimitiveV3fT3f*>& primitivesOut) const
+{
+    primitivesOut.clear();
+    if (lastTileColumn < firstTileColumn) {
+        return;
+    }
+    primitivesOut.resize(lastTileColumn - firstTileColumn + 1, NULL);
+    
+    const CiftiMatrixPyramid* pyramid = getMatrixPyramid();
+    if (pyramid == NULL) {
+        return;
+    }
+    const PaletteColorMapping* paletteColorMapping = getMapPaletteColorMapping(0);
+    if (paletteColorMapping == NULL) {
+        return;
+    }
+    
+    ++m_matrixPyramidTileCounter;
+    
+    /*
+     * Find tiles that need to be colored and mark cached tiles as used
+     */
+    int64_t firstMissingColumn = -1;
+    int64_t lastMissingColumn  = -1;
+    for (int64_t tileColumn = firstTileColumn; tileColumn <= lastTileColumn; tileColumn++) {
+        const MatrixPyramidTileKey key(static_cast<int32_t>(matrixViewMode), level, tileRow, tileColumn);
+        auto iter = m_matrixPyramidTiles.find(key);
+        if (iter != m_matrixPyramidTiles.end()) {
+            iter->second.m_lastUsedCounter = m_matrixPyramidTileCounter;
+            primitivesOut[tileColumn - firstTileColumn] = iter->second.m_primitive.get();
+        }
+        else {
+            if (firstMissingColumn < 0) {
+                firstMissingColumn = tileColumn;
+            }
+            lastMissingColumn = tileColumn;
+        }
+    }
+    
+    if (firstMissingColumn >= 0) {
+        const int64_t tileSize = CiftiMatrixPyramid::TILE_SIZE;
+        const int64_t tileNumberOfValues = tileSize * tileSize;
+        const int64_t numberOfMissingColumns = lastMissingColumn - firstMissingColumn + 1;
+        
+        /*
+         * All missing tiles are in one band of rows, so level zero
+         * is read from the file once
+         */
+        std::vector<float> tileData(numberOfMissingColumns * tileNumberOfValues);
+        pyramid->getTiles(&tileData[0],
+                          level,
+                          CiftiMatrixPyramid::MEAN,
+                          tileRow,
+                          firstMissingColumn,
+                          numberOfMissingColumns);
+        
+        const int64_t numberOfRows    = pyramid->getNumberOfRows();
+        const int64_t numberOfColumns = pyramid->getNumberOfColumns();
+        const int64_t blockSize = (static_cast<int64_t>(1) << level);
+        const float tileCellSize = static_cast<float>(tileSize * blockSize);
+        const bool squareMatrixFlag = (numberOfRows == numberOfColumns);
+        
+        std::vector<uint8_t> tileRGBA(tileNumberOfValues * 4);
+        for (int64_t tileColumn = firstMissingColumn; tileColumn <= lastMissingColumn; tileColumn++) {
+            const MatrixPyramidTileKey key(static_cast<int32_t>(matrixViewMode), level, tileRow, tileColumn);
+            if (m_matrixPyramidTiles.find(key) != m_matrixPyramidTiles.end()) {
+                continue;
+            }
+            
+            const float* data = &tileData[(tileColumn - firstMissingColumn) * tileNumberOfValues];
+            NodeAndVoxelColoring::colorScalarsWithPalette(m_matrixPyramidFastStatistics.get(),
+                                                          paletteColorMapping,
+                                                          data,
+                                                          paletteColorMapping,
+                                                          data,
+                                                          tileNumberOfValues,
+                                                          &tileRGBA[0]);
+            
+            /*
+             * Blocks entirely outside of the triangular view are not drawn.
+             * Blocks that cross the diagonal are drawn using all of their cells.
+             * Diagonals for non-square matrices not allowed.
+             */
+            if (squareMatrixFlag
+                && (matrixViewMode != ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_FULL)) {
+                for (int64_t i = 0; i < tileSize; i++) {
+                    const int64_t firstRow = (tileRow * tileSize + i) * blockSize;
+                    const int64_t lastRow  = firstRow + blockSize - 1;
+                    for (int64_t j = 0; j < tileSize; j++) {
+                        const int64_t firstColumn = (tileColumn * tileSize + j) * blockSize;
+                        const int64_t lastColumn  = firstColumn + blockSize - 1;
+                        bool drawBlockFlag = true;
+                        switch (matrixViewMode) {
+                            case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_FULL:
+                                break;
+                            case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_FULL_NO_DIAGONAL:
+                                drawBlockFlag = ((blockSize > 1) || (firstRow != firstColumn));
+                                break;
+                            case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_LOWER_NO_DIAGONAL:
+                                drawBlockFlag = (lastRow > firstColumn);
+                                break;
+                            case ChartTwoMatrixTriangularViewingModeEnum::MATRIX_VIEW_UPPER_NO_DIAGONAL:
+                                drawBlockFlag = (firstRow < lastColumn);
+                                break;
+                        }
+                        if ( ! drawBlockFlag) {
+                            tileRGBA[(i * tileSize + j) * 4 + 3] = 0;
+                        }
+                    }
+                }
+            }
+            
+            /*
+             * Texture row zero is the first row of the tile, which is at the top
+             * Order of vertices is Top Left, Bottom Left, Top Right, Bottom Right
+             */
+            GraphicsPrimitiveV3fT3f* primitive = GraphicsPrimitive::newPrimitiveV3fT3f(GraphicsPrimitive::PrimitiveType::OPENGL_TRIANGLE_STRIP,
+                                                                                       &tileRGBA[0],
+                                                                                       tileSize,
+                                                                                       tileSize);
+            primitive->setTextureFilteringType(GraphicsPrimitive::TextureFilteringType::NEAREST);
+            const float minX = tileColumn * tileCellSize;
+            const float maxX = minX + tileCellSize;
+            const float maxY = numberOfRows - tileRow * tileCellSize;
+            const float minY = maxY - tileCellSize;
+            primitive->addVertex(minX, maxY, 0, 0);  /* Top Left */
+            primitive->addVertex(minX, minY, 0, 1);  /* Bottom Left */
+            primitive->addVertex(maxX, maxY, 1, 0);  /* Top Right */
+            primitive->addVertex(maxX, minY, 1, 1);  /* Bottom Right */
+            
+            MatrixPyramidTile& tile = m_matrixPyramidTiles[key];
+            tile.m_primitive.reset(primitive);
+            tile.m_lastUsedCounter = m_matrixPyramidTileCounter;
+            primitivesOut[tileColumn - firstTileColumn] = primitive;
+        }
+        
+        /*
+         * Remove least recently used tiles, but never those returned by this call
+         */
+        const int32_t numberOfTiles = static_cast<int32_t>(m_matrixPyramidTiles.size());
+        if (numberOfTiles > s_matrixPyramidMaximumNumberOfTiles) {
+            std::vector<int64_t> lastUsedCounters;
+            lastUsedCounters.reserve(numberOfTiles);
+            for (const auto& keyAndTile : m_matrixPyramidTiles) {
+                lastUsedCounters.push_back(keyAndTile.second.m_lastUsedCounter);
+            }
+            const int32_t numberToRemove = numberOfTiles - s_matrixPyramidMaximumNumberOfTiles;
+            std::nth_element(lastUsedCounters.begin(),
+                             lastUsedCounters.begin() + (numberToRemove - 1),
+                             lastUsedCounters.end());
+            const int64_t removeCounter = std::min(lastUsedCounters[numberToRemove - 1],
+                                                   m_matrixPyramidTileCounter - 1);
+            auto iter = m_matrixPyramidTiles.begin();
+            while (iter != m_matrixPyramidTiles.end()) {
+                if (iter->second.m_lastUsedCounter <= removeCounter) {
+                    iter = m_matrixPyramidTiles.erase(iter);
+                }
+                else {
+                    ++iter;
+                }
+            }
+        }
+    }
+}
+
 /**
  * Get the matrix RGBA coloring for this matrix data creator.
  *
@@ -2541,6 +2981,7 @@ CiftiMappableDataFile::updateScalarColoringForMap(const int32_t mapIndex)
     invalidateHistogramChartColoring();
     m_matrixGraphicsPrimitive.reset();
     m_matrixGraphicsOutlinePrimitive.reset();
+    m_matrixPyramidTiles.clear();
 }
 
 /**
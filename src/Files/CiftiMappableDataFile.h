@@ -31,18 +31,22 @@
 #include "EventListenerInterface.h"
 #include "VolumeMappableInterface.h"
 
+#include <map>
 #include <memory>
 #include <set>
+#include <tuple>
 
 namespace caret {
     
     class ChartData;
     class ChartDataCartesian;
     class CiftiFile;
+    class CiftiMatrixPyramid;
     class CiftiParcelsMap;
     class CiftiXML;
     class FastStatistics;
     class GraphicsPrimitiveV3fC4f;
+    class GraphicsPrimitiveV3fT3f;
     class GroupAndNameHierarchyModel;
     class Histogram;
     class SparseVolumeIndexer;
@@ -498,6 +502,21 @@ namespace caret {
         /** Identifier for the matrix primitives alternative color used for the grid coloring */
         int32_t getMatrixChartGraphicsPrimitiveGridColorIdentifier() const { return 1; }
         
+        bool isMatrixChartingWithPyramid() const;
+        
+        const CiftiMatrixPyramid* getMatrixPyramid() const;
+        
+        bool isMatrixPyramidBuildRequested() const;
+        
+        bool buildMatrixPyramid();
+        
+        void getMatrixPyramidTileGraphicsPrimitives(const ChartTwoMatrixTriangularViewingModeEnum::Enum matrixViewMode,
+                                                    const int32_t level,
+                                                    const int64_t tileRow,
+                                                    const int64_t firstTileColumn,
+                                                    const int64_t lastTileColumn,
+                                                    std::vector<GraphicsPrimitiveV3fT3f*>& primitivesOut) const;
+        
         virtual void getFileData(std::vector<float>& data) const;
         
         const CiftiFile* getCiftiFile() const { return m_ciftiFile; }
@@ -764,6 +783,39 @@ namespace caret {
         
         mutable uint8_t m_previousMatrixGridRGBA[4] = { 0, 1, 2, 3 };
         
+        /** Min/max/mean summary of a matrix too large to draw cell by cell, lazily created */
+        mutable std::unique_ptr<CiftiMatrixPyramid> m_matrixPyramid;
+        
+        /** Statistics of the matrix pyramid for coloring its tiles */
+        mutable std::unique_ptr<FastStatistics> m_matrixPyramidFastStatistics;
+        
+        /** Controls lazy initialization of m_matrixPyramid */
+        mutable bool m_matrixPyramidCachedFlag = false;
+        
+        /** Drawing needed m_matrixPyramid and there is no valid sidecar, so it must be built outside of drawing */
+        mutable bool m_matrixPyramidBuildRequestedFlag = false;
+        
+        /** A colored tile of the matrix pyramid */
+        struct MatrixPyramidTile {
+            std::unique_ptr<GraphicsPrimitiveV3fT3f> m_primitive;
+            int64_t m_lastUsedCounter = 0;
+        };
+        
+        /** Key is view mode, level, tile row, tile column */
+        typedef std::tuple<int32_t, int32_t, int64_t, int64_t> MatrixPyramidTileKey;
+        
+        /** Colored tiles of the matrix pyramid, least recently used tiles are removed when there are too many */
+        mutable std::map<MatrixPyramidTileKey, MatrixPyramidTile> m_matrixPyramidTiles;
+        
+        /** Incremented for each request of tiles */
+        mutable int64_t m_matrixPyramidTileCounter = 0;
+        
+        /** Matrix charts with more cells than this use the matrix pyramid */
+        static const int64_t s_matrixPyramidMinimumNumberOfCells;
+        
+        /** Number of colored tiles kept before least recently used tiles are removed */
+        static const int32_t s_matrixPyramidMaximumNumberOfTiles;
+        
         int32_t m_fileHistogramNumberOfBuckets = 100;
         
         /** Histogram with limited values used when statistics computed on all data in file */
@@ -798,6 +850,8 @@ namespace caret {
         friend class ChartableTwoFileDelegate;
         friend class ChartableTwoFileMatrixChart;
         
+        void setMatrixPyramid(CiftiMatrixPyramid* pyramid) const;
+        
         /** Is lazily initialized and caches CiftiBrainModelsMap for comparison with other CIFTI files */
         mutable std::unique_ptr<CiftiBrainModelsMap> m_brainordinateMapping;
         
@@ -810,6 +864,8 @@ namespace caret {
     
 #ifdef __CIFTI_MAPPABLE_DATA_FILE_DECLARE__
     const int32_t CiftiMappableDataFile::S_CIFTI_XML_ALONG_INVALID = -1;
+    const int64_t CiftiMappableDataFile::s_matrixPyramidMinimumNumberOfCells = 2048 * 2048;
+    const int32_t CiftiMappableDataFile::s_matrixPyramidMaximumNumberOfTiles = 256;
 #endif // __CIFTI_MAPPABLE_DATA_FILE_DECLARE__
     
 } // namespace
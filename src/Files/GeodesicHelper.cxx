@@ -23,10 +23,12 @@
 #include "CaretAssert.h"
 #include "CaretHeap.h"
 #include "CaretMutex.h"
+#include "CaretOMP.h"
 #include "FastStatistics.h"
 #include "SurfaceFile.h"
 #include "TopologyHelper.h"
 
+#include <algorithm>
 #include <cmath>
 #include <stdint.h>
 
@@ -423,12 +425,12 @@ void GeodesicHelper::getGeoFromNode(const int32_t node, std::vector<float>& valu
     parent = tempi;
 }
 
-void GeodesicHelper::dijkstra(const int32_t root, const std::vector<int32_t>& interested, bool smooth)
+void GeodesicHelper::dijkstra(const int32_t root, const int32_t* interested, const int32_t numInterested, bool smooth)
 {
     int32_t i, j, whichnode, whichneigh, numNeigh, numChanged = 0, remain = 0;
     const int32_t* neighbors;
     float tempf;
-    j = interested.size();
+    j = numInterested;
     for (i = 0; i < j; ++i)
     {
         whichnode = interested[i];
@@ -1015,6 +1017,11 @@ void GeodesicHelper::aStarData(const int32_t& root, const int32_t& endpoint, con
 }
 
 void GeodesicHelper::getGeoToTheseNodes(const int32_t root, const std::vector<int32_t>& ofInterest, std::vector<float>& distsOut, bool smoothflag)
+{
+    getGeoToTheseNodes(root, (ofInterest.empty() ? NULL : &(ofInterest[0])), (int32_t)ofInterest.size(), distsOut, smoothflag);
+}
+
+void GeodesicHelper::getGeoToTheseNodes(const int32_t root, const int32_t* ofInterest, const int32_t numInterest, std::vector<float>& distsOut, bool smoothflag)
 {
     CaretAssert(root >= 0 && root < numNodes);
     if (root < 0 || root >= numNodes)
@@ -1022,7 +1029,7 @@ void GeodesicHelper::getGeoToTheseNodes(const int32_t root, const std::vector<in
         distsOut.clear();//empty array is error condition
         return;
     }
-    int32_t i, mysize = ofInterest.size(), node;
+    int32_t i, mysize = numInterest, node;
     for (i = 0; i < mysize; ++i)
     {//needs to do a linear scan of this array later anyway, so lets sanity check it
         node = ofInterest[i];
@@ -1033,7 +1040,7 @@ void GeodesicHelper::getGeoToTheseNodes(const int32_t root, const std::vector<in
         }
     }
     CaretMutexLocker locked(&inUse);//let sanity checks fail without locking
-    dijkstra(root, ofInterest, smoothflag);
+    dijkstra(root, ofInterest, mysize, smoothflag);
     distsOut.resize(mysize);
     for (i = 0; i < mysize; ++i)
     {
@@ -1286,3 +1293,77 @@ int32_t GeodesicHelper::getClosestNodeInRoi(const int32_t& root, const char* roi
     }
     return ret;
 }
+
+namespace
+{
+    class GeodesicSparseCollector : public GeodesicBatchCallback
+    {
+    public:
+        vector<vector<int32_t> > m_nodes;
+        vector<vector<float> > m_dists;
+        GeodesicSparseCollector(const int64_t& numRoots) : m_nodes(numRoots), m_dists(numRoots) { }
+        void processRoot(const int64_t& rootIndex, const int32_t* nodes, const float* dists, const int64_t& count)
+        {//each root has its own vectors, so no locking needed
+            m_nodes[rootIndex].assign(nodes, nodes + count);
+            m_dists[rootIndex].assign(dists, dists + count);
+        }
+    };
+}
+
+void GeodesicHelper::getNodesToGeoDistBatch(const vector<int32_t>& roots, const float maxdist, GeodesicBatchCallback* callback, const bool smoothflag) const
+{
+    CaretAssert(callback != NULL);
+    const int64_t numRoots = (int64_t)roots.size();
+#pragma omp CARET_PAR
+    {
+        GeodesicHelper threadHelper(m_myBase);//the base is never modified, so threads only need their own heap and mark arrays
+        vector<int32_t> nodes;
+        vector<float> dists;
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int64_t i = 0; i < numRoots; ++i)
+        {
+            threadHelper.getNodesToGeoDist(roots[i], maxdist, nodes, dists, smoothflag);
+            callback->processRoot(i, nodes.data(), dists.data(), (int64_t)nodes.size());
+        }
+    }
+}
+
+void GeodesicHelper::getNodesToGeoDistBatch(const vector<int32_t>& roots, const float maxdist, vector<int64_t>& offsetsOut,
+                                            vector<int32_t>& nodesOut, vector<float>& distsOut, const bool smoothflag) const
+{
+    const int64_t numRoots = (int64_t)roots.size();
+    GeodesicSparseCollector collector(numRoots);
+    getNodesToGeoDistBatch(roots, maxdist, &collector, smoothflag);
+    offsetsOut.resize(numRoots + 1);
+    offsetsOut[0] = 0;
+    for (int64_t i = 0; i < numRoots; ++i)
+    {
+        offsetsOut[i + 1] = offsetsOut[i] + (int64_t)collector.m_nodes[i].size();
+    }
+    nodesOut.resize(offsetsOut[numRoots]);
+    distsOut.resize(offsetsOut[numRoots]);
+    for (int64_t i = 0; i < numRoots; ++i)
+    {
+        copy(collector.m_nodes[i].begin(), collector.m_nodes[i].end(), nodesOut.begin() + offsetsOut[i]);
+        copy(collector.m_dists[i].begin(), collector.m_dists[i].end(), distsOut.begin() + offsetsOut[i]);
+        vector<int32_t>().swap(collector.m_nodes[i]);//free as we go, to keep peak memory down
+        vector<float>().swap(collector.m_dists[i]);
+    }
+}
+
+void GeodesicHelper::getGeoFromNodeBatch(const vector<int32_t>& roots, GeodesicBatchCallback* callback, const bool smoothflag) const
+{
+    CaretAssert(callback != NULL);
+    const int64_t numRoots = (int64_t)roots.size();
+#pragma omp CARET_PAR
+    {
+        GeodesicHelper threadHelper(m_myBase);
+        vector<float> dists(numNodes);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int64_t i = 0; i < numRoots; ++i)
+        {
+            threadHelper.getGeoFromNode(roots[i], dists.data(), smoothflag);
+            callback->processRoot(i, NULL, dists.data(), numNodes);
+        }
+    }
+}
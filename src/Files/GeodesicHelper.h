@@ -61,6 +61,16 @@ namespace caret {
         friend class GeodesicHelper;//let it grab the private variables it needs
     };
 
+    ///receives results from the GeodesicHelper batch functions
+    class GeodesicBatchCallback
+    {
+    public:
+        ///called from multiple threads at once, in no particular order, must not throw, and the arrays are only valid during the call
+        ///rootIndex is the position in the list of roots, nodes is NULL when dists contains every node on the surface
+        virtual void processRoot(const int64_t& rootIndex, const int32_t* nodes, const float* dists, const int64_t& count) = 0;
+        virtual ~GeodesicBatchCallback() { }
+    };
+
     class GeodesicHelper
     {
         CaretPointer<const GeodesicHelperBase> m_myBase;//mostly just for automatic memory management
@@ -84,7 +94,7 @@ namespace caret {
         GeodesicHelper(const GeodesicHelper&);//can't use copy constructor
         void dijkstra(const int32_t root, const float maxdist, std::vector<int32_t>& nodes, std::vector<float>& dists, bool smooth);//geodesic distance restricted
         void dijkstra(const int32_t root, bool smooth);//full surface
-        void dijkstra(const int32_t root, const std::vector<int32_t>& interested, bool smooth);//partial surface
+        void dijkstra(const int32_t root, const int32_t* interested, const int32_t numInterested, bool smooth);//partial surface
         int32_t dijkstra(const std::vector<int32_t>& startList, const std::vector<int32_t>& endList, const float& maxDist, bool smooth);//one path that connects lists
         int32_t closest(const int32_t& root, const char* roi, const float& maxdist, float& distOut, bool smooth);//just closest node
         int32_t closest(const int32_t& root, const char* roi, bool smooth);//just closest node
@@ -116,6 +126,9 @@ namespace caret {
         /// Get distances to a restricted set of nodes - output vector is in the SAME ORDER and same size as the input vector ofInterest
         void getGeoToTheseNodes(const int32_t root, const std::vector<int32_t>& ofInterest, std::vector<float>& distsOut, bool smoothflag = true);
         
+        /// Same as above, for a list that isn't in a vector (like a TopologyHelper neighbor span), so callers don't need to copy it
+        void getGeoToTheseNodes(const int32_t root, const int32_t* ofInterest, const int32_t numInterest, std::vector<float>& distsOut, bool smoothflag = true);
+        
         ///get the distances and nodes along the path to a node - NOTE: default is not smooth distances, so that all nodes in the path are connected in the surface
         void getPathToNode(const int32_t root, const int32_t endpoint, std::vector<int32_t>& pathNodesOut, std::vector<float>& pathDistsOut, bool smoothflag = false);
         
@@ -135,6 +148,16 @@ namespace caret {
         ///get just the closest node in the region and max distance given, returns -1 if no such node found - roi value of 0 means not in region, anything else is in region
         int32_t getClosestNodeInRoi(const int32_t& root, const char* roi, const float& maxdist, float& distOut, bool smoothflag = true);
         int32_t getClosestNodeInRoi(const int32_t& root, const char* roi, std::vector<int32_t>& pathNodesOut, std::vector<float>& pathDistsOut, bool smoothflag);
+        
+        ///distance limited geodesic from many roots, in parallel, using a private helper on the same base for each thread (doesn't lock this helper)
+        void getNodesToGeoDistBatch(const std::vector<int32_t>& roots, const float maxdist, GeodesicBatchCallback* callback, const bool smoothflag = true) const;
+        
+        ///same, but collected as sparse rows: root i has nodes and distances from offsetsOut[i] to offsetsOut[i + 1]
+        void getNodesToGeoDistBatch(const std::vector<int32_t>& roots, const float maxdist, std::vector<int64_t>& offsetsOut,
+                                    std::vector<int32_t>& nodesOut, std::vector<float>& distsOut, const bool smoothflag = true) const;
+        
+        ///distances to the entire surface from many roots, in parallel, callback is given nodes == NULL and count == number of nodes
+        void getGeoFromNodeBatch(const std::vector<int32_t>& roots, GeodesicBatchCallback* callback, const bool smoothflag = true) const;
     };
 
 } //namespace caret
@@ -21,17 +21,44 @@
 #include "MetricSmoothingObject.h"
 
 #include "CaretAssert.h"
+#include "CaretBinaryFile.h"
 #include "CaretException.h"
+#include "CaretLogger.h"
 #include "SurfaceFile.h"
 #include "MetricFile.h"
 #include "GeodesicHelper.h"
 #include "TopologyHelper.h"
 #include "CaretOMP.h"
+
+#include <QDir>
+#include <QFile>
+
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 using namespace std;
 using namespace caret;
 
+AString MetricSmoothingObject::s_weightCacheDirectory;
+const int MetricSmoothingObject::COLUMN_BLOCK_SIZE = 16;
+
+namespace
+{
+    const char WEIGHT_CACHE_MAGIC[8] = { 'w', 'b', 's', 'm', 'o', 'o', 't', 'h' };
+    const int32_t WEIGHT_CACHE_VERSION = 1;//change this if the weight computation changes, so old cache files aren't used
+    
+    void hashBytes(uint64_t& hash, const void* data, const int64_t& count)
+    {//64 bit FNV-1a, this only needs to avoid accidental collisions
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (int64_t i = 0; i < count; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+}
+
 MetricSmoothingObject::MetricSmoothingObject(const SurfaceFile* mySurf, const float& kernel, const MetricFile* myRoi, Method myMethod, const float* nodeAreas)
 {
     CaretAssert(mySurf != NULL);
@@ -39,14 +66,28 @@ MetricSmoothingObject::MetricSmoothingObject(const SurfaceFile* mySurf, const fl
     {
         throw CaretException("roi number of nodes doesn't match the surface");
     }
+    AString cacheFileName;
+    if (!s_weightCacheDirectory.isEmpty())
+    {
+        cacheFileName = getCacheFileName(mySurf, kernel, myRoi, myMethod, nodeAreas);
+        if (readWeightCache(cacheFileName, mySurf->getNumberOfNodes()))
+        {
+            CaretLogFine("loaded smoothing weights from " + cacheFileName);
+            return;
+        }
+    }
     precomputeWeights(mySurf, kernel, myRoi, myMethod, nodeAreas);
+    if (!cacheFileName.isEmpty())
+    {
+        writeWeightCache(cacheFileName);
+    }
 }
 
 void MetricSmoothingObject::smoothColumn(const MetricFile* metricIn, const int& whichColumn, MetricFile* columnOut, const MetricFile* roi, const bool& fixZeros) const
 {
     CaretAssert(metricIn != NULL);
     CaretAssert(columnOut != NULL);
-    if (metricIn->getNumberOfNodes() != (int32_t)m_weightLists.size())
+    if (metricIn->getNumberOfNodes() != getNumberOfNodes())
     {
         throw CaretException("metric does not match surface number of nodes");
     }
@@ -54,14 +95,14 @@ void MetricSmoothingObject::smoothColumn(const MetricFile* metricIn, const int&
     {
         throw CaretException("invalid column number");
     }
-    if (columnOut->getNumberOfNodes() != (int32_t)m_weightLists.size() || columnOut->getNumberOfColumns() != 1)
+    if (columnOut->getNumberOfNodes() != getNumberOfNodes() || columnOut->getNumberOfColumns() != 1)
     {
-        columnOut->setNumberOfNodesAndColumns(m_weightLists.size(), 1);
+        columnOut->setNumberOfNodesAndColumns(getNumberOfNodes(), 1);
     }
     vector<float> scratch(metricIn->getNumberOfNodes());
     if (roi != NULL)
     {
-        if (roi->getNumberOfNodes() != (int32_t)m_weightLists.size())
+        if (roi->getNumberOfNodes() != getNumberOfNodes())
         {
             throw CaretException("roi does not match surface number of nodes");
         }
@@ -75,15 +116,15 @@ void MetricSmoothingObject::smoothColumn(const MetricFile* metricIn, const int&
 {
     CaretAssert(metricIn != NULL);
     CaretAssert(metricOut != NULL);
-    if (metricIn->getNumberOfNodes() != (int32_t)m_weightLists.size())
+    if (metricIn->getNumberOfNodes() != getNumberOfNodes())
     {
         throw CaretException("metric does not match surface number of nodes");
     }
-    if (metricOut->getNumberOfNodes() != (int32_t)m_weightLists.size())
+    if (metricOut->getNumberOfNodes() != getNumberOfNodes())
     {
         throw CaretException("output metric does not match surface number of nodes");
     }
-    if (roi != NULL && (roi->getNumberOfNodes() != (int32_t)m_weightLists.size()))
+    if (roi != NULL && (roi->getNumberOfNodes() != getNumberOfNodes()))
     {
         throw CaretException("roi does not match surface number of nodes");
     }
@@ -113,29 +154,117 @@ void MetricSmoothingObject::smoothMetric(const MetricFile* metricIn, MetricFile*
     CaretAssert(metricIn != NULL);
     CaretAssert(metricOut != NULL);
     int32_t numCols = metricIn->getNumberOfColumns();
-    if (metricIn->getNumberOfNodes() != (int32_t)m_weightLists.size())
+    int32_t numNodes = getNumberOfNodes();
+    if (metricIn->getNumberOfNodes() != numNodes)
     {
         throw CaretException("metric does not match surface number of nodes");
     }
-    if (metricOut->getNumberOfNodes() != (int32_t)m_weightLists.size() || metricOut->getNumberOfColumns() != numCols)
+    if (metricOut->getNumberOfNodes() != numNodes || metricOut->getNumberOfColumns() != numCols)
     {
-        metricOut->setNumberOfNodesAndColumns(m_weightLists.size(), numCols);
+        metricOut->setNumberOfNodesAndColumns(numNodes, numCols);
     }
-    vector<float> scratch(metricIn->getNumberOfNodes());
+    const float* roiColumn = NULL;
     if (roi != NULL)
     {
-        if (roi->getNumberOfNodes() != (int32_t)m_weightLists.size())
+        if (roi->getNumberOfNodes() != numNodes)
         {
             throw CaretException("roi does not match surface number of nodes");
         }
-        for (int32_t i = 0; i < numCols; ++i)
+        roiColumn = roi->getValuePointerForColumn(0);
+    }
+    vector<float> blockIn((int64_t)numNodes * COLUMN_BLOCK_SIZE), blockOut((int64_t)numNodes * COLUMN_BLOCK_SIZE), scratch(numNodes);
+    for (int32_t blockStart = 0; blockStart < numCols; blockStart += COLUMN_BLOCK_SIZE)
+    {
+        int numBlockCols = min(COLUMN_BLOCK_SIZE, numCols - blockStart);
+        for (int c = 0; c < numBlockCols; ++c)
+        {//interleave the columns, so the kernel reads each neighbor's values for the whole block from one place
+            const float* inColumn = metricIn->getValuePointerForColumn(blockStart + c);
+            for (int32_t i = 0; i < numNodes; ++i)
+            {
+                blockIn[(int64_t)i * numBlockCols + c] = inColumn[i];
+            }
+        }
+        smoothColumnBlock(blockIn.data(), blockOut.data(), numBlockCols, roiColumn, fixZeros);
+        for (int c = 0; c < numBlockCols; ++c)
         {
-            smoothColumnInternal(scratch.data(), metricIn, i, metricOut, i, roi, 0, fixZeros);
+            for (int32_t i = 0; i < numNodes; ++i)
+            {
+                scratch[i] = blockOut[(int64_t)i * numBlockCols + c];
+            }
+            metricOut->setValuesForColumn(blockStart + c, scratch.data());
         }
-    } else {
-        for (int32_t i = 0; i < numCols; ++i)
+    }
+}
+
+void MetricSmoothingObject::smoothColumnBlock(const float* blockIn, float* blockOut, const int& numBlockCols, const float* roiColumn, const bool& fixZeros) const
+{//does the same operations in the same order as smoothColumnInternal for each column, so the results are identical
+    int32_t numNodes = getNumberOfNodes();
+#pragma omp CARET_PAR
+    {
+        vector<float> sums(numBlockCols), weightSums(numBlockCols);
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int32_t i = 0; i < numNodes; ++i)
         {
-            smoothColumnInternal(scratch.data(), metricIn, i, metricOut, i, fixZeros);
+            float* outValues = blockOut + (int64_t)i * numBlockCols;
+            if ((roiColumn != NULL && !(roiColumn[i] > 0.0f)) || m_weightSums[i] == 0.0f)
+            {
+                for (int c = 0; c < numBlockCols; ++c) outValues[c] = 0.0f;
+                continue;
+            }
+            for (int c = 0; c < numBlockCols; ++c)
+            {
+                sums[c] = 0.0f;
+                weightSums[c] = 0.0f;
+            }
+            float weightSum = 0.0f;//for when it doesn't depend on the column
+            int64_t rowEnd = m_rowStart[i + 1];
+            for (int64_t j = m_rowStart[i]; j < rowEnd; ++j)
+            {
+                int32_t neighbor = m_neighbors[j];
+                if (roiColumn != NULL && !(roiColumn[neighbor] > 0.0f)) continue;
+                float weight = m_weights[j];
+                const float* inValues = blockIn + (int64_t)neighbor * numBlockCols;
+                if (fixZeros)
+                {
+                    for (int c = 0; c < numBlockCols; ++c)
+                    {
+                        if (inValues[c] != 0.0f)
+                        {
+                            sums[c] += weight * inValues[c];
+                            weightSums[c] += weight;
+                        }
+                    }
+                } else {
+                    for (int c = 0; c < numBlockCols; ++c)
+                    {
+                        sums[c] += weight * inValues[c];
+                    }
+                    weightSum += weight;
+                }
+            }
+            if (fixZeros)
+            {
+                for (int c = 0; c < numBlockCols; ++c)
+                {
+                    if (weightSums[c] != 0.0f)
+                    {
+                        outValues[c] = sums[c] / weightSums[c];
+                    } else {
+                        outValues[c] = 0.0f;
+                    }
+                }
+            } else {
+                if (roiColumn == NULL) weightSum = m_weightSums[i];//without an roi, the precomputed sum is what the single column version uses
+                for (int c = 0; c < numBlockCols; ++c)
+                {
+                    if (weightSum != 0.0f)
+                    {
+                        outValues[c] = sums[c] / weightSum;
+                    } else {
+                        outValues[c] = 0.0f;
+                    }
+                }
+            }
         }
     }
 }
@@ -154,17 +283,16 @@ void MetricSmoothingObject::smoothColumnInternal(float* scratch, const MetricFil
 #pragma omp CARET_PARFOR schedule(dynamic)
         for (int32_t i = 0; i < numNodes; ++i)
         {
-            const WeightList& myWeightRef = m_weightLists[i];
-            if (myWeightRef.m_weightSum != 0.0f)//skip nodes with no neighbors quickly
+            if (m_weightSums[i] != 0.0f)//skip nodes with no neighbors quickly
             {
                 float sum = 0.0f, weightsum = 0.0f;
-                int32_t numWeights = myWeightRef.m_nodes.size();
-                for (int32_t j = 0; j < numWeights; ++j)
+                int64_t rowEnd = m_rowStart[i + 1];
+                for (int64_t j = m_rowStart[i]; j < rowEnd; ++j)
                 {
-                    float value = myColumn[myWeightRef.m_nodes[j]];
+                    float value = myColumn[m_neighbors[j]];
                     if (value != 0.0f)
                     {
-                        float weight = myWeightRef.m_weights[j];
+                        float weight = m_weights[j];
                         sum += weight * value;
                         weightsum += weight;
                     }
@@ -183,16 +311,15 @@ void MetricSmoothingObject::smoothColumnInternal(float* scratch, const MetricFil
 #pragma omp CARET_PARFOR schedule(dynamic)
         for (int32_t i = 0; i < numNodes; ++i)
         {
-            const WeightList& myWeightRef = m_weightLists[i];
-            if (myWeightRef.m_weightSum != 0.0f)
+            if (m_weightSums[i] != 0.0f)
             {
                 float sum = 0.0f;
-                int32_t numWeights = myWeightRef.m_nodes.size();
-                for (int32_t j = 0; j < numWeights; ++j)
+                int64_t rowEnd = m_rowStart[i + 1];
+                for (int64_t j = m_rowStart[i]; j < rowEnd; ++j)
                 {
-                    sum += myWeightRef.m_weights[j] * myColumn[myWeightRef.m_nodes[j]];
+                    sum += m_weights[j] * myColumn[m_neighbors[j]];
                 }
-                scratch[i] = sum / myWeightRef.m_weightSum;
+                scratch[i] = sum / m_weightSums[i];
             } else {
                 scratch[i] = 0.0f;
             }
@@ -218,18 +345,17 @@ void MetricSmoothingObject::smoothColumnInternal(float* scratch, const MetricFil
 #pragma omp CARET_PARFOR schedule(dynamic)
         for (int32_t i = 0; i < numNodes; ++i)
         {
-            const WeightList& myWeightRef = m_weightLists[i];
-            if (roiColumn[i] > 0.0f && myWeightRef.m_weightSum != 0.0f)//skip nodes with no neighbors quickly
+            if (roiColumn[i] > 0.0f && m_weightSums[i] != 0.0f)//skip nodes with no neighbors quickly
             {
                 float sum = 0.0f, weightsum = 0.0f;
-                int32_t numWeights = myWeightRef.m_nodes.size();
-                for (int32_t j = 0; j < numWeights; ++j)
+                int64_t rowEnd = m_rowStart[i + 1];
+                for (int64_t j = m_rowStart[i]; j < rowEnd; ++j)
                 {
-                    int32_t neighbor = myWeightRef.m_nodes[j];
+                    int32_t neighbor = m_neighbors[j];
                     float value = myColumn[neighbor];
                     if (roiColumn[neighbor] > 0.0f && value != 0.0f)
                     {
-                        float weight = myWeightRef.m_weights[j];
+                        float weight = m_weights[j];
                         sum += weight * value;
                         weightsum += weight;
                     }
@@ -248,17 +374,16 @@ void MetricSmoothingObject::smoothColumnInternal(float* scratch, const MetricFil
 #pragma omp CARET_PARFOR schedule(dynamic)
         for (int32_t i = 0; i < numNodes; ++i)
         {
-            const WeightList& myWeightRef = m_weightLists[i];
-            if (roiColumn[i] > 0.0f && myWeightRef.m_weightSum != 0.0f)
+            if (roiColumn[i] > 0.0f && m_weightSums[i] != 0.0f)
             {
                 float sum = 0.0f, weightsum = 0.0f;
-                int32_t numWeights = myWeightRef.m_nodes.size();
-                for (int32_t j = 0; j < numWeights; ++j)
+                int64_t rowEnd = m_rowStart[i + 1];
+                for (int64_t j = m_rowStart[i]; j < rowEnd; ++j)
                 {
-                    int32_t neighbor = myWeightRef.m_nodes[j];
+                    int32_t neighbor = m_neighbors[j];
                     if (roiColumn[neighbor] > 0.0f)
                     {
-                        float weight = myWeightRef.m_weights[j];
+                        float weight = m_weights[j];
                         sum += weight * myColumn[neighbor];
                         weightsum += weight;
                     }
@@ -277,12 +402,123 @@ void MetricSmoothingObject::smoothColumnInternal(float* scratch, const MetricFil
     metricOut->setValuesForColumn(whichOutColumn, scratch);
 }
 
-void MetricSmoothingObject::precomputeWeightsGeoGauss(const SurfaceFile* mySurf, float myKernel, const float* nodeAreas)
+AString MetricSmoothingObject::getCacheFileName(const SurfaceFile* mySurf, const float& myKernel, const MetricFile* theRoi, const Method& myMethod, const float* nodeAreas) const
+{
+    uint64_t hash = 14695981039346656037ULL;
+    int32_t numNodes = mySurf->getNumberOfNodes(), numTiles = mySurf->getNumberOfTriangles(), method = myMethod;
+    hashBytes(hash, &WEIGHT_CACHE_VERSION, sizeof(WEIGHT_CACHE_VERSION));
+    hashBytes(hash, &numNodes, sizeof(numNodes));
+    hashBytes(hash, &numTiles, sizeof(numTiles));
+    hashBytes(hash, &myKernel, sizeof(myKernel));
+    hashBytes(hash, &method, sizeof(method));
+    hashBytes(hash, mySurf->getCoordinateData(), sizeof(float) * 3 * (int64_t)numNodes);
+    for (int32_t i = 0; i < numTiles; ++i)
+    {
+        hashBytes(hash, mySurf->getTriangle(i), sizeof(int32_t) * 3);
+    }
+    unsigned char flag = (theRoi != NULL ? 1 : 0);
+    hashBytes(hash, &flag, 1);
+    if (theRoi != NULL)
+    {//only whether it is inside the roi matters
+        const float* roiColumn = theRoi->getValuePointerForColumn(0);
+        for (int32_t i = 0; i < numNodes; ++i)
+        {
+            flag = (roiColumn[i] > 0.0f ? 1 : 0);
+            hashBytes(hash, &flag, 1);
+        }
+    }
+    flag = (nodeAreas != NULL ? 1 : 0);//if NULL, areas are computed from the surface, which is already in the hash
+    hashBytes(hash, &flag, 1);
+    if (nodeAreas != NULL)
+    {
+        hashBytes(hash, nodeAreas, sizeof(float) * (int64_t)numNodes);
+    }
+    return QDir(s_weightCacheDirectory).filePath(AString::number((qulonglong)hash, 16).rightJustified(16, '0') + ".wbsmooth");
+}
+
+bool MetricSmoothingObject::readWeightCache(const AString& fileName, const int32_t& numNodes)
+{
+    if (!QFile::exists(fileName)) return false;
+    try
+    {
+        CaretBinaryFile myFile(fileName);
+        char magic[8];
+        int32_t version = -1, fileNodes = -1;
+        int64_t numEntries = -1;
+        myFile.read(magic, 8);
+        myFile.read(&version, sizeof(version));
+        myFile.read(&fileNodes, sizeof(fileNodes));
+        myFile.read(&numEntries, sizeof(numEntries));
+        if (memcmp(magic, WEIGHT_CACHE_MAGIC, 8) != 0 || version != WEIGHT_CACHE_VERSION || fileNodes != numNodes || numEntries < 0)
+        {
+            CaretLogWarning("ignoring smoothing weight cache file with wrong format: " + fileName);
+            return false;
+        }
+        m_rowStart.resize(numNodes + 1);
+        m_weightSums.resize(numNodes);
+        m_neighbors.resize(numEntries);
+        m_weights.resize(numEntries);
+        myFile.read(m_rowStart.data(), sizeof(int64_t) * m_rowStart.size());
+        myFile.read(m_weightSums.data(), sizeof(float) * m_weightSums.size());
+        myFile.read(m_neighbors.data(), sizeof(int32_t) * m_neighbors.size());
+        myFile.read(m_weights.data(), sizeof(float) * m_weights.size());
+        bool valid = (m_rowStart[0] == 0 && m_rowStart[numNodes] == numEntries);
+        for (int32_t i = 0; valid && i < numNodes; ++i)
+        {
+            if (m_rowStart[i + 1] < m_rowStart[i]) valid = false;
+        }
+        for (int64_t j = 0; valid && j < numEntries; ++j)
+        {
+            if (m_neighbors[j] < 0 || m_neighbors[j] >= numNodes) valid = false;
+        }
+        if (!valid)
+        {
+            CaretLogWarning("ignoring corrupt smoothing weight cache file: " + fileName);
+            return false;
+        }
+    } catch (CaretException& e) {
+        CaretLogWarning("failed to read smoothing weight cache file: " + e.whatString());
+        return false;
+    }
+    return true;
+}
+
+void MetricSmoothingObject::writeWeightCache(const AString& fileName) const
+{
+    AString tempName = fileName + ".partial";//rename when complete, so other processes never see a partial file
+    try
+    {
+        CaretBinaryFile myFile(tempName, CaretBinaryFile::WRITE_TRUNCATE);
+        int32_t numNodes = getNumberOfNodes();
+        int64_t numEntries = (int64_t)m_neighbors.size();
+        myFile.write(WEIGHT_CACHE_MAGIC, 8);
+        myFile.write(&WEIGHT_CACHE_VERSION, sizeof(WEIGHT_CACHE_VERSION));
+        myFile.write(&numNodes, sizeof(numNodes));
+        myFile.write(&numEntries, sizeof(numEntries));
+        myFile.write(m_rowStart.data(), sizeof(int64_t) * m_rowStart.size());
+        myFile.write(m_weightSums.data(), sizeof(float) * m_weightSums.size());
+        myFile.write(m_neighbors.data(), sizeof(int32_t) * m_neighbors.size());
+        myFile.write(m_weights.data(), sizeof(float) * m_weights.size());
+        myFile.close();
+    } catch (CaretException& e) {
+        CaretLogWarning("failed to write smoothing weight cache file: " + e.whatString());
+        QFile::remove(tempName);
+        return;
+    }
+    QFile::remove(fileName);
+    if (!QFile::rename(tempName, fileName))
+    {
+        CaretLogWarning("failed to rename smoothing weight cache file to " + fileName);
+        QFile::remove(tempName);
+    }
+}
+
+void MetricSmoothingObject::precomputeWeightsGeoGauss(vector<WeightList>& weightLists, const SurfaceFile* mySurf, float myKernel, const float* nodeAreas)
 {
     int32_t numNodes = mySurf->getNumberOfNodes();
     float myGeoDist = myKernel * 3.0f;
     float gaussianDenom = -0.5f / myKernel / myKernel;
-    m_weightLists.resize(numNodes);
+    weightLists.resize(numNodes);
     CaretPointer<GeodesicHelperBase> myGeoBase(new GeodesicHelperBase(mySurf, nodeAreas));//NOTE: if these are equal to the surface's areas, then it does some extra operations, but gets the same answer
 #pragma omp CARET_PAR
     {
@@ -292,32 +528,32 @@ void MetricSmoothingObject::precomputeWeightsGeoGauss(const SurfaceFile* mySurf,
 #pragma omp CARET_FOR schedule(dynamic)
         for (int32_t i = 0; i < numNodes; ++i)
         {
-            myGeoHelp->getNodesToGeoDist(i, myGeoDist, m_weightLists[i].m_nodes, distances, true);
+            myGeoHelp->getNodesToGeoDist(i, myGeoDist, weightLists[i].m_nodes, distances, true);
             if (distances.size() < 7)
             {
-                m_weightLists[i].m_nodes = myTopoHelp->getNodeNeighbors(i);
-                m_weightLists[i].m_nodes.push_back(i);
-                myGeoHelp->getGeoToTheseNodes(i, m_weightLists[i].m_nodes, distances, true);
+                weightLists[i].m_nodes = myTopoHelp->getNodeNeighbors(i);
+                weightLists[i].m_nodes.push_back(i);
+                myGeoHelp->getGeoToTheseNodes(i, weightLists[i].m_nodes, distances, true);
             }
             int32_t numNeigh = (int32_t)distances.size();
-            m_weightLists[i].m_weights.resize(numNeigh);
-            m_weightLists[i].m_weightSum = 0.0f;
+            weightLists[i].m_weights.resize(numNeigh);
+            weightLists[i].m_weightSum = 0.0f;
             for (int32_t j = 0; j < numNeigh; ++j)
             {
                 float weight = exp(distances[j] * distances[j] * gaussianDenom);//exp(- dist ^ 2 / (2 * sigma ^ 2))
-                m_weightLists[i].m_weights[j] = weight;
-                m_weightLists[i].m_weightSum += weight;
+                weightLists[i].m_weights[j] = weight;
+                weightLists[i].m_weightSum += weight;
             }
         }
     }
 }
 
-void MetricSmoothingObject::precomputeWeightsROIGeoGauss(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas)
+void MetricSmoothingObject::precomputeWeightsROIGeoGauss(vector<WeightList>& weightLists, const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas)
 {
     int32_t numNodes = mySurf->getNumberOfNodes();
     float myGeoDist = myKernel * 3.0f;
     float gaussianDenom = -0.5f / myKernel / myKernel;
-    m_weightLists.resize(numNodes);
+    weightLists.resize(numNodes);
     const float* myRoiColumn = theRoi->getValuePointerForColumn(0);
     CaretPointer<GeodesicHelperBase> myGeoBase(new GeodesicHelperBase(mySurf, nodeAreas));//NOTE: if these are equal to the surface's areas, then it does some extra operations, but gets the same answer
 #pragma omp CARET_PAR
@@ -339,17 +575,17 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGauss(const SurfaceFile* mySu
                     myGeoHelp->getGeoToTheseNodes(i, nodes, distances, true);
                 }
                 int32_t numNeigh = (int32_t)distances.size();
-                m_weightLists[i].m_weights.reserve(numNeigh);
-                m_weightLists[i].m_nodes.reserve(numNeigh);
-                m_weightLists[i].m_weightSum = 0.0f;
+                weightLists[i].m_weights.reserve(numNeigh);
+                weightLists[i].m_nodes.reserve(numNeigh);
+                weightLists[i].m_weightSum = 0.0f;
                 for (int32_t j = 0; j < numNeigh; ++j)
                 {
                     if (myRoiColumn[nodes[j]] > 0.0f)
                     {
                         float weight = exp(distances[j] * distances[j] * gaussianDenom);//exp(- dist ^ 2 / (2 * sigma ^ 2))
-                        m_weightLists[i].m_weights.push_back(weight);
-                        m_weightLists[i].m_nodes.push_back(nodes[j]);
-                        m_weightLists[i].m_weightSum += weight;
+                        weightLists[i].m_weights.push_back(weight);
+                        weightLists[i].m_nodes.push_back(nodes[j]);
+                        weightLists[i].m_weightSum += weight;
                     }
                 }
             }
@@ -357,7 +593,7 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGauss(const SurfaceFile* mySu
     }
 }
 
-void MetricSmoothingObject::precomputeWeightsGeoGaussArea(const SurfaceFile* mySurf, float myKernel, const float* nodeAreas)
+void MetricSmoothingObject::precomputeWeightsGeoGaussArea(vector<WeightList>& weightLists, const SurfaceFile* mySurf, float myKernel, const float* nodeAreas)
 {//this method is normalized in two ways to provide evenly diffusing smoothing with equivalent sum of areas * values as input
     int32_t numNodes = mySurf->getNumberOfNodes();
     float myGeoDist = myKernel * 3.0f;
@@ -374,7 +610,7 @@ void MetricSmoothingObject::precomputeWeightsGeoGaussArea(const SurfaceFile* myS
         for (int32_t i = 0; i < numNodes; ++i)
         {
             myGeoHelp->getNodesToGeoDist(i, myGeoDist, tempList[i].m_nodes, distances, true);
-            const vector<int32_t>& tempneighbors = myTopoHelp->getNodeNeighbors(i);
+            const TopologyIndexSpan tempneighbors = myTopoHelp->getNodeNeighbors(i);
             if (distances.size() <= tempneighbors.size())//because neighbors doesn't include center, so if they are equal, geo is missing a neighbor
             {
                 tempList[i].m_nodes = tempneighbors;
@@ -398,13 +634,13 @@ void MetricSmoothingObject::precomputeWeightsGeoGaussArea(const SurfaceFile* myS
             tempList[i].m_weightSum = nodeAreas[i];
         }
     }
-    m_weightLists.resize(numNodes);//now convert it to gathering kernels
+    weightLists.resize(numNodes);//now convert it to gathering kernels
     for (int32_t i = 0; i < numNodes; ++i)//sadly, this is VERY hard to parallelize in a manner that is efficient, since it needs random access modification
     {
-        m_weightLists[i].m_weightSum = 0.0f;//memory initialization may not go much faster in parallel
+        weightLists[i].m_weightSum = 0.0f;//memory initialization may not go much faster in parallel
         size_t neighborCount = tempList[i].m_nodes.size();
-        m_weightLists[i].m_nodes.reserve(neighborCount);//also preallocate the expected number of nodes (geodesic distance should be symmetric except for rounding errors, so it should usually be exact)
-        m_weightLists[i].m_weights.reserve(neighborCount);
+        weightLists[i].m_nodes.reserve(neighborCount);//also preallocate the expected number of nodes (geodesic distance should be symmetric except for rounding errors, so it should usually be exact)
+        weightLists[i].m_weights.reserve(neighborCount);
     }
     for (int32_t i = 0; i < numNodes; ++i)//and this needs to push onto random vectors in the weight list
     {
@@ -413,14 +649,14 @@ void MetricSmoothingObject::precomputeWeightsGeoGaussArea(const SurfaceFile* myS
         {
             int32_t node = tempList[i].m_nodes[j];
             float weight = tempList[i].m_weights[j];
-            m_weightLists[node].m_nodes.push_back(i);
-            m_weightLists[node].m_weights.push_back(weight);
-            m_weightLists[node].m_weightSum += weight;
+            weightLists[node].m_nodes.push_back(i);
+            weightLists[node].m_weights.push_back(weight);
+            weightLists[node].m_weightSum += weight;
         }
     }
 }
 
-void MetricSmoothingObject::precomputeWeightsROIGeoGaussArea(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas)
+void MetricSmoothingObject::precomputeWeightsROIGeoGaussArea(vector<WeightList>& weightLists, const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas)
 {
     int32_t numNodes = mySurf->getNumberOfNodes();
     float myGeoDist = myKernel * 3.0f;
@@ -441,7 +677,7 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGaussArea(const SurfaceFile*
             if (myRoiColumn[i] > 0.0f)//we don't need to scatter from things outside the ROI
             {
                 myGeoHelp->getNodesToGeoDist(i, myGeoDist, nodes, distances, true);
-                const vector<int32_t>& tempneighbors = myTopoHelp->getNodeNeighbors(i);
+                const TopologyIndexSpan tempneighbors = myTopoHelp->getNodeNeighbors(i);
                 if (distances.size() <= tempneighbors.size())//because neighbors doesn't include center, so if they are equal, geo is missing a neighbor
                 {
                     nodes = tempneighbors;
@@ -470,13 +706,13 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGaussArea(const SurfaceFile*
             }
         }
     }
-    m_weightLists.resize(numNodes);//now convert it to gathering kernels
+    weightLists.resize(numNodes);//now convert it to gathering kernels
     for (int32_t i = 0; i < numNodes; ++i)//sadly, this is VERY hard to parallelize in a manner that is efficient, since it needs random access modification
     {
-        m_weightLists[i].m_weightSum = 0.0f;//memory initialization may not go much faster in parallel
+        weightLists[i].m_weightSum = 0.0f;//memory initialization may not go much faster in parallel
         size_t neighborCount = tempList[i].m_nodes.size();
-        m_weightLists[i].m_nodes.reserve(neighborCount);//also preallocate the expected number of nodes, again, should be exact except for rounding errors in geodesic distance
-        m_weightLists[i].m_weights.reserve(neighborCount);
+        weightLists[i].m_nodes.reserve(neighborCount);//also preallocate the expected number of nodes, again, should be exact except for rounding errors in geodesic distance
+        weightLists[i].m_weights.reserve(neighborCount);
     }
     for (int32_t i = 0; i < numNodes; ++i)//and this needs to push onto random vectors in the weight list
     {
@@ -485,14 +721,14 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGaussArea(const SurfaceFile*
         {
             int32_t node = tempList[i].m_nodes[j];
             float weight = tempList[i].m_weights[j];
-            m_weightLists[node].m_nodes.push_back(i);
-            m_weightLists[node].m_weights.push_back(weight);
-            m_weightLists[node].m_weightSum += weight;
+            weightLists[node].m_nodes.push_back(i);
+            weightLists[node].m_weights.push_back(weight);
+            weightLists[node].m_weightSum += weight;
         }
     }
 }
 
-void MetricSmoothingObject::precomputeWeightsGeoGaussEqual(const SurfaceFile* mySurf, float myKernel, const float* nodeAreas)
+void MetricSmoothingObject::precomputeWeightsGeoGaussEqual(vector<WeightList>& weightLists, const SurfaceFile* mySurf, float myKernel, const float* nodeAreas)
 {//this method is normalized in two ways to provide evenly diffusing smoothing with equivalent sum of values as input - this special purpose smoothing is for things that should not be integrated across the surface
     int32_t numNodes = mySurf->getNumberOfNodes();
     float myGeoDist = myKernel * 3.0f;
@@ -509,7 +745,7 @@ void MetricSmoothingObject::precomputeWeightsGeoGaussEqual(const SurfaceFile* my
         for (int32_t i = 0; i < numNodes; ++i)
         {
             myGeoHelp->getNodesToGeoDist(i, myGeoDist, tempList[i].m_nodes, distances, true);
-            const vector<int32_t>& tempneighbors = myTopoHelp->getNodeNeighbors(i);
+            const TopologyIndexSpan tempneighbors = myTopoHelp->getNodeNeighbors(i);
             if (distances.size() <= tempneighbors.size())//because neighbors doesn't include center, so if they are equal, geo is missing a neighbor
             {
                 tempList[i].m_nodes = tempneighbors;
@@ -533,13 +769,13 @@ void MetricSmoothingObject::precomputeWeightsGeoGaussEqual(const SurfaceFile* my
             tempList[i].m_weightSum = 1.0f;
         }
     }
-    m_weightLists.resize(numNodes);//now convert it to gathering kernels
+    weightLists.resize(numNodes);//now convert it to gathering kernels
     for (int32_t i = 0; i < numNodes; ++i)//sadly, this is VERY hard to parallelize in a manner that is efficient, since it needs random access modification
     {
-        m_weightLists[i].m_weightSum = 0.0f;//memory initialization may not go much faster in parallel
+        weightLists[i].m_weightSum = 0.0f;//memory initialization may not go much faster in parallel
         size_t neighborCount = tempList[i].m_nodes.size();
-        m_weightLists[i].m_nodes.reserve(neighborCount);//also preallocate the expected number of nodes (geodesic distance should be symmetric except for rounding errors, so it should usually be exact)
-        m_weightLists[i].m_weights.reserve(neighborCount);
+        weightLists[i].m_nodes.reserve(neighborCount);//also preallocate the expected number of nodes (geodesic distance should be symmetric except for rounding errors, so it should usually be exact)
+        weightLists[i].m_weights.reserve(neighborCount);
     }
     for (int32_t i = 0; i < numNodes; ++i)//and this needs to push onto random vectors in the weight list
     {
@@ -548,14 +784,14 @@ void MetricSmoothingObject::precomputeWeightsGeoGaussEqual(const SurfaceFile* my
         {
             int32_t node = tempList[i].m_nodes[j];
             float weight = tempList[i].m_weights[j];
-            m_weightLists[node].m_nodes.push_back(i);
-            m_weightLists[node].m_weights.push_back(weight);
-            m_weightLists[node].m_weightSum += weight;
+            weightLists[node].m_nodes.push_back(i);
+            weightLists[node].m_weights.push_back(weight);
+            weightLists[node].m_weightSum += weight;
         }
     }
 }
 
-void MetricSmoothingObject::precomputeWeightsROIGeoGaussEqual(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas)
+void MetricSmoothingObject::precomputeWeightsROIGeoGaussEqual(vector<WeightList>& weightLists, const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas)
 {
     int32_t numNodes = mySurf->getNumberOfNodes();
     float myGeoDist = myKernel * 3.0f;
@@ -576,7 +812,7 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGaussEqual(const SurfaceFile*
             if (myRoiColumn[i] > 0.0f)//we don't need to scatter from things outside the ROI
             {
                 myGeoHelp->getNodesToGeoDist(i, myGeoDist, nodes, distances, true);
-                const vector<int32_t>& tempneighbors = myTopoHelp->getNodeNeighbors(i);
+                const TopologyIndexSpan tempneighbors = myTopoHelp->getNodeNeighbors(i);
                 if (distances.size() <= tempneighbors.size())//because neighbors doesn't include center, so if they are equal, geo is missing a neighbor
                 {
                     nodes = tempneighbors;
@@ -605,13 +841,13 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGaussEqual(const SurfaceFile*
             }
         }
     }
-    m_weightLists.resize(numNodes);//now convert it to gathering kernels
+    weightLists.resize(numNodes);//now convert it to gathering kernels
     for (int32_t i = 0; i < numNodes; ++i)//sadly, this is VERY hard to parallelize in a manner that is efficient, since it needs random access modification
     {
-        m_weightLists[i].m_weightSum = 0.0f;//memory initialization may not go much faster in parallel
+        weightLists[i].m_weightSum = 0.0f;//memory initialization may not go much faster in parallel
         size_t neighborCount = tempList[i].m_nodes.size();
-        m_weightLists[i].m_nodes.reserve(neighborCount);//also preallocate the expected number of nodes, again, should be exact except for rounding errors in geodesic distance
-        m_weightLists[i].m_weights.reserve(neighborCount);
+        weightLists[i].m_nodes.reserve(neighborCount);//also preallocate the expected number of nodes, again, should be exact except for rounding errors in geodesic distance
+        weightLists[i].m_weights.reserve(neighborCount);
     }
     for (int32_t i = 0; i < numNodes; ++i)//and this needs to push onto random vectors in the weight list
     {
@@ -620,9 +856,9 @@ void MetricSmoothingObject::precomputeWeightsROIGeoGaussEqual(const SurfaceFile*
         {
             int32_t node = tempList[i].m_nodes[j];
             float weight = tempList[i].m_weights[j];
-            m_weightLists[node].m_nodes.push_back(i);
-            m_weightLists[node].m_weights.push_back(weight);
-            m_weightLists[node].m_weightSum += weight;
+            weightLists[node].m_nodes.push_back(i);
+            weightLists[node].m_weights.push_back(weight);
+            weightLists[node].m_weightSum += weight;
         }
     }
 }
@@ -636,18 +872,19 @@ void MetricSmoothingObject::precomputeWeights(const SurfaceFile* mySurf, float m
         mySurf->computeNodeAreas(areasTemp);
         passAreas = areasTemp.data();
     }
+    vector<WeightList> weightLists;
     if (theRoi != NULL)
     {
         switch (myMethod)
         {
             case GEO_GAUSS_AREA:
-                precomputeWeightsROIGeoGaussArea(mySurf, myKernel, theRoi, passAreas);
+                precomputeWeightsROIGeoGaussArea(weightLists, mySurf, myKernel, theRoi, passAreas);
                 break;
             case GEO_GAUSS_EQUAL:
-                precomputeWeightsROIGeoGaussEqual(mySurf, myKernel, theRoi, passAreas);
+                precomputeWeightsROIGeoGaussEqual(weightLists, mySurf, myKernel, theRoi, passAreas);
                 break;
             case GEO_GAUSS:
-                precomputeWeightsROIGeoGauss(mySurf, myKernel, theRoi, passAreas);
+                precomputeWeightsROIGeoGauss(weightLists, mySurf, myKernel, theRoi, passAreas);
                 break;
             default:
                 throw CaretException("unknown smoothing method specified");
@@ -656,16 +893,38 @@ void MetricSmoothingObject::precomputeWeights(const SurfaceFile* mySurf, float m
         switch (myMethod)
         {
             case GEO_GAUSS_AREA:
-                precomputeWeightsGeoGaussArea(mySurf, myKernel, passAreas);
+                precomputeWeightsGeoGaussArea(weightLists, mySurf, myKernel, passAreas);
                 break;
             case GEO_GAUSS_EQUAL:
-                precomputeWeightsGeoGaussEqual(mySurf, myKernel, passAreas);
+                precomputeWeightsGeoGaussEqual(weightLists, mySurf, myKernel, passAreas);
                 break;
             case GEO_GAUSS:
-                precomputeWeightsGeoGauss(mySurf, myKernel, passAreas);
+                precomputeWeightsGeoGauss(weightLists, mySurf, myKernel, passAreas);
                 break;
             default:
                 throw CaretException("unknown smoothing method specified");
         };
     }
+    int32_t numNodes = (int32_t)weightLists.size();//now convert to CSR, so that applying it streams through contiguous memory
+    m_rowStart.resize(numNodes + 1);
+    m_weightSums.resize(numNodes);
+    m_rowStart[0] = 0;
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        m_rowStart[i + 1] = m_rowStart[i] + (int64_t)weightLists[i].m_nodes.size();
+        m_weightSums[i] = weightLists[i].m_weightSum;
+    }
+    m_neighbors.resize(m_rowStart[numNodes]);
+    m_weights.resize(m_rowStart[numNodes]);
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        CaretAssert(weightLists[i].m_weights.size() == weightLists[i].m_nodes.size());
+        int64_t base = m_rowStart[i];
+        int32_t numWeights = (int32_t)weightLists[i].m_nodes.size();
+        for (int32_t j = 0; j < numWeights; ++j)
+        {
+            m_neighbors[base + j] = weightLists[i].m_nodes[j];
+            m_weights[base + j] = weightLists[i].m_weights[j];
+        }
+    }
 }
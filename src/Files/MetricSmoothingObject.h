@@ -29,6 +29,12 @@
 //
 //NOTE: for a static ROI, it is (sometimes much) more efficient to use it in the constructor, and provide no ROI (NULL) to the functions, using both an ROI in constructor and in method
 //      will result in the effective ROI being the logical AND of the two (intersection).
+//
+//NOTE: the weights are stored as a CSR sparse matrix (row i gathers from m_neighbors[m_rowStart[i]] to m_neighbors[m_rowStart[i + 1] - 1]), smoothMetric applies it
+//      to blocks of columns at once, so the matrix is read once per block rather than once per column.  If a weight cache directory is set, the matrix is saved there
+//      keyed by a hash of the surface, kernel, method, ROI and areas, and loaded instead of being recomputed when the same inputs are used again.
+
+#include "AString.h"
 
 #include "stdint.h"
 #include "stddef.h"
@@ -52,6 +58,15 @@ namespace caret {
         void smoothColumn(const MetricFile* metricIn, const int& whichColumn, MetricFile* columnOut, const MetricFile* roi = NULL, const bool& fixZeros = false) const;
         void smoothColumn(const MetricFile* metricIn, const int& whichColumn, MetricFile* metricOut, const int& whichOutColumn, const MetricFile* roi = NULL, const int& whichRoiColumn = 0, const bool& fixZeros = false) const;
         void smoothMetric(const MetricFile* metricIn, MetricFile* metricOut, const MetricFile* roi = NULL, const bool& fixZeros = false) const;
+        int32_t getNumberOfNodes() const { return (int32_t)m_weightSums.size(); }
+        const std::vector<int64_t>& getRowStarts() const { return m_rowStart; }
+        const std::vector<int32_t>& getNeighbors() const { return m_neighbors; }
+        const std::vector<float>& getWeights() const { return m_weights; }
+        const std::vector<float>& getWeightSums() const { return m_weightSums; }
+        ///directory to save computed weights in and load them from, empty (default) disables the cache
+        static void setWeightCacheDirectory(const AString& directory) { s_weightCacheDirectory = directory; }
+        static const AString& getWeightCacheDirectory() { return s_weightCacheDirectory; }
+        static const int COLUMN_BLOCK_SIZE;
     private:
         struct WeightList
         {
@@ -59,16 +74,24 @@ namespace caret {
             std::vector<float> m_weights;
             float m_weightSum;
         };
-        std::vector<WeightList> m_weightLists;
+        std::vector<int64_t> m_rowStart;
+        std::vector<int32_t> m_neighbors;
+        std::vector<float> m_weights;
+        std::vector<float> m_weightSums;
+        static AString s_weightCacheDirectory;
+        void smoothColumnBlock(const float* blockIn, float* blockOut, const int& numBlockCols, const float* roiColumn, const bool& fixZeros) const;//block data is interleaved, node-major
+        AString getCacheFileName(const SurfaceFile* mySurf, const float& myKernel, const MetricFile* theRoi, const Method& myMethod, const float* nodeAreas) const;
+        bool readWeightCache(const AString& fileName, const int32_t& numNodes);
+        void writeWeightCache(const AString& fileName) const;
         void smoothColumnInternal(float* scratch, const MetricFile* metricIn, const int& whichColumn, MetricFile* metricOut, const int& whichOutColumn, const bool& fixZeros) const;
         void smoothColumnInternal(float* scratch, const MetricFile* metricIn, const int& whichColumn, MetricFile* metricOut, const int& whichOutColumn, const MetricFile* roi, const int& whichRoiColumn, const bool& fixZeros) const;
         void precomputeWeights(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, Method myMethod, const float* nodeAreas);
-        void precomputeWeightsGeoGauss(const SurfaceFile* mySurf, float myKernel, const float* nodeAreas);
-        void precomputeWeightsROIGeoGauss(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas);
-        void precomputeWeightsGeoGaussArea(const SurfaceFile* mySurf, float myKernel, const float* nodeAreas);
-        void precomputeWeightsROIGeoGaussArea(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas);
-        void precomputeWeightsGeoGaussEqual(const SurfaceFile* mySurf, float myKernel, const float* nodeAreas);
-        void precomputeWeightsROIGeoGaussEqual(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas);
+        void precomputeWeightsGeoGauss(std::vector<WeightList>& weightLists, const SurfaceFile* mySurf, float myKernel, const float* nodeAreas);
+        void precomputeWeightsROIGeoGauss(std::vector<WeightList>& weightLists, const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas);
+        void precomputeWeightsGeoGaussArea(std::vector<WeightList>& weightLists, const SurfaceFile* mySurf, float myKernel, const float* nodeAreas);
+        void precomputeWeightsROIGeoGaussArea(std::vector<WeightList>& weightLists, const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas);
+        void precomputeWeightsGeoGaussEqual(std::vector<WeightList>& weightLists, const SurfaceFile* mySurf, float myKernel, const float* nodeAreas);
+        void precomputeWeightsROIGeoGaussEqual(std::vector<WeightList>& weightLists, const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas);
         MetricSmoothingObject();
     };
     
@@ -21,6 +21,7 @@
 
 #include <cmath>
 #include <limits>
+#include <vector>
 
 //#include <QRunnable>
 //#include <QSemaphore>
@@ -38,6 +39,7 @@
 #include "GroupAndNameHierarchyItem.h"
 #include "Palette.h"
 #include "PaletteColorMapping.h"
+#include "PaletteScalarAndColor.h"
 #include "MathFunctions.h"
 
 using namespace caret;
@@ -56,6 +58,169 @@ static const float negativeThresholdGreenColor[] = {
     255.0f / 255.0f
 };
 
+namespace {
+    /**
+     * Flattened copy of a palette with a coarse index from normalized value
+     * to the first palette point that needs to be tested, so that coloring
+     * many values doesn't repeat the search and pointer chasing done by
+     * Palette::getPaletteColor().  Colors are identical to that method.
+     */
+    class PaletteLookup {
+    public:
+        PaletteLookup(const Palette* palette,
+                      const bool interpolateFlag);
+        
+        void getPaletteColor(const float scalarIn,
+                             float rgbaOut[4]) const;
+        
+    private:
+        int32_t findFirstBelow(const float scalar,
+                               const int32_t startIndex) const;
+        
+        static const int32_t NUMBER_OF_BUCKETS = 256;
+        
+        int32_t m_numberOfPoints;
+        
+        bool m_interpolateFlag;
+        
+        /** palette scalars, in the palette's descending order */
+        std::vector<float> m_scalars;
+        
+        /** four components for each palette point */
+        std::vector<float> m_rgba;
+        
+        std::vector<uint8_t> m_noneColor;
+        
+        /** for each bucket of [-1, 1], where searching for the palette point may start */
+        std::vector<int32_t> m_searchStart;
+    };
+    
+    PaletteLookup::PaletteLookup(const Palette* palette,
+                                 const bool interpolateFlag)
+    {
+        m_interpolateFlag = interpolateFlag;
+        m_numberOfPoints = palette->getNumberOfScalarsAndColors();
+        m_scalars.resize(m_numberOfPoints);
+        m_rgba.resize(m_numberOfPoints * 4);
+        m_noneColor.resize(m_numberOfPoints);
+        for (int32_t i = 0; i < m_numberOfPoints; i++) {
+            const PaletteScalarAndColor* psac = palette->getScalarAndColor(i);
+            m_scalars[i] = psac->getScalar();
+            psac->getColor(&m_rgba[i * 4]);
+            m_noneColor[i] = (psac->isNoneColor() ? 1 : 0);
+        }
+        
+        /*
+         * Start at the first point below the top of the NEXT bucket, so that
+         * a value rounded into the neighboring bucket is still found correctly.
+         */
+        m_searchStart.resize(NUMBER_OF_BUCKETS);
+        for (int32_t b = 0; b < NUMBER_OF_BUCKETS; b++) {
+            const float bucketTop = -1.0f + (2.0f * (b + 2)) / NUMBER_OF_BUCKETS;
+            m_searchStart[b] = findFirstBelow(bucketTop, 1);
+        }
+    }
+    
+    /**
+     * @return Index of first palette point, at or after startIndex, that is
+     * below the scalar (same test as the linear search in Palette).
+     */
+    inline int32_t
+    PaletteLookup::findFirstBelow(const float scalar,
+                                  const int32_t startIndex) const
+    {
+        for (int32_t i = startIndex; i < m_numberOfPoints; i++) {
+            if (scalar > m_scalars[i]) {
+                return i;
+            }
+        }
+        return m_numberOfPoints;
+    }
+    
+    /**
+     * Same result as Palette::getPaletteColor().
+     */
+    inline void
+    PaletteLookup::getPaletteColor(const float scalarIn,
+                                   float rgbaOut[4]) const
+    {
+        rgbaOut[0] = 0.0f;
+        rgbaOut[1] = 0.0f;
+        rgbaOut[2] = 0.0f;
+        rgbaOut[3] = 1.0f;
+        
+        if (m_numberOfPoints <= 0) {
+            return;
+        }
+        
+        float scalar = scalarIn;
+        if (scalar < -1.0) scalar = -1.0;
+        if (scalar >  1.0) scalar = 1.0;
+        
+        bool interpolateColorFlag = m_interpolateFlag;
+        int32_t paletteIndex = -1;
+        if (m_numberOfPoints == 1) {
+            paletteIndex = 0;
+            interpolateColorFlag = false;
+        }
+        else if (scalar >= m_scalars[0]) {
+            paletteIndex = 0;
+            interpolateColorFlag = false;
+        }
+        else if (scalar <= m_scalars[m_numberOfPoints - 1]) {
+            paletteIndex = m_numberOfPoints - 1;
+            interpolateColorFlag = false;
+        }
+        else if (m_numberOfPoints == 2) {
+            paletteIndex = 0;
+            interpolateColorFlag = true;
+        }
+        else {
+            const float bucketFloat = (scalar + 1.0f) * (NUMBER_OF_BUCKETS / 2);
+            int32_t bucket = 0;
+            if (bucketFloat > 0.0f) {//also false for NaN
+                bucket = static_cast<int32_t>(bucketFloat);
+                if (bucket >= NUMBER_OF_BUCKETS) bucket = NUMBER_OF_BUCKETS - 1;
+            }
+            const int32_t firstBelow = findFirstBelow(scalar, m_searchStart[bucket]);
+            if (firstBelow < m_numberOfPoints) {
+                paletteIndex = firstBelow - 1;
+            }
+        }
+        
+        if (paletteIndex >= 0) {
+            if (m_noneColor[paletteIndex]) {
+                rgbaOut[3] = 0.0;
+            }
+            else {
+                const float* rgbaAbove = &m_rgba[paletteIndex * 4];
+                rgbaOut[0] = rgbaAbove[0];
+                rgbaOut[1] = rgbaAbove[1];
+                rgbaOut[2] = rgbaAbove[2];
+                rgbaOut[3] = rgbaAbove[3];
+                if (interpolateColorFlag &&
+                    (paletteIndex < (m_numberOfPoints - 1))) {
+                    const float totalDiff = m_scalars[paletteIndex] - m_scalars[paletteIndex + 1];
+                    if (totalDiff != 0.0) {
+                        const float offset = scalar - m_scalars[paletteIndex + 1];
+                        const float percentAbove = offset / totalDiff;
+                        const float percentBelow = 1.0f - percentAbove;
+                        if ( ! m_noneColor[paletteIndex + 1]) {
+                            const float* rgbaBelow = &m_rgba[(paletteIndex + 1) * 4];
+                            rgbaOut[0] = (percentAbove * rgbaAbove[0]
+                                          + percentBelow * rgbaBelow[0]);
+                            rgbaOut[1] = (percentAbove * rgbaAbove[1]
+                                          + percentBelow * rgbaBelow[1]);
+                            rgbaOut[2] = (percentAbove * rgbaAbove[2]
+                                          + percentBelow * rgbaBelow[2]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
 
     
 /**
@@ -187,16 +352,37 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
      * Since there may be a large number of values that are -1.0 or 1.0
      * we can compute the color only once for these values and save time.
      */
+    const PaletteLookup paletteLookup(palette,
+                                      interpolateFlag);
     float rgbaPositiveOne[4], rgbaNegativeOne[4];
-    palette->getPaletteColor(1.0,
-                             interpolateFlag,
-                             rgbaPositiveOne);
+    paletteLookup.getPaletteColor(1.0,
+                                  rgbaPositiveOne);
     const bool rgbaPositiveOneValid = (rgbaPositiveOne[3] > 0.0);
-    palette->getPaletteColor(-1.0,
-                             interpolateFlag,
-                             rgbaNegativeOne);
+    paletteLookup.getPaletteColor(-1.0,
+                                  rgbaNegativeOne);
     const bool rgbaNegativeOneValid = (rgbaNegativeOne[3] > 0.0);
     
+    /*
+     * Threshold test for all scalars in a separate, branch free
+     * pass that the compiler can vectorize.
+     */
+    std::vector<uint8_t> thresholdPassed(numberOfScalars, 1);
+    if ( ! skipThresholdTesting) {
+        uint8_t* passedPointer = &thresholdPassed[0];
+        if (showOutsideFlag) {
+            for (int64_t i = 0; i < numberOfScalars; i++) {
+                passedPointer[i] = ((thresholdValues[i] > thresholdMaximum)
+                                    | (thresholdValues[i] < thresholdMinimum));
+            }
+        }
+        else {
+            for (int64_t i = 0; i < numberOfScalars; i++) {
+                passedPointer[i] = ((thresholdValues[i] >= thresholdMinimum)
+                                    & (thresholdValues[i] <= thresholdMaximum));
+            }
+        }
+    }
+    
     /*
      * Color all scalars.
      */
@@ -294,9 +480,8 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
              * Color scalar using palette
              */
             float rgba[4];
-            palette->getPaletteColor(normalValue,
-                                     interpolateFlag,
-                                     rgba);
+            paletteLookup.getPaletteColor(normalValue,
+                                          rgba);
             if (rgba[3] > 0.0f) {
                 rgbaOut[0] = rgba[0];
                 rgbaOut[1] = rgba[1];
@@ -310,25 +495,7 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
          * Threshold is done last so colors are still set
          * but if threshold test fails, alpha is set invalid.
          */
-        bool thresholdPassedFlag = false;
-        if (skipThresholdTesting) {
-            thresholdPassedFlag = true;
-        }
-        else if (showOutsideFlag) {
-            if (threshold > thresholdMaximum) {
-                thresholdPassedFlag = true;
-            }
-            else if (threshold < thresholdMinimum) {
-                thresholdPassedFlag = true;
-            }
-        }
-        else {
-            if ((threshold >= thresholdMinimum) &&
-                (threshold <= thresholdMaximum)) {
-                thresholdPassedFlag = true;
-            }
-        }
-        if (thresholdPassedFlag == false) {
+        if (thresholdPassed[i] == 0) {
             rgbaOut[3] = 0.0;
             if (showMappedThresholdFailuresInGreen) {
                 if (thresholdType == PaletteThresholdTypeEnum::THRESHOLD_TYPE_MAPPED) {
@@ -340,7 +340,7 @@ int SignedDistanceHelper::computeSign(const float coord[3], SignedDistanceHelper
                     {
                         int curSign = 0;
                         int numChanged = 0;
-                        const vector<int>& myTiles = m_base->m_topoHelp->getNodeTiles(myInfo.node1);
+                        const TopologyIndexSpan myTiles = m_base->m_topoHelp->getNodeTiles(myInfo.node1);
                         bool first = true;
                         float bestNorm = 0;
                         Vector3D tempvec, tempvec2, bestCent;
@@ -453,7 +453,7 @@ int SignedDistanceHelper::computeSign(const float coord[3], SignedDistanceHelper
                 case 1://edge
                     {
                         const vector<TopologyEdgeInfo>& edgeInfo = m_base->m_topoHelp->getEdgeInfo();
-                        const vector<int>& edges = m_base->m_topoHelp->getNodeEdges(myInfo.node1);
+                        const TopologyIndexSpan edges = m_base->m_topoHelp->getNodeEdges(myInfo.node1);
                         int whichEdge = -1, numEdges = (int)edges.size();
                         for (int i = 0; i < numEdges; ++i)
                         {
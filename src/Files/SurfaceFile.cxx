@@ -37,11 +37,13 @@
 
 #include "GiftiFile.h"
 #include "GiftiMetaDataXmlElements.h"
+#include "GraphicsPrimitiveV3fN3fC4f.h"
 #include "MathFunctions.h"
 #include "Matrix4x4.h"
 #include "Vector3D.h"
 
 #include "CaretPointLocator.h"
+#include "CaretTriangleLocator.h"
 #include "GeodesicHelper.h"
 #include "PlainTextStringBuilder.h"
 #include "SignedDistanceHelper.h"
@@ -565,6 +567,79 @@ void
 SurfaceFile::invalidateNormals()
 {
     m_normalsComputed = false;
+    m_trianglesGraphicsPrimitive.reset();
+}
+
+/**
+ * Get the graphics primitive for drawing the surface's triangles.  The
+ * coordinates, normal vectors, and triangles are only loaded into the
+ * primitive when it is created, after the surface changes, so that
+ * the graphics system keeps them and does not send them again each
+ * time the surface is drawn.  The coloring is replaced but is only
+ * reloaded by the graphics system when it differs from the coloring
+ * that was previously drawn.
+ *
+ * @param rgbaNodeColorComponents
+ *     RGBA coloring for the nodes.
+ * @return
+ *     The primitive or NULL if the surface has no triangles or its
+ *     normal vectors are not valid.
+ */
+GraphicsPrimitiveV3fN3fC4f*
+SurfaceFile::getTrianglesGraphicsPrimitive(const float* rgbaNodeColorComponents) const
+{
+    CaretAssert(rgbaNodeColorComponents);
+    
+    const int32_t numNodes = getNumberOfNodes();
+    const int32_t numTriangles = getNumberOfTriangles();
+    if ((numNodes <= 0)
+        || (numTriangles <= 0)
+        || ( ! m_normalsComputed)
+        || (static_cast<int32_t>(this->normalVectors.size()) != (numNodes * 3))) {
+        m_trianglesGraphicsPrimitive.reset();
+        return NULL;
+    }
+    
+    if (m_trianglesGraphicsPrimitive != NULL) {
+        if (m_trianglesGraphicsPrimitive->getNumberOfVertices() != numNodes) {
+            m_trianglesGraphicsPrimitive.reset();
+        }
+    }
+    
+    if (m_trianglesGraphicsPrimitive == NULL) {
+        GraphicsPrimitiveV3fN3fC4f* primitive = GraphicsPrimitive::newPrimitiveV3fN3fC4f(GraphicsPrimitive::PrimitiveType::OPENGL_TRIANGLES);
+        primitive->setUsageTypeCoordinates(GraphicsPrimitive::UsageType::MODIFIED_ONCE_DRAWN_MANY_TIMES);
+        primitive->setUsageTypeNormals(GraphicsPrimitive::UsageType::MODIFIED_ONCE_DRAWN_MANY_TIMES);
+        primitive->setUsageTypeColors(GraphicsPrimitive::UsageType::MODIFIED_MANY_DRAWN_MANY_TIMES);
+        primitive->addVertices(this->coordinatePointer,
+                               &this->normalVectors[0],
+                               rgbaNodeColorComponents,
+                               numNodes);
+        
+        /*
+         * Triangles with an invalid node are not drawn
+         */
+        std::vector<uint32_t> vertexIndices;
+        vertexIndices.reserve(numTriangles * 3);
+        for (int32_t i = 0; i < numTriangles; i++) {
+            const int32_t* tri = &this->trianglePointer[i * 3];
+            if ((tri[0] >= 0) && (tri[0] < numNodes)
+                && (tri[1] >= 0) && (tri[1] < numNodes)
+                && (tri[2] >= 0) && (tri[2] < numNodes)) {
+                vertexIndices.push_back(tri[0]);
+                vertexIndices.push_back(tri[1]);
+                vertexIndices.push_back(tri[2]);
+            }
+        }
+        primitive->setVertexIndices(vertexIndices);
+        
+        m_trianglesGraphicsPrimitive.reset(primitive);
+    }
+    else {
+        m_trianglesGraphicsPrimitive->replaceAllVertexFloatRGBA(rgbaNodeColorComponents);
+    }
+    
+    return m_trianglesGraphicsPrimitive.get();
 }
 /**
  * Compute surface normals.
@@ -577,6 +652,7 @@ SurfaceFile::computeNormals()
         return;
     }
     m_normalsComputed = true;
+    m_trianglesGraphicsPrimitive.reset();
     int32_t numCoords = this->getNumberOfNodes();
     if (numCoords > 0) {
         this->normalVectors.resize(numCoords * 3);
@@ -647,7 +723,7 @@ std::vector<float> SurfaceFile::computeAverageNormals()
     {
         int i3 = i * 3;
         Vector3D accum;
-        const std::vector<int32_t>& neighbors = myTopoHelp->getNodeNeighbors(i);
+        const TopologyIndexSpan neighbors = myTopoHelp->getNodeNeighbors(i);
         int numNeigh = (int)neighbors.size();
         for (int j = 0; j < numNeigh; ++j)
         {
@@ -858,6 +934,7 @@ CaretPointer<SignedDistanceHelper> SurfaceFile::getSignedDistanceHelper() const
 
 void SurfaceFile::invalidateHelpers()
 {
+    m_trianglesGraphicsPrimitive.reset();//topology or coordinates changed
     if (m_geoBase != NULL)
     {
         CaretMutexLocker myLock(&m_geoHelperMutex);//make this function threadsafe
@@ -884,6 +961,11 @@ void SurfaceFile::invalidateHelpers()
         CaretMutexLocker myLock3(&m_locatorMutex);
         m_locator.grabNew(NULL);
     }
+    if (m_triangleLocator != NULL)
+    {
+        CaretMutexLocker myLock5(&m_triangleLocatorMutex);
+        m_triangleLocator.grabNew(NULL);
+    }
 }
 
 /**
@@ -989,6 +1071,8 @@ SurfaceFile::applyMatrix(const Matrix4x4& matrix)
         }
     }
     
+    invalidateNormals();
+    invalidateHelpers();
     computeNormals();
     
     setModified();
@@ -1188,6 +1272,19 @@ CaretPointer<const CaretPointLocator> SurfaceFile::getPointLocator() const
     return m_locator;
 }
 
+CaretPointer<const CaretTriangleLocator> SurfaceFile::getTriangleLocator() const
+{
+    if (m_triangleLocator == NULL)//same locking scheme as getPointLocator
+    {
+        CaretMutexLocker myLock(&m_triangleLocatorMutex);
+        if (m_triangleLocator == NULL)
+        {
+            m_triangleLocator.grabNew(new CaretTriangleLocator(getCoordinateData(), getNumberOfNodes(), trianglePointer, getNumberOfTriangles()));
+        }
+    }
+    return m_triangleLocator;
+}
+
 void SurfaceFile::clearCachedHelpers() const
 {
     {
@@ -1212,6 +1309,10 @@ void SurfaceFile::clearCachedHelpers() const
         CaretMutexLocker locked(&m_locatorMutex);
         m_locator.grabNew(NULL);
     }
+    {
+        CaretMutexLocker locked(&m_triangleLocatorMutex);
+        m_triangleLocator.grabNew(NULL);
+    }
 }
 
 /**
@@ -1619,8 +1720,8 @@ bool SurfaceFile::hasNodeCorrespondence(const SurfaceFile& rhs) const
     CaretPointer<TopologyHelper> myHelp = getTopologyHelper(), rightHelp = rhs.getTopologyHelper();
     for (int i = 0; i < numNodes; ++i)
     {
-        const std::vector<int32_t>& myNeigh = myHelp->getNodeNeighbors(i);
-        const std::vector<int32_t>& rightNeigh = rightHelp->getNodeNeighbors(i);
+        const TopologyIndexSpan myNeigh = myHelp->getNodeNeighbors(i);
+        const TopologyIndexSpan rightNeigh = rightHelp->getNodeNeighbors(i);
         int mySize = (int)myNeigh.size();
         if (mySize != (int)rightNeigh.size()) return false;
         std::set<int32_t> myUsed;
@@ -22,6 +22,7 @@
  */
 /*LICENSE_END*/
 
+#include <memory>
 #include <vector>
 #include <stdint.h>
 
@@ -37,11 +38,13 @@ namespace caret {
 
     class BoundingBox;
     class CaretPointLocator;
+    class CaretTriangleLocator;
     class DescriptiveStatistics;
     class FastStatistics;
     class GeodesicHelper;
     class GeodesicHelperBase;
     class GiftiDataArray;
+    class GraphicsPrimitiveV3fN3fC4f;
     class Matrix4x4;
     class PlainTextStringBuilder;
     class SignedDistanceHelper;
@@ -138,6 +141,8 @@ namespace caret {
         
         CaretPointer<const CaretPointLocator> getPointLocator() const;
         
+        CaretPointer<const CaretTriangleLocator> getTriangleLocator() const;
+        
         void clearCachedHelpers() const;
         
         const BoundingBox* getBoundingBox() const;
@@ -176,6 +181,8 @@ namespace caret {
 
         void invalidateNormals();
         
+        GraphicsPrimitiveV3fN3fC4f* getTrianglesGraphicsPrimitive(const float* rgbaNodeColorComponents) const;
+        
         void translateToCenterOfMass();
         
         void flipNormals();
@@ -292,12 +299,18 @@ namespace caret {
         ///used to search for the closest point in the surface
         mutable CaretPointer<CaretPointLocator> m_locator;
         
+        ///used to find the triangle hit by a ray, such as the one under the mouse
+        mutable CaretPointer<CaretTriangleLocator> m_triangleLocator;
+        
         ///used to track when the surface file gets changed
         void invalidateHelpers();
         
         mutable BoundingBox* boundingBox;
         
-        mutable CaretMutex m_topoHelperMutex, m_geoHelperMutex, m_locatorMutex, m_distHelperMutex;
+        /** Coordinates, normals, and triangles for drawing, built when first drawn */
+        mutable std::unique_ptr<GraphicsPrimitiveV3fN3fC4f> m_trianglesGraphicsPrimitive;
+        
+        mutable CaretMutex m_topoHelperMutex, m_geoHelperMutex, m_locatorMutex, m_triangleLocatorMutex, m_distHelperMutex;
     };
 
 } // namespace
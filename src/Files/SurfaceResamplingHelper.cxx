@@ -259,7 +259,7 @@ void SurfaceResamplingHelper::resampleCutSurface(const SurfaceFile* cutSurfaceIn
                 break;
             case BarycentricInfo::EDGE:
             {
-                const vector<int32_t>& cutEdges = cutTopoHelp->getNodeEdges(largestNode[i]);
+                const TopologyIndexSpan cutEdges = cutTopoHelp->getNodeEdges(largestNode[i]);
                 for (int j = 0; j < (int)cutEdges.size(); ++j)
                 {
                     const TopologyEdgeInfo& myInfo = cutEdgeInfo[cutEdges[j]];
@@ -299,7 +299,7 @@ void SurfaceResamplingHelper::resampleCutSurface(const SurfaceFile* cutSurfaceIn
 #pragma omp CARET_FOR schedule(dynamic)
         for (int32_t i = 0; i < newNodes; ++i)
         {
-            const vector<int32_t>& neighbors = newTopoHelp->getNodeNeighbors(i);
+            const TopologyIndexSpan neighbors = newTopoHelp->getNodeNeighbors(i);
             if (isOnEdge[i])
             {
                 bool hasInteriorNeighbor = false;
@@ -321,7 +321,7 @@ void SurfaceResamplingHelper::resampleCutSurface(const SurfaceFile* cutSurfaceIn
                         cutGeoHelp->getPathToNode(largestNode[i], largestNode[neighbors[j]], cutPath, cutPathDists);
                         if (cutPathDists.size() == 0 || cutPathDists.back() > 2.0f * closedPathDists.back())//maybe this cutoff should be tunable
                         {
-                            const vector<int32_t>& myTiles = newTopoHelp->getNodeTiles(i);//find tiles on new mesh that share this edge, remove them
+                            const TopologyIndexSpan myTiles = newTopoHelp->getNodeTiles(i);//find tiles on new mesh that share this edge, remove them
                             for (int k = 0; k < (int)myTiles.size(); ++k)
                             {
                                 const int32_t* thisTile = newSphere->getTriangle(myTiles[k]);
@@ -334,7 +334,7 @@ void SurfaceResamplingHelper::resampleCutSurface(const SurfaceFile* cutSurfaceIn
                     }
                 } else {
                     nodeDisconnect[i] = 1;//disconnect it completely if it has no interior neighbors
-                    const vector<int32_t>& nodeTiles = newTopoHelp->getNodeTiles(i);
+                    const TopologyIndexSpan nodeTiles = newTopoHelp->getNodeTiles(i);
                     for (int j = 0; j < (int)nodeTiles.size(); ++j)
                     {
                         triRemove[nodeTiles[j]] = 1;
@@ -349,7 +349,7 @@ void SurfaceResamplingHelper::resampleCutSurface(const SurfaceFile* cutSurfaceIn
                     cutGeoHelp->getPathToNode(largestNode[i], largestNode[neighbors[j]], cutPath, cutPathDists);//note: path length of zero means no connection
                     if (cutPathDists.size() == 0 || cutPathDists.back() > 2.0f * closedPathDists.back())//maybe this cutoff should be tunable
                     {
-                        const vector<int32_t>& myTiles = newTopoHelp->getNodeTiles(i);//find tiles on new mesh that share this edge, remove them
+                        const TopologyIndexSpan myTiles = newTopoHelp->getNodeTiles(i);//find tiles on new mesh that share this edge, remove them
                         for (int k = 0; k < (int)myTiles.size(); ++k)
                         {
                             const int32_t* thisTile = newSphere->getTriangle(myTiles[k]);
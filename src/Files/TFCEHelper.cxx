@@ -0,0 +1,326 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "TFCEHelper.h"
+
+#include "CaretAssert.h"
+#include "CaretException.h"
+#include "SurfaceFile.h"
+#include "TopologyHelper.h"
+#include "Vector3D.h"
+#include "VolumeSpace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+using namespace caret;
+using namespace std;
+
+TFCEHelper::TFCEHelper(const SurfaceFile* mySurf, const float* areaData, const float* roiData, const float& param_e, const float& param_h)
+{
+    m_param_e = param_e;
+    m_param_h = param_h;
+    m_uniformArea = 1.0f;
+    int32_t numNodes = mySurf->getNumberOfNodes();
+    m_numElements = numNodes;
+    vector<float> surfAreas;
+    if (areaData == NULL)
+    {
+        mySurf->computeNodeAreas(surfAreas);
+        areaData = surfAreas.data();
+    }
+    vector<int32_t> compactIndex(numNodes, -1);
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        if (roiData == NULL || roiData[i] > 0.0f)
+        {
+            compactIndex[i] = (int32_t)m_elementIndex.size();
+            m_elementIndex.push_back(i);
+            m_areas.push_back(areaData[i]);
+        }
+    }
+    CaretPointer<TopologyHelper> myHelper = mySurf->getTopologyHelper();
+    int32_t numUsed = (int32_t)m_elementIndex.size();
+    m_neighborStart.resize(numUsed + 1);
+    m_neighborStart[0] = 0;
+    for (int32_t i = 0; i < numUsed; ++i)
+    {
+        const TopologyIndexSpan neighbors = myHelper->getNodeNeighbors((int32_t)m_elementIndex[i]);
+        int numNeigh = (int)neighbors.size();
+        for (int j = 0; j < numNeigh; ++j)
+        {
+            int32_t neighCompact = compactIndex[neighbors[j]];
+            if (neighCompact != -1)
+            {
+                m_neighbors.push_back(neighCompact);
+            }
+        }
+        m_neighborStart[i + 1] = (int64_t)m_neighbors.size();
+    }
+}
+
+TFCEHelper::TFCEHelper(const VolumeSpace& mySpace, const float* roiFrame, const float& param_e, const float& param_h)
+{
+    m_param_e = param_e;
+    m_param_h = param_h;
+    Vector3D ivec, jvec, kvec, origin;//compute the volume of a voxel so different resolutions have comparable values
+    mySpace.getSpacingVectors(ivec, jvec, kvec, origin);
+    m_uniformArea = abs(ivec.dot(jvec.cross(kvec)));
+    const int64_t* dims = mySpace.getDims();
+    m_numElements = dims[0] * dims[1] * dims[2];
+    vector<int32_t> compactIndex(m_numElements, -1);
+    for (int64_t i = 0; i < m_numElements; ++i)
+    {
+        if (roiFrame == NULL || roiFrame[i] > 0.0f)
+        {
+            if (m_elementIndex.size() >= (size_t)numeric_limits<int32_t>::max()) throw CaretException("too many voxels in roi for TFCE");
+            compactIndex[i] = (int32_t)m_elementIndex.size();
+            m_elementIndex.push_back(i);
+        }
+    }
+    const int STENCIL_SIZE = 18;
+    const int64_t stencil[STENCIL_SIZE] = { 0, 0, -1,
+                                            0, -1, 0,
+                                            -1, 0, 0,
+                                            1, 0, 0,
+                                            0, 1, 0,
+                                            0, 0, 1 };
+    int64_t numUsed = (int64_t)m_elementIndex.size();
+    m_neighborStart.resize(numUsed + 1);
+    m_neighborStart[0] = 0;
+    for (int64_t i = 0; i < numUsed; ++i)
+    {
+        int64_t index = m_elementIndex[i];
+        int64_t ijk[3] = { index % dims[0], (index / dims[0]) % dims[1], index / (dims[0] * dims[1]) };//VolumeSpace::getIndex is i-fastest
+        for (int s = 0; s < STENCIL_SIZE; s += 3)
+        {
+            int64_t ni = ijk[0] + stencil[s], nj = ijk[1] + stencil[s + 1], nk = ijk[2] + stencil[s + 2];
+            if (mySpace.indexValid(ni, nj, nk))
+            {
+                int32_t neighCompact = compactIndex[mySpace.getIndex(ni, nj, nk)];
+                if (neighCompact != -1)
+                {
+                    m_neighbors.push_back(neighCompact);
+                }
+            }
+        }
+        m_neighborStart[i + 1] = (int64_t)m_neighbors.size();
+    }
+}
+
+void TFCEHelper::computeTFCE(const float* dataIn, float* dataOut, Scratch& myScratch) const
+{
+    computeSigned(dataIn, myScratch);
+    for (int64_t i = 0; i < m_numElements; ++i)
+    {
+        dataOut[i] = 0.0f;
+    }
+    int64_t numUsed = (int64_t)m_elementIndex.size();
+    for (int64_t i = 0; i < numUsed; ++i)
+    {
+        dataOut[m_elementIndex[i]] = (float)myScratch.m_result[i];
+    }
+}
+
+void TFCEHelper::computeTFCEExtremes(const float* dataIn, float& maxOut, float& minOut, Scratch& myScratch) const
+{
+    computeSigned(dataIn, myScratch);
+    maxOut = 0.0f;
+    minOut = 0.0f;
+    int64_t numUsed = (int64_t)m_elementIndex.size();
+    for (int64_t i = 0; i < numUsed; ++i)
+    {
+        float value = (float)myScratch.m_result[i];
+        if (value > maxOut) maxOut = value;
+        if (value < minOut) minOut = value;
+    }
+}
+
+void TFCEHelper::computeSigned(const float* dataIn, Scratch& myScratch) const
+{
+    int64_t numUsed = (int64_t)m_elementIndex.size();
+    myScratch.m_values.resize(numUsed);
+    myScratch.m_result.assign(numUsed, 0.0);
+    for (int64_t i = 0; i < numUsed; ++i)
+    {
+        myScratch.m_values[i] = dataIn[m_elementIndex[i]];
+    }
+    tfcePositive(myScratch);
+    for (int64_t i = 0; i < numUsed; ++i)
+    {
+        myScratch.m_values[i] = -myScratch.m_values[i];
+    }
+    tfcePositive(myScratch);//negatives and positives don't overlap, and tfcePositive only sets the result of elements it uses
+    for (int64_t i = 0; i < numUsed; ++i)
+    {
+        if (myScratch.m_values[i] > 0.0f)//values are currently negated, so this is a negative input
+        {
+            myScratch.m_result[i] = -myScratch.m_result[i];
+        }
+    }
+}
+
+int32_t TFCEHelper::findRoot(const int32_t& element, Scratch& myScratch) const
+{
+    int32_t* parent = myScratch.m_parent.data();
+    int32_t root = element;
+    myScratch.m_path.clear();
+    while (parent[root] != root)
+    {
+        myScratch.m_path.push_back(root);
+        root = parent[root];
+    }
+    double* offset = myScratch.m_offset.data();
+    for (int i = (int)myScratch.m_path.size() - 1; i >= 0; --i)//compress from the end closest to the root, so each parent already points to the root
+    {
+        int32_t node = myScratch.m_path[i];
+        int32_t nodeParent = parent[node];
+        if (nodeParent != root)
+        {
+            offset[node] += offset[nodeParent];
+            parent[node] = root;
+        }
+    }
+    return root;
+}
+
+void TFCEHelper::tfcePositive(Scratch& myScratch) const
+{
+    int64_t numUsed = (int64_t)m_elementIndex.size();
+    const float* values = myScratch.m_values.data();
+    vector<pair<float, int32_t> >& order = myScratch.m_order;
+    order.clear();
+    for (int64_t i = 0; i < numUsed; ++i)
+    {
+        if (values[i] > 0.0f)
+        {
+            order.push_back(pair<float, int32_t>(values[i], (int32_t)i));
+        }
+    }
+    if (order.empty()) return;
+    sort(order.begin(), order.end(), greater<pair<float, int32_t> >());//visit from the peaks down
+    myScratch.m_parent.assign(numUsed, -1);//-1 is not yet reached, elements that are never reached must not keep a parent from the previous map
+    myScratch.m_size.resize(numUsed);
+    myScratch.m_offset.resize(numUsed);
+    myScratch.m_accum.resize(numUsed);
+    myScratch.m_area.resize(numUsed);
+    myScratch.m_lastPow.resize(numUsed);
+    myScratch.m_lastVal.resize(numUsed);
+    int32_t* parent = myScratch.m_parent.data();
+    int32_t* clusterSize = myScratch.m_size.data();
+    double* offset = myScratch.m_offset.data();//integral of element minus integral of its parent, roots hold 0
+    double* accum = myScratch.m_accum.data();//for roots, the integral of the cluster so far
+    double* area = myScratch.m_area.data();
+    double* lastPow = myScratch.m_lastPow.data();
+    float* lastVal = myScratch.m_lastVal.data();
+    int64_t numOrdered = (int64_t)order.size();
+    const bool areaPerElement = !m_areas.empty();
+    const double integrated_h = m_param_h + 1.0f;//integral(x^h) = (x^(h + 1))/(h + 1) + C
+    const double param_e = m_param_e;
+    const bool linearArea = (m_param_e == 1.0f);
+    vector<int32_t>& roots = myScratch.m_roots;
+    for (int64_t i = 0; i < numOrdered; ++i)
+    {
+        const float value = order[i].first;
+        const int32_t element = order[i].second;
+        const double valuePow = pow((double)value, integrated_h);
+        roots.clear();
+        for (int64_t n = m_neighborStart[element]; n < m_neighborStart[element + 1]; ++n)
+        {
+            int32_t neighbor = m_neighbors[n];
+            if (parent[neighbor] != -1)
+            {
+                int32_t root = findRoot(neighbor, myScratch);
+                if (find(roots.begin(), roots.end(), root) == roots.end())
+                {
+                    roots.push_back(root);
+                }
+            }
+        }
+        for (size_t r = 0; r < roots.size(); ++r)//bring every touching cluster down to this value, so their integrals are aligned
+        {
+            int32_t root = roots[r];
+            if (value != lastVal[root])//skip computing if there is no difference
+            {
+                CaretAssert(value < lastVal[root]);
+                double areaFactor = (linearArea ? area[root] : pow(area[root], param_e));
+                accum[root] += areaFactor * (lastPow[root] - valuePow) / integrated_h;
+                lastVal[root] = value;
+                lastPow[root] = valuePow;
+            }
+        }
+        const double elementArea = (areaPerElement ? m_areas[element] : m_uniformArea);
+        if (roots.empty())
+        {//new cluster
+            parent[element] = element;
+            clusterSize[element] = 1;
+            offset[element] = 0.0;
+            accum[element] = 0.0;
+            area[element] = elementArea;
+            lastVal[element] = value;
+            lastPow[element] = valuePow;
+            continue;
+        }
+        int32_t merged = roots[0];//use the biggest cluster as the root, to keep the trees shallow
+        for (size_t r = 1; r < roots.size(); ++r)
+        {
+            if (clusterSize[roots[r]] > clusterSize[merged]) merged = roots[r];
+        }
+        for (size_t r = 0; r < roots.size(); ++r)
+        {
+            int32_t root = roots[r];
+            if (root != merged)
+            {//members of the absorbed cluster keep its integral so far, and gain whatever the merged cluster accumulates from here down
+                parent[root] = merged;
+                offset[root] = accum[root] - accum[merged];
+                clusterSize[merged] += clusterSize[root];
+                area[merged] += area[root];
+            }
+        }
+        parent[element] = merged;
+        offset[element] = -accum[merged];//this element is on the edge, it gets nothing of the integral above this value
+        clusterSize[merged] += 1;
+        area[merged] += elementArea;
+    }
+    for (int64_t i = 0; i < numOrdered; ++i)//update the remaining clusters to include the to-zero slice
+    {
+        int32_t element = order[i].second;
+        if (parent[element] == element)
+        {
+            double areaFactor = (linearArea ? area[element] : pow(area[element], param_e));
+            accum[element] += areaFactor * lastPow[element] / integrated_h;
+            lastVal[element] = 0.0f;
+            lastPow[element] = 0.0;
+        }
+    }
+    double* result = myScratch.m_result.data();
+    for (int64_t i = 0; i < numOrdered; ++i)
+    {
+        int32_t element = order[i].second;
+        int32_t root = findRoot(element, myScratch);
+        if (root == element)
+        {
+            result[element] = accum[root];
+        } else {
+            result[element] = offset[element] + accum[root];
+        }
+    }
+}
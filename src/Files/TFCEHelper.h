@@ -0,0 +1,82 @@
+#ifndef __TFCE_HELPER_H__
+#define __TFCE_HELPER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+//NOTE: this is for running TFCE on many maps over the same domain (columns of a metric, frames of a volume, permuted maps), the neighbor graph and the
+//      areas are built once in the constructor, restricted to the ROI, and every map reuses them.
+//
+//NOTE: this object contains no mutable members, multiple threads can compute on the same instance concurrently as long as each thread uses its own Scratch
+//      (construct one inside the parallel region), a Scratch keeps its allocations between maps, so reuse it for every map the thread computes.
+//
+//NOTE: clusters are tracked with a union-find that stores, for each element, the difference between its integral and its parent's, so merging two clusters
+//      is a single link instead of a pass over the members of the smaller cluster.
+
+#include "stdint.h"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace caret {
+
+    class SurfaceFile;
+    class VolumeSpace;
+
+    class TFCEHelper
+    {
+    public:
+        ///per-thread working memory, reused for every map computed with it
+        class Scratch
+        {
+            std::vector<float> m_values;
+            std::vector<double> m_result;
+            std::vector<std::pair<float, int32_t> > m_order;
+            std::vector<int32_t> m_parent, m_size, m_roots, m_path;
+            std::vector<double> m_offset, m_accum, m_area, m_lastPow;
+            std::vector<float> m_lastVal;
+            friend class TFCEHelper;
+        };
+        ///areaData and roiData are per vertex, areaData defaults to the surface's vertex areas
+        TFCEHelper(const SurfaceFile* mySurf, const float* areaData = NULL, const float* roiData = NULL, const float& param_e = 1.0f, const float& param_h = 2.0f);
+        ///face neighbors, every voxel has the volume of a voxel in the space, roiFrame is one frame of the space
+        TFCEHelper(const VolumeSpace& mySpace, const float* roiFrame = NULL, const float& param_e = 1.0f, const float& param_h = 2.0f);
+        ///dataIn and dataOut are full size (all vertices or voxels), dataOut is zero outside the roi
+        void computeTFCE(const float* dataIn, float* dataOut, Scratch& myScratch) const;
+        ///largest positive and most negative TFCE value of the map, 0 if there are none, without writing the full output
+        void computeTFCEExtremes(const float* dataIn, float& maxOut, float& minOut, Scratch& myScratch) const;
+        int64_t getNumberOfElements() const { return m_numElements; }
+    private:
+        int64_t m_numElements;
+        std::vector<int64_t> m_elementIndex;//roi element to full index
+        std::vector<int64_t> m_neighborStart;//CSR over roi elements, neighbors of i are m_neighbors[m_neighborStart[i]] to m_neighbors[m_neighborStart[i + 1] - 1]
+        std::vector<int32_t> m_neighbors;
+        std::vector<float> m_areas;//per roi element, empty when all elements have m_uniformArea
+        float m_uniformArea;
+        float m_param_e, m_param_h;
+        void computeSigned(const float* dataIn, Scratch& myScratch) const;
+        void tfcePositive(Scratch& myScratch) const;
+        int32_t findRoot(const int32_t& element, Scratch& myScratch) const;
+        TFCEHelper();
+    };
+
+}
+
+#endif //__TFCE_HELPER_H__
@@ -22,6 +22,7 @@
 /*LICENSE_END*/
 
 #include <vector>
+#include "CaretAssert.h"
 #include "CaretPointer.h"
 
 namespace caret {
@@ -67,6 +68,27 @@ namespace caret {
         }
     };
     
+    ///read-only view of the neighbors, edges, or tiles of one node, which are stored contiguously for all nodes
+    class TopologyIndexSpan
+    {
+        const int32_t* m_data;
+        std::size_t m_size;
+    public:
+        typedef const int32_t* const_iterator;
+        TopologyIndexSpan(const int32_t* data, const std::size_t& size) : m_data(data), m_size(size) { }
+        std::size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        const int32_t* data() const { return m_data; }
+        const_iterator begin() const { return m_data; }
+        const_iterator end() const { return m_data + m_size; }
+        const int32_t& operator[](const std::size_t& index) const
+        {
+            CaretAssert(index < m_size);
+            return m_data[index];
+        }
+        operator std::vector<int32_t>() const { return std::vector<int32_t>(m_data, m_data + m_size); }//for code that wants its own copy
+    };
+    
     struct TopologyTileInfo
     {
         struct Edge
@@ -84,24 +106,13 @@ namespace caret {
         TopologyHelperBase& operator=(const TopologyHelperBase&);
         void processTileNeighbor(std::vector<TopologyEdgeInfo>& tempEdgeInfo, CaretArray<int32_t>& scratch, const int32_t& root, const int32_t& neighbor, const int32_t& thirdNode, const int32_t& tile, const int32_t& tileEdge, const bool& reversed);
         void sortNeighbors(const SurfaceFile* mySurf, const int32_t& node, CaretArray<int32_t>& nodeScratch, CaretArray<int32_t>& tileScratch);
-        struct NodeInfo
-        {
-            std::vector<int32_t> m_neighbors;
-            std::vector<int32_t> m_edges;//index into the topology edges vector, matched with neighbors
-            std::vector<int32_t> m_tiles;
-            std::vector<int32_t> m_whichVertex;//stores which tile vertex this node is, matched to m_tiles
-            void addTileInfo(int32_t tile, int32_t vertexNum)//don't take edge info yet because it is built after neighbor info
-            {
-                m_tiles.push_back(tile);
-                m_whichVertex.push_back(vertexNum);
-            }
-            void addNeighborInfo(int32_t neighbor, int32_t edge)//after we have tile info, we then generate neighbor info with the help of a mark array
-            {
-                m_neighbors.push_back(neighbor);
-                m_edges.push_back(edge);
-            }
-        };
-        std::vector<NodeInfo> m_nodeInfo;
+        //per-node info is stored compressed sparse row style: node i's entries are from offsets[i] to offsets[i + 1]
+        std::vector<int32_t> m_neighborOffsets;
+        std::vector<int32_t> m_neighbors;
+        std::vector<int32_t> m_edges;//index into the topology edges vector, matched with neighbors
+        std::vector<int32_t> m_tileOffsets;
+        std::vector<int32_t> m_tiles;
+        std::vector<int32_t> m_whichVertex;//stores which tile vertex this node is, matched to m_tiles
         std::vector<TopologyEdgeInfo> m_edgeInfo;
         std::vector<TopologyTileInfo> m_tileInfo;
         std::vector<int32_t> m_boundaryCount;
@@ -122,7 +133,11 @@ namespace caret {
         mutable CaretMutex m_usingMarkNodes;
         bool m_neighborsSorted;
         int32_t m_numNodes, m_maxNeigh;
-        const std::vector<TopologyHelperBase::NodeInfo>& m_nodeInfo;//references for convenience instead of using the m_base pointer
+        const std::vector<int32_t>& m_neighborOffsets;//references for convenience instead of using the m_base pointer
+        const std::vector<int32_t>& m_neighbors;
+        const std::vector<int32_t>& m_edges;
+        const std::vector<int32_t>& m_tileOffsets;
+        const std::vector<int32_t>& m_tiles;
         const std::vector<TopologyEdgeInfo>& m_edgeInfo;
         const std::vector<TopologyTileInfo>& m_tileInfo;
         const std::vector<int32_t>& m_boundaryCount;
@@ -148,14 +163,14 @@ namespace caret {
         int32_t getNodeNumberOfNeighbors(const int32_t nodeNum) const;
 
         /// Get the neighbors of a node
-        const std::vector<int32_t>& getNodeNeighbors(const int32_t nodeNum) const;
+        TopologyIndexSpan getNodeNeighbors(const int32_t nodeNum) const;
 
         /// Get the neighboring nodes for a node.  Returns a pointer to an array
         /// containing the neighbors.
         const int32_t* getNodeNeighbors(const int32_t nodeNum, int32_t& numNeighborsOut) const;
         
         ///get the edges of a node
-        const std::vector<int32_t>& getNodeEdges(const int32_t nodeNum) const;
+        TopologyIndexSpan getNodeEdges(const int32_t nodeNum) const;
 
         /// Get the neighbors to a specified depth
         void getNodeNeighborsToDepth(const int32_t nodeNum,
@@ -169,7 +184,7 @@ namespace caret {
         int32_t getMaximumNumberOfNeighbors() const;
 
         /// Get the tiles used by a node
-        const std::vector<int32_t>& getNodeTiles(const int32_t nodeNum) const;
+        TopologyIndexSpan getNodeTiles(const int32_t nodeNum) const;
 
         /// Get the tiles for a node.  Returns a pointer to an array
         /// containing the tiles.
@@ -22,6 +22,7 @@
 #include <sstream>
 #include <string>
 
+#include <QFileInfo>
 #include <QTemporaryFile>
 
 #include "ApplicationInformation.h"
@@ -53,6 +54,41 @@ using namespace std;
 
 const float VolumeFile::INVALID_INTERP_VALUE = 0.0f;//we may want NaN or something more obvious
 bool VolumeFile::s_voxelColoringEnabled = true;
+bool VolumeFile::s_framesOnDemandEnabled = false;
+int64_t VolumeFile::s_framesOnDemandMemoryBudget = ((int64_t)1) * 1024 * 1024 * 1024;//1GiB per volume
+
+namespace
+{
+    ///reads single-component frames from an open nifti file
+    class NiftiVolumeFrameSource : public VolumeFrameSource
+    {
+        NiftiIO m_io;
+        vector<int64_t> m_extraDims;
+        int m_fullDims;
+    public:
+        NiftiVolumeFrameSource(const AString& filename)
+        {
+            m_io.openRead(filename);
+            vector<int64_t> myDims = m_io.getDimensions();
+            CaretAssert(myDims.size() > 3);//single frame files are never read on demand
+            m_extraDims = vector<int64_t>(myDims.begin() + 3, myDims.end());
+            m_fullDims = 3;
+        }
+        void readFrame(float* frameOut, const int64_t& brickIndex, const int64_t& component)
+        {
+            CaretAssert(component == 0);//multi-component volumes are always read into memory
+            if (component != 0) throw DataFileException("multi-component volumes cannot be read on demand");
+            vector<int64_t> indexSelect(m_extraDims.size());//same order as VolumeBase::getNonSpatialIndexesFromBrickIndex
+            int64_t myRemaining = brickIndex;
+            for (int i = 0; i < (int)m_extraDims.size(); ++i)
+            {
+                indexSelect[i] = myRemaining % m_extraDims[i];
+                myRemaining /= m_extraDims[i];
+            }
+            m_io.readData(frameOut, m_fullDims, indexSelect);//NiftiIO reads are safe from multiple threads
+        }
+    };
+}
 
 /**
  * Static method that sets the status of voxel coloring.  Coloring may take
@@ -74,11 +110,55 @@ VolumeFile::setVoxelColoringEnabled(const bool enabled)
                            : "Volume coloring is disabled."));
 }
 
+/**
+ * Static method that controls whether multi-frame volumes are read one
+ * frame at a time as the frames are used, rather than all at once.  Only
+ * affects files read after it is called.
+ *
+ * @param enabled
+ *    True to read frames on demand for all volume files.
+ * @param memoryBudget
+ *    Bytes of decoded frames to keep in memory for each such volume.
+ */
+void
+VolumeFile::setFramesOnDemand(const bool enabled, const int64_t& memoryBudget)
+{
+    s_framesOnDemandEnabled = enabled;
+    s_framesOnDemandMemoryBudget = memoryBudget;
+    
+    CaretLogConfig(AString(s_framesOnDemandEnabled
+                           ? "Volume frames are read on demand, memory budget " + AString::number(s_framesOnDemandMemoryBudget / (1024 * 1024)) + " MiB."
+                           : "Volume frames are read when the file is opened."));
+}
+
+/**
+ * @return True if all multi-frame volume files read frames on demand.
+ */
+bool
+VolumeFile::isFramesOnDemandEnabled()
+{
+    return s_framesOnDemandEnabled;
+}
+
+/**
+ * Set preference for reading.
+ *
+ * @param prefer
+ *    When true, frames of a multi-frame volume are read from the file
+ *    when they are first used, instead of when the file is read.
+ */
+void
+VolumeFile::setPreferOnDiskReading(const bool& prefer)
+{
+    m_preferOnDiskReading = prefer;
+}
+
 
 VolumeFile::VolumeFile()
 : VolumeBase(), CaretMappableDataFile(DataFileTypeEnum::VOLUME)
 {//CaretPointers initialize to NULL, and this isn't an operator=
     m_forceUpdateOfGroupAndNameHierarchy = true;
+    m_preferOnDiskReading = false;
     for (int32_t i = 0; i < BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_TABS; i++) {
         m_chartingEnabledForTab[i] = false;
     }
@@ -90,6 +170,7 @@ VolumeFile::VolumeFile(const vector<int64_t>& dimensionsIn, const vector<vector<
 : VolumeBase(dimensionsIn, indexToSpace, numComponents), CaretMappableDataFile(DataFileTypeEnum::VOLUME)
 {//CaretPointers initialize to NULL, and this isn't an operator=
     m_forceUpdateOfGroupAndNameHierarchy = true;
+    m_preferOnDiskReading = false;
     for (int32_t i = 0; i < BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_TABS; i++) {
         m_chartingEnabledForTab[i] = false;
     }
@@ -185,6 +266,7 @@ VolumeFile::clear()
     m_fileHistogram.grabNew(NULL);
     m_fileHistorgramLimitedValues.grabNew(NULL);
     
+    m_framesOnDemandFileName = "";
     m_caretVolExt.clear();
     m_brickAttributes.clear();
     m_brickStatisticsValid = false;
@@ -255,10 +337,31 @@ void VolumeFile::readFile(const AString& filename)
                 throw DataFileException(filename, "volume FOV is 1x1x1 voxel, with over 10,000 frames, which suggests a broken cifti file (no header extension)");
             }
         }//this check is also done in reinitialize(), but we don't want to call getSForm before this check when reading a file
-        reinitialize(myDims, inHeader.getSForm(), numComponents);
+        int64_t numFrames = 1;
+        for (int i = 0; i < (int)extraDims.size(); ++i)
+        {
+            numFrames *= extraDims[i];
+        }
+        const bool onDemand = (s_framesOnDemandEnabled || m_preferOnDiskReading) &&
+                              fileToRead == filename &&//the temporary copy of a network file goes away at the end of this function
+                              numComponents == 1 && fullDims == 3 && numFrames > 1;
+        if (onDemand)
+        {//frames are decoded when first used, NiftiIO handles scaling and datatype the same as below
+            clear();
+            VolumeBase::reinitialize(myDims, inHeader.getSForm(), numComponents,
+                                     CaretPointer<VolumeFrameSource>(new NiftiVolumeFrameSource(fileToRead)), s_framesOnDemandMemoryBudget);
+            validateMembers();
+            setType(SubvolumeAttributes::ANATOMY);
+            m_framesOnDemandFileName = fileToRead;
+        } else {
+            reinitialize(myDims, inHeader.getSForm(), numComponents);
+        }
         setFileName(filename);  // must be done after reinitialize() since it calls clear() which clears the name of the file
         int64_t frameSize = myDims[0] * myDims[1] * myDims[2];
-        if (numComponents != 1)
+        if (onDemand)
+        {
+            CaretLogFine("Volume frames of " + filename + " will be read when used");
+        } else if (numComponents != 1)
         {
             vector<float> tempFrame(frameSize), readBuffer(frameSize * numComponents);
             for (MultiDimIterator<int64_t> myiter(extraDims); !myiter.atEnd(); ++myiter)
@@ -327,6 +430,11 @@ VolumeFile::writeFile(const AString& filename)
     }
     checkFileWritability(filename);
     
+    if (isFramesOnDemand() && QFileInfo(filename).absoluteFilePath() == QFileInfo(m_framesOnDemandFileName).absoluteFilePath())
+    {//writing would truncate the file that frames are still being read from
+        loadAllFrames();
+    }
+    
     if (getNumberOfComponents() != 1)
     {
         throw DataFileException(filename,
@@ -1759,14 +1867,18 @@ VolumeFile::getDataRangeFromAllMaps(float& dataRangeMinimumOut,
     m_dataRangeMinimum = std::numeric_limits<float>::max();
     
     const int64_t* dimensions = getDimensionsPtr();
-    int64_t m_dataSize = dimensions[0] * dimensions[1] * dimensions[2] * dimensions[3] * dimensions[4];
-    const float* data = getFrame();//HACK: use first frame knowing all data is contiguous after it
-    for (int64_t i = 0; i < m_dataSize; i++) {
-        if (data[i] > m_dataRangeMaximum) {
-            m_dataRangeMaximum = data[i];
-        }
-        if (data[i] < m_dataRangeMinimum) {
-            m_dataRangeMinimum = data[i];
+    const int64_t frameSize = dimensions[0] * dimensions[1] * dimensions[2];
+    for (int64_t c = 0; c < dimensions[4]; c++) {
+        for (int64_t b = 0; b < dimensions[3]; b++) {
+            const float* data = getFrame(b, c);//frames are not contiguous when read on demand
+            for (int64_t i = 0; i < frameSize; i++) {
+                if (data[i] > m_dataRangeMaximum) {
+                    m_dataRangeMaximum = data[i];
+                }
+                if (data[i] < m_dataRangeMinimum) {
+                    m_dataRangeMinimum = data[i];
+                }
+            }
         }
     }
     
@@ -115,6 +115,12 @@ namespace caret {
         
         mutable float m_dataRangeMaximum;
         
+        /** read frames only when they are used, for this file */
+        bool m_preferOnDiskReading;
+        
+        /** file the frames are read from, when they are read on demand */
+        AString m_framesOnDemandFileName;
+        
         /** Holds class and name hierarchy used for display selection */
         mutable CaretPointer<GroupAndNameHierarchyModel> m_classNameHierarchy;
         
@@ -123,6 +129,12 @@ namespace caret {
         
         CaretPointer<VolumeFileEditorDelegate> m_volumeFileEditorDelegate;
         
+        /** When true, multi-frame volumes read from local files decode each frame on first use */
+        static bool s_framesOnDemandEnabled;
+        
+        /** Bytes of decoded frames kept in memory for each volume read on demand */
+        static int64_t s_framesOnDemandMemoryBudget;
+        
     protected:
         virtual void saveFileDataToScene(const SceneAttributes* sceneAttributes,
                                          SceneClass* sceneClass);
@@ -146,6 +158,10 @@ namespace caret {
         
         static void setVoxelColoringEnabled(const bool enabled);
         
+        static void setFramesOnDemand(const bool enabled, const int64_t& memoryBudget);
+        
+        static bool isFramesOnDemandEnabled();
+        
         VolumeFile();
         VolumeFile(const std::vector<int64_t>& dimensionsIn, const std::vector<std::vector<float> >& indexToSpace, const int64_t numComponents = 1,
                    SubvolumeAttributes::VolumeType whatType = SubvolumeAttributes::ANATOMY, const AbstractHeader* templateHeader = NULL);
@@ -193,6 +209,8 @@ namespace caret {
 
         void writeFile(const AString& filename);
 
+        virtual void setPreferOnDiskReading(const bool& prefer);
+        
         bool isEmpty() const { return VolumeBase::isEmpty(); }
         
         bool hasGoodSpatialInformation() const;
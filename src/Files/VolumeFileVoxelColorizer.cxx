@@ -25,12 +25,12 @@
 
 #include "CaretAssert.h"
 #include "CaretLogger.h"
-#include "ElapsedTimer.h"
 #include "GiftiLabel.h"
 #include "GroupAndNameHierarchyItem.h"
 #include "NodeAndVoxelColoring.h"
 #include "VolumeFile.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace caret;
@@ -40,6 +40,10 @@ using namespace caret;
 /**
  * \class caret::VolumeFileVoxelColorizer 
  * \brief Delegate for coloring a volumes voxels.
+ *
+ * Voxels are colored when they are drawn, an axial slice at a time, rather
+ * than coloring entire maps when their settings change.  The coloring of all
+ * volume files shares a memory budget, releasing least recently used maps.
  */
 
 /**
@@ -63,12 +67,11 @@ VolumeFileVoxelColorizer::VolumeFileVoxelColorizer(VolumeFile* volumeFile)
                                 dimNumberOfComponents);
     
     m_voxelCountPerMap = m_dimI * m_dimJ * m_dimK;
-    m_mapRGBACount = m_voxelCountPerMap * 4;
     
-    for (int64_t i = 0; i < m_mapCount; i++) {
-        m_mapRGBA.push_back(new uint8_t[m_mapRGBACount]);
-        m_mapColoringValid.push_back(false);
-    }
+    m_mapColoring.resize(m_mapCount);
+    
+    CaretMutexLocker locked(&s_cacheMutex);
+    s_allColorizers.insert(this);
 }
 
 /**
@@ -76,14 +79,41 @@ VolumeFileVoxelColorizer::VolumeFileVoxelColorizer(VolumeFile* volumeFile)
  */
 VolumeFileVoxelColorizer::~VolumeFileVoxelColorizer()
 {
-    for (int64_t i = 0; i < m_mapCount; i++) {
-        delete[] m_mapRGBA[i];
+    CaretMutexLocker locked(&s_cacheMutex);
+    for (int32_t i = 0; i < static_cast<int32_t>(m_mapColoring.size()); i++) {
+        releaseMapColoringWithLockHeld(i);
     }
-    m_mapRGBA.clear();
+    s_allColorizers.erase(this);
 }
 
 /**
- * Assign voxel coloring for a map.
+ * Set the memory, in bytes, shared by the voxel coloring of all volume files.
+ * Least recently used maps are released when the coloring needs more memory.
+ *
+ * @param bytes
+ *    Memory budget in bytes.
+ */
+void
+VolumeFileVoxelColorizer::setCacheMemoryBudget(const int64_t& bytes)
+{
+    CaretMutexLocker locked(&s_cacheMutex);
+    s_cacheMemoryBudget = bytes;
+    makeRoomInCache(0, NULL, -1);
+}
+
+/**
+ * @return Memory, in bytes, shared by the voxel coloring of all volume files.
+ */
+int64_t
+VolumeFileVoxelColorizer::getCacheMemoryBudget()
+{
+    return s_cacheMemoryBudget;
+}
+
+/**
+ * Assign voxel coloring for a map.  Voxels are colored, using the
+ * map's current coloring settings, when they are first requested so
+ * any existing coloring of the map is discarded.
  *
  * @param mapIndex
  *     Index of map.
@@ -91,16 +121,66 @@ VolumeFileVoxelColorizer::~VolumeFileVoxelColorizer()
 void
 VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex)
 {
-    CaretAssertVectorIndex(m_mapRGBA, mapIndex);
+    CaretAssertVectorIndex(m_mapColoring, mapIndex);
     
-    ElapsedTimer timer;
-    timer.start();
+    releaseMapColoring(mapIndex);
     
     /*
-     * Pointer to map's data 
+     * Report problems with the coloring settings now rather than
+     * each time a slice is colored.
      */
-    const float* mapDataPointer = m_volumeFile->getFrame(mapIndex);
-    
+    switch (m_volumeFile->getType()) {
+        case SubvolumeAttributes::UNKNOWN:
+        case SubvolumeAttributes::ANATOMY:
+        case SubvolumeAttributes::FUNCTIONAL:
+        {
+            VolumeFile* thresholdVolume = NULL;
+            int32_t thresholdVolumeMapIndex = -1;
+            getThresholdVolume(mapIndex,
+                               thresholdVolume,
+                               thresholdVolumeMapIndex,
+                               true);
+        }
+            break;
+        case SubvolumeAttributes::LABEL:
+            break;
+        case SubvolumeAttributes::RGB:
+        {
+            const int32_t numberOfComponents = m_volumeFile->getNumberOfComponents();
+            if ((numberOfComponents != 3)
+                && (numberOfComponents != 4)) {
+                CaretLogSevere("An RGB/RGBA volume must contain 3 or 4 components per voxel: "
+                               + m_volumeFile->getFileNameNoPath());
+            }
+        }
+            break;
+        case SubvolumeAttributes::SEGMENTATION:
+            break;
+        case SubvolumeAttributes::VECTOR:
+            break;
+    }
+}
+
+/**
+ * Find the volume and map used for thresholding a map.
+ *
+ * @param mapIndex
+ *     Index of map.
+ * @param thresholdVolumeOut
+ *     Output containing the threshold volume.
+ * @param thresholdVolumeMapIndexOut
+ *     Output containing the map index in the threshold volume.
+ * @param logErrorsFlag
+ *     If true, log an invalid threshold volume or map.
+ * @return
+ *     True if the map is thresholded with a valid volume and map.
+ */
+bool
+VolumeFileVoxelColorizer::getThresholdVolume(const int32_t mapIndex,
+                                             VolumeFile*& thresholdVolumeOut,
+                                             int32_t& thresholdVolumeMapIndexOut,
+                                             const bool logErrorsFlag) const
+{
     VolumeFile* thresholdVolume = NULL;
     int32_t thresholdVolumeMapIndex   = -1;
 
@@ -133,38 +213,111 @@ VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex)
         }
     }
     
-    /*
-     * Get access to threshold data
-     */
-    bool ignoreThresholding = true;
-    if (thresholdVolume != NULL) {
-        int64_t threshI, threshJ, threshK, threshMapCount, threshNumberOfComponents;
-        thresholdVolume->getDimensions(threshI,
-                                       threshJ,
-                                       threshK,
-                                       threshMapCount,
-                                       threshNumberOfComponents);
-        if ((threshI != m_dimI)
-            || (threshJ != m_dimJ)
-            || (threshK != m_dimK)) {
+    if (thresholdVolume == NULL) {
+        return false;
+    }
+    
+    int64_t threshI, threshJ, threshK, threshMapCount, threshNumberOfComponents;
+    thresholdVolume->getDimensions(threshI,
+                                   threshJ,
+                                   threshK,
+                                   threshMapCount,
+                                   threshNumberOfComponents);
+    if ((threshI != m_dimI)
+        || (threshJ != m_dimJ)
+        || (threshK != m_dimK)) {
+        if (logErrorsFlag) {
             CaretLogSevere("Threshold volume ("
                            + thresholdVolume->getFileNameNoPath()
                            + ") dimensions do not match "
                            + m_volumeFile->getFileNameNoPath());
         }
-        else if ((thresholdVolumeMapIndex < 0)
-                 || (thresholdVolumeMapIndex >= thresholdVolume->getNumberOfMaps())) {
+        return false;
+    }
+    if ((thresholdVolumeMapIndex < 0)
+        || (thresholdVolumeMapIndex >= thresholdVolume->getNumberOfMaps())) {
+        if (logErrorsFlag) {
             CaretLogSevere("Threshold volume ("
                            + thresholdVolume->getFileNameNoPath()
                            + ") map index="
                            + AString::number(thresholdVolumeMapIndex)
                            + " is invalid");
         }
-        else {
-            ignoreThresholding = false;
-        }
+        return false;
+    }
+    
+    thresholdVolumeOut = thresholdVolume;
+    thresholdVolumeMapIndexOut = thresholdVolumeMapIndex;
+    return true;
+}
+
+/**
+ * Get values of voxels in a frame in consecutive memory.
+ *
+ * @param frame
+ *     Data for a frame.
+ * @param voxelOffsets
+ *     Offsets of the voxels in the frame, if NULL the voxels are
+ *     consecutive starting at firstVoxelOffset.
+ * @param firstVoxelOffset
+ *     Offset of first voxel when voxelOffsets is NULL.
+ * @param numberOfVoxels
+ *     Number of voxels.
+ * @param gatherBuffer
+ *     Used for the values when they are not consecutive in the frame.
+ * @return
+ *     Pointer to the values.
+ */
+static const float*
+getVoxelValues(const float* frame,
+               const int64_t* voxelOffsets,
+               const int64_t firstVoxelOffset,
+               const int64_t numberOfVoxels,
+               std::vector<float>& gatherBuffer)
+{
+    if (voxelOffsets == NULL) {
+        return frame + firstVoxelOffset;
     }
     
+    gatherBuffer.resize(numberOfVoxels);
+    for (int64_t i = 0; i < numberOfVoxels; i++) {
+        gatherBuffer[i] = frame[voxelOffsets[i]];
+    }
+    return &gatherBuffer[0];
+}
+
+/**
+ * Color voxels in a map, without the label display filtering.
+ *
+ * @param mapIndex
+ *     Index of map.
+ * @param voxelOffsets
+ *     Offsets of the voxels in the map, if NULL the voxels are
+ *     consecutive starting at firstVoxelOffset.
+ * @param firstVoxelOffset
+ *     Offset of first voxel when voxelOffsets is NULL.
+ * @param numberOfVoxels
+ *     Number of voxels.
+ * @param rgbaOut
+ *     RGBA for the voxels, in the same order as the voxels.
+ */
+void
+VolumeFileVoxelColorizer::colorVoxels(const int32_t mapIndex,
+                                      const int64_t* voxelOffsets,
+                                      const int64_t firstVoxelOffset,
+                                      const int64_t numberOfVoxels,
+                                      uint8_t* rgbaOut) const
+{
+    if (numberOfVoxels <= 0) {
+        return;
+    }
+    
+    std::fill(rgbaOut,
+              rgbaOut + (numberOfVoxels * 4),
+              0);
+    
+    std::vector<float> dataBuffer;
+    
     switch (m_volumeFile->getType()) {
         case SubvolumeAttributes::UNKNOWN:
         case SubvolumeAttributes::ANATOMY:
@@ -181,9 +334,26 @@ VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex)
             }
             CaretAssert(statistics);
             
+            VolumeFile* thresholdVolume = NULL;
+            int32_t thresholdVolumeMapIndex = -1;
+            const bool ignoreThresholding = ( ! getThresholdVolume(mapIndex,
+                                                                   thresholdVolume,
+                                                                   thresholdVolumeMapIndex,
+                                                                   false));
+            
+            const float* mapDataPointer = getVoxelValues(m_volumeFile->getFrame(mapIndex),
+                                                         voxelOffsets,
+                                                         firstVoxelOffset,
+                                                         numberOfVoxels,
+                                                         dataBuffer);
+            std::vector<float> thresholdBuffer;
             const float* thresholdDataPointer = (ignoreThresholding
                                                  ? mapDataPointer
-                                                 : thresholdVolume->getFrame(thresholdVolumeMapIndex));
+                                                 : getVoxelValues(thresholdVolume->getFrame(thresholdVolumeMapIndex),
+                                                                  voxelOffsets,
+                                                                  firstVoxelOffset,
+                                                                  numberOfVoxels,
+                                                                  thresholdBuffer));
             const PaletteColorMapping* thresholdPaletteColorMapping = (ignoreThresholding
                                                                        ? m_volumeFile->getMapPaletteColorMapping(mapIndex)
                                                                        : thresholdVolume->getMapPaletteColorMapping(thresholdVolumeMapIndex));
@@ -193,20 +363,23 @@ VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex)
                                                           mapDataPointer,
                                                           thresholdPaletteColorMapping,
                                                           thresholdDataPointer,
-                                                          m_voxelCountPerMap,
-                                                          m_mapRGBA[mapIndex],
+                                                          numberOfVoxels,
+                                                          rgbaOut,
                                                           ignoreThresholding);
-            m_mapColoringValid[mapIndex] = true;
         }
             break;
         case SubvolumeAttributes::LABEL:
-            if (m_voxelCountPerMap > 0) {
-                NodeAndVoxelColoring::colorIndicesWithLabelTable(m_volumeFile->getMapLabelTable(mapIndex),
-                                                                 &mapDataPointer[0],
-                                                                 m_voxelCountPerMap,
-                                                                 m_mapRGBA[mapIndex]);
-                m_mapColoringValid[mapIndex] = true;
-            }
+        {
+            const float* mapDataPointer = getVoxelValues(m_volumeFile->getFrame(mapIndex),
+                                                         voxelOffsets,
+                                                         firstVoxelOffset,
+                                                         numberOfVoxels,
+                                                         dataBuffer);
+            NodeAndVoxelColoring::colorIndicesWithLabelTable(m_volumeFile->getMapLabelTable(mapIndex),
+                                                             mapDataPointer,
+                                                             numberOfVoxels,
+                                                             rgbaOut);
+        }
             break;
         case SubvolumeAttributes::RGB:
         {
@@ -214,22 +387,23 @@ VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex)
             const int32_t numberOfComponents = m_volumeFile->getNumberOfComponents();
             if ((numberOfComponents == 3)
                 || (numberOfComponents == 4)) {
-                const float* alphaComponents = ((numberOfComponents == 4)
-                                                ? m_volumeFile->getFrame(mapIndex, 3)
-                                                : NULL);
+                std::vector<float> componentBuffers[4];
+                const float* componentPointers[4] = { NULL, NULL, NULL, NULL };
+                for (int32_t iComp = 0; iComp < numberOfComponents; iComp++) {
+                    componentPointers[iComp] = getVoxelValues(m_volumeFile->getFrame(mapIndex, iComp),
+                                                              voxelOffsets,
+                                                              firstVoxelOffset,
+                                                              numberOfVoxels,
+                                                              componentBuffers[iComp]);
+                }
                 
-                NodeAndVoxelColoring::colorScalarsWithRGBA(m_volumeFile->getFrame(mapIndex, 0),
-                                                           m_volumeFile->getFrame(mapIndex, 1),
-                                                           m_volumeFile->getFrame(mapIndex, 2),
-                                                           alphaComponents,
-                                                           m_voxelCountPerMap,
+                NodeAndVoxelColoring::colorScalarsWithRGBA(componentPointers[0],
+                                                           componentPointers[1],
+                                                           componentPointers[2],
+                                                           componentPointers[3],
+                                                           numberOfVoxels,
                                                            thresholdRGB,
-                                                           m_mapRGBA[mapIndex]);
-                m_mapColoringValid[mapIndex] = true;
-            }
-            else {
-                CaretLogSevere("An RGB/RGBA volume must contain 3 or 4 components per voxel: "
-                               + m_volumeFile->getFileNameNoPath());
+                                                           rgbaOut);
             }
         }
             break;
@@ -238,14 +412,280 @@ VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex)
         case SubvolumeAttributes::VECTOR:
             break;
     }
+}
+
+/**
+ * Color an axial slice of a map into the map's coloring, if it has not
+ * already been colored.  Makes room for the map's coloring by releasing
+ * the coloring of the least recently used maps.
+ *
+ * @param mapIndex
+ *     Index of map.
+ * @param sliceIndex
+ *     Index of the axial slice.
+ */
+void
+VolumeFileVoxelColorizer::colorAxialSlice(const int32_t mapIndex,
+                                          const int64_t sliceIndex) const
+{
+    CaretAssertVectorIndex(m_mapColoring, mapIndex);
+    CaretAssert((sliceIndex >= 0) && (sliceIndex < m_dimK));
+    
+    MapColoring& mapColoring = m_mapColoring[mapIndex];
+    {
+        CaretMutexLocker locked(&s_cacheMutex);
+        mapColoring.m_lastUsed = ++s_cacheUseCounter;
+        
+        if (mapColoring.m_rgba.empty()) {
+            const int64_t bytesNeeded = m_voxelCountPerMap * 4;
+            makeRoomInCache(bytesNeeded,
+                            this,
+                            mapIndex);
+            mapColoring.m_rgba.resize(bytesNeeded);
+            mapColoring.m_axialSliceColored.assign(m_dimK, false);
+            mapColoring.m_slicesColoredCount = 0;
+            s_cacheMemoryUsed += bytesNeeded;
+        }
+    }
+    
+    if ( ! mapColoring.m_axialSliceColored[sliceIndex]) {
+        const int64_t sliceVoxelCount = m_dimI * m_dimJ;
+        colorVoxels(mapIndex,
+                    NULL,
+                    sliceIndex * sliceVoxelCount,
+                    sliceVoxelCount,
+                    &mapColoring.m_rgba[sliceIndex * sliceVoxelCount * 4]);
+        mapColoring.m_axialSliceColored[sliceIndex] = true;
+        ++mapColoring.m_slicesColoredCount;
+    }
+}
+
+/**
+ * Release the coloring of a map.
+ *
+ * @param mapIndex
+ *     Index of map.
+ */
+void
+VolumeFileVoxelColorizer::releaseMapColoring(const int32_t mapIndex) const
+{
+    CaretMutexLocker locked(&s_cacheMutex);
+    releaseMapColoringWithLockHeld(mapIndex);
+}
+
+/**
+ * Release the coloring of a map, the caller must hold the cache mutex.
+ *
+ * @param mapIndex
+ *     Index of map.
+ */
+void
+VolumeFileVoxelColorizer::releaseMapColoringWithLockHeld(const int32_t mapIndex) const
+{
+    CaretAssertVectorIndex(m_mapColoring, mapIndex);
+    MapColoring& mapColoring = m_mapColoring[mapIndex];
+    
+    s_cacheMemoryUsed -= mapColoring.m_rgba.size();
+    std::vector<uint8_t>().swap(mapColoring.m_rgba);
+    mapColoring.m_axialSliceColored.clear();
+    mapColoring.m_slicesColoredCount = 0;
+}
+
+/**
+ * Release the coloring of least recently used maps, in all volume files,
+ * until the given amount of memory fits in the budget or no other maps
+ * are colored.  The caller must hold the cache mutex.
+ *
+ * @param bytesNeeded
+ *     Memory needed.
+ * @param requester
+ *     Colorizer needing the memory (may be NULL).
+ * @param requesterMapIndex
+ *     Map needing the memory, its coloring is never released.
+ */
+void
+VolumeFileVoxelColorizer::makeRoomInCache(const int64_t& bytesNeeded,
+                                          const VolumeFileVoxelColorizer* requester,
+                                          const int32_t requesterMapIndex)
+{
+    while (s_cacheMemoryUsed + bytesNeeded > s_cacheMemoryBudget) {
+        const VolumeFileVoxelColorizer* oldestColorizer = NULL;
+        int32_t oldestMapIndex = -1;
+        int64_t oldestUse = -1;
+        for (std::set<const VolumeFileVoxelColorizer*>::const_iterator iter = s_allColorizers.begin();
+             iter != s_allColorizers.end();
+             iter++) {
+            const VolumeFileVoxelColorizer* colorizer = *iter;
+            const int32_t numMaps = static_cast<int32_t>(colorizer->m_mapColoring.size());
+            for (int32_t iMap = 0; iMap < numMaps; iMap++) {
+                if ((colorizer == requester)
+                    && (iMap == requesterMapIndex)) {
+                    continue;
+                }
+                const MapColoring& mapColoring = colorizer->m_mapColoring[iMap];
+                if (mapColoring.m_rgba.empty()) {
+                    continue;
+                }
+                if ((oldestUse < 0)
+                    || (mapColoring.m_lastUsed < oldestUse)) {
+                    oldestColorizer = colorizer;
+                    oldestMapIndex = iMap;
+                    oldestUse = mapColoring.m_lastUsed;
+                }
+            }
+        }
+        if (oldestColorizer == NULL) {
+            break;//nothing left to release, allow going over budget rather than failing
+        }
+        oldestColorizer->releaseMapColoringWithLockHeld(oldestMapIndex);
+    }
+}
+
+/**
+ * Is the label for a data value displayed in the display group and tab?
+ *
+ * @param labelTable
+ *     Label table of the map.
+ * @param dataValue
+ *     Value of the voxel.
+ * @param displayGroup
+ *    The selected display group.
+ * @param tabIndex
+ *    Index of selected tab.
+ * @return
+ *    False if the label exists and is not selected, otherwise true.
+ */
+bool
+VolumeFileVoxelColorizer::isLabelDisplayed(const GiftiLabelTable* labelTable,
+                                           const float dataValue,
+                                           const DisplayGroupEnum::Enum displayGroup,
+                                           const int32_t tabIndex) const
+{
+    const GiftiLabel* label = labelTable->getLabel(static_cast<int32_t>(dataValue));
+    if (label != NULL) {
+        const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
+        if (item != NULL) {
+            if (item->isSelected(displayGroup, tabIndex) == false) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Get voxel coloring for voxels in a map.  Voxels that are all in one
+ * axial slice are colored a slice at a time and kept in the map's
+ * coloring, other voxels are colored directly unless the entire map
+ * has already been colored.
+ *
+ * @param mapIndex
+ *     Index of map.
+ * @param voxelOffsets
+ *     Offsets of the voxels in the map.
+ * @param displayGroup
+ *    The selected display group.
+ * @param tabIndex
+ *    Index of selected tab.
+ * @param rgbaOut
+ *    RGBA color components out, in the same order as the voxels.
+ * @return
+ *    Number of voxels with alpha greater than zero
+ */
+int64_t
+VolumeFileVoxelColorizer::getVoxelColors(const int32_t mapIndex,
+                                         const std::vector<int64_t>& voxelOffsets,
+                                         const DisplayGroupEnum::Enum displayGroup,
+                                         const int32_t tabIndex,
+                                         uint8_t* rgbaOut) const
+{
+    CaretAssertVectorIndex(m_mapColoring, mapIndex);
+    CaretAssert(rgbaOut);
     
-    CaretLogFine("Time to color map named \""
-                   + m_volumeFile->getMapName(mapIndex)
-                   + " in volume file "
-                   + m_volumeFile->getFileNameNoPath()
-                   + " was "
-                   + AString::number(timer.getElapsedTimeMilliseconds())
-                   + " milliseconds");
+    const int64_t numberOfVoxels = static_cast<int64_t>(voxelOffsets.size());
+    if (numberOfVoxels <= 0) {
+        return 0;
+    }
+    
+    const MapColoring& mapColoring = m_mapColoring[mapIndex];
+    bool useMapColoringFlag = ((m_dimK > 0)
+                               && (mapColoring.m_slicesColoredCount == m_dimK));
+    if ( ! useMapColoringFlag) {
+        const int64_t sliceVoxelCount = m_dimI * m_dimJ;
+        const int64_t sliceIndex = voxelOffsets[0] / sliceVoxelCount;
+        bool oneSliceFlag = true;
+        for (int64_t i = 1; i < numberOfVoxels; i++) {
+            if ((voxelOffsets[i] / sliceVoxelCount) != sliceIndex) {
+                oneSliceFlag = false;
+                break;
+            }
+        }
+        if (oneSliceFlag) {
+            colorAxialSlice(mapIndex,
+                            sliceIndex);
+            useMapColoringFlag = true;
+        }
+    }
+    
+    if (useMapColoringFlag) {
+        {
+            CaretMutexLocker locked(&s_cacheMutex);
+            m_mapColoring[mapIndex].m_lastUsed = ++s_cacheUseCounter;
+        }
+        const uint8_t* mapRGBA = &mapColoring.m_rgba[0];
+        for (int64_t i = 0; i < numberOfVoxels; i++) {
+            const int64_t rgbaOffset = voxelOffsets[i] * 4;
+            CaretAssertVectorIndex(mapColoring.m_rgba, rgbaOffset + 3);
+            const int64_t i4 = i * 4;
+            rgbaOut[i4]   = mapRGBA[rgbaOffset];
+            rgbaOut[i4+1] = mapRGBA[rgbaOffset+1];
+            rgbaOut[i4+2] = mapRGBA[rgbaOffset+2];
+            rgbaOut[i4+3] = mapRGBA[rgbaOffset+3];
+        }
+    }
+    else {
+        colorVoxels(mapIndex,
+                    &voxelOffsets[0],
+                    0,
+                    numberOfVoxels,
+                    rgbaOut);
+    }
+    
+    const GiftiLabelTable* labelTable = (m_volumeFile->isMappedWithLabelTable()
+                                         ? m_volumeFile->getMapLabelTable(mapIndex)
+                                         : NULL);
+    if (m_volumeFile->isMappedWithLabelTable()) {
+        CaretAssert(labelTable);
+    }
+    const float* mapData = ((labelTable != NULL)
+                            ? m_volumeFile->getFrame(mapIndex)
+                            : NULL);
+    
+    int64_t validVoxelCount = 0;
+    for (int64_t i = 0; i < numberOfVoxels; i++) {
+        uint8_t& alpha = rgbaOut[i * 4 + 3];
+        if (alpha > 0) {
+            if (labelTable != NULL) {
+                /*
+                 * For label data, verify that the label is displayed.
+                 * If NOT displayed, zero out the alpha value to
+                 * prevent display of the data.
+                 */
+                if ( ! isLabelDisplayed(labelTable,
+                                        mapData[voxelOffsets[i]],
+                                        displayGroup,
+                                        tabIndex)) {
+                    alpha = 0;
+                }
+            }
+        }
+        
+        if (alpha > 0) {
+            ++validVoxelCount;
+        }
+    }
+    
+    return validVoxelCount;
 }
 
 /**
@@ -254,15 +694,15 @@ VolumeFileVoxelColorizer::assignVoxelColorsForMap(const int32_t mapIndex)
 void
 VolumeFileVoxelColorizer::invalidateColoring()
 {
-    std::fill(m_mapColoringValid.begin(),
-              m_mapColoringValid.end(),
-              false);
+    CaretMutexLocker locked(&s_cacheMutex);
+    for (int32_t i = 0; i < static_cast<int32_t>(m_mapColoring.size()); i++) {
+        releaseMapColoringWithLockHeld(i);
+    }
 }
 
 /**
- * Get voxel coloring for a slice in a map.  If voxel coloring is not ready
- * (it may be running in a different thread) this method will wait until the 
- * coloring is valid prior to returning the slice's coloring.
+ * Get voxel coloring for a slice in a map.  Voxels that have not been
+ * colored are colored using the map's current coloring settings.
  *
  * @param mapIndex
  *     Index of map.
@@ -287,7 +727,7 @@ VolumeFileVoxelColorizer::getVoxelColorsForSliceInMap(const int32_t mapIndex,
                                                       const int32_t tabIndex,
                                                       uint8_t* rgbaOut) const
 {
-    CaretAssertVectorIndex(m_mapRGBA, mapIndex);
+    CaretAssertVectorIndex(m_mapColoring, mapIndex);
     CaretAssert(sliceIndex >= 0);
     CaretAssert(rgbaOut);
     
@@ -315,67 +755,21 @@ VolumeFileVoxelColorizer::getVoxelColorsForSliceInMap(const int32_t mapIndex,
             break;
     }
 
-    /*
-     * Pointer to maps RGBA values
-     */
-    const uint8_t* mapRGBA = m_mapRGBA[mapIndex];
-    
-    const GiftiLabelTable* labelTable = (m_volumeFile->isMappedWithLabelTable()
-                                         ? m_volumeFile->getMapLabelTable(mapIndex)
-                                         : NULL);
-    if (m_volumeFile->isMappedWithLabelTable()) {
-        CaretAssert(labelTable);
-    }
-    
-    int64_t validVoxelCount = 0;
-    
-    /*
-     * Output RGBA values for slice
-     */
-    int64_t rgbaOutIndex = 0;
+    std::vector<int64_t> voxelOffsets;
+    voxelOffsets.reserve((iEnd - iStart + 1) * (jEnd - jStart + 1) * (kEnd - kStart + 1));
     for (int64_t k = kStart; k <= kEnd; k++) {
         for (int64_t j = jStart; j <= jEnd; j++) {
             for (int64_t i = iStart; i <= iEnd; i++) {
-                const int64_t rgbaOffset = getRgbaOffsetForVoxelIndex(i, j, k);
-                CaretAssertArrayIndex(mapRGBA, m_mapRGBACount, rgbaOffset);
-                rgbaOut[rgbaOutIndex]   = mapRGBA[rgbaOffset];
-                rgbaOut[rgbaOutIndex+1] = mapRGBA[rgbaOffset+1];
-                rgbaOut[rgbaOutIndex+2] = mapRGBA[rgbaOffset+2];
-                uint8_t alpha = mapRGBA[rgbaOffset+3];
-                
-                if (alpha > 0) {
-                    if (labelTable != NULL) {
-                        /*
-                         * For label data, verify that the label is displayed.
-                         * If NOT displayed, zero out the alpha value to
-                         * prevent display of the data.
-                         */
-                        const int32_t dataValue = static_cast<int32_t>(m_volumeFile->getValue(i,
-                                                                                              j,
-                                                                                              k,
-                                                                                              mapIndex));
-                        const GiftiLabel* label = labelTable->getLabel(dataValue);
-                        if (label != NULL) {
-                            const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                            if (item != NULL) {
-                                if (item->isSelected(displayGroup, tabIndex) == false) {
-                                    alpha = 0;
-                                }
-                            }
-                        }
-                    }
-                }
-                
-                if (alpha > 0.0) {
-                    ++validVoxelCount;
-                }
-                rgbaOut[rgbaOutIndex+3] = alpha;
-                rgbaOutIndex += 4;
+                voxelOffsets.push_back(getVoxelOffset(i, j, k));
             }
         }
     }
     
-    return validVoxelCount;
+    return getVoxelColors(mapIndex,
+                          voxelOffsets,
+                          displayGroup,
+                          tabIndex,
+                          rgbaOut);
 }
 
 /**
@@ -413,60 +807,15 @@ VolumeFileVoxelColorizer::getVoxelColorsForSliceInMap(const int32_t mapIndex,
                                     const int32_t tabIndex,
                                     uint8_t* rgbaOut) const
 {
-    /*
-     * Pointer to maps RGBA values
-     */
-    const uint8_t* mapRGBA = m_mapRGBA[mapIndex];
-    
-    const GiftiLabelTable* labelTable = (m_volumeFile->isMappedWithLabelTable()
-                                         ? m_volumeFile->getMapLabelTable(mapIndex)
-                                         : NULL);
-    if (m_volumeFile->isMappedWithLabelTable()) {
-        CaretAssert(labelTable);
-    }
-    
-    int64_t validVoxelCount = 0;
-    int64_t rgbaOutIndex = 0;
+    std::vector<int64_t> voxelOffsets;
+    voxelOffsets.reserve(numberOfRows * numberOfColumns);
     
     int64_t rowIJK[3] = { firstVoxelIJK[0], firstVoxelIJK[1], firstVoxelIJK[2] };
     for (int64_t iRow = 0; iRow < numberOfRows; iRow++) {
         
         int64_t ijk[3] = { rowIJK[0], rowIJK[1], rowIJK[2] };
         for (int64_t iCol = 0; iCol < numberOfColumns; iCol++) {
-            const int64_t rgbaOffset = getRgbaOffsetForVoxelIndex(ijk);
-            
-            CaretAssertArrayIndex(mapRGBA, m_mapRGBACount, rgbaOffset);
-            rgbaOut[rgbaOutIndex]   = mapRGBA[rgbaOffset];
-            rgbaOut[rgbaOutIndex+1] = mapRGBA[rgbaOffset+1];
-            rgbaOut[rgbaOutIndex+2] = mapRGBA[rgbaOffset+2];
-            uint8_t alpha = mapRGBA[rgbaOffset+3];
-            
-            if (alpha > 0) {
-                if (labelTable != NULL) {
-                    /*
-                     * For label data, verify that the label is displayed.
-                     * If NOT displayed, zero out the alpha value to
-                     * prevent display of the data.
-                     */
-                    const int32_t dataValue = static_cast<int32_t>(m_volumeFile->getValue(ijk,
-                                                                                          mapIndex));
-                    const GiftiLabel* label = labelTable->getLabel(dataValue);
-                    if (label != NULL) {
-                        const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                        if (item != NULL) {
-                            if (item->isSelected(displayGroup, tabIndex) == false) {
-                                alpha = 0;
-                            }
-                        }
-                    }
-                }
-            }
-            
-            if (alpha > 0.0) {
-                ++validVoxelCount;
-            }
-            rgbaOut[rgbaOutIndex+3] = alpha;
-            rgbaOutIndex += 4;
+            voxelOffsets.push_back(getVoxelOffset(ijk));
             
             ijk[0] += columnStepIJK[0];
             ijk[1] += columnStepIJK[1];
@@ -478,13 +827,16 @@ VolumeFileVoxelColorizer::getVoxelColorsForSliceInMap(const int32_t mapIndex,
         rowIJK[2] += rowStepIJK[2];
     }
     
-    return validVoxelCount;
+    return getVoxelColors(mapIndex,
+                          voxelOffsets,
+                          displayGroup,
+                          tabIndex,
+                          rgbaOut);
 }
 
 /**
- * Get voxel coloring for a sub-slice in a map.  If voxel coloring is not ready
- * (it may be running in a different thread) this method will wait until the
- * coloring is valid prior to returning the slice's coloring.
+ * Get voxel coloring for a sub-slice in a map.  Voxels that have not been
+ * colored are colored using the map's current coloring settings.
  *
  * @param mapIndex
  *     Index of map.
@@ -518,7 +870,7 @@ VolumeFileVoxelColorizer::getVoxelColorsForSubSliceInMap(const int32_t mapIndex,
                                                          const int32_t tabIndex,
                                                          uint8_t* rgbaOut) const
 {
-    CaretAssertVectorIndex(m_mapRGBA, mapIndex);
+    CaretAssertVectorIndex(m_mapColoring, mapIndex);
     CaretAssert(sliceIndex >= 0);
     CaretAssert(rgbaOut);
     
@@ -574,23 +926,9 @@ VolumeFileVoxelColorizer::getVoxelColorsForSubSliceInMap(const int32_t mapIndex,
     CaretUsedInDebugCompileOnly(const int64_t voxelCount = (voxelCountIJK[0] * voxelCountIJK[1] * voxelCountIJK[2]));
     CaretUsedInDebugCompileOnly(const int64_t rgbaCount = voxelCount * 4);
     
-    /*
-     * Pointer to maps RGBA values
-     */
-    const uint8_t* mapRGBA = m_mapRGBA[mapIndex];
-    
-    const GiftiLabelTable* labelTable = (m_volumeFile->isMappedWithLabelTable()
-                                         ? m_volumeFile->getMapLabelTable(mapIndex)
-                                         : NULL);
-    if (m_volumeFile->isMappedWithLabelTable()) {
-        CaretAssert(labelTable);
-    }
-    
-    int64_t validVoxelCount = 0;
-    
     CaretUsedInDebugCompileOnly(int64_t innerCount = std::abs(lastCornerVoxelIndex[innerLoop] - firstCornerVoxelIndex[innerLoop]) + 1);//to check validity of index
     
-    int64_t rgbaOutIndex = 0;
+    std::vector<int64_t> voxelOffsets;
     for (iterijk[outerLoop] = firstCornerVoxelIndex[outerLoop];
          iterijk[outerLoop] != lastCornerVoxelIndex[outerLoop] + incrementijk[outerLoop];
          iterijk[outerLoop] += incrementijk[outerLoop])
@@ -599,52 +937,19 @@ VolumeFileVoxelColorizer::getVoxelColorsForSubSliceInMap(const int32_t mapIndex,
             iterijk[innerLoop] != lastCornerVoxelIndex[innerLoop] + incrementijk[innerLoop];
             iterijk[innerLoop] += incrementijk[innerLoop])
         {
-            CaretAssert(rgbaOutIndex == 4 * (innerCount * std::abs(iterijk[outerLoop] - firstCornerVoxelIndex[outerLoop]) +
+            CaretAssert(static_cast<int64_t>(voxelOffsets.size()) == (innerCount * std::abs(iterijk[outerLoop] - firstCornerVoxelIndex[outerLoop]) +
                         std::abs(iterijk[innerLoop] - firstCornerVoxelIndex[innerLoop])));
-            CaretAssertArrayIndex(rgbaOut, rgbaCount, rgbaOutIndex + 3);
-            
-            const int64_t rgbaOffset = getRgbaOffsetForVoxelIndex(iterijk[0], iterijk[1], iterijk[2]);
-            CaretAssertArrayIndex(mapRGBA, m_mapRGBACount, rgbaOffset);
+            CaretAssertArrayIndex(rgbaOut, rgbaCount, static_cast<int64_t>(voxelOffsets.size()) * 4 + 3);
             
-            rgbaOut[rgbaOutIndex]   = mapRGBA[rgbaOffset];
-            rgbaOut[rgbaOutIndex+1] = mapRGBA[rgbaOffset+1];
-            rgbaOut[rgbaOutIndex+2] = mapRGBA[rgbaOffset+2];
-            uint8_t alpha = mapRGBA[rgbaOffset+3];
-            
-            if (alpha > 0)
-            {
-                if (labelTable != NULL)
-                {
-                    //For label data, verify that the label is displayed.
-                    //If NOT displayed, zero out the alpha value to
-                    //prevent display of the data.
-                    
-                    const int32_t dataValue = static_cast<int32_t>(m_volumeFile->getValue(iterijk, mapIndex));
-                    const GiftiLabel* label = labelTable->getLabel(dataValue);
-                    if (label != NULL)
-                    {
-                        const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                        if (item != NULL)
-                        {
-                            if (item->isSelected(displayGroup, tabIndex) == false)
-                            {
-                                alpha = 0;
-                            }
-                        }
-                    }
-                }
-            }
-            
-            if (alpha > 0.0) {
-                ++validVoxelCount;
-            }
-            rgbaOut[rgbaOutIndex+3] = alpha;
-
-            rgbaOutIndex += 4;
+            voxelOffsets.push_back(getVoxelOffset(iterijk));
         }
     }
 
-    return validVoxelCount;
+    return getVoxelColors(mapIndex,
+                          voxelOffsets,
+                          displayGroup,
+                          tabIndex,
+                          rgbaOut);
 }
 
 /**
@@ -674,13 +979,14 @@ VolumeFileVoxelColorizer::getVoxelColorInMap(const int64_t i,
                                              const int32_t tabIndex,
                                              uint8_t rgbaOut[4]) const
 {
-    /*
-     * Pointer to maps RGBA values
-     */
-    CaretAssertVectorIndex(m_mapRGBA, mapIndex);
-    const uint8_t* mapRGBA = m_mapRGBA[mapIndex];
-    const int64_t rgbaOffset = getRgbaOffsetForVoxelIndex(i, j, k);
-    CaretAssertArrayIndex(mapRGBA, m_mapRGBACount, rgbaOffset);
+    CaretAssertVectorIndex(m_mapColoring, mapIndex);
+    colorAxialSlice(mapIndex,
+                    k);
+    
+    const int64_t voxelOffset = getVoxelOffset(i, j, k);
+    const std::vector<uint8_t>& mapRGBA = m_mapColoring[mapIndex].m_rgba;
+    const int64_t rgbaOffset = voxelOffset * 4;
+    CaretAssertVectorIndex(mapRGBA, rgbaOffset + 3);
     rgbaOut[0] = mapRGBA[rgbaOffset];
     rgbaOut[1] = mapRGBA[rgbaOffset+1];
     rgbaOut[2] = mapRGBA[rgbaOffset+2];
@@ -695,18 +1001,11 @@ VolumeFileVoxelColorizer::getVoxelColorInMap(const int64_t i,
              * If NOT displayed, zero out the alpha value to
              * prevent display of the data.
              */
-            const int32_t dataValue = static_cast<int32_t>(m_volumeFile->getValue(i,
-                                                                                  j,
-                                                                                  k,
-                                                                                  mapIndex));
-            const GiftiLabel* label = labelTable->getLabel(dataValue);
-            if (label != NULL) {
-                const GroupAndNameHierarchyItem* item = label->getGroupNameSelectionItem();
-                if (item != NULL) {
-                    if (item->isSelected(displayGroup, tabIndex) == false) {
-                        alpha = 0;
-                    }
-                }
+            if ( ! isLabelDisplayed(labelTable,
+                                    m_volumeFile->getFrame(mapIndex)[voxelOffset],
+                                    displayGroup,
+                                    tabIndex)) {
+                alpha = 0;
             }
         }
     }
@@ -722,14 +1021,5 @@ VolumeFileVoxelColorizer::getVoxelColorInMap(const int64_t i,
 void
 VolumeFileVoxelColorizer::clearVoxelColoringForMap(const int64_t mapIndex)
 {
-    CaretAssertVectorIndex(m_mapRGBA, mapIndex);
-    uint8_t* mapRGBA = m_mapRGBA[mapIndex];
-    
-    for (int64_t i = 0; i < m_mapRGBACount; i++) {
-        mapRGBA[i] = 0.0;
-    }
-    
-    CaretAssertVectorIndex(m_mapColoringValid, mapIndex);
-    m_mapColoringValid[mapIndex] = false;
+    releaseMapColoring(mapIndex);
 }
-
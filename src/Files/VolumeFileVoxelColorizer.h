@@ -22,12 +22,17 @@
 /*LICENSE_END*/
 
 
+#include <set>
+#include <vector>
+
+#include "CaretMutex.h"
 #include "CaretObject.h"
 #include "DisplayGroupEnum.h"
 #include "VolumeSliceViewPlaneEnum.h"
 
 namespace caret {
 
+    class GiftiLabelTable;
     class VolumeFile;
     
     class VolumeFileVoxelColorizer : public CaretObject {
@@ -78,31 +83,81 @@ namespace caret {
         
         void invalidateColoring();
         
+        static void setCacheMemoryBudget(const int64_t& bytes);
+        
+        static int64_t getCacheMemoryBudget();
+        
     private:
         VolumeFileVoxelColorizer(const VolumeFileVoxelColorizer&);
 
         VolumeFileVoxelColorizer& operator=(const VolumeFileVoxelColorizer&);
         
         /**
-         * Get theRGBA offset for a voxel index
+         * Coloring of one map.  The RGBA buffer is allocated the first time
+         * any of the map's voxels are colored, and is filled in one axial
+         * slice at a time as slices are requested.
+         */
+        class MapColoring {
+        public:
+            MapColoring() : m_slicesColoredCount(0), m_lastUsed(0) { }
+            
+            std::vector<uint8_t> m_rgba;
+            std::vector<bool> m_axialSliceColored;
+            int64_t m_slicesColoredCount;
+            int64_t m_lastUsed;
+        };
+        
+        /**
+         * Get the offset of a voxel in a map's frame
          */
-        inline int64_t getRgbaOffsetForVoxelIndex(const int64_t i,
-                                           const int64_t j,
-                                           const int64_t k) const {
-            return (4 * (i
-                         + (j * m_dimI)
-                         + ((k * m_dimI * m_dimJ))));
+        inline int64_t getVoxelOffset(const int64_t i,
+                                      const int64_t j,
+                                      const int64_t k) const {
+            return (i
+                    + (j * m_dimI)
+                    + ((k * m_dimI * m_dimJ)));
         }
 
         /**
-         * Get theRGBA offset for a voxel index
+         * Get the offset of a voxel in a map's frame
          */
-        inline int64_t getRgbaOffsetForVoxelIndex(const int64_t ijk[3]) const {
-            return (4 * (ijk[0]
-                         + (ijk[1] * m_dimI)
-                         + ((ijk[2] * m_dimI * m_dimJ))));
+        inline int64_t getVoxelOffset(const int64_t ijk[3]) const {
+            return getVoxelOffset(ijk[0], ijk[1], ijk[2]);
         }
         
+        bool getThresholdVolume(const int32_t mapIndex,
+                                VolumeFile*& thresholdVolumeOut,
+                                int32_t& thresholdVolumeMapIndexOut,
+                                const bool logErrorsFlag) const;
+        
+        void colorVoxels(const int32_t mapIndex,
+                         const int64_t* voxelOffsets,
+                         const int64_t firstVoxelOffset,
+                         const int64_t numberOfVoxels,
+                         uint8_t* rgbaOut) const;
+        
+        void colorAxialSlice(const int32_t mapIndex,
+                             const int64_t sliceIndex) const;
+        
+        int64_t getVoxelColors(const int32_t mapIndex,
+                               const std::vector<int64_t>& voxelOffsets,
+                               const DisplayGroupEnum::Enum displayGroup,
+                               const int32_t tabIndex,
+                               uint8_t* rgbaOut) const;
+        
+        bool isLabelDisplayed(const GiftiLabelTable* labelTable,
+                              const float dataValue,
+                              const DisplayGroupEnum::Enum displayGroup,
+                              const int32_t tabIndex) const;
+        
+        void releaseMapColoring(const int32_t mapIndex) const;
+        
+        void releaseMapColoringWithLockHeld(const int32_t mapIndex) const;
+        
+        static void makeRoomInCache(const int64_t& bytesNeeded,
+                                    const VolumeFileVoxelColorizer* requester,
+                                    const int32_t requesterMapIndex);
+        
         // ADD_NEW_MEMBERS_HERE
 
         VolumeFile* m_volumeFile;
@@ -112,14 +167,31 @@ namespace caret {
         int64_t m_dimK;
         int64_t m_voxelCountPerMap;
         int64_t m_mapCount;
-        int64_t m_mapRGBACount;
         
-        std::vector<bool> m_mapColoringValid;
-        std::vector<uint8_t*> m_mapRGBA;
+        mutable std::vector<MapColoring> m_mapColoring;
+        
+        /**
+         * colorizers share one memory budget for their RGBA buffers, coloring is only done from the GUI thread
+         * but colorizers are created and deleted by volume files that are read on worker threads
+         */
+        static std::set<const VolumeFileVoxelColorizer*> s_allColorizers;
+        
+        /** protects the colorizer set, the memory used, and the use counter */
+        static CaretMutex s_cacheMutex;
+        
+        static int64_t s_cacheMemoryBudget;
+        
+        static int64_t s_cacheMemoryUsed;
+        
+        static int64_t s_cacheUseCounter;
     };
     
 #ifdef __VOLUME_FILE_VOXEL_COLORIZER_DECLARE__
-    // <PLACE DECLARATIONS OF STATIC MEMBERS HERE>
+    std::set<const VolumeFileVoxelColorizer*> VolumeFileVoxelColorizer::s_allColorizers;
+    CaretMutex VolumeFileVoxelColorizer::s_cacheMutex;
+    int64_t VolumeFileVoxelColorizer::s_cacheMemoryBudget = ((int64_t)512) * 1024 * 1024;//512MiB shared by all volume files
+    int64_t VolumeFileVoxelColorizer::s_cacheMemoryUsed = 0;
+    int64_t VolumeFileVoxelColorizer::s_cacheUseCounter = 0;
 #endif // __VOLUME_FILE_VOXEL_COLORIZER_DECLARE__
 
 } // namespace
@@ -0,0 +1,230 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "VolumeResamplingHelper.h"
+
+#include "CaretAssert.h"
+#include "CaretException.h"
+#include "CaretOMP.h"
+#include "Vector3D.h"
+#include "VolumeSpline.h"
+
+#include <cmath>
+
+using namespace caret;
+using namespace std;
+
+VolumeResamplingHelper::VolumeResamplingHelper(const VolumeSpace& inSpace, const VolumeSpace& outSpace, const FloatMatrix& targetToSource, const VolumeFile::InterpType& method)
+{
+    int64_t affRows, affColumns;
+    targetToSource.getDimensions(affRows, affColumns);
+    if (affRows < 3 || affRows > 4 || affColumns != 4) throw CaretException("resampling transform is not an affine matrix");
+    setup(inSpace, outSpace, method);
+    Vector3D xvec, yvec, zvec, offset;
+    xvec[0] = targetToSource[0][0]; xvec[1] = targetToSource[1][0]; xvec[2] = targetToSource[2][0];
+    yvec[0] = targetToSource[0][1]; yvec[1] = targetToSource[1][1]; yvec[2] = targetToSource[2][1];
+    zvec[0] = targetToSource[0][2]; zvec[1] = targetToSource[1][2]; zvec[2] = targetToSource[2][2];
+    offset[0] = targetToSource[0][3]; offset[1] = targetToSource[1][3]; offset[2] = targetToSource[2][3];
+    const int64_t* outDims = outSpace.getDims();
+    vector<SliceSources> slices(outDims[2]);
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int64_t k = 0; k < outDims[2]; ++k)
+    {
+        for (int64_t j = 0; j < outDims[1]; ++j)
+        {
+            for (int64_t i = 0; i < outDims[0]; ++i)
+            {
+                Vector3D outCoord, inCoord;
+                outSpace.indexToSpace(i, j, k, outCoord);
+                inCoord = xvec * outCoord[0] + yvec * outCoord[1] + zvec * outCoord[2] + offset;
+                addVoxel(inSpace, outSpace.getIndex(i, j, k), inCoord, slices[k]);
+            }
+        }
+    }
+    concatenate(slices);
+}
+
+VolumeResamplingHelper::VolumeResamplingHelper(const VolumeSpace& inSpace, const VolumeSpace& outSpace, const VolumeFile* warpfield, const VolumeFile::InterpType& method)
+{
+    CaretAssert(warpfield != NULL);
+    if (warpfield->getNumberOfMaps() != 3) throw CaretException("warpfield must have 3 subvolumes");
+    setup(inSpace, outSpace, method);
+    const int64_t* outDims = outSpace.getDims();
+    vector<SliceSources> slices(outDims[2]);
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int64_t k = 0; k < outDims[2]; ++k)
+    {
+        for (int64_t j = 0; j < outDims[1]; ++j)
+        {
+            for (int64_t i = 0; i < outDims[0]; ++i)
+            {
+                Vector3D outCoord, inCoord, displacement;
+                outSpace.indexToSpace(i, j, k, outCoord);
+                bool validDisplacement = false;
+                displacement[0] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, &validDisplacement, 0);
+                if (validDisplacement)
+                {
+                    displacement[1] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, NULL, 1);
+                    displacement[2] = warpfield->interpolateValue(outCoord, VolumeFile::TRILINEAR, NULL, 2);
+                    inCoord = outCoord + displacement;
+                    addVoxel(inSpace, outSpace.getIndex(i, j, k), inCoord, slices[k]);
+                }
+            }
+        }
+    }
+    concatenate(slices);
+}
+
+void VolumeResamplingHelper::setup(const VolumeSpace& inSpace, const VolumeSpace& outSpace, const VolumeFile::InterpType& method)
+{
+    const int64_t* inDims = inSpace.getDims();
+    const int64_t* outDims = outSpace.getDims();
+    m_inDims[0] = inDims[0];
+    m_inDims[1] = inDims[1];
+    m_inDims[2] = inDims[2];
+    m_outFrameSize = outDims[0] * outDims[1] * outDims[2];
+    m_method = method;
+    if (inDims[0] == 1 || inDims[1] == 1 || inDims[2] == 1)
+    {
+        m_method = VolumeFile::ENCLOSING_VOXEL;//same as VolumeFile::interpolateValue, cubic and trilinear need neighbors along every axis
+    }
+}
+
+void VolumeResamplingHelper::addVoxel(const VolumeSpace& inSpace, const int64_t& outIndex, const float inCoord[3], SliceSources& sliceOut) const
+{
+    switch (m_method)
+    {
+        case VolumeFile::ENCLOSING_VOXEL:
+        {
+            int64_t ijk[3];
+            inSpace.enclosingVoxel(inCoord, ijk);
+            if (inSpace.indexValid(ijk))
+            {
+                sliceOut.m_outIndex.push_back(outIndex);
+                sliceOut.m_sourceIndex.push_back(inSpace.getIndex(ijk));
+            }
+            break;
+        }
+        case VolumeFile::TRILINEAR:
+        case VolumeFile::CUBIC:
+        {
+            float indexSpace[3];
+            inSpace.spaceToIndex(inCoord, indexSpace);
+            int64_t low[3] = { (int64_t)floor(indexSpace[0]), (int64_t)floor(indexSpace[1]), (int64_t)floor(indexSpace[2]) };
+            if (!inSpace.indexValid(low[0], low[1], low[2]) || !inSpace.indexValid(low[0] + 1, low[1] + 1, low[2] + 1)) break;//both methods need the surrounding 8 voxels
+            sliceOut.m_outIndex.push_back(outIndex);
+            if (m_method == VolumeFile::TRILINEAR)
+            {
+                sliceOut.m_sourceIndex.push_back(inSpace.getIndex(low));
+                for (int i = 0; i < 3; ++i)
+                {
+                    sliceOut.m_sourceFloats.push_back(indexSpace[i] - low[i]);
+                }
+            } else {
+                for (int i = 0; i < 3; ++i)
+                {
+                    sliceOut.m_sourceFloats.push_back(indexSpace[i]);
+                }
+            }
+            break;
+        }
+    }
+}
+
+void VolumeResamplingHelper::concatenate(vector<SliceSources>& slices)
+{
+    int64_t numValid = 0;
+    for (size_t k = 0; k < slices.size(); ++k)
+    {
+        numValid += (int64_t)slices[k].m_outIndex.size();
+    }
+    m_outIndex.reserve(numValid);
+    if (m_method != VolumeFile::CUBIC) m_sourceIndex.reserve(numValid);
+    if (m_method != VolumeFile::ENCLOSING_VOXEL) m_sourceFloats.reserve(numValid * 3);
+    for (size_t k = 0; k < slices.size(); ++k)
+    {
+        m_outIndex.insert(m_outIndex.end(), slices[k].m_outIndex.begin(), slices[k].m_outIndex.end());
+        m_sourceIndex.insert(m_sourceIndex.end(), slices[k].m_sourceIndex.begin(), slices[k].m_sourceIndex.end());
+        m_sourceFloats.insert(m_sourceFloats.end(), slices[k].m_sourceFloats.begin(), slices[k].m_sourceFloats.end());
+        vector<int64_t>().swap(slices[k].m_outIndex);//release as we go, so the peak memory isn't double the plan
+        vector<int64_t>().swap(slices[k].m_sourceIndex);
+        vector<float>().swap(slices[k].m_sourceFloats);
+    }
+}
+
+bool VolumeResamplingHelper::resampleFrame(const float* inFrame, float* outFrame, const float& invalidVal) const
+{
+    for (int64_t i = 0; i < m_outFrameSize; ++i)
+    {
+        outFrame[i] = invalidVal;
+    }
+    const int64_t numValid = (int64_t)m_outIndex.size();
+    switch (m_method)
+    {
+        case VolumeFile::ENCLOSING_VOXEL:
+        {
+#pragma omp CARET_PARFOR
+            for (int64_t v = 0; v < numValid; ++v)
+            {
+                outFrame[m_outIndex[v]] = inFrame[m_sourceIndex[v]];
+            }
+            return true;
+        }
+        case VolumeFile::TRILINEAR:
+        {
+            const int64_t jstep = m_inDims[0], kstep = m_inDims[0] * m_inDims[1];
+#pragma omp CARET_PARFOR
+            for (int64_t v = 0; v < numValid; ++v)
+            {//same arithmetic as VolumeFile::interpolateValue, so results are identical
+                const float* lowCorner = inFrame + m_sourceIndex[v];
+                const float* weights = m_sourceFloats.data() + v * 3;
+                float xhighWeight = weights[0];
+                float xlowWeight = 1.0f - xhighWeight;
+                float xinterp[2][2];
+                xinterp[0][0] = xlowWeight * lowCorner[0] + xhighWeight * lowCorner[1];
+                xinterp[1][0] = xlowWeight * lowCorner[jstep] + xhighWeight * lowCorner[jstep + 1];
+                xinterp[0][1] = xlowWeight * lowCorner[kstep] + xhighWeight * lowCorner[kstep + 1];
+                xinterp[1][1] = xlowWeight * lowCorner[kstep + jstep] + xhighWeight * lowCorner[kstep + jstep + 1];
+                float yhighWeight = weights[1];
+                float ylowWeight = 1.0f - yhighWeight;
+                float yinterp[2];
+                yinterp[0] = ylowWeight * xinterp[0][0] + yhighWeight * xinterp[1][0];
+                yinterp[1] = ylowWeight * xinterp[0][1] + yhighWeight * xinterp[1][1];
+                float zhighWeight = weights[2];
+                float zlowWeight = 1.0f - zhighWeight;
+                outFrame[m_outIndex[v]] = zlowWeight * yinterp[0] + zhighWeight * yinterp[1];
+            }
+            return true;
+        }
+        case VolumeFile::CUBIC:
+        {
+            if (numValid == 0) return true;
+            VolumeSpline mySpline(inFrame, m_inDims);//deconvolution is parallel unless we are already in a parallel section
+#pragma omp CARET_PARFOR
+            for (int64_t v = 0; v < numValid; ++v)//sample doesn't modify the spline, the old per-voxel loops also shared one spline between threads
+            {
+                outFrame[m_outIndex[v]] = mySpline.sample(m_sourceFloats.data() + v * 3);
+            }
+            return !mySpline.ignoredNonNumeric();
+        }
+    }
+    CaretAssert(false);
+    return true;
+}
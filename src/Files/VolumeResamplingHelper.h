@@ -0,0 +1,65 @@
+#ifndef __VOLUME_RESAMPLING_HELPER_H__
+#define __VOLUME_RESAMPLING_HELPER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+//NOTE: this is for applying the same spatial transform to many frames, where the source location of each output voxel is found once in the constructor,
+//      so each frame is only a pass over the precomputed source voxels - trilinear and enclosing voxel give the same values as VolumeFile::interpolateValue
+//
+//NOTE: this object contains no mutable members, multiple threads can resample different frames with the same instance concurrently
+
+#include "FloatMatrix.h"
+#include "VolumeFile.h"
+#include "VolumeSpace.h"
+
+#include "stdint.h"
+#include <vector>
+
+namespace caret {
+
+    class VolumeResamplingHelper
+    {
+        VolumeFile::InterpType m_method;
+        int64_t m_inDims[3], m_outFrameSize;
+        std::vector<int64_t> m_outIndex;//output voxels that have a valid source location
+        std::vector<int64_t> m_sourceIndex;//per valid output voxel, the source voxel (enclosing voxel) or the lowest corner of the 8 source voxels (trilinear)
+        std::vector<float> m_sourceFloats;//3 per valid output voxel, the high weights along i, j, k (trilinear) or the source index space coordinate (cubic)
+        struct SliceSources
+        {//built per output slice in parallel, then concatenated
+            std::vector<int64_t> m_outIndex, m_sourceIndex;
+            std::vector<float> m_sourceFloats;
+        };
+        void setup(const VolumeSpace& inSpace, const VolumeSpace& outSpace, const VolumeFile::InterpType& method);
+        void addVoxel(const VolumeSpace& inSpace, const int64_t& outIndex, const float inCoord[3], SliceSources& sliceOut) const;
+        void concatenate(std::vector<SliceSources>& slices);
+        VolumeResamplingHelper();
+    public:
+        ///targetToSource maps output coordinates to input coordinates, as a 3x4 or 4x4 affine
+        VolumeResamplingHelper(const VolumeSpace& inSpace, const VolumeSpace& outSpace, const FloatMatrix& targetToSource, const VolumeFile::InterpType& method);
+        ///the warpfield contains the displacement from output coordinate to input coordinate, output voxels outside the warpfield have no valid source
+        VolumeResamplingHelper(const VolumeSpace& inSpace, const VolumeSpace& outSpace, const VolumeFile* warpfield, const VolumeFile::InterpType& method);
+        ///resample one frame of the input space to one frame of the output space, returns false if cubic interpolation ignored non-numeric input values
+        bool resampleFrame(const float* inFrame, float* outFrame, const float& invalidVal = VolumeFile::INVALID_INTERP_VALUE) const;
+    };
+
+}
+
+#endif //__VOLUME_RESAMPLING_HELPER_H__
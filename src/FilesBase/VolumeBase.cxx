@@ -19,6 +19,7 @@
 /*LICENSE_END*/
 
 #include "VolumeBase.h"
+#include "CaretOMP.h"
 #include "DataFileException.h"
 #include "FloatMatrix.h"
 #include "GiftiLabelTable.h"
@@ -28,6 +29,7 @@
 #include "PaletteColorMapping.h"
 #include "Vector3D.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace caret;
@@ -37,7 +39,14 @@ AbstractHeader::~AbstractHeader()
 {
 }
 
-void VolumeBase::reinitialize(const vector<int64_t>& dimensionsIn, const vector<vector<float> >& indexToSpace, const int64_t numComponents)
+VolumeFrameSource::~VolumeFrameSource()
+{
+}
+
+const int64_t VolumeBase::VolumeStorage::RESIDENT_FRAME_MARGIN = 32;//for callers that hold a few frames from different bricks at once
+
+void VolumeBase::reinitialize(const vector<int64_t>& dimensionsIn, const vector<vector<float> >& indexToSpace, const int64_t numComponents,
+                              const CaretPointer<VolumeFrameSource>& frameSource, const int64_t& memoryBudget)
 {
     CaretAssert(numComponents > 0);
     clear();
@@ -64,7 +73,7 @@ void VolumeBase::reinitialize(const vector<int64_t>& dimensionsIn, const vector<
         throw DataFileException("this file doesn't appear to be a volume file");
     }
     storeDims[4] = numComponents;
-    m_storage.reinitialize(storeDims);
+    m_storage.reinitialize(storeDims, frameSource, memoryBudget);
 }
 
 void VolumeBase::addSubvolumes(const int64_t& numToAdd)
@@ -349,6 +358,9 @@ VolumeBase::isEmpty() const
 
 VolumeBase::VolumeStorage::VolumeStorage()
 {
+    m_framesOnDemand = false;
+    m_frameMemoryBudget = 0;
+    m_minResidentFrames = 0;
     for (int i = 0; i < 5; ++i)
     {
         m_dimensions[i] = 0;
@@ -356,8 +368,9 @@ VolumeBase::VolumeStorage::VolumeStorage()
     }
 }
 
-void VolumeBase::VolumeStorage::reinitialize(int64_t dims[5])
+void VolumeBase::VolumeStorage::reinitialize(int64_t dims[5], const CaretPointer<VolumeFrameSource>& frameSource, const int64_t& memoryBudget)
 {
+    resetFrameSource();
     for (int i = 0; i < 5; ++i)
     {
         CaretAssert(dims[i] > 0);//stop the debugger in the right place
@@ -369,21 +382,109 @@ void VolumeBase::VolumeStorage::reinitialize(int64_t dims[5])
     {
         m_mult[i] = m_mult[i - 1] * m_dimensions[i];
     }
-    m_data.resize(m_mult[4]);
+    if (frameSource != NULL)
+    {
+        setFrameSource(frameSource, memoryBudget);//don't allocate the full data at all
+    } else {
+        m_data.resize(m_mult[4]);
+    }
 }
 
 VolumeBase::VolumeStorage::VolumeStorage(int64_t dims[5])
 {
+    m_framesOnDemand = false;
+    m_frameMemoryBudget = 0;
+    m_minResidentFrames = 0;
     reinitialize(dims);
 }
 
 const float* VolumeBase::VolumeStorage::getFrame(const int64_t brickIndex, const int64_t component) const
 {
+    if (m_framesOnDemand)
+    {
+        int64_t whichFrame = component * m_dimensions[3] + brickIndex;
+        {
+            CaretMutexLocker locked(&m_frameMutex);
+            CaretAssertVectorIndex(m_framePointers, whichFrame);
+            const float* ret = m_framePointers[whichFrame];
+            if (ret != NULL) return ret;
+        }
+        return loadFrame(whichFrame);//read without holding the lock
+    }
     return m_data.data() + brickIndex * m_mult[2] + component * m_mult[3];//NOTE: do not use [4]
 }
 
+const float* VolumeBase::VolumeStorage::loadFrame(const int64_t& whichFrame) const
+{
+    CaretArray<float> newFrame(m_mult[2]);
+    m_frameSource->readFrame(newFrame.getArray(), whichFrame % m_dimensions[3], whichFrame / m_dimensions[3]);//read outside the lock so that threads can decode different frames at once
+    CaretMutexLocker locked(&m_frameMutex);
+    if (m_framePointers[whichFrame] != NULL) return m_framePointers[whichFrame];//another thread got there first
+    m_frames[whichFrame] = newFrame;
+    m_framePointers[whichFrame] = newFrame.getArray();
+    m_frameLoadOrder.push_back(whichFrame);
+    int64_t frameBytes = m_mult[2] * sizeof(float);
+    while ((int64_t)m_frameLoadOrder.size() > m_minResidentFrames && (int64_t)m_frameLoadOrder.size() * frameBytes > m_frameMemoryBudget)
+    {
+        int64_t evict = m_frameLoadOrder.front();
+        m_frameLoadOrder.pop_front();
+        m_framePointers[evict] = NULL;
+        m_frames[evict] = CaretArray<float>();
+    }
+    return newFrame.getArray();
+}
+
+void VolumeBase::VolumeStorage::setFrameSource(const CaretPointer<VolumeFrameSource>& source, const int64_t& memoryBudget)
+{
+    CaretAssert(source != NULL);
+    CaretAssert(m_mult[4] > 0);//must have dimensions already
+    int64_t numFrames = m_dimensions[3] * m_dimensions[4];
+    resetFrameSource();
+    vector<float>().swap(m_data);//actually release the memory
+    m_frameSource = source;
+    m_frameMemoryBudget = memoryBudget;
+    int64_t maxThreads = 1;
+#ifdef CARET_OMP
+    maxThreads = max(omp_get_max_threads(), omp_get_num_procs());//this may be called inside a parallel region, where omp_get_max_threads can be 1
+#endif
+    m_minResidentFrames = maxThreads * m_dimensions[4] + RESIDENT_FRAME_MARGIN;//each thread may hold every component of a brick, as the voxel colorizer does
+    m_frames.resize(numFrames);
+    m_framePointers.resize(numFrames, NULL);
+    m_framesOnDemand = true;
+}
+
+void VolumeBase::VolumeStorage::loadAllFrames()
+{
+    if (!m_framesOnDemand) return;
+    vector<float> newData(m_mult[4]);
+    int64_t numFrames = m_dimensions[3] * m_dimensions[4];
+    for (int64_t i = 0; i < numFrames; ++i)
+    {
+        const float* thisFrame = getFrame(i % m_dimensions[3], i / m_dimensions[3]);
+        for (int64_t j = 0; j < m_mult[2]; ++j)
+        {
+            newData[i * m_mult[2] + j] = thisFrame[j];
+        }
+    }
+    resetFrameSource();
+    m_data.swap(newData);
+}
+
+void VolumeBase::VolumeStorage::resetFrameSource()
+{
+    CaretMutexLocker locked(&m_frameMutex);
+    m_framesOnDemand = false;
+    m_frameSource.grabNew(NULL);
+    m_frameMemoryBudget = 0;
+    m_minResidentFrames = 0;
+    m_frames.clear();
+    m_framePointers.clear();
+    m_frameLoadOrder.clear();
+}
+
 void VolumeBase::VolumeStorage::setFrame(const float* frameIn, const int64_t brickIndex, const int64_t component)
 {
+    if (m_framesOnDemand) loadAllFrames();
     int64_t start = brickIndex * m_mult[2] + component * m_mult[3];
     for (int64_t i = 0; i < m_mult[2]; ++i)
     {
@@ -393,6 +494,11 @@ void VolumeBase::VolumeStorage::setFrame(const float* frameIn, const int64_t bri
 
 void VolumeBase::VolumeStorage::setValueAllVoxels(const float value)
 {
+    if (m_framesOnDemand)
+    {//everything gets overwritten, so don't bother reading the frames
+        resetFrameSource();
+        m_data.resize(m_mult[4]);
+    }
     for (int64_t i = 0; i < m_mult[4]; ++i)
     {
         m_data[i] = value;
@@ -401,7 +507,18 @@ void VolumeBase::VolumeStorage::setValueAllVoxels(const float value)
 
 void VolumeBase::VolumeStorage::swap(VolumeStorage& rhs)
 {
+    CaretMutexLocker locked(&m_frameMutex);
+    CaretMutexLocker rhsLocked(&rhs.m_frameMutex);
     m_data.swap(rhs.m_data);
+    std::swap(m_framesOnDemand, rhs.m_framesOnDemand);
+    CaretPointer<VolumeFrameSource> tempSource = m_frameSource;
+    m_frameSource = rhs.m_frameSource;
+    rhs.m_frameSource = tempSource;
+    std::swap(m_frameMemoryBudget, rhs.m_frameMemoryBudget);
+    std::swap(m_minResidentFrames, rhs.m_minResidentFrames);
+    m_frames.swap(rhs.m_frames);
+    m_framePointers.swap(rhs.m_framePointers);
+    m_frameLoadOrder.swap(rhs.m_frameLoadOrder);
     for (int i = 0; i < 5; ++i)
     {
         std::swap(m_dimensions[i], rhs.m_dimensions[i]);
@@ -436,6 +553,7 @@ vector<int64_t> VolumeBase::VolumeStorage::getDimensions() const
 
 void VolumeBase::VolumeStorage::clear()
 {
+    resetFrameSource();
     m_data.clear();
     for (int i = 0; i < 5; ++i)
     {
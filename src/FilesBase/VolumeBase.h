@@ -23,8 +23,10 @@
 /*LICENSE_END*/
 
 #include "stdint.h"
+#include <deque>
 #include <vector>
 #include "CaretAssert.h"
+#include "CaretMutex.h"
 #include "CaretPointer.h"
 #include "VolumeMappableInterface.h"
 #include "VolumeSpace.h"
@@ -44,6 +46,13 @@ namespace caret {
         virtual ~AbstractHeader();
     };
     
+    ///supplies the frames of a volume that is read on demand, readFrame must be safe to call from multiple threads at once
+    struct VolumeFrameSource
+    {
+        virtual void readFrame(float* frameOut, const int64_t& brickIndex, const int64_t& component) = 0;
+        virtual ~VolumeFrameSource();
+    };
+    
     class VolumeBase : public VolumeMappableInterface
     {
         class VolumeStorage
@@ -51,12 +60,24 @@ namespace caret {
             std::vector<float> m_data;
             int64_t m_dimensions[5];//store internally as 4d+component
             int64_t m_mult[5];//precalculated multipliers for getIndex/getValue/setValue - NOTE: [0] is for index[1], [4] is the entire size of the data
+            bool m_framesOnDemand;//when true, m_data is empty and frames are read from m_frameSource when first used
+            CaretPointer<VolumeFrameSource> m_frameSource;
+            int64_t m_frameMemoryBudget;
+            int64_t m_minResidentFrames;//set with the frame source, from the number of threads that can hold a frame at once
+            mutable std::vector<CaretArray<float> > m_frames;//indexed by component * m_dimensions[3] + brick, same order as m_data
+            mutable std::vector<const float*> m_framePointers;//only touched with the mutex held, eviction can happen from any thread
+            mutable std::deque<int64_t> m_frameLoadOrder;//oldest loaded frame is evicted first
+            mutable CaretMutex m_frameMutex;
+            static const int64_t RESIDENT_FRAME_MARGIN;//pointers from getFrame stay valid until one brick of components per thread, plus this many, other frames are loaded
+            const float* loadFrame(const int64_t& whichFrame) const;
+            void setFrameSource(const CaretPointer<VolumeFrameSource>& source, const int64_t& memoryBudget);
+            void resetFrameSource();
             VolumeStorage(const VolumeStorage& rhs);//deny copy, assignment for now
             VolumeStorage& operator=(const VolumeStorage& rhs);
         public:
             VolumeStorage();
             VolumeStorage(int64_t dims[5]);
-            void reinitialize(int64_t dims[5]);
+            void reinitialize(int64_t dims[5], const CaretPointer<VolumeFrameSource>& frameSource = CaretPointer<VolumeFrameSource>(), const int64_t& memoryBudget = 0);
             void clear();
             
             virtual void getDimensions(std::vector<int64_t>& dimOut) const;//NOTE: always returns a vector of 5 elements
@@ -73,6 +94,10 @@ namespace caret {
             inline const float& getValue(const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t brickIndex, const int64_t component) const
             {
                 CaretAssert(indexValid(indexIn1, indexIn2, indexIn3, brickIndex, component));//assert so release version isn't slowed by checking
+                if (m_framesOnDemand)
+                {
+                    return getFrame(brickIndex, component)[indexIn1 + m_mult[0] * indexIn2 + m_mult[1] * indexIn3];
+                }
                 return m_data[getIndex(indexIn1, indexIn2, indexIn3, brickIndex, component)];
             }
             inline const float& getValue(const int64_t indexIn[3], const int64_t brickIndex, const int64_t component) const
@@ -110,6 +135,7 @@ namespace caret {
             inline void setValue(const float& valueIn, const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t brickIndex, const int64_t component)
             {
                 CaretAssert(indexValid(indexIn1, indexIn2, indexIn3, brickIndex, component));//assert so release version isn't slowed by checking
+                if (m_framesOnDemand) loadAllFrames();//any modification makes the whole volume resident
                 m_data[getIndex(indexIn1, indexIn2, indexIn3, brickIndex, component)] = valueIn;
             }
             inline void setValue(const float& valueIn, const int64_t indexIn[3], const int64_t brickIndex, const int64_t component)
@@ -125,6 +151,11 @@ namespace caret {
             
             ///set a frame
             void setFrame(const float* frameIn, const int64_t brickIndex = 0, const int64_t component = 0);
+            
+            ///read any frames not yet read, and stop using the frame source
+            void loadAllFrames();
+            
+            bool isFramesOnDemand() const { return m_framesOnDemand; }
         };
         
         VolumeStorage m_storage;
@@ -135,8 +166,9 @@ namespace caret {
     protected:
         VolumeBase();
         VolumeBase(const std::vector<int64_t>& dimensionsIn, const std::vector<std::vector<float> >& indexToSpace, const int64_t numComponents = 1);
-        ///recreates the volume file storage with new size and spacing
-        void reinitialize(const std::vector<int64_t>& dimensionsIn, const std::vector<std::vector<float> >& indexToSpace, const int64_t numComponents = 1);
+        ///recreates the volume file storage with new size and spacing, if frameSource is given, frames are read from it when first used, keeping roughly memoryBudget bytes of them
+        void reinitialize(const std::vector<int64_t>& dimensionsIn, const std::vector<std::vector<float> >& indexToSpace, const int64_t numComponents = 1,
+                          const CaretPointer<VolumeFrameSource>& frameSource = CaretPointer<VolumeFrameSource>(), const int64_t& memoryBudget = 0);
         
         void addSubvolumes(const int64_t& numToAdd);
         
@@ -308,9 +340,15 @@ namespace caret {
             return 0.0;
         }
         
-        ///get a frame (const)
+        ///get a frame (const) - when frames are read on demand, the pointer stays valid only until several more frames have been loaded, so use it before getting many other frames
         const float* getFrame(const int64_t brickIndex = 0, const int64_t component = 0) const { return m_storage.getFrame(brickIndex, component); }
         
+        ///true if frames are read from the file only when they are used
+        bool isFramesOnDemand() const { return m_storage.isFramesOnDemand(); }
+        
+        ///read all frames into memory, if they are being read on demand (modifying any voxel does this automatically)
+        void loadAllFrames() { m_storage.loadAllFrames(); }
+        
         ///set a value at an index triplet and optionally timepoint
         inline void setValue(const float& valueIn, const int64_t* indexIn, const int64_t brickIndex = 0, const int64_t component = 0)
         {
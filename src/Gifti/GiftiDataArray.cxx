@@ -577,9 +577,12 @@ GiftiDataArray::transferLabelIndices(const std::map<int32_t,int32_t>& indexConve
 /**
  * read a GIFTI data array from text.
  * Data array should already be initialized and allocated.
+ * The text is the UTF-8 content of the Data element and
+ * does not need to be null terminated.
  */
 void 
-GiftiDataArray::readFromText(const AString text,
+GiftiDataArray::readFromText(const char* text,
+                             const int64_t textLength,
                              const GiftiEndianEnum::Enum dataEndianForReading,
                              const GiftiArrayIndexingOrderEnum::Enum arraySubscriptingOrderForReading,
                              const NiftiDataTypeEnum::Enum dataTypeForReading,
@@ -613,7 +616,7 @@ GiftiDataArray::readFromText(const AString text,
       switch (encoding) {
           case GiftiEncodingEnum::ASCII:
             {
-                std::istringstream stream(text.toStdString());
+                std::istringstream stream(std::string(text, textLength));
                 
                switch (dataType) {
                   case NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32:
@@ -653,12 +656,13 @@ GiftiDataArray::readFromText(const AString text,
           case GiftiEncodingEnum::BASE64_BINARY:
             {
                //
-               // Decode the Base64 data using VTK's algorithm
+               // Decode the Base64 text directly into the data
                //
                const uint64_t numDecoded =
-                     Base64::decode((const unsigned char*)(text.toStdString().c_str()),
-                                                data.size(),
-                                                &data[0]);
+                     Base64::decodeText(text,
+                                        textLength,
+                                        &data[0],
+                                        data.size());
                if (numDecoded != data.size()) {
                   std::ostringstream str;
                   str << "Decoding of Base64 Binary data failed.\n"
@@ -678,14 +682,16 @@ GiftiDataArray::readFromText(const AString text,
           case GiftiEncodingEnum::GZIP_BASE64_BINARY:
             {
                //
-               // Decode the Base64 data using VTK's algorithm
+               // Decode the Base64 text.  The buffer is sized from the
+               // text since compressed data may be larger than the
+               // uncompressed data.
                //
-               unsigned char* dataBuffer = new unsigned char[data.size()];
-               //const char* textChars = text.toLatin1().constData();
+               std::vector<unsigned char> dataBuffer((textLength / 4) * 3 + 3);
                const uint64_t numDecoded =
-                     Base64::decode((unsigned char*)text.toStdString().c_str(),
-                                                data.size(),
-                                                dataBuffer);
+                     Base64::decodeText(text,
+                                        textLength,
+                                        &dataBuffer[0],
+                                        dataBuffer.size());
                if (numDecoded == 0) {
                    std::ostringstream str;
                    str << "Decoding of GZip Base64 Binary data failed."
@@ -694,13 +700,12 @@ GiftiDataArray::readFromText(const AString text,
                    throw GiftiException(AString::fromStdString(str.str()));
                }
                
-               
                //
-               // Uncompress the data using VTK's algorithm
+               // Uncompress directly into the data
                // 
                 DataCompressZLib compressor;
                 const uint64_t uncompressedDataLength = 
-                                   compressor.uncompressData(dataBuffer,
+                                   compressor.uncompressData(&dataBuffer[0],
                                                           numDecoded,
                                                           (unsigned char*)&data[0],
                                                           data.size());
@@ -712,11 +717,6 @@ GiftiDataArray::readFromText(const AString text,
                   throw GiftiException(AString::fromStdString(str.str()));
                }
                
-               //
-               // Free memory
-               //
-               delete[] dataBuffer;
-               
                //
                // Is byte swapping needed ? 
                //
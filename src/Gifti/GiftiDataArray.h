@@ -113,7 +113,8 @@ namespace caret {
         //int64_t getDataOffset(const int64_t nodeNum, const int64_t componentNum) const;//TSC: implementation was wrong, commenting out for now
         
         // read a data array from text
-        void readFromText(const AString text,
+        void readFromText(const char* text,
+                          const int64_t textLength,
                           const GiftiEndianEnum::Enum dataEndianForReading,
                           const GiftiArrayIndexingOrderEnum::Enum arraySubscriptingOrderForReading,
                           const NiftiDataTypeEnum::Enum dataTypeForReading,
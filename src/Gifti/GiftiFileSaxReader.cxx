@@ -18,9 +18,11 @@
  */
 /*LICENSE_END*/
 
+#include <new>
 #include <sstream>
 
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "FileInformation.h"
 #include "GiftiEndianEnum.h"
 #include "GiftiLabel.h"
@@ -36,6 +38,8 @@
 
 using namespace caret;
 
+const int64_t GiftiFileSaxReader::MAX_ARRAY_TEXT_BYTES_TO_DECODE = ((int64_t)256) * 1024 * 1024;
+
 /**
  * constructor.
  */
@@ -50,6 +54,7 @@ GiftiFileSaxReader::GiftiFileSaxReader(GiftiFile* giftiFileIn)
     this->labelTableSaxReader = NULL;
     this->metaDataSaxReader = NULL;
     this->dataArrayDataHasBeenRead = false;
+    this->arrayDataToDecodeBytes = 0;
 }
 
 /**
@@ -508,6 +513,9 @@ GiftiFileSaxReader::createDataArray(const XmlAttributes& attributes)
 
 /**
  * process the array data into numbers.
+ * The data is saved and decoded, with the data of other arrays,
+ * when there is one array for each thread or the saved text
+ * is large, and at the end of the document.
  */
 void 
 GiftiFileSaxReader::processArrayData()
@@ -515,19 +523,79 @@ GiftiFileSaxReader::processArrayData()
     this->dataArrayDataHasBeenRead = true;
 
     CaretAssert(dataArray);
-    try {
-        dataArray->readFromText(elementText,
-                                this->endianForReadingArrayData,
-                                arraySubscriptingOrderForReadingArrayData,
-                                dataTypeForReadingArrayData,
-                                dimensionsForReadingArrayData,
-                                encodingForReadingArrayData,
-                                externalFileNameForReadingData,
-                                externalFileOffsetForReadingData,
-                                this->giftiFile->getReadMetaDataOnlyFlag());
+    
+    /*
+     * Swap so that the (possibly very large) text is not copied
+     */
+    arrayDataToDecode.push_back(ArrayDataToDecode());
+    ArrayDataToDecode& add = arrayDataToDecode.back();
+    add.dataArray = dataArray.getPointer();
+    add.text.swap(dataArrayText);
+    add.endian = this->endianForReadingArrayData;
+    add.arraySubscriptingOrder = arraySubscriptingOrderForReadingArrayData;
+    add.dataType = dataTypeForReadingArrayData;
+    add.dimensions = dimensionsForReadingArrayData;
+    add.encoding = encodingForReadingArrayData;
+    add.externalFileName = externalFileNameForReadingData;
+    add.externalFileOffset = externalFileOffsetForReadingData;
+    
+    dataArrayText.clear();
+    
+    arrayDataToDecodeBytes += static_cast<int64_t>(add.text.size());
+    int64_t batchSize = 1;
+#ifdef CARET_OMP
+    batchSize = omp_get_max_threads();
+#endif // CARET_OMP
+    if ((static_cast<int64_t>(arrayDataToDecode.size()) >= batchSize)
+        || (arrayDataToDecodeBytes >= MAX_ARRAY_TEXT_BYTES_TO_DECODE)) {
+        decodeArrayData();
     }
-    catch (const GiftiException& e) {
-        throw XmlSaxParserException(e.whatString());
+}
+
+/**
+ * decode the array data of the data arrays that are waiting.  Data
+ * arrays are independent so they are decoded in parallel.
+ */
+void
+GiftiFileSaxReader::decodeArrayData()
+{
+    const bool metaDataOnlyFlag = this->giftiFile->getReadMetaDataOnlyFlag();
+    const int64_t numArrays = static_cast<int64_t>(arrayDataToDecode.size());
+    std::vector<AString> errorMessages(numArrays);
+    
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int64_t i = 0; i < numArrays; i++) {
+        ArrayDataToDecode& add = arrayDataToDecode[i];
+        try {
+            add.dataArray->readFromText(add.text.data(),
+                                        add.text.size(),
+                                        add.endian,
+                                        add.arraySubscriptingOrder,
+                                        add.dataType,
+                                        add.dimensions,
+                                        add.encoding,
+                                        add.externalFileName,
+                                        add.externalFileOffset,
+                                        metaDataOnlyFlag);
+        }
+        catch (const CaretException& e) {
+            errorMessages[i] = e.whatString();
+        }
+        catch (const std::bad_alloc&) {
+            errorMessages[i] = ("Out of memory decoding data array "
+                                + AString::number(i));
+        }
+        
+        std::string().swap(add.text);
+    }
+    
+    arrayDataToDecode.clear();
+    arrayDataToDecodeBytes = 0;
+    
+    for (int64_t i = 0; i < numArrays; i++) {
+        if ( ! errorMessages[i].isEmpty()) {
+            throw XmlSaxParserException(errorMessages[i]);
+        }
     }
 }
 
@@ -543,6 +611,14 @@ GiftiFileSaxReader::characters(const char* ch)
     else if (this->labelTableSaxReader != NULL) {
         this->labelTableSaxReader->characters(ch);
     }
+    else if (this->state == STATE_DATA_ARRAY_DATA) {
+        /*
+         * Keep the array data as UTF-8, it is decoded from these bytes
+         */
+        if ( ! this->giftiFile->getReadMetaDataOnlyFlag()) {
+            dataArrayText.append(ch);
+        }
+    }
     else {
         elementText += ch;
     }
@@ -594,5 +670,6 @@ GiftiFileSaxReader::startDocument()
 void 
 GiftiFileSaxReader::endDocument()
 {
+    decodeArrayData();
 }
 
@@ -23,6 +23,8 @@
 /*LICENSE_END*/
 
 #include <stack>
+#include <string>
+#include <vector>
 #include <AString.h>
 #include <stdint.h>
 
@@ -103,6 +105,9 @@ namespace caret {
         // process the array data into numbers
         void processArrayData();
         
+        // decode the array data of all data arrays
+        void decodeArrayData();
+        
         // create a data array
         void createDataArray(const XmlAttributes& attributes);
         
@@ -162,6 +167,32 @@ namespace caret {
         
         /// tracks if data has been read since external binary may not have DATA tag
         bool dataArrayDataHasBeenRead;
+        
+        /// raw UTF-8 text of the Data element being read
+        std::string dataArrayText;
+        
+        /// array data saved while parsing and decoded, in parallel, a batch at a time
+        class ArrayDataToDecode {
+        public:
+            GiftiDataArray* dataArray;
+            std::string text;
+            GiftiEndianEnum::Enum endian;
+            GiftiArrayIndexingOrderEnum::Enum arraySubscriptingOrder;
+            NiftiDataTypeEnum::Enum dataType;
+            std::vector<int64_t> dimensions;
+            GiftiEncodingEnum::Enum encoding;
+            AString externalFileName;
+            int64_t externalFileOffset;
+        };
+        
+        /// array data waiting to be decoded
+        std::vector<ArrayDataToDecode> arrayDataToDecode;
+        
+        /// bytes of text in arrayDataToDecode
+        int64_t arrayDataToDecodeBytes;
+        
+        /// decode the waiting arrays once their text reaches this many bytes, so a large file is never held entirely as text
+        static const int64_t MAX_ARRAY_TEXT_BYTES_TO_DECODE;
     };
 
 } // namespace
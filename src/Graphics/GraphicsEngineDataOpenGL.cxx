@@ -97,6 +97,16 @@ GraphicsEngineDataOpenGL::invalidateColors()
     m_reloadColorsFlag = true;
 }
 
+/**
+ * Invalidate the vertex indices after they have
+ * changed in the graphics primitive.
+ */
+void
+GraphicsEngineDataOpenGL::invalidateVertexIndices()
+{
+    m_reloadVertexIndicesFlag = true;
+}
+
 /**
  * Get the OpenGL Buffer Usage Hint from the primitive.
  *
@@ -238,9 +248,15 @@ GraphicsEngineDataOpenGL::loadColorBuffer(GraphicsPrimitive* primitive)
             break;
         case GraphicsPrimitive::ColorDataType::FLOAT_RGBA:
         {
-            EventGraphicsOpenGLCreateBufferObject createEvent;
-            EventManager::get()->sendEvent(createEvent.getPointer());
-            m_colorBufferObject.reset(createEvent.getOpenGLBufferObject());
+            /*
+             * Color buffer may have been created.
+             * Colors may change but the number of colors does not change.
+             */
+            if (m_colorBufferObject == NULL) {
+                EventGraphicsOpenGLCreateBufferObject createEvent;
+                EventManager::get()->sendEvent(createEvent.getPointer());
+                m_colorBufferObject.reset(createEvent.getOpenGLBufferObject());
+            }
             CaretAssert(m_colorBufferObject->getBufferObjectName());
             
             m_componentsPerColor = 4;
@@ -260,9 +276,11 @@ GraphicsEngineDataOpenGL::loadColorBuffer(GraphicsPrimitive* primitive)
             break;
         case GraphicsPrimitive::ColorDataType::UNSIGNED_BYTE_RGBA:
         {
-            EventGraphicsOpenGLCreateBufferObject createEvent;
-            EventManager::get()->sendEvent(createEvent.getPointer());
-            m_colorBufferObject.reset(createEvent.getOpenGLBufferObject());
+            if (m_colorBufferObject == NULL) {
+                EventGraphicsOpenGLCreateBufferObject createEvent;
+                EventManager::get()->sendEvent(createEvent.getPointer());
+                m_colorBufferObject.reset(createEvent.getOpenGLBufferObject());
+            }
             CaretAssert(m_colorBufferObject->getBufferObjectName());
             
             m_componentsPerColor = 4;
@@ -324,6 +342,48 @@ GraphicsEngineDataOpenGL::loadTextureCoordinateBuffer(GraphicsPrimitive* primiti
     }    
 }
 
+/**
+ * Load the vertex indices buffer.
+ *
+ * @param primitive
+ *     The graphics primitive that will be drawn.
+ */
+void
+GraphicsEngineDataOpenGL::loadVertexIndicesBuffer(GraphicsPrimitive* primitive)
+{
+    CaretAssert(primitive);
+    
+    m_vertexIndicesCount = primitive->m_vertexIndices.size();
+    if (m_vertexIndicesCount > 0) {
+        if (m_vertexIndicesBufferObject == NULL) {
+            EventGraphicsOpenGLCreateBufferObject createEvent;
+            EventManager::get()->sendEvent(createEvent.getPointer());
+            m_vertexIndicesBufferObject.reset(createEvent.getOpenGLBufferObject());
+        }
+        CaretAssert(m_vertexIndicesBufferObject->getBufferObjectName());
+        
+        const GLuint indicesSizeBytes = m_vertexIndicesCount * sizeof(uint32_t);
+        const GLvoid* indicesDataPointer = (const GLvoid*)&primitive->m_vertexIndices[0];
+        
+        /*
+         * Indices are only changed when the primitive's topology changes
+         */
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                     m_vertexIndicesBufferObject->getBufferObjectName());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                     indicesSizeBytes,
+                     indicesDataPointer,
+                     GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                     0);
+    }
+    else {
+        m_vertexIndicesBufferObject.reset();
+    }
+    
+    m_reloadVertexIndicesFlag = false;
+}
+
 
 /**
  * Load the buffers with data from the grpahics primitive.
@@ -338,6 +398,7 @@ GraphicsEngineDataOpenGL::loadAllBuffers(GraphicsPrimitive* primitive)
     loadNormalVectorBuffer(primitive);
     loadColorBuffer(primitive);
     loadTextureCoordinateBuffer(primitive);    
+    loadVertexIndicesBuffer(primitive);
 }
 
 /**
@@ -384,6 +445,13 @@ GraphicsEngineDataOpenGL::loadTextureImageDataBuffer(GraphicsPrimitive* primitiv
             glBindTexture(GL_TEXTURE_2D, openGLTextureName);
             
             bool useMipMapFlag = true;
+            switch (primitive->getTextureFilteringType()) {
+                case GraphicsPrimitive::TextureFilteringType::LINEAR:
+                    break;
+                case GraphicsPrimitive::TextureFilteringType::NEAREST:
+                    useMipMapFlag = false;
+                    break;
+            }
             if (useMipMapFlag) {
                 glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
                 glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
@@ -427,7 +495,7 @@ GraphicsEngineDataOpenGL::loadTextureImageDataBuffer(GraphicsPrimitive* primitiv
             }
             
             if ( ! useMipMapFlag) {
-                CaretAssert(0);   // image must be 2^N by 2^M
+                CaretAssert(primitive->getTextureFilteringType() == GraphicsPrimitive::TextureFilteringType::NEAREST);   // image must be 2^N by 2^M
                 glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
                 glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
                 glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -957,6 +1025,13 @@ GraphicsEngineDataOpenGL::drawPrivate(const PrivateDrawMode drawMode,
         if (openglData->m_reloadColorsFlag) {
             openglData->loadColorBuffer(primitive);
         }
+        
+        /*
+         * Vertex indices may get updated
+         */
+        if (openglData->m_reloadVertexIndicesFlag) {
+            openglData->loadVertexIndicesBuffer(primitive);
+        }
     }
     
     openglData->loadTextureImageDataBuffer(primitive);
@@ -1129,7 +1204,23 @@ GraphicsEngineDataOpenGL::drawPrivate(const PrivateDrawMode drawMode,
     }
     
     CaretAssert(openGLPrimitiveType != GL_INVALID_ENUM);
-    glDrawArrays(openGLPrimitiveType, 0, openglData->m_arrayIndicesCount);
+    if (openglData->m_vertexIndicesCount > 0) {
+        /*
+         * Vertices are shared so draw using the vertex indices
+         */
+        CaretAssert(glIsBuffer(openglData->m_vertexIndicesBufferObject->getBufferObjectName()));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                     openglData->m_vertexIndicesBufferObject->getBufferObjectName());
+        glDrawElements(openGLPrimitiveType,
+                       openglData->m_vertexIndicesCount,
+                       GL_UNSIGNED_INT,
+                       (GLvoid*)0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                     0);
+    }
+    else {
+        glDrawArrays(openGLPrimitiveType, 0, openglData->m_arrayIndicesCount);
+    }
     
     /*
      * Disable drawing
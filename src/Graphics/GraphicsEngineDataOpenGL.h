@@ -56,6 +56,8 @@ namespace caret {
         
         void invalidateColors();
         
+        void invalidateVertexIndices();
+        
         // ADD_NEW_METHODS_HERE
 
     private:
@@ -78,6 +80,8 @@ namespace caret {
         
         void loadTextureCoordinateBuffer(GraphicsPrimitive* primitive);
         
+        void loadVertexIndicesBuffer(GraphicsPrimitive* primitive);
+        
         void loadTextureImageDataBuffer(GraphicsPrimitive* primitive);
         
         static void drawPrivate(const PrivateDrawMode drawMode,
@@ -116,6 +120,8 @@ namespace caret {
         
         bool m_reloadColorsFlag = false;
         
+        bool m_reloadVertexIndicesFlag = false;
+        
         std::unique_ptr<GraphicsOpenGLBufferObject> m_normalVectorBufferObject;
         
         GLenum m_normalVectorDataType = GL_FLOAT;
@@ -132,6 +138,10 @@ namespace caret {
         
         GraphicsOpenGLTextureName* m_textureImageDataName = NULL;
         
+        std::unique_ptr<GraphicsOpenGLBufferObject> m_vertexIndicesBufferObject;
+        
+        GLsizei m_vertexIndicesCount = 0;
+        
 // ADD_NEW_MEMBERS_HERE
 
     };
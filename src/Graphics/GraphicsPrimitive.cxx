@@ -23,6 +23,8 @@
 #include "GraphicsPrimitive.h"
 #undef __GRAPHICS_PRIMITIVE_DECLARE__
 
+#include <algorithm>
+
 #include "BoundingBox.h"
 #include "CaretAssert.h"
 #include "CaretLogger.h"
@@ -32,6 +34,7 @@
 #include "GraphicsPrimitiveV3fC4f.h"
 #include "GraphicsPrimitiveV3fC4ub.h"
 #include "GraphicsPrimitiveV3fN3f.h"
+#include "GraphicsPrimitiveV3fN3fC4f.h"
 #include "GraphicsPrimitiveV3fT3f.h"
 
 using namespace caret;
@@ -131,6 +134,8 @@ GraphicsPrimitive::copyHelperGraphicsPrimitive(const GraphicsPrimitive& obj)
     m_textureImageBytesRGBA       = obj.m_textureImageBytesRGBA;
     m_textureImageWidth           = obj.m_textureImageWidth;
     m_textureImageHeight          = obj.m_textureImageHeight;
+    m_textureFilteringType        = obj.m_textureFilteringType;
+    m_vertexIndices               = obj.m_vertexIndices;
 
     m_graphicsEngineDataForOpenGL.reset();
 }
@@ -1088,7 +1093,64 @@ GraphicsPrimitive::replaceAllVertexSolidFloatRGBA(const float rgba[4])
     }
 }
 
+/**
+ * Replace the float RGBA coloring of all vertices.  If the new coloring
+ * is identical to the existing coloring, the colors are not invalidated
+ * so that the graphics engine does not reload them.
+ *
+ * @param rgbaArray
+ *     RGBA values for all vertices, four per vertex
+ */
+void
+GraphicsPrimitive::replaceAllVertexFloatRGBA(const float rgbaArray[])
+{
+    switch (m_colorDataType) {
+        case ColorDataType::NONE:
+            CaretAssert(0);
+            break;
+        case ColorDataType::FLOAT_RGBA:
+        {
+            CaretAssert(rgbaArray);
+            if (std::equal(m_floatRGBA.begin(),
+                           m_floatRGBA.end(),
+                           rgbaArray)) {
+                return;
+            }
+            std::copy(rgbaArray,
+                      rgbaArray + m_floatRGBA.size(),
+                      m_floatRGBA.begin());
+        }
+            break;
+        case ColorDataType::UNSIGNED_BYTE_RGBA:
+            CaretAssertMessage(0, "Replacing float RGBA in primitive but coloring type is Byte");
+            CaretLogWarning("Replacing float RGBA in primitive but coloring type is Byte");
+            break;
+    }
+    
+    if (m_graphicsEngineDataForOpenGL != NULL) {
+        m_graphicsEngineDataForOpenGL->invalidateColors();
+    }
+}
 
+/**
+ * Set the indices of the vertices used for drawing.  Each index refers
+ * to a vertex so that vertices shared by many triangles (or lines)
+ * are only stored once.  Vertex indices are supported for the OPENGL
+ * primitive types but are ignored by the POLYGONAL and SPHERES types.
+ *
+ * @param vertexIndices
+ *     Indices of the vertices, an empty vector draws vertices in the
+ *     order they were added.
+ */
+void
+GraphicsPrimitive::setVertexIndices(const std::vector<uint32_t>& vertexIndices)
+{
+    m_vertexIndices = vertexIndices;
+    
+    if (m_graphicsEngineDataForOpenGL != NULL) {
+        m_graphicsEngineDataForOpenGL->invalidateVertexIndices();
+    }
+}
 
 
 /**
@@ -1550,6 +1612,20 @@ GraphicsPrimitive::newPrimitiveV3f(const GraphicsPrimitive::PrimitiveType primit
     return primitive;
 }
 
+/**
+ * @return A new primitive for XYZ with normal vectors and float RGBA.  Caller
+ * is responsible for deleting the returned pointer.
+ *
+ * @param primitiveType
+ *     Type of primitive drawn (triangles, lines, etc.)
+ */
+GraphicsPrimitiveV3fN3fC4f*
+GraphicsPrimitive::newPrimitiveV3fN3fC4f(const GraphicsPrimitive::PrimitiveType primitiveType)
+{
+    GraphicsPrimitiveV3fN3fC4f* primitive = new GraphicsPrimitiveV3fN3fC4f(primitiveType);
+    return primitive;
+}
+
 /**
  * @return A new primitive for XYZ with float RGBA.  Caller is responsible
  * for deleting the returned pointer.
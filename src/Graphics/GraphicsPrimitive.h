@@ -38,6 +38,7 @@ namespace caret {
     class GraphicsPrimitiveV3fC4f;
     class GraphicsPrimitiveV3fC4ub;
     class GraphicsPrimitiveV3fN3f;
+    class GraphicsPrimitiveV3fN3fC4f;
     class GraphicsPrimitiveV3fT3f;
     
     class GraphicsPrimitive : public CaretObject, public EventListenerInterface {
@@ -95,6 +96,16 @@ namespace caret {
             FLOAT_STR
         };
         
+        /**
+         * Filtering of the texture image when it is drawn larger or smaller than its size
+         */
+        enum class TextureFilteringType {
+            /** Linear interpolation with mipmaps, for images that should appear smooth */
+            LINEAR,
+            /** Nearest pixel and no mipmaps, for images whose pixels are data (such as matrix cells) */
+            NEAREST
+        };
+        
         /**
          * Type of primitives for drawing.  There are NO primitives equivalent to
          * OpenGL's GL_QUAD_STRIP and GL_POLYGON.  The reason is that these
@@ -265,6 +276,8 @@ namespace caret {
         static GraphicsPrimitiveV3fN3f* newPrimitiveV3fN3f(const GraphicsPrimitive::PrimitiveType primitiveType,
                                                            const uint8_t unsignedByteRGBA[4]);
         
+        static GraphicsPrimitiveV3fN3fC4f* newPrimitiveV3fN3fC4f(const GraphicsPrimitive::PrimitiveType primitiveType);
+        
         static GraphicsPrimitiveV3fC4f* newPrimitiveV3fC4f(const GraphicsPrimitive::PrimitiveType primitiveType);
         
         static GraphicsPrimitiveV3fC4ub* newPrimitiveV3fC4ub(const GraphicsPrimitive::PrimitiveType primitiveType);
@@ -330,6 +343,19 @@ namespace caret {
          */
         inline TextureDataType getTextureDataType() const { return m_textureDataType; }
         
+        /**
+         * @return Filtering of the texture image.
+         */
+        inline TextureFilteringType getTextureFilteringType() const { return m_textureFilteringType; }
+        
+        /**
+         * Set the filtering of the texture image.  Must be set before the primitive is first drawn.
+         *
+         * @param textureFilteringType
+         *     New filtering type.
+         */
+        void setTextureFilteringType(const TextureFilteringType textureFilteringType) { m_textureFilteringType = textureFilteringType; }
+        
         /**
          * @return The float coordinates.
          */
@@ -361,6 +387,16 @@ namespace caret {
         
         void replaceAllVertexSolidFloatRGBA(const float rgba[4]);
         
+        void replaceAllVertexFloatRGBA(const float rgbaArray[]);
+        
+        /**
+         * @return Indices of vertices used for drawing.  When empty, the vertices
+         * are drawn in the order they were added.
+         */
+        const std::vector<uint32_t>& getVertexIndices() const { return m_vertexIndices; }
+        
+        void setVertexIndices(const std::vector<uint32_t>& vertexIndices);
+        
         bool getVertexBounds(BoundingBox& boundingBoxOut) const;
         
         void addPrimitiveRestart();
@@ -447,6 +483,8 @@ namespace caret {
         
         int32_t m_textureImageHeight = -1;
         
+        TextureFilteringType m_textureFilteringType = TextureFilteringType::LINEAR;
+        
         mutable PointSizeType m_pointSizeType = PointSizeType::PIXELS;
         
         mutable float m_pointDiameterValue = 1.0f;
@@ -485,6 +523,9 @@ namespace caret {
         std::vector<float> m_floatTextureSTR;
         
         std::vector<uint8_t> m_textureImageBytesRGBA;
+        
+        std::vector<uint32_t> m_vertexIndices;
+        
         friend class GraphicsEngineDataOpenGL;
         friend class GraphicsOpenGLPolylineTriangles;
         friend class GraphicsPrimitiveSelectionHelper;
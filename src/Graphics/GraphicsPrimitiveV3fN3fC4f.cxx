@@ -0,0 +1,143 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#define __GRAPHICS_PRIMITIVE_V3F_N3F_C4F_DECLARE__
+#include "GraphicsPrimitiveV3fN3fC4f.h"
+#undef __GRAPHICS_PRIMITIVE_V3F_N3F_C4F_DECLARE__
+
+#include "CaretAssert.h"
+
+using namespace caret;
+
+
+    
+/**
+ * \class caret::GraphicsPrimitiveV3fN3fC4f 
+ * \brief Primitive containing vertices, normals, and a float RGBA color for each vertex.
+ * \ingroup Graphics
+ *
+ * Intended for lit, per-vertex colored geometry such as surfaces.
+ */
+
+/**
+ * Constructor.
+ * 
+ * @param primitiveType
+ *     Type of primitive drawn (triangles, lines, etc.)
+ */
+GraphicsPrimitiveV3fN3fC4f::GraphicsPrimitiveV3fN3fC4f(const PrimitiveType primitiveType)
+: GraphicsPrimitive(VertexDataType::FLOAT_XYZ,
+                    NormalVectorDataType::FLOAT_XYZ,
+                    ColorDataType::FLOAT_RGBA,
+                    VertexColorType::PER_VERTEX_RGBA,
+                    TextureDataType::NONE,
+                    primitiveType)
+{
+    
+}
+
+/**
+ * Destructor.
+ */
+GraphicsPrimitiveV3fN3fC4f::~GraphicsPrimitiveV3fN3fC4f()
+{
+}
+
+/**
+ * Copy constructor.
+ * @param obj
+ *    Object that is copied.
+ */
+GraphicsPrimitiveV3fN3fC4f::GraphicsPrimitiveV3fN3fC4f(const GraphicsPrimitiveV3fN3fC4f& obj)
+: GraphicsPrimitive(obj)
+{
+    this->copyHelperGraphicsPrimitiveV3fN3fC4f(obj);
+}
+
+/**
+ * Helps with copying an object of this type.
+ * @param obj
+ *    Object that is copied.
+ */
+void 
+GraphicsPrimitiveV3fN3fC4f::copyHelperGraphicsPrimitiveV3fN3fC4f(const GraphicsPrimitiveV3fN3fC4f& /*obj*/)
+{
+    
+}
+
+/**
+ * Add a vertex.
+ * 
+ * @param xyz
+ *     Coordinate of vertex.
+ * @param normalXYZ
+ *     Normal vector
+ * @param rgba
+ *     Float RGBA color components.
+ */
+void
+GraphicsPrimitiveV3fN3fC4f::addVertex(const float xyz[3],
+                                      const float normalXYZ[3],
+                                      const float rgba[4])
+{
+    addVertexProtected(xyz,
+                       normalXYZ,
+                       rgba,
+                       NULL,
+                       NULL);
+}
+
+/**
+ * Add XYZ vertices from an array.
+ *
+ * @param xyzArray
+ *    Array containing XYZ vertex data.
+ * @param normalXyzArray
+ *    Array containing XYZ normal vector data.
+ * @param rgbaArray
+ *    Array containing float RGBA color components.
+ * @param numberOfVertices
+ *    Number of vertices (xyz triplets) to add
+ */
+void
+GraphicsPrimitiveV3fN3fC4f::addVertices(const float xyzArray[],
+                                        const float normalXyzArray[],
+                                        const float rgbaArray[],
+                                        const int32_t numberOfVertices)
+{
+    reserveForNumberOfVertices(getNumberOfVertices() + numberOfVertices);
+    for (int32_t i = 0; i < numberOfVertices; i++) {
+        addVertex(&xyzArray[i*3],
+                  &normalXyzArray[i*3],
+                  &rgbaArray[i*4]);
+    }
+}
+
+/**
+ * Clone this primitive.
+ */
+GraphicsPrimitive*
+GraphicsPrimitiveV3fN3fC4f::clone() const
+{
+    GraphicsPrimitiveV3fN3fC4f* obj = new GraphicsPrimitiveV3fN3fC4f(*this);
+    return obj;
+}
+
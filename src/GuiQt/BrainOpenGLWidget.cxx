@@ -31,6 +31,7 @@
 #ifdef WORKBENCH_USE_QT5_QOPENGL_WIDGET
 #endif
 #include <QOpenGLContext>
+#include <QTimer>
 #include <QToolTip>
 #include <QWheelEvent>
 
@@ -46,6 +47,7 @@
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "CaretPreferences.h"
+#include "CiftiMappableDataFile.h"
 #include "CursorManager.h"
 #include "DummyFontTextRenderer.h"
 #include "EventBrainReset.h"
@@ -67,6 +69,7 @@
 #include "Model.h"
 #include "MouseEvent.h"
 #include "OffScreenOpenGLRenderer.h"
+#include "ProgressReportingDialog.h"
 #include "SelectionManager.h"
 #include "SelectionItemAnnotation.h"
 #include "SelectionItemSurfaceNode.h"
@@ -634,6 +637,25 @@ BrainOpenGLWidget::paintGL()
                                   m_contextShareGroupPointer,
                                   m_windowContent.getAllTabViewports());
     
+    /*
+     * Matrix pyramids are not built while drawing since building
+     * reads the entire matrix.  Build them, with a progress dialog,
+     * after this drawing is complete.
+     */
+    if ( ! m_matrixPyramidBuildPendingFlag) {
+        std::vector<CiftiMappableDataFile*> ciftiFiles;
+        GuiManager::get()->getBrain()->getAllCiftiMappableDataFiles(ciftiFiles);
+        for (auto ciftiFile : ciftiFiles) {
+            if (ciftiFile->isMatrixPyramidBuildRequested()) {
+                m_matrixPyramidBuildPendingFlag = true;
+                QTimer::singleShot(0,
+                                   this,
+                                   SLOT(buildRequestedMatrixPyramids()));
+                break;
+            }
+        }
+    }
+    
     /*
      * Issue browser window redrawn event
      */
@@ -643,6 +665,36 @@ BrainOpenGLWidget::paintGL()
     }
 }
 
+/**
+ * Build the matrix pyramids that were requested while drawing,
+ * each with a progress dialog that allows cancelling the build,
+ * and then update the graphics.
+ */
+void
+BrainOpenGLWidget::buildRequestedMatrixPyramids()
+{
+    m_matrixPyramidBuildPendingFlag = false;
+    
+    bool builtFlag = false;
+    std::vector<CiftiMappableDataFile*> ciftiFiles;
+    GuiManager::get()->getBrain()->getAllCiftiMappableDataFiles(ciftiFiles);
+    for (auto ciftiFile : ciftiFiles) {
+        if (ciftiFile->isMatrixPyramidBuildRequested()) {
+            ProgressReportingDialog progressDialog("Matrix Summary",
+                                                   ("Computing matrix summary for "
+                                                    + ciftiFile->getFileNameNoPath()),
+                                                   this);
+            if (ciftiFile->buildMatrixPyramid()) {
+                builtFlag = true;
+            }
+        }
+    }
+    
+    if (builtFlag) {
+        EventManager::get()->sendEvent(EventGraphicsUpdateAllWindows().getPointer());
+    }
+}
+
 /**
  * Override of event handling.
  */
@@ -145,6 +145,9 @@ namespace caret {
         
         virtual void leaveEvent(QEvent* e);
         
+    private slots:
+        void buildRequestedMatrixPyramids();
+        
     private:
         
         std::vector<BrainOpenGLViewportContent*> getDrawingViewportContent(const int32_t windowViewportIn[4]) const;
@@ -207,6 +210,8 @@ namespace caret {
         
         void* m_contextShareGroupPointer = NULL;
         
+        bool m_matrixPyramidBuildPendingFlag = false;
+        
         static bool s_defaultGLFormatInitialized;
         
         static std::set<BrainOpenGLWidget*> s_brainOpenGLWidgets;
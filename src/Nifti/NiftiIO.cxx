@@ -25,9 +25,15 @@
 using namespace std;
 using namespace caret;
 
-void NiftiIO::openRead(const QString& filename)
+void NiftiIO::openRead(const QString& filename, const bool& memoryMap)
 {
-    m_file.open(filename);
+    m_readOnly = true;
+    if (memoryMap)
+    {
+        m_file.open(filename, CaretBinaryFile::READ_MEMORY_MAP);
+    } else {
+        m_file.open(filename);
+    }
     m_header.read(m_file);
     if (m_header.getDataType() == DT_BINARY)
     {
@@ -52,6 +58,7 @@ void NiftiIO::writeNew(const QString& filename, const NiftiHeader& header, const
     {
         throw DataFileException("writing NIFTI with binary datatype is unsupported");
     }
+    m_readOnly = false;
     if (withRead)
     {
         m_file.open(filename, CaretBinaryFile::READ_WRITE_TRUNCATE);//for cifti on-disk writing, replace structure with along row needs to RMW
@@ -30,6 +30,7 @@
 
 #include <QString>
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <vector>
@@ -42,9 +43,12 @@ namespace caret
         CaretBinaryFile m_file;
         NiftiHeader m_header;
         std::vector<int64_t> m_dims;
-        std::vector<char> m_scratch;//scratch memory for byteswapping, type conversion, etc
-        CaretMutex m_mutex;//protect multithreaded calls from each other
+        std::vector<char> m_scratch;//scratch memory for byteswapping, type conversion, etc when writing, reading uses per-call scratch
+        CaretMutex m_mutex;//protect multithreaded writes from each other, and reads from writes
+        bool m_readOnly;//reads don't need the mutex when nothing can be writing
         int numBytesPerElem();//for resizing scratch
+        template<typename T>
+        void convertReadAny(T* out, char* in, const int64_t& count);//switch on datatype, in gets byteswapped in place when needed
         template<typename TO, typename FROM>
         void convertRead(TO* out, FROM* in, const int64_t& count);//for reading from file
         template<typename TO, typename FROM>
@@ -52,24 +56,35 @@ namespace caret
         template<typename TO, typename FROM>
         static TO clamp(const FROM& in);//deal with integer cast being undefined when converting from outside range
     public:
-        void openRead(const QString& filename);
+        NiftiIO() { m_readOnly = true; }
+        void openRead(const QString& filename, const bool& memoryMap = false);//memory mapping is silently not done for compressed files, or when mapping fails
         void writeNew(const QString& filename, const NiftiHeader& header, const int& version = 1, const bool& withRead = false, const bool& swapEndian = false);
         QString getFilename() const { return m_file.getFilename(); }
         void overrideDimensions(const std::vector<int64_t>& newDims) { m_dims = newDims; }//HACK: deal with reading/writing CIFTI-1's broken headers
         void close();
         const NiftiHeader& getHeader() const { return m_header; }
         const std::vector<int64_t>& getDimensions() const { return m_dims; }
+        bool isMemoryMapped() { return m_file.getMappedData() != NULL; }
         int getNumComponents() const;
         //to read/write 1 frame of a standard volume file, call with fullDims = 3, indexSelect containing indexes for any of dims 4-7 that exist
         //NOTE: you need to provide storage for all components within the range, if getNumComponents() == 3 and fullDims == 0, you need 3 elements allocated
         template<typename T>
         void readData(T* dataOut, const int& fullDims, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead = false);
+        //reads numSelected consecutive indexes of dimension fullDims, starting at indexSelect[0], as one contiguous read (several cifti rows, several volume frames)
+        template<typename T>
+        void readDataRange(T* dataOut, const int& fullDims, const std::vector<int64_t>& indexSelect, const int64_t& numSelected, const bool& tolerateShortRead = false);
         template<typename T>
         void writeData(const T* dataIn, const int& fullDims, const std::vector<int64_t>& indexSelect);
     };
     
     template<typename T>
     void NiftiIO::readData(T* dataOut, const int& fullDims, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead)
+    {
+        readDataRange(dataOut, fullDims, indexSelect, 1, tolerateShortRead);
+    }
+    
+    template<typename T>
+    void NiftiIO::readDataRange(T* dataOut, const int& fullDims, const std::vector<int64_t>& indexSelect, const int64_t& numSelected, const bool& tolerateShortRead)
     {
         CaretAssert(fullDims >= 0 && fullDims <= (int)m_dims.size());
         CaretAssert((size_t)fullDims + indexSelect.size() == m_dims.size());//could be >=, but should catch more stupid mistakes as ==
@@ -86,55 +101,95 @@ namespace caret
             numSkip += indexSelect[curDim - fullDims] * numDimSkip;
             numDimSkip *= m_dims[curDim];
         }
-        CaretMutexLocker locked(&m_mutex);//protect starting with resizing until we are done converting, because we use an internal variable for scratch space
+        CaretAssert(numSelected >= 1 && (numSelected == 1 || (fullDims < (int)m_dims.size() && indexSelect[0] + numSelected <= m_dims[fullDims])));
+        numElems *= numSelected;
+        const char* mappedData = m_file.getMappedData();
+        if (mappedData != NULL)
+        {//memory mapped, so we don't need the file position or the shared scratch space, and therefore don't need the mutex
+            int64_t elemBytes = numBytesPerElem();
+            int64_t start = numSkip * elemBytes + m_header.getDataOffset();
+            int64_t available = std::max(std::min(numElems, (m_file.size() - start) / elemBytes), int64_t(0));
+            if (available != numElems && !tolerateShortRead)
+            {
+                throw DataFileException("error while reading from nifti file '" + m_file.getFilename() + "'");
+            }
+            if (available > 0)
+            {//start may be past the end of the mapping, so only make a pointer from it when there is something to read
+                const char* source = mappedData + start;
+                if (m_header.isSwapped() || ((size_t)source) % elemBytes != 0)
+                {//mapping is read-only, and conversion may need aligned data, so copy
+                    std::vector<char> localScratch(source, source + available * elemBytes);
+                    convertReadAny(dataOut, localScratch.data(), available);
+                } else {
+                    convertReadAny(dataOut, (char*)source, available);//not swapped, so conversion doesn't modify the input
+                }
+            }
+            if (available < numElems)
+            {//match the unmapped path, which converts zero bytes past the end of the file (so scaling still applies)
+                std::vector<char> zeroScratch((numElems - available) * elemBytes, 0);
+                convertReadAny(dataOut + available, zeroScratch.data(), numElems - available);
+            }
+            return;
+        }
         //we can't guarantee that the output memory is enough to use as scratch space, as we might be doing a narrowing conversion
-        //we are doing FILE ACCESS, so cpu performance isn't really something to worry about
-        m_scratch.resize(numElems * numBytesPerElem());
-        m_file.seek(numSkip * numBytesPerElem() + m_header.getDataOffset());
+        //use per-call scratch and a positional read, so that concurrent reads (getRow in an omp loop) don't serialize on each other
+        std::vector<char> scratch(numElems * numBytesPerElem());
         int64_t numRead = 0;
-        m_file.read(m_scratch.data(), m_scratch.size(), &numRead);
-        if ((numRead != (int64_t)m_scratch.size() && !tolerateShortRead) || numRead < 0)//for now, assume read giving -1 is always a problem
+        if (m_readOnly)
+        {
+            m_file.readAt(scratch.data(), numSkip * numBytesPerElem() + m_header.getDataOffset(), scratch.size(), &numRead);
+        } else {
+            CaretMutexLocker locked(&m_mutex);//writeData uses the file position, so don't let them interleave
+            m_file.readAt(scratch.data(), numSkip * numBytesPerElem() + m_header.getDataOffset(), scratch.size(), &numRead);
+        }
+        if ((numRead != (int64_t)scratch.size() && !tolerateShortRead) || numRead < 0)//for now, assume read giving -1 is always a problem
         {
             throw DataFileException("error while reading from nifti file '" + m_file.getFilename() + "'");
         }
+        convertReadAny(dataOut, scratch.data(), numElems);
+    }
+    
+    template<typename T>
+    void NiftiIO::convertReadAny(T* dataOut, char* in, const int64_t& numElems)
+    {
         switch (m_header.getDataType())
         {
             case NIFTI_TYPE_UINT8:
             case NIFTI_TYPE_RGB24://handled by components
-                convertRead(dataOut, (uint8_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (uint8_t*)in, numElems);
                 break;
             case NIFTI_TYPE_INT8:
-                convertRead(dataOut, (int8_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (int8_t*)in, numElems);
                 break;
             case NIFTI_TYPE_UINT16:
-                convertRead(dataOut, (uint16_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (uint16_t*)in, numElems);
                 break;
             case NIFTI_TYPE_INT16:
-                convertRead(dataOut, (int16_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (int16_t*)in, numElems);
                 break;
             case NIFTI_TYPE_UINT32:
-                convertRead(dataOut, (uint32_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (uint32_t*)in, numElems);
                 break;
             case NIFTI_TYPE_INT32:
-                convertRead(dataOut, (int32_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (int32_t*)in, numElems);
                 break;
             case NIFTI_TYPE_UINT64:
-                convertRead(dataOut, (uint64_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (uint64_t*)in, numElems);
                 break;
             case NIFTI_TYPE_INT64:
-                convertRead(dataOut, (int64_t*)m_scratch.data(), numElems);
+                convertRead(dataOut, (int64_t*)in, numElems);
                 break;
             case NIFTI_TYPE_FLOAT32:
             case NIFTI_TYPE_COMPLEX64://components
-                convertRead(dataOut, (float*)m_scratch.data(), numElems);
+                convertRead(dataOut, (float*)in, numElems);
                 break;
             case NIFTI_TYPE_FLOAT64:
             case NIFTI_TYPE_COMPLEX128:
-                convertRead(dataOut, (double*)m_scratch.data(), numElems);
+                convertRead(dataOut, (double*)in, numElems);
                 break;
             case NIFTI_TYPE_FLOAT128:
             case NIFTI_TYPE_COMPLEX256:
-                convertRead(dataOut, (long double*)m_scratch.data(), numElems);
+                convertRead(dataOut, (long double*)in, numElems);
                 break;
             default:
                 CaretAssert(0);
@@ -28,6 +28,7 @@
 #include "CiftiXML.h"
 #include "MultiDimIterator.h"
 
+#include <algorithm>
 #include <iostream>
 
 using namespace caret;
@@ -235,7 +236,16 @@ void OperationCiftiMath::useParameters(OperationParameters* myParams, ProgressOb
     }
     if (outXML.getNumberOfDimensions() < 1) throw OperationException("output must have at least 1 dimension");
     myCiftiOut->setCiftiXML(outXML);
-    vector<float> values(numVars), scratchRow(outDims[0]);
+    int64_t rowLength = outDims[0];
+    int64_t rowsPerGroup = max((int64_t)1, ((int64_t)1 << 20) / rowLength);//evaluate many rows at once, so short rows (dtseries) still get split across threads
+    vector<vector<float> > groupInputs(numVars, vector<float>(rowsPerGroup * rowLength));
+    vector<const float*> groupPointers(numVars);
+    for (int v = 0; v < numVars; ++v)
+    {
+        groupPointers[v] = groupInputs[v].data();
+    }
+    vector<float> groupOutput(rowsPerGroup * rowLength);
+    vector<vector<int64_t> > groupIndices;//output row indices of the rows in the current group
     vector<vector<float> > inputRows(numVars);
     vector<vector<int64_t> > loadedRow(numVars);//to detect and prevent rereading the same row
     for (int v = 0; v < numVars; ++v)
@@ -243,7 +253,8 @@ void OperationCiftiMath::useParameters(OperationParameters* myParams, ProgressOb
         inputRows[v].resize(varCiftiFiles[v]->getCiftiXML().getDimensionLength(CiftiXML::ALONG_ROW));
         loadedRow[v].resize(varCiftiFiles[v]->getCiftiXML().getNumberOfDimensions() - 1, -1);//we always load a full row, so ignore first dim
     }
-    for (MultiDimIterator<int64_t> iter(vector<int64_t>(outDims.begin() + 1, outDims.end())); !iter.atEnd(); ++iter)
+    MultiDimIterator<int64_t> iter(vector<int64_t>(outDims.begin() + 1, outDims.end()));
+    while (!iter.atEnd())
     {
         for (int v = 0; v < numVars; ++v)//first, retrieve whichever rows are needed
         {
@@ -268,24 +279,42 @@ void OperationCiftiMath::useParameters(OperationParameters* myParams, ProgressOb
             {
                 varCiftiFiles[v]->getRow(inputRows[v].data(), loadedRow[v]);
             }
+            float* groupRow = groupInputs[v].data() + groupIndices.size() * rowLength;
+            if (selectInfo[v][0] == -1)//now we check for select along row
+            {
+                for (int64_t j = 0; j < rowLength; ++j)
+                {
+                    groupRow[j] = inputRows[v][j];
+                }
+            } else {
+                float selected = inputRows[v][selectInfo[v][0]];
+                for (int64_t j = 0; j < rowLength; ++j)
+                {
+                    groupRow[j] = selected;
+                }
+            }
         }
-        for (int j = 0; j < outDims[0]; ++j)
+        groupIndices.push_back(*iter);
+        ++iter;
+        if ((int64_t)groupIndices.size() == rowsPerGroup || iter.atEnd())
         {
-            for (int v = 0; v < numVars; ++v)//now we check for select along row
+            int64_t groupElements = groupIndices.size() * rowLength;
+            myExpr.evaluateMany(groupOutput.data(), groupPointers, groupElements);
+            if (nanfix)
             {
-                if (selectInfo[v][0] == -1)
+                for (int64_t j = 0; j < groupElements; ++j)
                 {
-                    values[v] = inputRows[v][j];
-                } else {
-                    values[v] = inputRows[v][selectInfo[v][0]];
+                    if (groupOutput[j] != groupOutput[j])
+                    {
+                        groupOutput[j] = nanfixval;
+                    }
                 }
             }
-            scratchRow[j] = (float)myExpr.evaluate(values);
-            if (nanfix && scratchRow[j] != scratchRow[j])
+            for (int64_t row = 0; row < (int64_t)groupIndices.size(); ++row)
             {
-                scratchRow[j] = nanfixval;
+                myCiftiOut->setRow(groupOutput.data() + row * rowLength, groupIndices[row]);
             }
+            groupIndices.clear();
         }
-        myCiftiOut->setRow(scratchRow.data(), *iter);
     }
 }
@@ -0,0 +1,97 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "OperationCiftiMatrixPyramid.h"
+#include "OperationException.h"
+#include "CiftiFile.h"
+#include "CiftiMatrixPyramid.h"
+
+#include <QFile>
+
+using namespace caret;
+using namespace std;
+
+AString OperationCiftiMatrixPyramid::getCommandSwitch()
+{
+    return "-cifti-matrix-pyramid";
+}
+
+AString OperationCiftiMatrixPyramid::getShortDescription()
+{
+    return "SUMMARIZE A LARGE CIFTI MATRIX FOR FAST DISPLAY";
+}
+
+OperationParameters* OperationCiftiMatrixPyramid::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    ret->addStringParameter(1, "cifti", "the 2D cifti file to summarize");
+    OptionalParameter* maxCellsOpt = ret->createOptionalParameter(2, "-max-cells", "limit the size of the finest stored level");
+    maxCellsOpt->addIntegerParameter(1, "cells", "maximum number of blocks in the finest stored level, default " + AString::number(CiftiMatrixPyramid::DEFAULT_MAX_STORED_CELLS));
+    ret->createOptionalParameter(3, "-remove", "delete the summary file instead of making it");
+    ret->setHelpText(
+        AString("Computes the minimum, maximum, and mean of the matrix of the cifti file over square blocks of 2, 4, 8, etc rows and columns, ") +
+        "and writes the levels that are small enough to keep in memory to a file with the same name plus '.wbpyramid'.  " +
+        "The cifti file is read once, a band of rows at a time, so this works on matrices much larger than memory.\n\n" +
+        "wb_view uses this file when charting a large matrix (for instance, a dense connectome), so that only the blocks covering the visible part of the " +
+        "matrix at the current zoom are colored and drawn.  If the file doesn't exist, or the cifti file has been modified since it was made, " +
+        "wb_view computes the summary when the matrix is first charted, with a progress dialog that can cancel it, and tries to save it.  " +
+        "For a cifti file opened from a URL, wb_view never computes the summary, it only reads the summary file at the same URL plus '.wbpyramid', so run this command " +
+        "on a copy of the file and put the summary file on the server next to it.\n\n" +
+        "The summary file is a cache for the machine it is made on, it uses native byte order and 32-bit floats.  Only 2D cifti files are supported."
+    );
+    return ret;
+}
+
+void OperationCiftiMatrixPyramid::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    AString ciftiName = myParams->getString(1);
+    int64_t maxCells = CiftiMatrixPyramid::DEFAULT_MAX_STORED_CELLS;
+    OptionalParameter* maxCellsOpt = myParams->getOptionalParameter(2);
+    if (maxCellsOpt->m_present)
+    {
+        maxCells = maxCellsOpt->getInteger(1);
+        if (maxCells < 1) throw OperationException("maximum cells must be positive");
+    }
+    AString sidecarName = CiftiMatrixPyramid::getSidecarFileName(ciftiName);
+    if (myParams->getOptionalParameter(3)->m_present)
+    {
+        if (QFile::exists(sidecarName) && !QFile::remove(sidecarName))
+        {
+            throw OperationException("failed to remove file '" + sidecarName + "'");
+        }
+        return;
+    }
+    CiftiFile myCifti;
+    myCifti.openFile(ciftiName);
+    if (myCifti.getDimensions().size() != 2)
+    {
+        throw OperationException("matrix summaries can only be made of 2D cifti files");
+    }
+    CiftiMatrixPyramid myPyramid;
+    myPyramid.build(&myCifti, maxCells);
+    try
+    {
+        myPyramid.writeFile(sidecarName, ciftiName);
+    } catch (...) {
+        QFile::remove(sidecarName);//don't leave a partial file around, even though readFile() would reject it
+        throw;
+    }
+}
@@ -0,0 +1,92 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "OperationCiftiTileSidecar.h"
+#include "OperationException.h"
+#include "CiftiFile.h"
+#include "CiftiTileFile.h"
+
+#include <QFile>
+
+using namespace caret;
+using namespace std;
+
+AString OperationCiftiTileSidecar::getCommandSwitch()
+{
+    return "-cifti-tile-sidecar";
+}
+
+AString OperationCiftiTileSidecar::getShortDescription()
+{
+    return "MAKE A TILED COPY OF A CIFTI FILE FOR FAST COLUMN READING";
+}
+
+OperationParameters* OperationCiftiTileSidecar::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    ret->addStringParameter(1, "cifti", "the 2D cifti file to make a tiled copy of");
+    OptionalParameter* tileSizeOpt = ret->createOptionalParameter(2, "-tile-size", "set the size of the tiles");
+    tileSizeOpt->addIntegerParameter(1, "size", "number of rows and columns in each tile, default " + AString::number(CiftiTileFile::DEFAULT_TILE_SIZE));
+    ret->createOptionalParameter(3, "-remove", "delete the tiled copy instead of making it");
+    ret->setHelpText(
+        AString("Writes the matrix of the cifti file a second time, in square tiles, to a file with the same name plus '.wbtiles'.  ") +
+        "When this file exists and the cifti file has not been modified since it was made, reading a column of the cifti file " +
+        "(for instance, column loading in wb_view, or commands that operate along columns) reads one short piece of each row of tiles, " +
+        "instead of one value from every row of the cifti file.  Rows are still read from the cifti file itself.\n\n" +
+        "The tiled file is a cache for the machine it is made on, it uses native byte order and 32-bit floats, and takes about as much space " +
+        "as an uncompressed float cifti file.  Only 2D cifti files are supported."
+    );
+    return ret;
+}
+
+void OperationCiftiTileSidecar::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    AString ciftiName = myParams->getString(1);
+    int64_t tileSize = CiftiTileFile::DEFAULT_TILE_SIZE;
+    OptionalParameter* tileSizeOpt = myParams->getOptionalParameter(2);
+    if (tileSizeOpt->m_present)
+    {
+        tileSize = tileSizeOpt->getInteger(1);
+        if (tileSize < 1) throw OperationException("tile size must be positive");
+    }
+    AString sidecarName = CiftiTileFile::getSidecarFileName(ciftiName);
+    if (myParams->getOptionalParameter(3)->m_present)
+    {
+        if (QFile::exists(sidecarName) && !QFile::remove(sidecarName))
+        {
+            throw OperationException("failed to remove file '" + sidecarName + "'");
+        }
+        return;
+    }
+    CiftiFile myCifti;
+    myCifti.openFile(ciftiName);
+    if (myCifti.getDimensions().size() != 2)
+    {
+        throw OperationException("tiled copies can only be made of 2D cifti files");
+    }
+    try
+    {
+        CiftiTileFile::writeFile(myCifti, sidecarName, ciftiName, tileSize);
+    } catch (...) {
+        QFile::remove(sidecarName);//don't leave a partial file around, even though open() would reject it
+        throw;
+    }
+}
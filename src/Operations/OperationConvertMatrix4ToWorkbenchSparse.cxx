@@ -64,9 +64,13 @@ OperationParameters* OperationConvertMatrix4ToWorkbenchSparse::getParameters()
     volumeOpt->addCiftiParameter(1, "cifti-template", "cifti file to use the volume mappings from");
     volumeOpt->addStringParameter(2, "direction", "dimension along the cifti file to take the mapping from, ROW or COLUMN");
     
+    OptionalParameter* versionOpt = ret->createOptionalParameter(9, "-version", "write a different wbsparse file version");
+    versionOpt->addIntegerParameter(1, "version", "the version to write, 1 or 2 (default 1)");
+    
     ret->setHelpText(
         AString("Converts the matrix 4 output of probtrackx to workbench sparse file format.  ") +
-        "Exactly one of -surface-seeds and -volume-seeds must be specified."
+        "Exactly one of -surface-seeds and -volume-seeds must be specified.\n\n" +
+        "Version 2 wbsparse files are much smaller, but can't be read by wb_command or wb_view versions older than this one."
     );
     return ret;
 }
@@ -84,6 +88,13 @@ void OperationConvertMatrix4ToWorkbenchSparse::useParameters(OperationParameters
     const int64_t* sparseDims = inFile.getDimensions();
     OptionalParameter* surfaceOpt = myParams->getOptionalParameter(7);
     OptionalParameter* volumeOpt = myParams->getOptionalParameter(8);
+    int version = 1;
+    OptionalParameter* versionOpt = myParams->getOptionalParameter(9);
+    if (versionOpt->m_present)
+    {
+        version = (int)versionOpt->getInteger(1);
+        if (version != 1 && version != 2) throw OperationException("wbsparse version must be 1 or 2");
+    }
     if (surfaceOpt->m_present == volumeOpt->m_present) throw OperationException("you must specify exactly one of -surface-seeds and -volume-seeds");//use == on booleans as xnor
     const CiftiXML& orientXML = orientationFile->getCiftiXML();
     if (orientXML.getMappingType(CiftiXML::ALONG_COLUMN) != CiftiMappingType::BRAIN_MODELS) throw OperationException("orientation file must have brain models mapping along column");
@@ -180,7 +191,7 @@ void OperationConvertMatrix4ToWorkbenchSparse::useParameters(OperationParameters
             rowReorder[i / 3] = tempInd;
         }
     }
-    CaretSparseFileWriter mywriter(outFileName, myXML);//NOTE: CaretSparseFile has a different encoding of fibers, ALWAYS use getFibersRow, etc
+    CaretSparseFileWriter mywriter(outFileName, myXML, version);//NOTE: CaretSparseFile has a different encoding of fibers, ALWAYS use getFibersRow, etc
     vector<int64_t> indicesIn, indicesOut;//this method knows about sparseness, does sorting of indexes in order to avoid scanning full rows
     vector<FiberFractions> fibersIn, fibersOut;//can be slower if matrix isn't very sparse, but that is a problem for other reasons anyway
     CaretMinHeap<FiberFractions, int64_t> myHeap;//use our heap to do heapsort, rather than coding a struct for stl sort
@@ -0,0 +1,128 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "OperationMetricTFCEMax.h"
+#include "OperationException.h"
+
+#include "CaretOMP.h"
+#include "MetricFile.h"
+#include "SurfaceFile.h"
+#include "TFCEHelper.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+AString OperationMetricTFCEMax::getCommandSwitch()
+{
+    return "-metric-tfce-max";
+}
+
+AString OperationMetricTFCEMax::getShortDescription()
+{
+    return "MAXIMUM TFCE VALUES OF EACH METRIC COLUMN";
+}
+
+OperationParameters* OperationMetricTFCEMax::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+
+    ret->addSurfaceParameter(1, "surface", "the surface to compute on");
+
+    ret->addMetricParameter(2, "metric-in", "the maps to run TFCE on, such as statistics from permuted data");
+
+    OptionalParameter* roiOpt = ret->createOptionalParameter(3, "-roi", "select a region of interest to run TFCE on");
+    roiOpt->addMetricParameter(1, "roi-metric", "the area to run TFCE on, as a metric");
+
+    OptionalParameter* paramsOpt = ret->createOptionalParameter(4, "-parameters", "set parameters for TFCE integral");
+    paramsOpt->addDoubleParameter(1, "E", "exponent for cluster area (default 1.0)");
+    paramsOpt->addDoubleParameter(2, "H", "exponent for threshold value (default 2.0)");
+
+    OptionalParameter* corrAreaOpt = ret->createOptionalParameter(5, "-corrected-areas", "vertex areas to use instead of computing them from the surface");
+    corrAreaOpt->addMetricParameter(1, "area-metric", "the corrected vertex areas, as a metric");
+
+    ret->createOptionalParameter(6, "-show-map-name", "print map index and name before each output");
+
+    ret->setHelpText(
+        AString("For each column of the input, the largest positive and the most negative value of its TFCE result are printed, separated by a tab, ") +
+        "which is the same as running -metric-tfce and taking the maximum and minimum of each output column, but without writing the TFCE maps.  " +
+        "The surface topology and vertex areas are only prepared once for all columns, so this is intended for building the null distribution " +
+        "of the maximum TFCE statistic from many permutations, with one permuted statistic map per column.  " +
+        "A column without any positive (or negative) values prints 0 for that extreme.\n\n" +
+        "See -metric-tfce for the meaning of the options."
+    );
+    return ret;
+}
+
+void OperationMetricTFCEMax::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    SurfaceFile* mySurf = myParams->getSurface(1);
+    MetricFile* myMetric = myParams->getMetric(2);
+    int numNodes = mySurf->getNumberOfNodes();
+    if (myMetric->getNumberOfNodes() != numNodes) throw OperationException("metric and surface have different number of vertices");
+    const float* roiData = NULL;
+    OptionalParameter* roiOpt = myParams->getOptionalParameter(3);
+    if (roiOpt->m_present)
+    {
+        MetricFile* myRoi = roiOpt->getMetric(1);
+        if (myRoi->getNumberOfNodes() != numNodes) throw OperationException("roi metric and surface have different number of vertices");
+        roiData = myRoi->getValuePointerForColumn(0);
+    }
+    float param_e = 1.0f, param_h = 2.0f;
+    OptionalParameter* paramsOpt = myParams->getOptionalParameter(4);
+    if (paramsOpt->m_present)
+    {
+        param_e = (float)paramsOpt->getDouble(1);
+        param_h = (float)paramsOpt->getDouble(2);
+    }
+    const float* areaData = NULL;
+    OptionalParameter* corrAreaOpt = myParams->getOptionalParameter(5);
+    if (corrAreaOpt->m_present)
+    {
+        MetricFile* corrAreaMetric = corrAreaOpt->getMetric(1);
+        if (corrAreaMetric->getNumberOfNodes() != numNodes) throw OperationException("corrected area metric and surface have different number of vertices");
+        areaData = corrAreaMetric->getValuePointerForColumn(0);
+    }
+    bool showMapName = myParams->getOptionalParameter(6)->m_present;
+    int numCols = myMetric->getNumberOfColumns();
+    TFCEHelper myTFCE(mySurf, areaData, roiData, param_e, param_h);
+    vector<float> maxVals(numCols), minVals(numCols);
+#pragma omp CARET_PAR
+    {
+        TFCEHelper::Scratch myScratch;
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int col = 0; col < numCols; ++col)
+        {
+            myTFCE.computeTFCEExtremes(myMetric->getValuePointerForColumn(col), maxVals[col], minVals[col], myScratch);
+        }
+    }
+    for (int col = 0; col < numCols; ++col)
+    {
+        if (showMapName) cout << AString::number(col + 1) << ":\t" << myMetric->getMapName(col) << ":\t";
+        stringstream resultsstr;
+        resultsstr << setprecision(7) << maxVals[col] << "\t" << minVals[col];
+        cout << resultsstr.str() << endl;
+    }
+}
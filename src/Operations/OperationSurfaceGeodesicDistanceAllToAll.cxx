@@ -30,6 +30,44 @@
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    class RowWriter : public GeodesicBatchCallback
+    {
+        CiftiFile* m_ciftiOut;
+        const CiftiBrainModelsMap& m_map;
+        StructureEnum::Enum m_structure;
+        const vector<CiftiBrainModelsMap::SurfaceMap>& m_surfMap;
+    public:
+        RowWriter(CiftiFile* ciftiOut, const CiftiBrainModelsMap& myMap, const StructureEnum::Enum& structure, const vector<CiftiBrainModelsMap::SurfaceMap>& surfMap) :
+            m_ciftiOut(ciftiOut), m_map(myMap), m_structure(structure), m_surfMap(surfMap)
+        {
+        }
+        void processRoot(const int64_t& rootIndex, const int32_t* nodes, const float* dists, const int64_t& count)
+        {//root index is the same as the row index, because the roots are in cifti order
+            const int64_t mapLength = (int64_t)m_surfMap.size();
+            vector<float> outRow(mapLength, -1.0f);
+            if (nodes != NULL)
+            {
+                for (int64_t j = 0; j < count; ++j)
+                {
+                    int64_t index = m_map.getIndexForNode(nodes[j], m_structure);//-1 if outside ROI
+                    if (index >= 0) outRow[index] = dists[j];
+                }
+            } else {
+                for (int64_t j = 0; j < mapLength; ++j)
+                {
+                    outRow[j] = dists[m_surfMap[j].m_surfaceNode];
+                }
+            }
+#pragma omp critical
+            {
+                m_ciftiOut->setRow(outRow.data(), rootIndex);
+            }
+        }
+    };
+}
+
 AString OperationSurfaceGeodesicDistanceAllToAll::getCommandSwitch()
 {
     return "-surface-geodesic-distance-all-to-all";
@@ -115,39 +153,16 @@ void OperationSurfaceGeodesicDistanceAllToAll::useParameters(OperationParameters
     myXML.setMap(CiftiXML::ALONG_ROW, myMap);
     myXML.setMap(CiftiXML::ALONG_COLUMN, myMap);
     ciftiOut->setCiftiXML(myXML);
-#pragma omp CARET_PAR
+    vector<int32_t> roots(mapLength);
+    for (int64_t i = 0; i < mapLength; ++i)
     {
-        CaretPointer<GeodesicHelper> privHelper;
-        if (corrAreaOpt->m_present)
-        {
-            privHelper.grabNew(new GeodesicHelper(myBase));
-        } else {
-            privHelper = mySurf->getGeodesicHelper();
-        }
-#pragma omp CARET_FOR schedule(dynamic)
-        for (int64_t i = 0; i < mapLength; ++i)
-        {
-            vector<float> outRow(mapLength, -1.0f), outDists;
-            vector<int32_t> outNodes;
-            if (distLimit > 0.0f)
-            {
-                privHelper->getNodesToGeoDist(surfMap[i].m_surfaceNode, distLimit, outNodes, outDists, !naive);
-                for (int j = 0; j < int(outNodes.size()); ++j)
-                {
-                    int64_t index = myMap.getIndexForNode(outNodes[j], structure);//-1 if outside ROI
-                    if (index >= 0) outRow[index] = outDists[j];
-                }
-            } else {
-                privHelper->getGeoFromNode(surfMap[i].m_surfaceNode, outDists, !naive);
-                for (int64_t j = 0; j < mapLength; ++j)
-                {
-                    outRow[j] = outDists[surfMap[j].m_surfaceNode];
-                }
-            }
-#pragma omp critical
-            {
-                ciftiOut->setRow(outRow.data(), i);
-            }
-        }
+        roots[i] = surfMap[i].m_surfaceNode;
+    }
+    RowWriter myWriter(ciftiOut, myMap, structure, surfMap);
+    if (distLimit > 0.0f)
+    {
+        myHelp->getNodesToGeoDistBatch(roots, distLimit, &myWriter, !naive);
+    } else {
+        myHelp->getGeoFromNodeBatch(roots, &myWriter, !naive);
     }
 }
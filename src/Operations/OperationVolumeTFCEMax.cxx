@@ -0,0 +1,112 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "OperationVolumeTFCEMax.h"
+#include "OperationException.h"
+
+#include "CaretOMP.h"
+#include "TFCEHelper.h"
+#include "VolumeFile.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+AString OperationVolumeTFCEMax::getCommandSwitch()
+{
+    return "-volume-tfce-max";
+}
+
+AString OperationVolumeTFCEMax::getShortDescription()
+{
+    return "MAXIMUM TFCE VALUES OF EACH VOLUME SUBVOLUME";
+}
+
+OperationParameters* OperationVolumeTFCEMax::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+
+    ret->addVolumeParameter(1, "volume-in", "the maps to run TFCE on, such as statistics from permuted data");
+
+    OptionalParameter* roiOpt = ret->createOptionalParameter(2, "-roi", "select a region of interest to run TFCE on");
+    roiOpt->addVolumeParameter(1, "roi-volume", "the region, as a volume file");
+
+    OptionalParameter* paramsOpt = ret->createOptionalParameter(3, "-parameters", "set parameters for TFCE integral");
+    paramsOpt->addDoubleParameter(1, "E", "exponent for cluster volume (default 0.5)");
+    paramsOpt->addDoubleParameter(2, "H", "exponent for threshold value (default 2.0)");
+
+    ret->createOptionalParameter(4, "-show-map-name", "print map index and name before each output");
+
+    ret->setHelpText(
+        AString("For each subvolume of the input, the largest positive and the most negative value of its TFCE result are printed, separated by a tab, ") +
+        "which is the same as running -volume-tfce and taking the maximum and minimum of each output subvolume, but without writing the TFCE maps.  " +
+        "The voxel neighbors are only prepared once for all subvolumes, so this is intended for building the null distribution " +
+        "of the maximum TFCE statistic from many permutations, with one permuted statistic map per subvolume.  " +
+        "A subvolume without any positive (or negative) values prints 0 for that extreme.\n\n" +
+        "See -volume-tfce for the meaning of the options."
+    );
+    return ret;
+}
+
+void OperationVolumeTFCEMax::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    VolumeFile* myVol = myParams->getVolume(1);
+    if (myVol->getNumberOfComponents() != 1) throw OperationException("multi-component volumes are not supported in -volume-tfce-max");
+    const float* roiFrame = NULL;
+    OptionalParameter* roiOpt = myParams->getOptionalParameter(2);
+    if (roiOpt->m_present)
+    {
+        VolumeFile* myRoi = roiOpt->getVolume(1);
+        if (!myVol->matchesVolumeSpace(myRoi)) throw OperationException("roi volume has different volume space than input");
+        roiFrame = myRoi->getFrame();
+    }
+    float param_e = 0.5f, param_h = 2.0f;
+    OptionalParameter* paramsOpt = myParams->getOptionalParameter(3);
+    if (paramsOpt->m_present)
+    {
+        param_e = (float)paramsOpt->getDouble(1);
+        param_h = (float)paramsOpt->getDouble(2);
+    }
+    bool showMapName = myParams->getOptionalParameter(4)->m_present;
+    int64_t numMaps = myVol->getNumberOfMaps();
+    TFCEHelper myTFCE(myVol->getVolumeSpace(), roiFrame, param_e, param_h);
+    vector<float> maxVals(numMaps), minVals(numMaps);
+#pragma omp CARET_PAR
+    {
+        TFCEHelper::Scratch myScratch;
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int64_t b = 0; b < numMaps; ++b)
+        {
+            myTFCE.computeTFCEExtremes(myVol->getFrame(b), maxVals[b], minVals[b], myScratch);
+        }
+    }
+    for (int64_t b = 0; b < numMaps; ++b)
+    {
+        if (showMapName) cout << AString::number(b + 1) << ":\t" << myVol->getMapName(b) << ":\t";
+        stringstream resultsstr;
+        resultsstr << setprecision(7) << maxVals[b] << "\t" << minVals[b];
+        cout << resultsstr.str() << endl;
+    }
+}
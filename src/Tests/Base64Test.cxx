@@ -0,0 +1,122 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "Base64Test.h"
+
+#include "Base64.h"
+
+#include <cstdlib>
+#include <string>
+
+using namespace caret;
+using namespace std;
+
+Base64Test::Base64Test(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void Base64Test::checkDecode(const vector<unsigned char>& expected, const char* text, const uint64_t textLength,
+                             const uint64_t outputLength, const char* descrip)
+{
+    const unsigned char GUARD = 0xA5;
+    vector<unsigned char> output(outputLength + 8, GUARD);//guard bytes to catch writing past outputLength
+    uint64_t decoded = Base64::decodeText(text, textLength, output.data(), outputLength);
+    if (decoded != expected.size())
+    {
+        setFailed(AString(descrip) + ": decoded " + AString::number(decoded) + " bytes, expected " + AString::number(expected.size()));
+        return;
+    }
+    for (uint64_t i = 0; i < decoded; ++i)
+    {
+        if (output[i] != expected[i])
+        {
+            setFailed(AString(descrip) + ": decoded byte " + AString::number(i) + " is wrong");
+            return;
+        }
+    }
+    for (uint64_t i = outputLength; i < output.size(); ++i)
+    {
+        if (output[i] != GUARD)
+        {
+            setFailed(AString(descrip) + ": wrote past the end of the output");
+            return;
+        }
+    }
+}
+
+void Base64Test::execute()
+{
+    const char* whitespace[] = { " ", "\n", "\r\n", "\t  " };
+    srand(1234);
+    for (int numBytes = 0; numBytes < 50 && !failed(); ++numBytes)
+    {
+        vector<unsigned char> data(numBytes);
+        for (int i = 0; i < numBytes; ++i)
+        {
+            data[i] = (unsigned char)(rand() & 0xFF);
+        }
+        vector<unsigned char> encodeBuffer(numBytes * 2 + 8);
+        uint64_t encodedLength = Base64::encode(data.data(), numBytes, encodeBuffer.data());
+        string encoded((const char*)encodeBuffer.data(), encodedLength);
+        uint64_t capacity = (encoded.size() / 4) * 3 + 3;
+        checkDecode(data, encoded.data(), encoded.size(), capacity, "plain text");
+        
+        string spaced;//whitespace at varying intervals, so it lands both inside and outside of the fast path's groups
+        int interval = numBytes % 9 + 1;
+        for (uint64_t i = 0; i < encoded.size(); ++i)
+        {
+            if (i % interval == 0) spaced += whitespace[i % 4];
+            spaced += encoded[i];
+        }
+        spaced += "\n";
+        checkDecode(data, spaced.data(), spaced.size(), capacity, "embedded whitespace");
+        
+        string padded = encoded + "=QUJD";//anything after padding must be ignored
+        checkDecode(data, padded.data(), padded.size(), capacity, "text after padding");
+        
+        string nullTerminated = encoded;//the length includes the terminating null
+        nullTerminated.push_back('\0');
+        checkDecode(data, nullTerminated.data(), nullTerminated.size(), capacity, "terminating null");
+        
+        if (numBytes % 3 == 0)
+        {//no padding, so removing characters leaves a short final group
+            for (int removed = 1; removed <= 3 && removed <= numBytes; ++removed)
+            {
+                vector<unsigned char> expected(data.begin(), data.end() - removed);//3 characters hold 2 bytes, 2 hold 1, 1 holds none
+                checkDecode(expected, encoded.data(), encoded.size() - removed, capacity, "truncated text");
+            }
+        }
+        
+        int numGroups = numBytes / 3;
+        if (numGroups > 0)
+        {
+            int badGroup = numGroups / 2;
+            string invalid = encoded;
+            invalid[badGroup * 4] = '*';
+            vector<unsigned char> expected(data.begin(), data.begin() + badGroup * 3);
+            checkDecode(expected, invalid.data(), invalid.size(), capacity, "invalid character");
+        }
+        if (numGroups > 1)
+        {
+            int limitGroups = numGroups / 2;//output buffer too small, only the complete groups that fit are decoded
+            vector<unsigned char> limited(data.begin(), data.begin() + limitGroups * 3);
+            checkDecode(limited, spaced.data(), spaced.size(), limitGroups * 3 + 2, "limited output");
+        }
+    }
+}
@@ -20,6 +20,11 @@
 
 #include "CiftiFileTest.h"
 #include "CiftiFile.h"
+#include "CiftiTileFile.h"
+
+#include <algorithm>
+#include <vector>
+
 using namespace caret;
 CiftiFileTest::CiftiFileTest(const AString &identifier) : TestInterface(identifier)
 {
@@ -194,6 +199,60 @@ void CiftiFileTest::testCiftiReadWriteOnDisk()
             return;
         }
     }
+    //consecutive rows read with one request must match single row reads
+    const int64_t rowsPerRead = 7;
+    std::vector<float> multiRow(rowsPerRead * rowSize);
+    for(int64_t i = 0;i<columnSize;i+=rowsPerRead)
+    {
+        int64_t numRows = std::min(rowsPerRead, columnSize - i);
+        test.getRows(multiRow.data(),i,numRows);
+        for(int64_t j = 0;j<numRows;j++)
+        {
+            reader.getRow(row,i+j);
+            if(memcmp((void *)row,(void *)(multiRow.data() + j * rowSize),rowSize*sizeof(float)))
+            {
+                this->setFailed("Cifti getRows does not match getRow.");
+                return;
+            }
+        }
+    }
+    //columns come from cached tiles of several columns, check ones at the start, middle, and end of tiles
+    std::vector<float> column(columnSize);
+    int64_t testColumns[] = { 0, 1, 63, 64, 65, rowSize - 1 };
+    for(int c = 0;c<6;c++)
+    {
+        int64_t whichColumn = std::min(testColumns[c], rowSize - 1);
+        test.getColumn(column.data(),whichColumn);
+        for(int64_t i = 0;i<columnSize;i++)
+        {
+            reader.getRow(row,i);
+            if(row[whichColumn] != column[i])
+            {
+                this->setFailed("Cifti getColumn does not match getRow.");
+                return;
+            }
+        }
+    }
+    //same columns through a tiled sidecar, with a tile size that leaves padded edge tiles
+    CiftiTileFile::writeFile(test, CiftiTileFile::getSidecarFileName(outFile), outFile, 50);
+    {
+        CiftiFile tiled(outFile);
+        for(int c = 0;c<6;c++)
+        {
+            int64_t whichColumn = std::min(testColumns[c], rowSize - 1);
+            tiled.getColumn(column.data(),whichColumn);
+            for(int64_t i = 0;i<columnSize;i++)
+            {
+                reader.getRow(row,i);
+                if(row[whichColumn] != column[i])
+                {
+                    this->setFailed("Cifti getColumn from tiled sidecar does not match getRow.");
+                    return;
+                }
+            }
+        }
+    }
+    QFile::remove(CiftiTileFile::getSidecarFileName(outFile));
     std::cout << "Reading and writing of Cifti was successful for all frames." << std::endl;
     delete [] row;
     delete [] testRow;
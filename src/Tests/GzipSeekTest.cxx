@@ -0,0 +1,128 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "GzipSeekTest.h"
+
+#include "CaretBinaryFile.h"
+#include "GzipIndexedReader.h"
+#include "MultiDimIterator.h"
+#include "NiftiIO.h"
+
+#include <QDir>
+#include <QFile>
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+GzipSeekTest::GzipSeekTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void GzipSeekTest::execute()
+{
+    const int64_t DATA_SIZE = 5 * GzipIndexedReader::INDEX_SPAN + 12345;//enough for several access points
+    vector<unsigned char> data(DATA_SIZE);
+    for (int64_t i = 0; i < DATA_SIZE; ++i)
+    {//mix of noise and runs, so it compresses somewhat
+        data[i] = ((i / 4096) % 2 == 0) ? (unsigned char)(rand() % 16) : (unsigned char)(i / 4096);
+    }
+    AString fileName = QDir::tempPath() + "/wb_gzip_seek_test.gz";
+    {
+        CaretBinaryFile writer(fileName, CaretBinaryFile::WRITE_TRUNCATE);
+        writer.write(data.data(), DATA_SIZE);
+    }
+    CaretBinaryFile reader(fileName, CaretBinaryFile::READ);
+    vector<unsigned char> buffer(1<<20);
+    for (int i = 0; i < 50 && !failed(); ++i)
+    {//random order, so it seeks both forwards and backwards
+        int64_t position = (int64_t)(((double)rand()) / RAND_MAX * (DATA_SIZE - (int64_t)buffer.size()));
+        reader.seek(position);
+        reader.read(buffer.data(), buffer.size());
+        if (reader.pos() != position + (int64_t)buffer.size()) setFailed("wrong position after read at " + AString::number(position));
+        if (memcmp(buffer.data(), data.data() + position, buffer.size()) != 0) setFailed("wrong data read at " + AString::number(position));
+    }
+    reader.seek(0);
+    for (int64_t position = 0; position + (int64_t)buffer.size() <= DATA_SIZE && !failed(); position += buffer.size())
+    {//sequential reads, which use read-ahead
+        reader.read(buffer.data(), buffer.size());
+        if (memcmp(buffer.data(), data.data() + position, buffer.size()) != 0) setFailed("wrong data in sequential read at " + AString::number(position));
+    }
+    int64_t numRead = -1;
+    reader.seek(DATA_SIZE - 10);
+    reader.read(buffer.data(), 20, &numRead);
+    if (numRead != 10) setFailed("read past end returned " + AString::number(numRead) + " bytes, expected 10");
+    if (memcmp(buffer.data(), data.data() + DATA_SIZE - 10, 10) != 0) setFailed("wrong data read at end of file");
+    reader.close();
+    QFile::remove(fileName);
+    if (failed()) return;
+    testNiftiWriteRead();
+}
+
+void GzipSeekTest::testNiftiWriteRead()
+{//writing a nifti header seeks forward to vox_offset, so this also checks the writer's position while input is still pending
+    vector<int64_t> dims(4);
+    dims[0] = 37; dims[1] = 41; dims[2] = 43; dims[3] = 5;
+    NiftiHeader header;
+    header.setDimensions(dims);
+    header.setDataType(NIFTI_TYPE_FLOAT32);
+    const int64_t frameSize = dims[0] * dims[1] * dims[2];
+    vector<float> frame(frameSize);
+    AString fileName = QDir::tempPath() + "/wb_gzip_write_test.nii.gz";
+    for (int version = 1; version <= 2 && !failed(); ++version)
+    {
+        {
+            NiftiIO writer;
+            writer.writeNew(fileName, header, version);
+            for (MultiDimIterator<int64_t> iter(vector<int64_t>(dims.begin() + 3, dims.end())); !iter.atEnd(); ++iter)
+            {
+                for (int64_t i = 0; i < frameSize; ++i)
+                {
+                    frame[i] = (float)(i % 1000) + 1000.0f * (*iter)[0];
+                }
+                writer.writeData(frame.data(), 3, *iter);
+            }
+            writer.close();
+        }
+        NiftiIO reader;
+        reader.openRead(fileName);
+        if (reader.getDimensions() != dims)
+        {
+            setFailed("wrong dimensions reading back nifti-" + AString::number(version) + " .nii.gz");
+            break;
+        }
+        for (MultiDimIterator<int64_t> iter(vector<int64_t>(dims.begin() + 3, dims.end())); !iter.atEnd() && !failed(); ++iter)
+        {
+            reader.readData(frame.data(), 3, *iter);
+            for (int64_t i = 0; i < frameSize; ++i)
+            {
+                if (frame[i] != (float)(i % 1000) + 1000.0f * (*iter)[0])
+                {
+                    setFailed("wrong data reading back nifti-" + AString::number(version) + " .nii.gz, frame " + AString::number((*iter)[0]));
+                    break;
+                }
+            }
+        }
+        reader.close();
+    }
+    QFile::remove(fileName);
+}
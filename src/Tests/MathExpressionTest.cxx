@@ -20,12 +20,58 @@
 #include "MathExpressionTest.h"
 
 #include "CaretMathExpression.h"
+#include "MathFunctionEnum.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    //one expression per function, arguments shifted so that x in [-0.9, 0.9) stays inside the function's domain
+    const char* functionStrings[] = { "sin(x)", "cos(x)", "tan(x)", "asin(x)", "acos(x)", "atan(x)", "atan2(x, 0.5)",
+                                      "sinh(x)", "cosh(x)", "tanh(x)", "asinh(x)", "acosh(x + 2)", "atanh(x)",
+                                      "ln(x + 1)", "exp(x)", "log(x + 1)", "sqrt(x + 1)", "abs(x)",
+                                      "floor(x * 5)", "round(x * 5)", "ceil(x * 5)",
+                                      "min(x, 0.25)", "max(x, 0.25)", "mod(x, 0.3)", "clamp(x, -0.5, 0.5)" };
+    const int NUM_FUNCTION_STRINGS = sizeof(functionStrings) / sizeof(functionStrings[0]);
+    
+    double functionReference(const int& which, const double& x)
+    {//written out independently of CaretMathExpression, inverse hyperbolics from their definitions
+        switch (which)
+        {
+            case 0: return sin(x);
+            case 1: return cos(x);
+            case 2: return tan(x);
+            case 3: return asin(x);
+            case 4: return acos(x);
+            case 5: return atan(x);
+            case 6: return atan2(x, 0.5);
+            case 7: return sinh(x);
+            case 8: return cosh(x);
+            case 9: return tanh(x);
+            case 10: return log(x + sqrt(x * x + 1.0));
+            case 11: return log((x + 2.0) + sqrt((x + 2.0) * (x + 2.0) - 1.0));
+            case 12: return 0.5 * log((1.0 + x) / (1.0 - x));
+            case 13: return log(x + 1.0);
+            case 14: return exp(x);
+            case 15: return log10(x + 1.0);
+            case 16: return sqrt(x + 1.0);
+            case 17: return (x < 0.0 ? -x : x);
+            case 18: return floor(x * 5.0);
+            case 19: return (x * 5.0 > 0.0 ? floor(x * 5.0 + 0.5) : ceil(x * 5.0 - 0.5));
+            case 20: return ceil(x * 5.0);
+            case 21: return (x < 0.25 ? x : 0.25);
+            case 22: return (x > 0.25 ? x : 0.25);
+            case 23: return x - 0.3 * floor(x / 0.3);
+            case 24: return (x < -0.5 ? -0.5 : (x > 0.5 ? 0.5 : x));
+        }
+        return 0.0;
+    }
+}
+
 MathExpressionTest::MathExpressionTest(const AString& identifier) : TestInterface(identifier)
 {
 }
@@ -55,4 +101,90 @@ void MathExpressionTest::execute()
     {
         setFailed("output value incorrect, expected " + AString::number(correctresult) + ", got " + AString::number(testresult));
     }
+    const int64_t NUM_ELEMS = 10000;//several batches, to test the bytecode evaluator, including with threads
+    vector<float> xvals(NUM_ELEMS), yipvals(NUM_ELEMS), manyresult(NUM_ELEMS);
+    for (int64_t i = 0; i < NUM_ELEMS; ++i)
+    {
+        xvals[i] = (i % 101) / 25.0f - 2.0f;
+        yipvals[i] = (i % 37) / 9.0f - 2.0f;
+    }
+    vector<const float*> varPointers(2);
+    const char* exprStrings[] = { " sin ( - yip * 5 ) + x ^ 3 * ( clamp(1, 3, 5) + 2 ) + - 2 ^ - 2 ",
+                                  "x > 0.5 && yip <= 1 || !(x == yip) * 3 - (x != 0) + (x >= yip)",
+                                  "min(x, yip) + max(x, PI) - mod(x * 10, yip) / abs(round(x) + ceil(yip) - floor(x))",
+                                  "clamp(x, -1, yip) + atan2(x, yip) + exp(x) * cos(yip) - sqrt(abs(x)) * ln(abs(yip)) + asinh(x) + tanh(yip) - yip" };
+    for (int e = 0; e < 4; ++e)
+    {
+        CaretMathExpression manyExpr(exprStrings[e]);
+        vector<AString> manyNames = manyExpr.getVarNames();
+        if (manyNames.size() != 2)
+        {
+            setFailed("incorrect number of variables found in '" + AString(exprStrings[e]) + "'");
+            continue;
+        }
+        for (int v = 0; v < 2; ++v)
+        {
+            varPointers[v] = (manyNames[v] == "x" ? xvals.data() : yipvals.data());
+        }
+        manyExpr.evaluateMany(manyresult.data(), varPointers, NUM_ELEMS);
+        for (int64_t i = 0; i < NUM_ELEMS; ++i)
+        {
+            vars[0] = varPointers[0][i];
+            vars[1] = varPointers[1][i];
+            float single = (float)manyExpr.evaluate(vars);
+            if (single != manyresult[i] && (single == single || manyresult[i] == manyresult[i]))//NaN must match NaN
+            {
+                setFailed("batch evaluation of '" + AString(exprStrings[e]) + "' differs from single evaluation, expected " +
+                          AString::number(single) + ", got " + AString::number(manyresult[i]));
+                break;
+            }
+        }
+    }
+    vector<MathFunctionEnum::Enum> allFunctions;
+    MathFunctionEnum::getAllEnums(allFunctions);
+    for (int f = 0; f < (int)allFunctions.size(); ++f)
+    {
+        AString funcName = MathFunctionEnum::toName(allFunctions[f]) + "(";
+        bool found = false;
+        for (int e = 0; e < NUM_FUNCTION_STRINGS; ++e)
+        {
+            if (AString(functionStrings[e]).startsWith(funcName))
+            {
+                found = true;
+                break;
+            }
+        }
+        if (!found) setFailed("no test case for function '" + MathFunctionEnum::toName(allFunctions[f]) + "'");
+    }
+    const int64_t NUM_FUNC_ELEMS = 1000;
+    vector<float> funcX(NUM_FUNC_ELEMS), funcResult(NUM_FUNC_ELEMS);
+    for (int64_t i = 0; i < NUM_FUNC_ELEMS; ++i)
+    {
+        funcX[i] = (i % 180) / 100.0f - 0.9f;
+    }
+    vector<const float*> funcPointers(1, funcX.data());
+    vector<float> funcVars(1);
+    for (int e = 0; e < NUM_FUNCTION_STRINGS; ++e)
+    {
+        CaretMathExpression funcExpr(functionStrings[e]);
+        if (funcExpr.getVarNames().size() != 1)
+        {
+            setFailed("incorrect number of variables found in '" + AString(functionStrings[e]) + "'");
+            continue;
+        }
+        funcExpr.evaluateMany(funcResult.data(), funcPointers, NUM_FUNC_ELEMS);
+        for (int64_t i = 0; i < NUM_FUNC_ELEMS; ++i)
+        {
+            double expected = functionReference(e, funcX[i]);
+            funcVars[0] = funcX[i];
+            double single = funcExpr.evaluate(funcVars);
+            double toler = 0.00001 * max(1.0, abs(expected));//batch results are stored as float
+            if (!(abs(single - expected) <= toler) || !(abs(funcResult[i] - expected) <= toler))//trap NaNs
+            {
+                setFailed("'" + AString(functionStrings[e]) + "' with x = " + AString::number(funcX[i]) + " gave " + AString::number(single) +
+                          " (single) and " + AString::number(funcResult[i]) + " (batch), expected " + AString::number(expected));
+                break;
+            }
+        }
+    }
 }
@@ -0,0 +1,255 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "SparseFileTest.h"
+
+#include "CaretSparseFile.h"
+#include "CiftiSeriesMap.h"
+#include "CiftiXML.h"
+
+#include <QDir>
+#include <QFile>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+SparseFileTest::SparseFileTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+namespace
+{
+    const int64_t NUM_COLS = 37, NUM_ROWS = 23;
+    
+    CiftiXML makeXML()
+    {
+        CiftiXML ret;
+        ret.setNumberOfDimensions(2);
+        ret.setMap(CiftiXML::ALONG_ROW, CiftiSeriesMap(NUM_COLS));
+        ret.setMap(CiftiXML::ALONG_COLUMN, CiftiSeriesMap(NUM_ROWS));
+        return ret;
+    }
+    
+    //row-major, the first and last rows and some others are empty, others are dense, and the rest are sparse, with both end columns used
+    vector<int64_t> makeValues()
+    {
+        vector<int64_t> ret(NUM_ROWS * NUM_COLS, 0);
+        for (int64_t row = 1; row < NUM_ROWS - 1; ++row)
+        {
+            int kind = row % 4;
+            if (kind == 0) continue;
+            for (int64_t col = 0; col < NUM_COLS; ++col)
+            {
+                if (kind == 1 || col == 0 || col == NUM_COLS - 1 || rand() % 5 == 0)
+                {
+                    int64_t value;
+                    switch (rand() % 4)
+                    {
+                        case 0:
+                            value = 1;
+                            break;
+                        case 1:
+                            value = (((int64_t)rand()) << 32) | rand();//multi-byte varints
+                            break;
+                        case 2:
+                            value = -(rand() % 1000) - 1;//negative values are the longest varints
+                            break;
+                        default:
+                            value = rand() % 200 + 1;
+                            break;
+                    }
+                    ret[row * NUM_COLS + col] = value;
+                }
+            }
+        }
+        return ret;
+    }
+    
+    AString tempFileName(const int& version, const bool& sparseWriting, const AString& kind)
+    {
+        return QDir::tempPath() + "/wb_sparse_test_" + kind + "_v" + AString::number(version) + (sparseWriting ? "_sparse" : "_dense") + ".trajTEMP.wbsparse";
+    }
+}
+
+void SparseFileTest::execute()
+{
+    srand(2468);
+    for (int version = 1; version <= 2 && !failed(); ++version)
+    {
+        for (int sparse = 0; sparse < 2; ++sparse)
+        {//the reader is closed when each test returns, so the files can be removed here
+            testValues(version, sparse != 0);
+            QFile::remove(tempFileName(version, sparse != 0, "values"));
+            testFibers(version, sparse != 0);
+            QFile::remove(tempFileName(version, sparse != 0, "fibers"));
+        }
+    }
+}
+
+void SparseFileTest::testValues(const int& version, const bool& sparseWriting)
+{
+    AString fileName = tempFileName(version, sparseWriting, "values");
+    AString descrip = "version " + AString::number(version) + (sparseWriting ? " sparse" : " dense") + " values";
+    vector<int64_t> values = makeValues();
+    {
+        CaretSparseFileWriter myWriter(fileName, makeXML(), version);
+        for (int64_t row = 0; row < NUM_ROWS; ++row)
+        {
+            const int64_t* rowValues = values.data() + row * NUM_COLS;
+            if (sparseWriting)
+            {
+                vector<int64_t> indices, rowNonzero;
+                for (int64_t col = 0; col < NUM_COLS; ++col)
+                {
+                    if (rowValues[col] != 0)
+                    {
+                        indices.push_back(col);
+                        rowNonzero.push_back(rowValues[col]);
+                    }
+                }
+                if (!indices.empty()) myWriter.writeRowSparse(row, indices, rowNonzero);//skip empty rows, including the last
+            } else {
+                myWriter.writeRow(row, rowValues);
+            }
+        }
+        myWriter.finish();
+    }
+    CaretSparseFile myFile(fileName);
+    if (myFile.getDimensions()[0] != NUM_COLS || myFile.getDimensions()[1] != NUM_ROWS)
+    {
+        setFailed(descrip + ": read wrong dimensions");
+        return;
+    }
+    vector<int64_t> rowOut(NUM_COLS), indicesOut, valuesOut;
+    for (int64_t row = NUM_ROWS - 1; row >= 0; --row)//out of order on purpose
+    {
+        const int64_t* expected = values.data() + row * NUM_COLS;
+        myFile.getRow(row, rowOut.data());
+        myFile.getRowSparse(row, indicesOut, valuesOut);
+        size_t nonzero = 0;
+        for (int64_t col = 0; col < NUM_COLS; ++col)
+        {
+            if (rowOut[col] != expected[col])
+            {
+                setFailed(descrip + ": wrong value in row " + AString::number(row) + ", column " + AString::number(col));
+                return;
+            }
+            if (expected[col] != 0)
+            {
+                if (nonzero >= indicesOut.size() || indicesOut[nonzero] != col || valuesOut[nonzero] != expected[col])
+                {
+                    setFailed(descrip + ": wrong sparse row " + AString::number(row) + " at column " + AString::number(col));
+                    return;
+                }
+                ++nonzero;
+            }
+        }
+        if (nonzero != indicesOut.size() || indicesOut.size() != valuesOut.size())
+        {
+            setFailed(descrip + ": sparse row " + AString::number(row) + " has extra elements");
+            return;
+        }
+    }
+}
+
+void SparseFileTest::testFibers(const int& version, const bool& sparseWriting)
+{
+    AString fileName = tempFileName(version, sparseWriting, "fibers");
+    AString descrip = "version " + AString::number(version) + (sparseWriting ? " sparse" : " dense") + " fibers";
+    vector<int64_t> pattern = makeValues();//only used for which elements are nonzero
+    vector<FiberFractions> fibers(NUM_ROWS * NUM_COLS);
+    for (int64_t i = 0; i < NUM_ROWS * NUM_COLS; ++i)
+    {
+        fibers[i].zero();
+        if (pattern[i] != 0)
+        {//fractions and distance in the steps that the encoding keeps
+            int first = rand() % 1001, second = rand() % (1001 - first);
+            fibers[i].totalCount = rand() % 100000 + 1;
+            fibers[i].fiberFractions.resize(3);
+            fibers[i].fiberFractions[0] = first / 1000.0f;
+            fibers[i].fiberFractions[1] = second / 1000.0f;
+            fibers[i].fiberFractions[2] = 1.0f - fibers[i].fiberFractions[0] - fibers[i].fiberFractions[1];
+            fibers[i].distance = rand() % 1001;
+        }
+    }
+    {
+        CaretSparseFileWriter myWriter(fileName, makeXML(), version);
+        for (int64_t row = 0; row < NUM_ROWS; ++row)
+        {
+            const FiberFractions* rowFibers = fibers.data() + row * NUM_COLS;
+            if (sparseWriting)
+            {
+                vector<int64_t> indices;
+                vector<FiberFractions> rowNonzero;
+                for (int64_t col = 0; col < NUM_COLS; ++col)
+                {
+                    if (rowFibers[col].totalCount != 0)
+                    {
+                        indices.push_back(col);
+                        rowNonzero.push_back(rowFibers[col]);
+                    }
+                }
+                if (!indices.empty()) myWriter.writeFibersRowSparse(row, indices, rowNonzero);
+            } else {
+                myWriter.writeFibersRow(row, rowFibers);
+            }
+        }
+        myWriter.finish();
+    }
+    CaretSparseFile myFile(fileName);
+    vector<FiberFractions> rowOut(NUM_COLS), valuesOut;
+    vector<int64_t> indicesOut;
+    for (int64_t row = 0; row < NUM_ROWS; ++row)
+    {
+        const FiberFractions* expected = fibers.data() + row * NUM_COLS;
+        myFile.getFibersRow(row, rowOut.data());
+        myFile.getFibersRowSparse(row, indicesOut, valuesOut);
+        size_t nonzero = 0;
+        for (int64_t col = 0; col < NUM_COLS; ++col)
+        {
+            if (rowOut[col].totalCount != expected[col].totalCount)
+            {
+                setFailed(descrip + ": wrong total count in row " + AString::number(row) + ", column " + AString::number(col));
+                return;
+            }
+            if (expected[col].totalCount == 0) continue;
+            if (rowOut[col].fiberFractions.size() != 3 || rowOut[col].fiberFractions[0] != expected[col].fiberFractions[0] ||
+                rowOut[col].fiberFractions[1] != expected[col].fiberFractions[1] || rowOut[col].distance != expected[col].distance)
+            {
+                setFailed(descrip + ": wrong fiber fractions or distance in row " + AString::number(row) + ", column " + AString::number(col));
+                return;
+            }
+            if (nonzero >= indicesOut.size() || indicesOut[nonzero] != col || valuesOut[nonzero].totalCount != expected[col].totalCount ||
+                valuesOut[nonzero].fiberFractions != rowOut[col].fiberFractions || valuesOut[nonzero].distance != rowOut[col].distance)
+            {
+                setFailed(descrip + ": wrong sparse fibers row " + AString::number(row) + " at column " + AString::number(col));
+                return;
+            }
+            ++nonzero;
+        }
+        if (nonzero != indicesOut.size() || indicesOut.size() != valuesOut.size())
+        {
+            setFailed(descrip + ": sparse fibers row " + AString::number(row) + " has extra elements");
+            return;
+        }
+    }
+}
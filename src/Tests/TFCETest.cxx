@@ -0,0 +1,382 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "TFCETest.h"
+
+#include "MetricFile.h"
+#include "OperationMetricTFCEMax.h"
+#include "OperationParameters.h"
+#include "OperationVolumeTFCEMax.h"
+#include "SurfaceFile.h"
+#include "TFCEHelper.h"
+#include "VolumeFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+TFCETest::TFCETest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+namespace
+{
+    const int NUM_MAPS = 4;
+    const int NUM_PARAMS = 3;
+    const float PARAM_E[NUM_PARAMS] = { 1.0f, 0.5f, 2.0f / 3.0f };
+    const float PARAM_H[NUM_PARAMS] = { 2.0f, 2.0f, 2.0f };
+    
+    //straight from the definition: for each pair of adjacent distinct values, every cluster above the upper one gets area^E * integral(h^H) over the interval
+    void bruteForceTFCE(const vector<vector<int32_t> >& neighbors, const vector<float>& areas, const float* values, const vector<bool>& inRoi,
+                        const float& param_e, const float& param_h, vector<double>& out)
+    {
+        int32_t numElems = (int32_t)neighbors.size();
+        out.assign(numElems, 0.0);
+        for (int sign = 1; sign >= -1; sign -= 2)
+        {
+            vector<float> signedVals(numElems, 0.0f), levels;
+            for (int32_t i = 0; i < numElems; ++i)
+            {
+                if (inRoi[i]) signedVals[i] = sign * values[i];
+                if (signedVals[i] > 0.0f) levels.push_back(signedVals[i]);
+            }
+            sort(levels.begin(), levels.end());
+            levels.erase(unique(levels.begin(), levels.end()), levels.end());
+            double lastLevel = 0.0;
+            for (size_t k = 0; k < levels.size(); ++k)
+            {
+                double slice = (pow((double)levels[k], param_h + 1.0) - pow(lastLevel, param_h + 1.0)) / (param_h + 1.0);
+                lastLevel = levels[k];
+                vector<bool> visited(numElems, false);
+                for (int32_t start = 0; start < numElems; ++start)
+                {
+                    if (visited[start] || signedVals[start] < levels[k]) continue;
+                    vector<int32_t> cluster(1, start);
+                    visited[start] = true;
+                    double clusterArea = 0.0;
+                    for (size_t c = 0; c < cluster.size(); ++c)
+                    {
+                        int32_t elem = cluster[c];
+                        clusterArea += areas[elem];
+                        for (size_t n = 0; n < neighbors[elem].size(); ++n)
+                        {
+                            int32_t neigh = neighbors[elem][n];
+                            if (!visited[neigh] && signedVals[neigh] >= levels[k])
+                            {
+                                visited[neigh] = true;
+                                cluster.push_back(neigh);
+                            }
+                        }
+                    }
+                    double contribution = sign * pow(clusterArea, (double)param_e) * slice;
+                    for (size_t c = 0; c < cluster.size(); ++c)
+                    {
+                        out[cluster[c]] += contribution;
+                    }
+                }
+            }
+        }
+    }
+    
+    bool closeEnough(const double& expected, const double& actual)
+    {
+        return abs(expected - actual) <= 0.0001 * max(1.0, abs(expected));//TFCE output is float
+    }
+    
+    void randomMap(float* values, const int64_t& count)
+    {
+        for (int64_t i = 0; i < count; ++i)
+        {
+            values[i] = ((rand() % 13) - 6) * 0.5f;//few distinct values, so there are ties and zeros, and both signs
+        }
+    }
+    
+    //runs a *-tfce-max operation, and reads the max and min that it prints for each map
+    template<typename T>
+    void runMaxOperation(OperationParameters* myParams, vector<float>& maxOut, vector<float>& minOut)
+    {
+        stringstream captured;
+        streambuf* oldBuf = cout.rdbuf(captured.rdbuf());
+        try
+        {
+            T::useParameters(myParams, NULL);
+        } catch (...) {
+            cout.rdbuf(oldBuf);
+            throw;
+        }
+        cout.rdbuf(oldBuf);
+        maxOut.clear();
+        minOut.clear();
+        float maxVal, minVal;
+        while (captured >> maxVal >> minVal)
+        {
+            maxOut.push_back(maxVal);
+            minOut.push_back(minVal);
+        }
+    }
+}
+
+void TFCETest::execute()
+{
+    srand(4321);
+    testSurface();
+    if (failed()) return;
+    testVolume();
+}
+
+void TFCETest::testSurface()
+{
+    const int32_t GRID_X = 9, GRID_Y = 7, numNodes = GRID_X * GRID_Y;
+    CaretPointer<SurfaceFile> mySurf(new SurfaceFile());
+    mySurf->setNumberOfNodesAndTriangles(numNodes, 2 * (GRID_X - 1) * (GRID_Y - 1));
+    vector<vector<int32_t> > neighbors(numNodes);
+    for (int32_t y = 0; y < GRID_Y; ++y)
+    {
+        for (int32_t x = 0; x < GRID_X; ++x)
+        {
+            mySurf->setCoordinate(x + y * GRID_X, x + 0.3f * (rand() / (float)RAND_MAX), y + 0.3f * (rand() / (float)RAND_MAX), 0.0f);
+        }
+    }
+    int32_t tri = 0;
+    for (int32_t y = 0; y < GRID_Y - 1; ++y)
+    {
+        for (int32_t x = 0; x < GRID_X - 1; ++x)
+        {
+            int32_t corner = x + y * GRID_X;
+            int32_t quad[4] = { corner, corner + 1, corner + GRID_X + 1, corner + GRID_X };
+            mySurf->setTriangle(tri++, quad[0], quad[1], quad[2]);
+            mySurf->setTriangle(tri++, quad[0], quad[2], quad[3]);
+            int32_t edges[5][2] = { { quad[0], quad[1] }, { quad[1], quad[2] }, { quad[2], quad[3] }, { quad[3], quad[0] }, { quad[0], quad[2] } };
+            for (int e = 0; e < 5; ++e)
+            {
+                vector<int32_t>& first = neighbors[edges[e][0]];
+                if (find(first.begin(), first.end(), edges[e][1]) == first.end())
+                {
+                    first.push_back(edges[e][1]);
+                    neighbors[edges[e][1]].push_back(edges[e][0]);
+                }
+            }
+        }
+    }
+    vector<float> surfAreas, givenAreas(numNodes), roiData(numNodes);
+    mySurf->computeNodeAreas(surfAreas);
+    vector<bool> allIn(numNodes, true), inRoi(numNodes);
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        givenAreas[i] = 0.5f + rand() / (float)RAND_MAX;
+        inRoi[i] = (rand() % 5 != 0);
+        roiData[i] = (inRoi[i] ? 1.0f : 0.0f);
+    }
+    CaretPointer<MetricFile> myMetric(new MetricFile());
+    myMetric->setNumberOfNodesAndColumns(numNodes, NUM_MAPS);
+    for (int map = 0; map < NUM_MAPS; ++map)
+    {
+        vector<float> values(numNodes);
+        randomMap(values.data(), numNodes);
+        myMetric->setValuesForColumn(map, values.data());
+    }
+    vector<float> output(numNodes);
+    vector<double> expected;
+    for (int p = 0; p < NUM_PARAMS && !failed(); ++p)
+    {
+        for (int useRoi = 0; useRoi < 2; ++useRoi)
+        {
+            for (int useAreas = 0; useAreas < 2; ++useAreas)
+            {
+                TFCEHelper myTFCE(mySurf.getPointer(), (useAreas ? givenAreas.data() : NULL), (useRoi ? roiData.data() : NULL), PARAM_E[p], PARAM_H[p]);
+                TFCEHelper::Scratch myScratch;//reused for every map, like the operations do
+                const vector<bool>& roiUsed = (useRoi ? inRoi : allIn);
+                const vector<float>& areasUsed = (useAreas ? givenAreas : surfAreas);
+                AString descrip = "surface TFCE with E = " + AString::number(PARAM_E[p]) + (useRoi ? ", roi" : "") + (useAreas ? ", corrected areas" : "");
+                for (int map = 0; map < NUM_MAPS; ++map)
+                {
+                    const float* values = myMetric->getValuePointerForColumn(map);
+                    bruteForceTFCE(neighbors, areasUsed, values, roiUsed, PARAM_E[p], PARAM_H[p], expected);
+                    myTFCE.computeTFCE(values, output.data(), myScratch);
+                    float expectMax = 0.0f, expectMin = 0.0f;
+                    for (int32_t i = 0; i < numNodes; ++i)
+                    {
+                        if (!closeEnough(expected[i], output[i]))
+                        {
+                            setFailed(descrip + ", map " + AString::number(map) + ", vertex " + AString::number(i) + ": expected " +
+                                      AString::number(expected[i]) + ", got " + AString::number(output[i]));
+                            return;
+                        }
+                        expectMax = max(expectMax, (float)expected[i]);
+                        expectMin = min(expectMin, (float)expected[i]);
+                    }
+                    float maxVal, minVal;
+                    myTFCE.computeTFCEExtremes(values, maxVal, minVal, myScratch);
+                    if (!closeEnough(expectMax, maxVal) || !closeEnough(expectMin, minVal))
+                    {
+                        setFailed(descrip + ", map " + AString::number(map) + ": expected extremes " + AString::number(expectMax) + " and " +
+                                  AString::number(expectMin) + ", got " + AString::number(maxVal) + " and " + AString::number(minVal));
+                        return;
+                    }
+                }
+            }
+        }
+    }
+    CaretPointer<MetricFile> roiMetric(new MetricFile());
+    roiMetric->setNumberOfNodesAndColumns(numNodes, 1);
+    roiMetric->setValuesForColumn(0, roiData.data());
+    const int p = 1;
+    CaretPointer<OperationParameters> myParams(OperationMetricTFCEMax::getParameters());
+    ((SurfaceParameter*)myParams->getInputParameter(1, OperationParametersEnum::SURFACE))->m_parameter = mySurf;
+    ((MetricParameter*)myParams->getInputParameter(2, OperationParametersEnum::METRIC))->m_parameter = myMetric;
+    OptionalParameter* roiOpt = myParams->getOptionalParameter(3);
+    roiOpt->m_present = true;
+    ((MetricParameter*)roiOpt->getInputParameter(1, OperationParametersEnum::METRIC))->m_parameter = roiMetric;
+    OptionalParameter* paramsOpt = myParams->getOptionalParameter(4);
+    paramsOpt->m_present = true;
+    ((DoubleParameter*)paramsOpt->getInputParameter(1, OperationParametersEnum::DOUBLE))->m_parameter = PARAM_E[p];
+    ((DoubleParameter*)paramsOpt->getInputParameter(2, OperationParametersEnum::DOUBLE))->m_parameter = PARAM_H[p];
+    vector<float> maxVals, minVals;
+    runMaxOperation<OperationMetricTFCEMax>(myParams.getPointer(), maxVals, minVals);
+    if ((int)maxVals.size() != NUM_MAPS)
+    {
+        setFailed("-metric-tfce-max printed " + AString::number(maxVals.size()) + " results, expected " + AString::number(NUM_MAPS));
+        return;
+    }
+    for (int map = 0; map < NUM_MAPS; ++map)
+    {
+        bruteForceTFCE(neighbors, surfAreas, myMetric->getValuePointerForColumn(map), inRoi, PARAM_E[p], PARAM_H[p], expected);
+        double expectMax = max(0.0, *max_element(expected.begin(), expected.end())), expectMin = min(0.0, *min_element(expected.begin(), expected.end()));
+        if (!closeEnough(expectMax, maxVals[map]) || !closeEnough(expectMin, minVals[map]))
+        {
+            setFailed("-metric-tfce-max map " + AString::number(map) + ": expected " + AString::number(expectMax) + " and " + AString::number(expectMin) +
+                      ", got " + AString::number(maxVals[map]) + " and " + AString::number(minVals[map]));
+            return;
+        }
+    }
+}
+
+void TFCETest::testVolume()
+{
+    const int64_t DIMS[3] = { 6, 5, 4 };
+    vector<int64_t> volDims(DIMS, DIMS + 3);
+    volDims.push_back(NUM_MAPS);
+    vector<vector<float> > sform(3, vector<float>(4, 0.0f));
+    sform[0][0] = 2.0f;
+    sform[1][1] = 1.5f;
+    sform[2][2] = 1.0f;//voxel volume of 3
+    CaretPointer<VolumeFile> myVol(new VolumeFile(volDims, sform));
+    CaretPointer<VolumeFile> roiVol(new VolumeFile(vector<int64_t>(DIMS, DIMS + 3), sform));
+    const int64_t numVoxels = DIMS[0] * DIMS[1] * DIMS[2];
+    vector<vector<int32_t> > neighbors(numVoxels);
+    vector<float> areas(numVoxels, 3.0f), roiFrame(numVoxels);
+    vector<bool> allIn(numVoxels, true), inRoi(numVoxels);
+    for (int64_t k = 0; k < DIMS[2]; ++k)
+    {
+        for (int64_t j = 0; j < DIMS[1]; ++j)
+        {
+            for (int64_t i = 0; i < DIMS[0]; ++i)
+            {
+                int64_t index = myVol->getIndex(i, j, k);
+                if (i > 0) neighbors[index].push_back(myVol->getIndex(i - 1, j, k));
+                if (j > 0) neighbors[index].push_back(myVol->getIndex(i, j - 1, k));
+                if (k > 0) neighbors[index].push_back(myVol->getIndex(i, j, k - 1));
+                if (i < DIMS[0] - 1) neighbors[index].push_back(myVol->getIndex(i + 1, j, k));
+                if (j < DIMS[1] - 1) neighbors[index].push_back(myVol->getIndex(i, j + 1, k));
+                if (k < DIMS[2] - 1) neighbors[index].push_back(myVol->getIndex(i, j, k + 1));
+                inRoi[index] = (rand() % 5 != 0);
+                roiFrame[index] = (inRoi[index] ? 1.0f : 0.0f);
+            }
+        }
+    }
+    roiVol->setFrame(roiFrame.data());
+    for (int map = 0; map < NUM_MAPS; ++map)
+    {
+        vector<float> values(numVoxels);
+        randomMap(values.data(), numVoxels);
+        myVol->setFrame(values.data(), map);
+    }
+    vector<float> output(numVoxels);
+    vector<double> expected;
+    for (int p = 0; p < NUM_PARAMS; ++p)
+    {
+        for (int useRoi = 0; useRoi < 2; ++useRoi)
+        {
+            TFCEHelper myTFCE(myVol->getVolumeSpace(), (useRoi ? roiFrame.data() : NULL), PARAM_E[p], PARAM_H[p]);
+            TFCEHelper::Scratch myScratch;
+            const vector<bool>& roiUsed = (useRoi ? inRoi : allIn);
+            AString descrip = "volume TFCE with E = " + AString::number(PARAM_E[p]) + (useRoi ? ", roi" : "");
+            for (int map = 0; map < NUM_MAPS; ++map)
+            {
+                const float* values = myVol->getFrame(map);
+                bruteForceTFCE(neighbors, areas, values, roiUsed, PARAM_E[p], PARAM_H[p], expected);
+                myTFCE.computeTFCE(values, output.data(), myScratch);
+                float expectMax = 0.0f, expectMin = 0.0f;
+                for (int64_t i = 0; i < numVoxels; ++i)
+                {
+                    if (!closeEnough(expected[i], output[i]))
+                    {
+                        setFailed(descrip + ", map " + AString::number(map) + ", voxel " + AString::number(i) + ": expected " +
+                                  AString::number(expected[i]) + ", got " + AString::number(output[i]));
+                        return;
+                    }
+                    expectMax = max(expectMax, (float)expected[i]);
+                    expectMin = min(expectMin, (float)expected[i]);
+                }
+                float maxVal, minVal;
+                myTFCE.computeTFCEExtremes(values, maxVal, minVal, myScratch);
+                if (!closeEnough(expectMax, maxVal) || !closeEnough(expectMin, minVal))
+                {
+                    setFailed(descrip + ", map " + AString::number(map) + ": expected extremes " + AString::number(expectMax) + " and " +
+                              AString::number(expectMin) + ", got " + AString::number(maxVal) + " and " + AString::number(minVal));
+                    return;
+                }
+            }
+        }
+    }
+    const int p = 0;
+    CaretPointer<OperationParameters> myParams(OperationVolumeTFCEMax::getParameters());
+    ((VolumeParameter*)myParams->getInputParameter(1, OperationParametersEnum::VOLUME))->m_parameter = myVol;
+    OptionalParameter* roiOpt = myParams->getOptionalParameter(2);
+    roiOpt->m_present = true;
+    ((VolumeParameter*)roiOpt->getInputParameter(1, OperationParametersEnum::VOLUME))->m_parameter = roiVol;
+    OptionalParameter* paramsOpt = myParams->getOptionalParameter(3);
+    paramsOpt->m_present = true;
+    ((DoubleParameter*)paramsOpt->getInputParameter(1, OperationParametersEnum::DOUBLE))->m_parameter = PARAM_E[p];
+    ((DoubleParameter*)paramsOpt->getInputParameter(2, OperationParametersEnum::DOUBLE))->m_parameter = PARAM_H[p];
+    vector<float> maxVals, minVals;
+    runMaxOperation<OperationVolumeTFCEMax>(myParams.getPointer(), maxVals, minVals);
+    if ((int)maxVals.size() != NUM_MAPS)
+    {
+        setFailed("-volume-tfce-max printed " + AString::number(maxVals.size()) + " results, expected " + AString::number(NUM_MAPS));
+        return;
+    }
+    for (int map = 0; map < NUM_MAPS; ++map)
+    {
+        bruteForceTFCE(neighbors, areas, myVol->getFrame(map), inRoi, PARAM_E[p], PARAM_H[p], expected);
+        double expectMax = max(0.0, *max_element(expected.begin(), expected.end())), expectMin = min(0.0, *min_element(expected.begin(), expected.end()));
+        if (!closeEnough(expectMax, maxVals[map]) || !closeEnough(expectMin, minVals[map]))
+        {
+            setFailed("-volume-tfce-max map " + AString::number(map) + ": expected " + AString::number(expectMax) + " and " + AString::number(expectMin) +
+                      ", got " + AString::number(maxVals[map]) + " and " + AString::number(minVals[map]));
+            return;
+        }
+    }
+}
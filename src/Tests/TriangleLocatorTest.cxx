@@ -0,0 +1,215 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2018  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "TriangleLocatorTest.h"
+
+#include "CaretTriangleLocator.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+TriangleLocatorTest::TriangleLocatorTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+namespace
+{
+    const int NUM_TRIANGLES = 500;
+    const int NUM_COORDS = NUM_TRIANGLES * 3;
+    const int NUM_RAYS = 3000;
+    const double BOX_SIZE = 10.0;
+    const double EDGE_TOLERANCE = 1e-5;//rays this close to an edge may reasonably go either way
+    
+    double randUniform(const double& low, const double& high)
+    {
+        return low + (high - low) * (rand() / (double)RAND_MAX);
+    }
+    
+    //solves origin + t * direction = vert0 + u * edge1 + v * edge2 with Cramer's rule, independently of the locator's method
+    //returns the closest triangle with t >= 0, u >= 0, v >= 0, u + v <= 1, or -1, and whether any triangle in front of the origin is too close to call
+    int64_t bruteForceRayHit(const vector<float>& coords, const vector<int32_t>& triangles, const float origin[3], const float direction[3],
+                             double& distanceOut, bool& ambiguousOut)
+    {
+        int64_t best = -1;
+        distanceOut = 0.0;
+        ambiguousOut = false;
+        int64_t numTriangles = (int64_t)triangles.size() / 3;
+        for (int64_t i = 0; i < numTriangles; ++i)
+        {
+            const int32_t* tri = triangles.data() + i * 3;
+            if (tri[0] < 0 || tri[1] < 0 || tri[2] < 0 || tri[0] >= NUM_COORDS || tri[1] >= NUM_COORDS || tri[2] >= NUM_COORDS) continue;
+            double e1[3], e2[3], rhs[3], negDir[3];
+            for (int j = 0; j < 3; ++j)
+            {
+                e1[j] = (double)coords[tri[1] * 3 + j] - coords[tri[0] * 3 + j];
+                e2[j] = (double)coords[tri[2] * 3 + j] - coords[tri[0] * 3 + j];
+                rhs[j] = (double)origin[j] - coords[tri[0] * 3 + j];
+                negDir[j] = -(double)direction[j];
+            }
+            //columns are e1, e2, -direction
+            double det = e1[0] * (e2[1] * negDir[2] - e2[2] * negDir[1]) - e2[0] * (e1[1] * negDir[2] - e1[2] * negDir[1]) + negDir[0] * (e1[1] * e2[2] - e1[2] * e2[1]);
+            if (abs(det) < 1e-12) continue;//parallel, random geometry won't hit this
+            double u = (rhs[0] * (e2[1] * negDir[2] - e2[2] * negDir[1]) - e2[0] * (rhs[1] * negDir[2] - rhs[2] * negDir[1]) + negDir[0] * (rhs[1] * e2[2] - rhs[2] * e2[1])) / det;
+            double v = (e1[0] * (rhs[1] * negDir[2] - rhs[2] * negDir[1]) - rhs[0] * (e1[1] * negDir[2] - e1[2] * negDir[1]) + negDir[0] * (e1[1] * rhs[2] - e1[2] * rhs[1])) / det;
+            double t = (e1[0] * (e2[1] * rhs[2] - e2[2] * rhs[1]) - e2[0] * (e1[1] * rhs[2] - e1[2] * rhs[1]) + rhs[0] * (e1[1] * e2[2] - e1[2] * e2[1])) / det;
+            double margin = min(min(u, v), 1.0 - u - v);
+            if (t < -EDGE_TOLERANCE) continue;
+            if (abs(margin) < EDGE_TOLERANCE || t < EDGE_TOLERANCE) ambiguousOut = true;
+            if (margin < 0.0 || t < 0.0) continue;
+            if (best < 0 || t < distanceOut)
+            {
+                best = i;
+                distanceOut = t;
+            }
+        }
+        return best;
+    }
+}
+
+void TriangleLocatorTest::execute()
+{
+    srand(13579);
+    vector<float> coords(NUM_COORDS * 3);
+    vector<int32_t> triangles(NUM_TRIANGLES * 3);
+    for (int i = 0; i < NUM_TRIANGLES; ++i)
+    {//small triangles scattered through a box, overlapping each other
+        for (int k = 0; k < 3; ++k)
+        {
+            coords[i * 9 + k] = randUniform(-BOX_SIZE, BOX_SIZE);
+        }
+        for (int j = 1; j < 3; ++j)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                coords[i * 9 + j * 3 + k] = coords[i * 9 + k] + randUniform(-3.0, 3.0);
+            }
+        }
+        for (int j = 0; j < 3; ++j)
+        {//mix up the vertex order so the triangles don't all face the same way
+            triangles[i * 3 + j] = i * 3 + (j + i) % 3;
+        }
+    }
+    triangles[7 * 3 + 1] = -1;//invalid triangles must never be hit, and must not change the indices of the others
+    triangles[42 * 3 + 2] = NUM_COORDS;
+    CaretTriangleLocator myLocator(coords.data(), NUM_COORDS, triangles.data(), NUM_TRIANGLES);
+    int numHits = 0, numMisses = 0, numAmbiguous = 0;
+    for (int ray = 0; ray < NUM_RAYS; ++ray)
+    {
+        float origin[3], direction[3];
+        int kind = ray % 4;
+        for (int k = 0; k < 3; ++k)
+        {
+            origin[k] = randUniform(-2.0 * BOX_SIZE, 2.0 * BOX_SIZE);
+        }
+        if (kind == 0)
+        {//aim at the inside of a random triangle, through other triangles or from behind it
+            int32_t target = rand() % NUM_TRIANGLES;//triangles own their vertices, so this also works for the invalid ones
+            double u = randUniform(0.05, 0.9), v = randUniform(0.05, 0.95 - u);
+            for (int k = 0; k < 3; ++k)
+            {
+                double point = (1.0 - u - v) * coords[target * 9 + k] + u * coords[target * 9 + 3 + k] + v * coords[target * 9 + 6 + k];
+                direction[k] = (point - origin[k]) * randUniform(0.1, 3.0);//not normalized
+            }
+        } else if (kind == 1) {//axis-aligned, exercises zero direction components in the box test
+            direction[0] = direction[1] = direction[2] = 0.0f;
+            direction[rand() % 3] = (rand() % 2 ? 1.0f : -2.5f);
+            if (ray % 8 == 1)
+            {//start inside the mesh bounds, so hits can be behind as well as in front
+                for (int k = 0; k < 3; ++k) origin[k] = randUniform(-BOX_SIZE, BOX_SIZE);
+            }
+        } else if (kind == 2) {//pointing away from everything, must miss
+            int axis = rand() % 3;
+            origin[axis] = (rand() % 2 ? 1.0f : -1.0f) * randUniform(2.0 * BOX_SIZE, 3.0 * BOX_SIZE);
+            for (int k = 0; k < 3; ++k) direction[k] = randUniform(-0.3, 0.3);
+            direction[axis] = (origin[axis] > 0.0f ? 1.0f : -1.0f);
+        } else {//random, hits and misses
+            for (int k = 0; k < 3; ++k) direction[k] = randUniform(-1.0, 1.0);
+        }
+        double bruteDistance;
+        bool ambiguous;
+        int64_t bruteHit = bruteForceRayHit(coords, triangles, origin, direction, bruteDistance, ambiguous);
+        float distance = -1.0f, bary[3];
+        int64_t hit = myLocator.closestRayHit(origin, direction, &distance, bary);
+        if (hit == 7 || hit == 42)
+        {
+            setFailed("ray " + AString::number(ray) + " hit an invalid triangle");
+            return;
+        }
+        if (ambiguous)
+        {
+            ++numAmbiguous;
+            continue;
+        }
+        if (kind == 2 && bruteHit != -1)
+        {
+            setFailed("brute force found a hit for ray " + AString::number(ray) + " that points away from the mesh");
+            return;
+        }
+        if ((hit < 0) != (bruteHit < 0))
+        {
+            setFailed("ray " + AString::number(ray) + ": locator triangle " + AString::number(hit) + ", brute force triangle " + AString::number(bruteHit));
+            return;
+        }
+        if (hit < 0)
+        {
+            ++numMisses;
+            continue;
+        }
+        ++numHits;
+        if (abs(distance - bruteDistance) > 1e-4 * max(1.0, bruteDistance))
+        {
+            setFailed("ray " + AString::number(ray) + ": locator distance " + AString::number(distance) + ", brute force distance " + AString::number(bruteDistance));
+            return;
+        }
+        if (hit != bruteHit)
+        {//only acceptable if the two triangles are hit at the same distance, which random triangles won't do
+            setFailed("ray " + AString::number(ray) + ": locator triangle " + AString::number(hit) + ", brute force triangle " + AString::number(bruteHit));
+            return;
+        }
+        const int32_t* tri = triangles.data() + hit * 3;
+        for (int k = 0; k < 3; ++k)
+        {//barycentric weights must give the hit point
+            double fromWeights = bary[0] * coords[tri[0] * 3 + k] + bary[1] * coords[tri[1] * 3 + k] + bary[2] * coords[tri[2] * 3 + k];
+            double alongRay = origin[k] + bruteDistance * direction[k];
+            if (abs(fromWeights - alongRay) > 1e-3)
+            {
+                setFailed("ray " + AString::number(ray) + ": barycentric weights don't give the hit point");
+                return;
+            }
+        }
+    }
+    if (numHits < NUM_RAYS / 8 || numMisses < NUM_RAYS / 8)
+    {
+        setFailed("test rays didn't produce enough hits and misses: " + AString::number(numHits) + " hits, " + AString::number(numMisses) + " misses");
+    }
+    if (numAmbiguous > NUM_RAYS / 20)
+    {
+        setFailed("too many rays were too close to an edge to check: " + AString::number(numAmbiguous));
+    }
+    CaretTriangleLocator emptyLocator(coords.data(), NUM_COORDS, triangles.data(), 0);
+    float origin[3] = { 0.0f, 0.0f, 0.0f }, direction[3] = { 1.0f, 0.0f, 0.0f };
+    if (emptyLocator.closestRayHit(origin, direction) != -1)
+    {
+        setFailed("locator with no triangles found a hit");
+    }
+}
@@ -22,6 +22,8 @@
 #include "FloatMatrix.h"
 #include "VolumeFile.h"
 
+#include <QFile>
+
 #include <cstdlib>
 
 using namespace caret;
@@ -110,4 +112,54 @@ void VolumeFileTest::execute()
             }
         }
     }
+    VolumeFile frameTestVol(myDims, indexSpace.getMatrix());//single component, so it can be written and read back on demand
+    for (t = 0; t < myDims[3]; ++t)
+    {
+        for (k = 0; k < myDims[2]; ++k)
+        {
+            for (j = 0; j < myDims[1]; ++j)
+            {
+                for (i = 0; i < myDims[0]; ++i)
+                {
+                    frameTestVol.setValue(testvals[i][j][k][t][0], i, j, k, t);
+                }
+            }
+        }
+    }
+    AString outFile = m_default_path + "/volumeFramesOnDemandTest.nii";
+    if (QFile::exists(outFile)) QFile::remove(outFile);
+    frameTestVol.writeFile(outFile);
+    VolumeFile onDemandVol;
+    onDemandVol.setPreferOnDiskReading(true);
+    onDemandVol.readFile(outFile);
+    if (!onDemandVol.isFramesOnDemand())
+    {
+        setFailed("multi-frame volume was not read on demand");
+    }
+    for (t = myDims[3] - 1; t >= 0; --t)//out of order on purpose
+    {
+        const float* frame = onDemandVol.getFrame(t);
+        for (k = 0; k < myDims[2]; ++k)
+        {
+            for (j = 0; j < myDims[1]; ++j)
+            {
+                for (i = 0; i < myDims[0]; ++i)
+                {
+                    if (onDemandVol.getValue(i, j, k, t) != testvals[i][j][k][t][0] || frame[onDemandVol.getIndex(i, j, k)] != testvals[i][j][k][t][0])
+                    {
+                        setFailed(AString("on demand frame data was not consistent starting at (") + AString::number(i) + ", " + AString::number(j) +
+                            ", " + AString::number(k) + ", " + AString::number(t) + ")");
+                        QFile::remove(outFile);
+                        return;
+                    }
+                }
+            }
+        }
+    }
+    onDemandVol.setValue(-1.0f, 0, 0, 0, 1);//modifying must read everything into memory first
+    if (onDemandVol.isFramesOnDemand() || onDemandVol.getValue(0, 0, 0, 1) != -1.0f || onDemandVol.getValue(1, 0, 0, 1) != testvals[1][0][0][1][0])
+    {
+        setFailed("modifying a volume read on demand did not keep its data");
+    }
+    QFile::remove(outFile);
 }
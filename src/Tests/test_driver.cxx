@@ -33,9 +33,11 @@
 #include "CaretException.h"
 
 //tests
+#include "Base64Test.h"
 #include "CiftiFileTest.h"
 #include "DotTest.h"
 #include "GeodesicHelperTest.h"
+#include "GzipSeekTest.h"
 #include "HttpTest.h"
 #include "HeapTest.h"
 #include "LookupTest.h"
@@ -44,9 +46,12 @@
 #include "PointerTest.h"
 #include "ProgressTest.h"
 #include "QuatTest.h"
+#include "SparseFileTest.h"
 #include "StatisticsTest.h"
+#include "TFCETest.h"
 #include "TimerTest.h"
 #include "TopologyHelperTest.h"
+#include "TriangleLocatorTest.h"
 #include "VolumeFileTest.h"
 #include "XnatTest.h"
 
@@ -69,9 +74,11 @@ int main(int argc, char** argv)
         caret_global_commandLine_init(argc, argv);
         SessionManager::createSessionManager(ApplicationTypeEnum::APPLICATION_TYPE_COMMAND_LINE);
         vector<TestInterface*> mytests;
+        mytests.push_back(new Base64Test("base64"));
         mytests.push_back(new CiftiFileTest("ciftifile"));
         mytests.push_back(new DotTest("dotsimd"));
         mytests.push_back(new GeodesicHelperTest("geohelp"));
+        mytests.push_back(new GzipSeekTest("gzipseek"));
         mytests.push_back(new HeapTest("heap"));
         mytests.push_back(new HttpTest("http"));
         mytests.push_back(new LookupTest("lookup"));
@@ -81,9 +88,12 @@ int main(int argc, char** argv)
         mytests.push_back(new PointerTest("pointer"));
         mytests.push_back(new ProgressTest("progress"));
         mytests.push_back(new QuatTest("quaternion"));
+        mytests.push_back(new SparseFileTest("sparsefile"));
         mytests.push_back(new StatisticsTest("statistics"));
+        mytests.push_back(new TFCETest("tfce"));
         mytests.push_back(new TimerTest("timer"));
         mytests.push_back(new TopologyHelperTest("topohelp"));
+        mytests.push_back(new TriangleLocatorTest("trianglelocator"));
         mytests.push_back(new VolumeFileTest("volumefile"));
         mytests.push_back(new XnatTest("xnat"));
         if (argc < 2)